@@ -41,6 +41,7 @@
 
 
 #include <queue>
+#include <sys/epoll.h>
 
 
 namespace OSS {
@@ -64,6 +65,13 @@ public:
   void processEvents();
   void terminate();
   void join();
+
+  bool addDescriptor(int fd, int events);
+    /// Register fd with the loop's epoll set.  events takes the POLLIN
+    /// family of flags, optionally combined with EPOLLET for handlers that
+    /// drain the descriptor on every callback.
+
+  bool removeDescriptor(int fd);
   
   JSIsolate* getIsolate();
   JSFileDescriptorManager& fdManager();
@@ -78,6 +86,7 @@ public:
 protected:
   bool _isTerminated;
   JSIsolate* _pIsolate;
+  int _epollFd;
   JSPersistentFunctionHandle _jsonParser;
   JSPersistentFunctionHandle _promiseHandler;
   JSPersistentObjectHandle _externalPointerTemplate;
@@ -52,7 +52,6 @@ public:
   bool enqueue(int fd, const EventPtr& pEvent);
   bool dequeue(int fd);
   std::size_t getSize();
-  void appendDescriptors(Descriptors& descriptors);
   
 private:
   OSS::mutex _queuesMutex;
@@ -43,9 +43,10 @@ public:
   ~JSFileDescriptorManager();
   
   void addFileDescriptor(int fd, v8::Handle<v8::Value> ioHandler, int events);
+    /// Monitor fd and call ioHandler from the event loop when it becomes
+    /// ready.  Pass EPOLLET in events only if ioHandler drains fd.
   bool removeFileDescriptor(int fd);
   JSFileDescriptor::Ptr findDescriptor(int fd);
-  void appendDescriptors(Descriptors& descriptors);
   bool signalIO(pollfd pfd);
   
   //
@@ -62,8 +62,12 @@ protected:
   JSInterIsolateCall(const Request& request, uint32_t timeout, void* userData);
   JSInterIsolateCall(const Request& request, uint32_t timeout, void* userData, JSPersistentFunctionHandle* cb);
   void setValue(const std::string& value);
+  void setValue();
+    /// Signal completion after _result was filled in directly by the
+    /// handling isolate.  The waiter skips the JSON parse in this case.
   Request _request;
   Result _result;
+  bool _hasResult;
   void* _userData;
   uint32_t _timeout;
   Future _future;
@@ -77,6 +81,7 @@ protected:
 
 
 inline JSInterIsolateCall::JSInterIsolateCall() :
+  _hasResult(false),
   _userData(0),
   _timeout(0),
   _cb(0)
@@ -86,6 +91,7 @@ inline JSInterIsolateCall::JSInterIsolateCall() :
 
 inline JSInterIsolateCall::JSInterIsolateCall(const Request& request, uint32_t timeout, void* userData, JSPersistentFunctionHandle* cb) :
   _request(request),
+  _hasResult(false),
   _userData(userData),
   _timeout(timeout),
   _cb(cb)
@@ -95,6 +101,7 @@ inline JSInterIsolateCall::JSInterIsolateCall(const Request& request, uint32_t t
 
 inline JSInterIsolateCall::JSInterIsolateCall(const Request& request, uint32_t timeout, void* userData) :
   _request(request),
+  _hasResult(false),
   _userData(userData),
   _timeout(timeout),
   _cb(0)
@@ -161,7 +168,12 @@ inline bool JSInterIsolateCall::waitForResult()
       return false;
     }
   }
-  return setResult(_future.get());
+  std::string value = _future.get();
+  if (_hasResult)
+  {
+    return true;
+  }
+  return setResult(value);
 }
 
 inline std::string JSInterIsolateCall::json() const
@@ -176,6 +188,12 @@ inline void JSInterIsolateCall::setValue(const std::string& value)
   set_value(value);
 }
 
+inline void JSInterIsolateCall::setValue()
+{
+  _hasResult = true;
+  set_value(std::string());
+}
+
 
  
 } } // OSS::JS
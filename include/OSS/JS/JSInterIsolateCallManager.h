@@ -56,6 +56,8 @@ public:
 protected:
   void enqueue(const JSInterIsolateCall::Ptr& pCall);
   JSInterIsolateCall::Ptr dequeue();
+  void dispatch(const JSInterIsolateCall::Ptr& pCall);
+  void processCall(const JSInterIsolateCall::Ptr& pCall);
   OSS::mutex_critic_sec _queueMutex;
   CallQueue _queue;
   Handler _handler;
@@ -23,8 +23,9 @@
 
 #include "OSS/build.h"
 #if ENABLE_FEATURE_V8
+#include <queue>
 #include "OSS/JS/JS.h"
-#include "OSS/JS/JSFunctionCallbackQueue.h"
+#include "OSS/JS/JSEventLoopComponent.h"
 #include "OSS/JS/JSTimer.h"
 
 
@@ -33,21 +34,40 @@ namespace JS {
 
 class JSEventLoop;
 
-class JSTimerManager : public JSFunctionCallbackQueue
+class JSTimerManager : public JSEventLoopComponent
+  /// One-shot script timers kept in a min-heap ordered by deadline.
+  /// The event loop sleeps until the earliest deadline and fires expired
+  /// timers on its own thread, so timers carry no extra thread hop or
+  /// polling latency.  Cancelled timers are dropped from the map and their
+  /// heap entries are discarded lazily when they reach the top.
 {
 public:
   typedef std::map<int, JSTimer::Ptr> TimerMap;
+  typedef std::pair<OSS::UInt64, int> Deadline;
+  typedef std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline> > DeadlineHeap;
+
   JSTimerManager(JSEventLoop* pEventLoop);
   ~JSTimerManager();
   int scheduleTimer(int expire, const v8::Handle<v8::Value>& callback, const v8::Handle<v8::Value>& args);
   int scheduleTimer(int expire, const v8::Handle<v8::Value>& callback);
   void cancelTimer(int timerId);
+
+  int getTimeout();
+    /// Milliseconds until the earliest pending timer expires, or -1 if
+    /// there is none
+
+  bool processTimers();
+    /// Fire every expired timer.  Returns true if at least one fired.
+
+  static OSS::UInt64 getMonotonicTime();
   
 protected:
+  int addTimer(JSTimer* pTimer, int expire);
   JSTimer::Ptr removeTimer(int timerId);
 private:
   OSS::mutex_critic_sec _timersMutex;
   TimerMap _timers;
+  DeadlineHeap _deadlines;
   int _timerIdCounter;
   friend class JSTimer;
   
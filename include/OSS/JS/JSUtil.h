@@ -25,6 +25,7 @@
 
 #include "v8.h"
 #include "OSS/UTL/CoreUtils.h"
+#include "OSS/JSON/Json.h"
 
 
 namespace OSS {
@@ -68,6 +69,16 @@ void wrap_external_object(v8::Persistent<v8::Context>* pContext,
   OSS_HANDLE pObject);
 
 std::string get_stack_trace(v8::Handle<v8::Message> message, uint32_t bufLen);
+
+//
+// Direct conversion between JSON trees and JS values.  These walk both
+// sides in place and avoid the stringify/parse round trip when objects
+// cross an isolate boundary.  The caller must have a handle scope.
+//
+v8::Handle<v8::Value> js_value_from_json(const OSS::JSON::UnknownElement& element);
+v8::Handle<v8::Object> js_object_from_json(const OSS::JSON::Object& object);
+bool js_value_to_json(const v8::Handle<v8::Value>& value, OSS::JSON::UnknownElement& element);
+bool js_object_to_json(const v8::Handle<v8::Object>& object, OSS::JSON::Object& json);
   
 } }
 
@@ -22,12 +22,21 @@
 
 #include <v8.h>
 #include <vector>
+#include <boost/shared_ptr.hpp>
 #include <OSS/JS/JSPlugin.h>
 
 class BufferObject : public OSS::JS::JSObjectWrap
+  /// Byte buffer exposed to scripts.
+  ///
+  /// The bytes are handed to v8 as external unsigned byte array data so
+  /// scripts index into the native memory directly, the same way a
+  /// Uint8Array does, without an interceptor call per element.  slice()
+  /// returns a Buffer that views the same memory.  Native modules read and
+  /// write through data() and size() and never copy into script values.
 {
 public:
   typedef std::vector<unsigned char> ByteArray;
+  typedef boost::shared_ptr<ByteArray> Storage;
   
   
   JS_CONSTRUCTOR_DECLARE();
@@ -44,36 +53,58 @@ public:
   JS_METHOD_DECLARE(equals);
   JS_METHOD_DECLARE(resize);
   JS_METHOD_DECLARE(clear);
-  
-  //
-  // Properties
-  //
-  JS_INDEX_GETTER_DECLARE(getAt);
-  JS_INDEX_SETTER_DECLARE(setAt);
-  
+  JS_METHOD_DECLARE(slice);
   
   //
   // Helpers
   //
   static JSValueHandle createNew(uint32_t size);
+  static JSValueHandle createNew(const char* data, std::size_t size);
+    /// Create a buffer holding a copy of data
   static bool isBuffer(JSValueHandle value);
   static JSValueHandle  isBufferObject(JSArguments& args);
   
-  ByteArray& buffer();
+  unsigned char* data();
+    /// Start of the bytes this buffer views
+  
+  std::size_t size() const;
+  
+  bool resize(std::size_t size);
+    /// Resize the buffer.  Fails if the memory is shared with a slice
+    /// because moving it would leave the other view dangling.
+  
+  bool isShared() const;
+    /// True if a slice or the buffer it was sliced from is still alive
+
 private:
   BufferObject();
   BufferObject(std::size_t size);
   BufferObject(const BufferObject& obj);
   virtual ~BufferObject();
-  ByteArray _buffer;
+  void exposeData();
+    /// (Re)attach data() to the script object as its indexed elements
+  
+  Storage _storage;
+  std::size_t _offset;
+  std::size_t _size;
 };
 
 //
 // Inlines
 //
-inline BufferObject::ByteArray& BufferObject::buffer()
+inline unsigned char* BufferObject::data()
+{
+  return _storage->data() + _offset;
+}
+
+inline std::size_t BufferObject::size() const
+{
+  return _size;
+}
+
+inline bool BufferObject::isShared() const
 {
-  return _buffer;
+  return !_storage.unique();
 }
 
 typedef std::vector<unsigned char> ByteArray;
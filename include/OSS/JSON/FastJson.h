@@ -0,0 +1,137 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+#ifndef OSS_FASTJSON_H_INCLUDED
+#define OSS_FASTJSON_H_INCLUDED
+
+
+#include <string>
+
+#include "OSS/OSS.h"
+#include "OSS/JSON/reader.h"
+#include "OSS/JSON/writer.h"
+
+
+namespace OSS {
+namespace JSON {
+
+
+class FastReader
+  /// Single-pass JSON reader that builds the regular CAJUN elements.
+  ///
+  /// json::Reader pulls one character at a time out of an istream, tokenizes
+  /// the whole document into a vector of strings and then parses the tokens.
+  /// FastReader walks a contiguous buffer once and parses every value in
+  /// place into its final element, so no token list or intermediate copies
+  /// are built.  String bodies are scanned sixteen bytes at a time with SSE2
+  /// where it is available.
+  ///
+  /// It accepts everything json::Reader accepts, also decodes \u escapes,
+  /// and throws the same json::Reader::ScanException and ParseException
+  /// types on malformed input.
+{
+public:
+  static void Read(json::Object& object, const char* data, std::size_t size);
+  static void Read(json::Array& array, const char* data, std::size_t size);
+  static void Read(json::UnknownElement& element, const char* data, std::size_t size);
+
+  static void Read(json::Object& object, const std::string& data);
+  static void Read(json::Array& array, const std::string& data);
+  static void Read(json::UnknownElement& element, const std::string& data);
+
+  enum
+  {
+    MAX_DEPTH = 512
+      /// Documents nested deeper than this are rejected
+  };
+};
+
+class FastWriter : private json::ConstVisitor
+  /// Compact JSON writer that appends directly to a std::string.
+  ///
+  /// The output has no whitespace.  Numbers that hold an integer are written
+  /// without a fraction and other numbers with the shortest precision that
+  /// reads back to the same double.
+{
+public:
+  static void Write(const json::Object& object, std::string& out);
+  static void Write(const json::Array& array, std::string& out);
+  static void Write(const json::UnknownElement& element, std::string& out);
+    /// Append the serialized element to out
+
+  static std::string toString(const json::Object& object);
+  static std::string toString(const json::UnknownElement& element);
+
+private:
+  explicit FastWriter(std::string& out);
+
+  void write(const json::Object& object);
+  void write(const json::Array& array);
+  void write(const std::string& value);
+  void write(double value);
+
+  virtual void Visit(const json::Array& array);
+  virtual void Visit(const json::Object& object);
+  virtual void Visit(const json::Number& number);
+  virtual void Visit(const json::String& string);
+  virtual void Visit(const json::Boolean& boolean);
+  virtual void Visit(const json::Null& null);
+
+  std::string& _out;
+};
+
+//
+// Inlines
+//
+
+inline void FastReader::Read(json::Object& object, const std::string& data)
+{
+  Read(object, data.data(), data.size());
+}
+
+inline void FastReader::Read(json::Array& array, const std::string& data)
+{
+  Read(array, data.data(), data.size());
+}
+
+inline void FastReader::Read(json::UnknownElement& element, const std::string& data)
+{
+  Read(element, data.data(), data.size());
+}
+
+inline std::string FastWriter::toString(const json::Object& object)
+{
+  std::string out;
+  Write(object, out);
+  return out;
+}
+
+inline std::string FastWriter::toString(const json::UnknownElement& element)
+{
+  std::string out;
+  Write(element, out);
+  return out;
+}
+
+
+} } // OSS::JSON
+
+#endif // OSS_FASTJSON_H_INCLUDED
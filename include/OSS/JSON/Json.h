@@ -23,6 +23,7 @@
 
 #include "OSS/JSON/reader.h"
 #include "OSS/JSON/writer.h"
+#include "OSS/JSON/FastJson.h"
 
 namespace OSS {
 namespace JSON {
@@ -48,9 +49,8 @@ bool json_to_string(const T& object, std::string& jsonString, OSS::JSON::Excepti
 {
   try
   {
-    std::stringstream ostr;
-    OSS::JSON::Writer::Write(object, ostr);
-    jsonString = ostr.str();
+    jsonString.clear();
+    OSS::JSON::FastWriter::Write(object, jsonString);
   }
   catch(OSS::JSON::Exception& e_)
   {
@@ -250,9 +250,7 @@ public:
         json::Object* pResponse = new json::Object();
         try
         {
-          std::stringstream strm;
-          strm << event.data;
-          json::Reader::Read(*pResponse, strm);
+          OSS::JSON::FastReader::Read(*pResponse, event.data);
           json::Object::const_iterator iter = pResponse->Find("id");
           if (iter != pResponse->End())
           {
@@ -260,7 +258,7 @@ public:
             JsonRpcTransaction::Ptr pTransaction = findTransaction(id.Value());
             if (pTransaction)
             {
-              pTransaction->queueResponse(pResponse, strm.str());
+              pTransaction->queueResponse(pResponse, event.data);
             }
             else
             {
@@ -303,14 +301,14 @@ public:
 
     try
     {
-      std::ostringstream requestStrm;
+      std::string requestStr;
       json::Object request;
       request["jsonrpc"] = json::String("2.0");
       request["method"] = json::String(method);
       request["id"] = json::Number(pTransaction->id());
       request["params"] = params;
-      json::Writer::Write(request, requestStrm);
-      if (!_connection.send(requestStrm.str()))
+      OSS::JSON::FastWriter::Write(request, requestStr);
+      if (!_connection.send(requestStr))
       {
         OSS_LOG_DEBUG("Unable to send JSON-RPC request " << method);
         destroyTransaction(pTransaction->id());
@@ -353,13 +351,13 @@ public:
     
     try
     {
-      std::ostringstream requestStrm;
+      std::string requestStr;
       json::Object request;
       request["jsonrpc"] = json::String("2.0");
       request["method"] = json::String(method);
       request["params"] = params;
-      json::Writer::Write(request, requestStrm);
-      _connection.send(requestStrm.str());
+      OSS::JSON::FastWriter::Write(request, requestStr);
+      _connection.send(requestStr);
     }
     catch(json::Exception& e)
     {
@@ -391,15 +389,15 @@ protected:
   {
     try
     {
-      std::ostringstream requestStrm;
+      std::string requestStr;
       json::Object request;
       request["jsonrpc"] = json::String("2.0");
       request["method"] = json::String(method);
       request["id"] = json::Number(generateId());
       request["params"] = params;
-      json::Writer::Write(request, requestStrm);
+      OSS::JSON::FastWriter::Write(request, requestStr);
       std::string result;
-      if (!_connection.sendAndReceive(requestStrm.str(), result, timeout))
+      if (!_connection.sendAndReceive(requestStr, result, timeout))
       {
         OSS_LOG_DEBUG("Unable to send JSON-RPC request " << method);
         return false;
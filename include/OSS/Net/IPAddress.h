@@ -24,6 +24,7 @@
 #include <boost/asio.hpp>
 
 #include "OSS/OSS.h"
+#include "OSS/Net/IPEndPoint.h"
 
 
 namespace OSS {
@@ -73,6 +74,9 @@ public:
   IPAddress(const IPAddress& address);
     /// Copy constructor
 
+  explicit IPAddress(const IPEndPoint& endpoint);
+    /// Create an address from its packed representation
+
   IPAddress& operator = (const std::string& address);
     /// Copy an address from a string
 
@@ -118,6 +122,10 @@ public:
   std::string toString() const;
     /// Get the address in its string format
 
+  IPEndPoint toEndPoint() const;
+    /// Get the packed representation of this address.  The external
+    /// address and alias are interned.
+
   unsigned short& cidr();
     /// Return the CIDR segment of a CIDR address
 
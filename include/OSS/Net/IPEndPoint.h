@@ -0,0 +1,222 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+#ifndef OSS_IPENDPOINT_H_INCLUDED
+#define OSS_IPENDPOINT_H_INCLUDED
+
+
+#include <string>
+#include <cstring>
+#include <boost/static_assert.hpp>
+
+#include "OSS/OSS.h"
+
+
+namespace OSS {
+namespace Net {
+
+
+struct OSS_API IPEndPoint
+  /// Packed, trivially copyable address:port tuple for hot paths.
+  ///
+  /// IPAddress carries an asio address and two std::string members, which
+  /// makes every copy allocate.  IPEndPoint holds the same information in 32
+  /// bytes that can be copied with memcpy, hashed without touching the heap
+  /// and compared with a few integer operations.  The external address and
+  /// alias are stored as ids into a process-wide intern table.
+  ///
+  /// IPv4 addresses occupy the first four bytes of address in network order
+  /// and the remaining bytes are zero.
+{
+  enum Family
+  {
+    Unspecified = 0,
+    V4 = 4,
+    V6 = 6
+  };
+
+  enum Flags
+  {
+    Virtual = 0x01
+  };
+
+  OSS::UInt8 address[16];
+  OSS::UInt32 scopeId;
+  OSS::UInt16 port;
+  OSS::UInt8 family;
+  OSS::UInt8 protocol;
+    /// IPAddress::Protocol value
+  OSS::UInt16 externalId;
+    /// Interned external address.  Zero means none.
+  OSS::UInt16 aliasId;
+    /// Interned alias.  Zero means none.
+  OSS::UInt8 flags;
+  OSS::UInt8 cidr;
+
+  IPEndPoint();
+    /// Creates an unspecified endpoint with every field zeroed
+
+  void clear();
+
+  bool isValid() const;
+    /// Returns true if the family is V4 or V6
+
+  bool isV4() const;
+
+  bool isV6() const;
+
+  bool isVirtual() const;
+
+  std::size_t hash() const;
+    /// Hash of the address, scope, port, family and protocol
+
+  bool operator == (const IPEndPoint& endpoint) const;
+    /// Compares the same fields as hash().  Interned names, flags and the
+    /// CIDR prefix are not part of the identity of an endpoint.
+
+  bool operator != (const IPEndPoint& endpoint) const;
+
+  bool operator < (const IPEndPoint& endpoint) const;
+
+  const std::string& externalAddress() const;
+    /// Returns the interned external address or an empty string
+
+  const std::string& alias() const;
+    /// Returns the interned alias or an empty string
+
+  static OSS::UInt16 intern(const std::string& value);
+    /// Returns the id of value in the intern table, adding it if needed.
+    /// The empty string is always id 0.  Interned strings are never
+    /// released so this is meant for the small set of configured listener
+    /// names and external addresses, not for per-packet data.  Returns 0
+    /// once the table is full.  Neither lookups nor inserts take a lock.
+
+  static const std::string& internedString(OSS::UInt16 id);
+    /// Returns the string for an id returned by intern().  Lookups do not
+    /// take a lock.
+};
+
+BOOST_STATIC_ASSERT(sizeof(IPEndPoint) == 32);
+
+//
+// Inlines
+//
+
+inline IPEndPoint::IPEndPoint()
+{
+  clear();
+}
+
+inline void IPEndPoint::clear()
+{
+  std::memset(this, 0, sizeof(IPEndPoint));
+}
+
+inline bool IPEndPoint::isValid() const
+{
+  return family == V4 || family == V6;
+}
+
+inline bool IPEndPoint::isV4() const
+{
+  return family == V4;
+}
+
+inline bool IPEndPoint::isV6() const
+{
+  return family == V6;
+}
+
+inline bool IPEndPoint::isVirtual() const
+{
+  return (flags & Virtual) != 0;
+}
+
+inline std::size_t IPEndPoint::hash() const
+{
+  OSS::UInt64 high;
+  OSS::UInt64 low;
+  std::memcpy(&high, address, sizeof(high));
+  std::memcpy(&low, address + sizeof(high), sizeof(low));
+
+  OSS::UInt64 h = high ^ (low * 0x9e3779b97f4a7c15ULL);
+  h ^= ((OSS::UInt64)scopeId << 32) | ((OSS::UInt64)port << 16) |
+    ((OSS::UInt64)family << 8) | protocol;
+
+  //
+  // MurmurHash3 finalizer
+  //
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return (std::size_t)h;
+}
+
+inline bool IPEndPoint::operator == (const IPEndPoint& endpoint) const
+{
+  return port == endpoint.port &&
+    family == endpoint.family &&
+    protocol == endpoint.protocol &&
+    scopeId == endpoint.scopeId &&
+    std::memcmp(address, endpoint.address, sizeof(address)) == 0;
+}
+
+inline bool IPEndPoint::operator != (const IPEndPoint& endpoint) const
+{
+  return !(*this == endpoint);
+}
+
+inline bool IPEndPoint::operator < (const IPEndPoint& endpoint) const
+{
+  if (family != endpoint.family)
+    return family < endpoint.family;
+  int cmp = std::memcmp(address, endpoint.address, sizeof(address));
+  if (cmp != 0)
+    return cmp < 0;
+  if (scopeId != endpoint.scopeId)
+    return scopeId < endpoint.scopeId;
+  if (port != endpoint.port)
+    return port < endpoint.port;
+  return protocol < endpoint.protocol;
+}
+
+inline const std::string& IPEndPoint::externalAddress() const
+{
+  return internedString(externalId);
+}
+
+inline const std::string& IPEndPoint::alias() const
+{
+  return internedString(aliasId);
+}
+
+inline std::size_t hash_value(const IPEndPoint& endpoint)
+  /// Allows IPEndPoint to be used as a boost::unordered_map key
+{
+  return endpoint.hash();
+}
+
+
+} } // OSS::Net
+
+#endif // OSS_IPENDPOINT_H_INCLUDED
@@ -0,0 +1,123 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef OSS_REDISASYNCWRITER_H_INCLUDED
+#define OSS_REDISASYNCWRITER_H_INCLUDED
+
+#include "OSS/build.h"
+
+#if ENABLE_FEATURE_REDIS
+#if OSS_HAVE_HIREDIS
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread.hpp>
+#include <boost/atomic.hpp>
+#include "OSS/Persistent/RedisClient.h"
+
+
+namespace OSS {
+
+namespace Persistent {
+
+
+class RedisAsyncWriter : boost::noncopyable
+  /// Fire-and-forget write path for a single redis server.
+  ///
+  /// Callers queue commands and return at once.  A background thread owns a
+  /// dedicated connection and each time it wakes up sends everything queued
+  /// since its previous round as one pipeline, so a round trip is paid per
+  /// batch instead of per command and never on the caller's thread.
+  /// Commands are applied in the order they were queued.  A batch that
+  /// fails to reach the server is dropped and counted, not retried.
+{
+public:
+  typedef RedisClient::Command Command;
+  typedef RedisClient::Commands Commands;
+
+  struct Metrics
+  {
+    Metrics();
+    OSS::UInt64 enqueued;
+    OSS::UInt64 written;
+    OSS::UInt64 dropped;
+    OSS::UInt64 failed;
+    OSS::UInt64 batches;
+  };
+
+  RedisAsyncWriter(const std::string& tcpHost, int tcpPort, std::size_t maxQueueSize = 65536, std::size_t maxBatchSize = 512);
+
+  ~RedisAsyncWriter();
+
+  bool start(const std::string& password = "", int db = 0, bool transaction = false);
+    /// Start the writer thread.  With transaction set every batch is
+    /// wrapped in MULTI/EXEC.  A server that is down at start is retried by
+    /// the writer thread on the next batch.
+
+  void stop();
+    /// Send what is still queued and join the writer thread
+
+  bool enqueue(const Command& command);
+    /// Queue a command.  Returns false if the writer is not running or the
+    /// queue is full, in which case the command is dropped.
+
+  bool set(const std::string& key, const std::string& value, int expires = -1);
+
+  bool hset(const std::string& key, const std::string& name, const std::string& value);
+
+  bool expire(const std::string& key, int seconds);
+
+  bool del(const std::string& key);
+
+  std::size_t getQueueSize() const;
+
+  Metrics getMetrics() const;
+
+private:
+  void run();
+  void flush(Commands& batch);
+
+  RedisClient _client;
+  std::string _password;
+  int _db;
+  bool _transaction;
+  std::size_t _maxQueueSize;
+  std::size_t _maxBatchSize;
+  Commands _queue;
+  mutable boost::mutex _queueMutex;
+  boost::condition_variable _wakeup;
+  boost::thread* _pWriterThread;
+  bool _isTerminating;
+  boost::atomic<OSS::UInt64> _enqueued;
+  boost::atomic<OSS::UInt64> _written;
+  boost::atomic<OSS::UInt64> _dropped;
+  boost::atomic<OSS::UInt64> _failed;
+  boost::atomic<OSS::UInt64> _batches;
+  OSS::UInt64 _lastReportedDrops;
+};
+
+
+} } // OSS::Persistent
+
+
+#endif // OSS_HAVE_HIREDIS
+
+#endif // ENABLE_FEATURE_REDIS
+
+#endif // OSS_REDISASYNCWRITER_H_INCLUDED
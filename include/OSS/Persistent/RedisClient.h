@@ -35,6 +35,7 @@
 #include "OSS/JSON/elements.h"
 #include "OSS/UTL/CoreUtils.h"
 #include <map>
+#include <vector>
 
 
 namespace OSS {
@@ -61,6 +62,17 @@ public:
     UNIX
   };
 
+  typedef std::vector<std::string> Command;
+  typedef std::vector<Command> Commands;
+
+  enum
+  {
+    SCAN_COUNT = 1000,
+      /// Keys requested per SCAN round trip
+    PIPELINE_BATCH_SIZE = 256
+      /// Commands sent per pipeline by getAll()
+  };
+
 protected:
   mutable mutex _mutex;
   redisContext* _context;
@@ -105,6 +117,10 @@ protected:
   std::vector<std::string> getReplyStringArray(const std::vector<std::string>& args) const;
 
   std::string getStatusString(const std::vector<std::string>& args) const;
+
+  bool executePipeline(const Commands& commands, bool transaction, std::vector<std::string>* replies);
+
+  bool sendPipeline(const Commands& commands, std::size_t& next, bool transaction, std::vector<std::string>* replies);
   
 public:
   void execute(const std::vector<std::string>& args, std::ostream& strm) const;
@@ -140,6 +156,24 @@ public:
   bool hmget(const std::string& key, const std::vector<std::string>& fields, std::vector<std::string>& value) const;
 
   bool getKeys(const std::string& pattern, std::vector<std::string>& keys);
+    /// Collect the keys matching pattern.  Uses SCAN so the server is never
+    /// blocked walking the whole keyspace in one go.
+
+  bool scan(const std::string& pattern, std::vector<std::string>& keys, std::size_t count = SCAN_COUNT) const;
+    /// Iterate the keyspace with SCAN, asking for count keys per round trip.
+    /// Keys reported more than once by the server are returned once.
+
+  bool pipeline(const Commands& commands, bool transaction = false);
+    /// Send every command in one round trip and read the replies back in
+    /// order.  With transaction set the batch is wrapped in MULTI/EXEC so
+    /// other clients never see it half applied.  Returns false if the
+    /// connection failed or any command replied with an error.  After a
+    /// dropped connection only the commands that had no reply yet are sent
+    /// again, and a transaction is not retried at all.
+
+  bool pipeline(const Commands& commands, std::vector<std::string>& replies, bool transaction = false);
+    /// Same as above but also returns one string per command.  Nil and
+    /// non-scalar replies come back as empty strings.
 
   bool del(const std::string& key);
 
@@ -159,15 +193,24 @@ public:
   
 };
 
+class RedisAsyncWriter;
+
 class RedisBroadcastClient
 {
 public:
   typedef std::map<std::string, RedisClient*> Pool;
+  typedef std::map<std::string, RedisAsyncWriter*> Writers;
 
   RedisBroadcastClient();
 
   ~RedisBroadcastClient();
 
+  void setAsyncWrites(bool asyncWrites, bool transaction = false);
+    /// Route set, hset and del through a RedisAsyncWriter per server instead
+    /// of waiting for the reply on the calling thread.  Applies to servers
+    /// added by later calls to connect().  Reads keep using the synchronous
+    /// clients, so a get() issued right after a set() may not observe it.
+
   bool connect(const std::string& tcpHost, int tcpPort, const std::string& password = "", int db = 0, bool allowReconnect = true);
 
   void disconnect();
@@ -190,7 +233,10 @@ public:
   
 protected:
   Pool _pool;
+  Writers _writers;
   RedisClient* _defaultClient;
+  bool _asyncWrites;
+  bool _asyncTransaction;
 };
 
 
@@ -0,0 +1,121 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef OSS_RTPPORTALLOCATOR_H_INCLUDED
+#define OSS_RTPPORTALLOCATOR_H_INCLUDED
+
+#include "OSS/build.h"
+#if ENABLE_FEATURE_RTP
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/tss.hpp>
+#include "OSS/OSS.h"
+
+
+namespace OSS {
+namespace RTP {
+
+
+class OSS_API RTPPortAllocator : boost::noncopyable
+  /// Lock-free allocator for RTP/RTCP port pairs.
+  ///
+  /// Every even port in the range is a bit in a free-list bitmap.  Threads
+  /// claim free ports a word at a time with a compare-and-swap and keep
+  /// them in a small thread-local pool, so allocate() is usually a pop from
+  /// that pool and never takes a lock.  A port is only handed out again
+  /// after it has been released, so live sessions never collide with new
+  /// ones once the range wraps.
+  ///
+  /// Pools are sized from the range so a small range is not parked in a
+  /// few idle threads, and once the free list is empty allocate() takes
+  /// ports from the pools of other threads before giving up.
+  ///
+  /// Released ports are not reused right away.  They cool down in one of
+  /// three bitmaps that rotate on every call to recycle(), which gives late
+  /// packets for an ended call at least one recycle interval to drain
+  /// before the port is bound by another session.
+  ///
+  /// Thread pools hold a reference to the shared state, so threads may
+  /// exit after the allocator itself is gone.
+{
+public:
+  enum
+  {
+    THREAD_POOL_SIZE = 16
+      /// Most ports a thread claims from the shared bitmap at a time
+  };
+
+  RTPPortAllocator();
+
+  ~RTPPortAllocator();
+
+  bool open(unsigned short portBase, unsigned short portMax);
+    /// Add every even port pair in [portBase, portMax] to the free list.
+    /// Must be called once, before any other thread uses the allocator.
+
+  bool isOpen() const;
+
+  unsigned short allocate();
+    /// Return a free data port.  The control port is the data port + 1.
+    /// Returns 0 if every port in the range is in use or cooling down.
+
+  void release(unsigned short port);
+    /// Return a data port obtained from allocate() or reserve().  The port
+    /// becomes available after two calls to recycle().
+
+  bool reserve(unsigned short port);
+    /// Remove a specific data port from the free list.  Used when sessions
+    /// restored after a restart rebind the ports they had.  Returns false if
+    /// the port was not free.
+
+  void recycle();
+    /// Make ports released two rotations ago available again.  Called from
+    /// a single thread, normally the house keeping timer.
+
+  std::size_t available() const;
+    /// Number of ports in the shared free list.  Ports held by thread pools
+    /// and ports cooling down are not counted.
+
+  unsigned short getPortBase() const;
+
+  unsigned short getPortMax() const;
+
+private:
+  struct State;
+  struct ThreadPool;
+
+  enum
+  {
+    COOLING_BITMAPS = 3
+  };
+
+  static void releaseThreadPool(ThreadPool* pPool);
+
+  boost::shared_ptr<State> _pState;
+  boost::thread_specific_ptr<ThreadPool> _threadPool;
+};
+
+
+} } // OSS::RTP
+
+#endif // ENABLE_FEATURE_RTP
+
+#endif // OSS_RTPPORTALLOCATOR_H_INCLUDED
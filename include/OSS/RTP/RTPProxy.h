@@ -29,6 +29,7 @@
 #include <boost/shared_ptr.hpp>
 #include <boost/thread.hpp>
 #include <boost/enable_shared_from_this.hpp>
+#include <boost/function.hpp>
 
 #include "OSS/UTL/Exception.h"
 #include "OSS/Net/Net.h"
@@ -36,6 +37,9 @@
 #include "OSS/SIP/SIP.h"
 #include "OSS/RTP/RTPResizer.h"
 #include "OSS/RTP/RTPPacket.h"
+#if ENABLE_FEATURE_STUN
+#include "OSS/STUN/STUNBindingResponder.h"
+#endif
 
 // Note: Always define this for now.
 // We encounter crashes in I/O because
@@ -98,6 +102,19 @@ public:
     Control
   };
 
+  enum PacketClass
+    /// RFC 7983 classification based on the first byte of a datagram
+  {
+    PACKET_STUN,
+    PACKET_ZRTP,
+    PACKET_DTLS,
+    PACKET_TURN_CHANNEL,
+    PACKET_RTP,
+    PACKET_UNKNOWN
+  };
+
+  typedef boost::function<bool(int /*legIndex*/, const char* /*packet*/, std::size_t /*size*/, const boost::asio::ip::udp::endpoint& /*source*/)> DTLSHandler;
+
   RTPProxy(Type type, RTPProxyManager* pManager, RTPProxySession* pSession, const std::string& identifier, bool isXORDisabled = false);
     /// Creates a new RTPProxy
 
@@ -179,6 +196,21 @@ public:
 
   Type& type();
 
+  void setICECredentials(int legIndex, const std::string& localUserFragment, const std::string& password);
+    /// Answer STUN binding requests arriving on legIndex using the ICE
+    /// credentials the peer on that leg was given in SDP.  Connectivity
+    /// checks are answered in the read handler and are not relayed.
+    /// An empty user fragment disables the responder and STUN packets
+    /// are relayed to the other leg like any other datagram.
+
+  void setDTLSHandler(const DTLSHandler& handler);
+    /// Route DTLS records to handler instead of relaying them.  If the
+    /// handler returns false the record is relayed.  Set this before start().
+
+  static PacketClass classifyPacket(const char* packet, std::size_t size);
+    /// Classify a datagram using the first byte demultiplexing rules
+    /// of RFC 7983
+
   static bool validateBuffer(boost::array<char, RTP_PACKET_BUFFER_SIZE>& buff, int size);
 protected:
   void handleLeg1FrameRead(
@@ -201,6 +233,20 @@ protected:
     /// Process resizer buffers for leg1 and leg2 simultaneously
 
   void onResizerDequeue(RTPResizer& resizer, OSS::RTP::RTPPacket& packet);
+
+  bool handleNonMediaPacket(int legIndex, std::size_t size);
+    /// Answer STUN and route DTLS received on legIndex.  Returns true if
+    /// the packet was consumed and must not be relayed.  Legs that may
+    /// carry XOR obfuscated media are never demultiplexed.
+
+  bool hasICECredentials(int legIndex);
+    /// Returns true if ICE credentials were set for legIndex
+
+  void readLeg1();
+    /// Queue the next read on the leg 1 socket
+
+  void readLeg2();
+    /// Queue the next read on the leg 2 socket
   
   const std::string& logId() const;
 private:
@@ -217,6 +263,8 @@ private:
   boost::asio::ip::udp::endpoint _senderEndPointLeg2;
   boost::asio::ip::udp::endpoint _lastSenderEndPointLeg1;
   boost::asio::ip::udp::endpoint _lastSenderEndPointLeg2;
+  boost::asio::ip::udp::endpoint* _pLeg1ReadEndPoint;
+  boost::asio::ip::udp::endpoint* _pLeg2ReadEndPoint;
   boost::array<char, RTP_PACKET_BUFFER_SIZE> _leg1Buffer;
   boost::array<char, RTP_PACKET_BUFFER_SIZE> _leg2Buffer;
   RTPResizer _leg1Resizer;
@@ -240,6 +288,11 @@ private:
   std::string _logId;
   bool _verbose;
   OSS::UInt64 _timeStamp;
+#if ENABLE_FEATURE_STUN
+  boost::shared_ptr<OSS::STUN::STUNBindingResponder> _pLeg1ICEResponder;
+  boost::shared_ptr<OSS::STUN::STUNBindingResponder> _pLeg2ICEResponder;
+#endif
+  DTLSHandler _dtlsHandler;
   friend class RTPProxySession;
   friend class RTPResizer;
 };
@@ -311,6 +364,29 @@ inline void RTPProxy::handleLeg2FrameWrite(const boost::system::error_code& e)
 {
 }
 
+inline void RTPProxy::setDTLSHandler(const DTLSHandler& handler)
+{
+  _dtlsHandler = handler;
+}
+
+inline RTPProxy::PacketClass RTPProxy::classifyPacket(const char* packet, std::size_t size)
+{
+  if (!size)
+    return PACKET_UNKNOWN;
+  unsigned char firstByte = (unsigned char)packet[0];
+  if (firstByte <= 3)
+    return PACKET_STUN;
+  else if (firstByte >= 128 && firstByte <= 191)
+    return PACKET_RTP;
+  else if (firstByte >= 20 && firstByte <= 63)
+    return PACKET_DTLS;
+  else if (firstByte >= 16 && firstByte <= 19)
+    return PACKET_ZRTP;
+  else if (firstByte >= 64 && firstByte <= 79)
+    return PACKET_TURN_CHANNEL;
+  return PACKET_UNKNOWN;
+}
+
 inline bool& RTPProxy::isPooled()
 {
   return _isPooled;
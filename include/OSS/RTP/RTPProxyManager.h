@@ -30,6 +30,8 @@
 #include "OSS/UTL/Thread.h"
 #include "OSS/RTP/RTPProxySession.h"
 #include "OSS/RTP/RTPProxyRecord.h"
+#include "OSS/RTP/RTPSessionTable.h"
+#include "OSS/RTP/RTPPortAllocator.h"
 #include "OSS/RTP/RTPProxy.h"
 #include "OSS/Persistent/RedisClient.h"
 
@@ -104,6 +106,19 @@ public:
     RTPProxy::Attributes& rtpAttribute);
     /// Process the incoming SDP
 
+  void handleSDP(
+    const std::string& logId,
+    const std::string& sessionId,
+    const OSS::Net::IPEndPoint& sentBy,
+    const OSS::Net::IPEndPoint& packetSourceIP,
+    const OSS::Net::IPEndPoint& packetLocalInterface,
+    const OSS::Net::IPEndPoint& route,
+    const OSS::Net::IPEndPoint& routeLocalInterface,
+    RTPProxySession::RequestType requestType,
+    std::string& sdp,
+    RTPProxy::Attributes& rtpAttribute);
+    /// Process the incoming SDP using packed endpoints
+
   void handleSDP(const std::string& method,
     const json::Object& args,
     json::Object& response);
@@ -132,7 +147,21 @@ public:
     /// Set the current maximum port for UDP
 
   unsigned short getNextAvailablePortTuple();
-    /// Return the next available port tuple for data and control listeners
+    /// Return the next available port tuple for data and control listeners.
+    /// Returns 0 if the range is exhausted.  The port must be handed back
+    /// with releasePortTuple() once its sockets are closed.
+
+  void releasePortTuple(unsigned short port);
+    /// Return a port obtained from getNextAvailablePortTuple() or
+    /// reservePortTuple().  It is not reused until it has cooled down for
+    /// at least one house keeping interval.
+
+  bool reservePortTuple(unsigned short port);
+    /// Mark a specific port tuple as in use.  Used by restored sessions that
+    /// rebind the ports they had before a restart.
+
+  RTPPortAllocator& portAllocator();
+    /// Return the port allocator
 
   void removeSession(const std::string& sessionId);
     /// closes and deletes the rtp session
@@ -193,6 +222,18 @@ public:
   std::size_t getSessionCount() const;
     /// Return the total number of active session sessions
 
+  bool openSessionTable(const boost::filesystem::path& file, std::size_t capacity = RTPSessionTable::DEFAULT_CAPACITY);
+    /// Keep session state in a memory-mapped table stored in file.  Once
+    /// open, sessions are written to the table instead of individual state
+    /// files and recycleState() restores them from it.  Call this before
+    /// recycleState().
+
+  RTPSessionTable& sessionTable();
+    /// Return the session table.  Only valid if hasSessionTable() is true.
+
+  bool hasSessionTable() const;
+    /// Returns true if openSessionTable() succeeded
+
   bool persistStateFiles() const;
     /// If this flag is true, state files for RTP will be stored in the diretory
     /// specified by _rtpStateDirectory.  The default value is false and is
@@ -207,17 +248,25 @@ public:
   bool enableHairpins() const;
   bool& enableHairpins();
 private:
+  void openPortAllocator();
+    /// Build the port free list from the configured UDP range
+
+  void recycleSessionTable();
+    /// Restore every session held by the session table
+
   boost::asio::io_service _ioService;
+  RTPSessionTable _sessionTable;
+    /// Declared before the session list so sessions destroyed with the
+    /// manager never see a destroyed table
   mutable OSS::mutex_critic_sec _sessionListMutex;
   mutable RTPProxySessionList _sessionList;
   int _houseKeepingInterval;
   boost::asio::deadline_timer _houseKeepingTimer;
   unsigned short _rtpProxyUDPPortBase;
   unsigned short _rtpProxyUDPPortMax;
-  unsigned short _rtpProxyUDPPortCurrent;
   unsigned int _rtpProxyThreadCount;
   boost::filesystem::path _rtpStateDirectory;
-  mutable OSS::mutex_critic_sec _csPortMutex;
+  RTPPortAllocator _portAllocator;
   std::vector<boost::shared_ptr<boost::thread> > _threadPool;
   int _readTimeout;
   unsigned _rtpSessionMax;
@@ -282,6 +331,11 @@ inline void RTPProxyManager::setUdpPortMax(unsigned short portMax)
 }
 
 
+inline RTPPortAllocator& RTPProxyManager::portAllocator()
+{
+  return _portAllocator;
+}
+
 inline unsigned& RTPProxyManager::rtpSessionMax()
 {
   return _rtpSessionMax;
@@ -315,6 +369,16 @@ inline std::size_t RTPProxyManager::getSessionCount() const
   return _sessionList.size();
 }
 
+inline RTPSessionTable& RTPProxyManager::sessionTable()
+{
+  return _sessionTable;
+}
+
+inline bool RTPProxyManager::hasSessionTable() const
+{
+  return _sessionTable.isOpen();
+}
+
 inline bool RTPProxyManager::persistStateFiles() const
 {
   return _persistStateFiles;
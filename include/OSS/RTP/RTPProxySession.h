@@ -30,6 +30,8 @@
 namespace OSS {
 namespace RTP {
 
+struct RTPProxyRecord;
+
 class OSS_API RTPProxySession
 {
 public:
@@ -86,6 +88,17 @@ public:
     /// This will throw and RTPProxyException if
     /// the SDP cannot be processed
 
+  void handleSDP(
+    const OSS::Net::IPEndPoint& sentBy,
+    const OSS::Net::IPEndPoint& packetSourceIP,
+    const OSS::Net::IPEndPoint& packetLocalInterface,
+    const OSS::Net::IPEndPoint& route,
+    const OSS::Net::IPEndPoint& routeLocalInterface,
+    RequestType requestType,
+    std::string& sdp,
+    RTPProxy::Attributes& rtpAttribute);
+    /// handles the incoming SDP offer or answer using packed endpoints
+
   RTPProxyManager*& manager();
     /// Returns a direct pointer to the manager
 
@@ -130,6 +143,9 @@ public:
     /// manager to reconstruct during retarts
 #endif
 
+  void toRecord(RTPProxyRecord& record);
+    /// Copy the session state that is needed to reconstruct it into record
+
 #if ENABLE_FEATURE_CONFIG
   static RTPProxySession::Ptr reconstructFromStateFile(RTPProxyManager* pManager,
     const boost::filesystem::path& stateFile);
@@ -144,6 +160,11 @@ public:
     /// if the session can't be reconstructed
 #endif
 
+  static RTPProxySession::Ptr reconstructFromRecord(RTPProxyManager* pManager,
+    const RTPProxyRecord& record);
+    /// Reconstruct session-state from a record, re-binding its sockets.
+    /// Returns a null pointer if the session can't be reconstructed
+
   std::string& from();
     /// Return the from header of the transaction that created the session
 
@@ -168,6 +189,9 @@ public:
   static State state_transition(State currentState, RequestType requestType);
     // returns the next state based on the current request-type
 protected:
+  void reservePorts();
+    /// Claim the ports rebound by a restored session from the manager
+
   void handleStateIdle(
     const OSS::Net::IPAddress& sentBy,
     const OSS::Net::IPAddress& packetSourceIP,
@@ -51,7 +51,11 @@ public:
     /// Start polling socket events
 
   void stop();
-    /// Stop Polling socket events
+    /// Stop Polling socket events and return the ports to the manager
+
+  void reservePorts(unsigned short leg1DataPort, unsigned short leg2DataPort);
+    /// Take ownership of ports bound outside of open(), such as by a session
+    /// restored after a restart, so stop() returns them to the manager
 
   RTPProxyManager*& manager();
     /// Returns a direct pointer to the manager
@@ -67,12 +71,20 @@ public:
 
   void setResizerSamples(int leg1, int leg2);
     /// Enable resizing of RTP packets
+
+  void setICECredentials(int legIndex, const std::string& localUserFragment, const std::string& password);
+    /// Answer ICE connectivity checks arriving on legIndex for both
+    /// the data and control sockets
 protected:
+  void releasePorts();
+
   RTPProxy::Ptr _data;
   RTPProxy::Ptr _control;
   std::string _identifier;
   RTPProxyManager* _pManager;
   RTPProxySession* _pSession;
+  unsigned short _leg1DataPort;
+  unsigned short _leg2DataPort;
 };
 
 //
@@ -0,0 +1,125 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef OSS_RTPSESSIONTABLE_H_INCLUDED
+#define OSS_RTPSESSIONTABLE_H_INCLUDED
+
+#include "OSS/build.h"
+#if ENABLE_FEATURE_RTP
+
+#include <string>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/filesystem.hpp>
+#include "OSS/OSS.h"
+#include "OSS/UTL/Thread.h"
+#include "OSS/RTP/RTPProxyRecord.h"
+
+
+namespace OSS {
+namespace RTP {
+
+
+class OSS_API RTPSessionTable : boost::noncopyable
+  /// Fixed-layout table of RTP session state in a memory-mapped file.
+  ///
+  /// Each session owns one page-sized slot holding its identifiers, state
+  /// flags, the local port tuples and latched sender endpoints of every
+  /// proxy, the XOR flags and the last SDP seen in an ACK together with
+  /// its hash.  Updating a session is a copy into its slot, with no
+  /// serialization and no system call.  Because the mapping is shared
+  /// with the kernel page cache, the table outlives a crashed or restarted
+  /// process and a new process only has to re-attach and walk the slots
+  /// to rebuild every session.
+  ///
+  /// A slot is bracketed by a sequence number that is odd while it is being
+  /// written.  A slot left odd by a crash is discarded on open().
+{
+public:
+  enum
+  {
+    SLOT_SIZE = 4096,
+    DEFAULT_CAPACITY = 16384
+  };
+
+  RTPSessionTable();
+
+  ~RTPSessionTable();
+
+  bool open(const boost::filesystem::path& file, std::size_t capacity = DEFAULT_CAPACITY);
+    /// Map the table stored in file, creating it if needed, and index the
+    /// sessions it already holds.  An existing table is grown to capacity
+    /// but never shrunk.
+
+  void close();
+
+  bool isOpen() const;
+
+  bool store(const RTPProxyRecord& record);
+    /// Insert or overwrite the slot for record.identifier.  Returns false if
+    /// the table is full or the identifier does not fit in a slot.
+
+  bool remove(const std::string& identifier);
+    /// Release the slot of a session.  Returns false if it is not stored.
+
+  std::size_t load(std::vector<RTPProxyRecord>& records) const;
+    /// Append every stored session to records and return the count
+
+  std::size_t size() const;
+    /// Number of stored sessions
+
+  std::size_t capacity() const;
+    /// Number of slots
+
+  const boost::filesystem::path& getFile() const;
+
+private:
+  struct Header;
+  struct Slot;
+  typedef boost::unordered_map<std::string, OSS::UInt32> Index;
+
+  Slot* slot(OSS::UInt32 index) const;
+
+  boost::filesystem::path _file;
+  char* _pMap;
+  std::size_t _mapSize;
+  Header* _pHeader;
+  Index _index;
+  std::vector<OSS::UInt32> _freeSlots;
+  mutable OSS::mutex_critic_sec _mutex;
+};
+
+
+//
+// Inlines
+//
+
+inline const boost::filesystem::path& RTPSessionTable::getFile() const
+{
+  return _file;
+}
+
+
+} } // OSS::RTP
+
+#endif // ENABLE_FEATURE_RTP
+
+#endif // OSS_RTPSESSIONTABLE_H_INCLUDED
@@ -0,0 +1,198 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef SIP_SIPB2BAdmissionControl_INCLUDED
+#define SIP_SIPB2BAdmissionControl_INCLUDED
+
+#include "OSS/build.h"
+#if ENABLE_FEATURE_B2BUA
+
+#include <boost/noncopyable.hpp>
+#include <boost/atomic.hpp>
+#include <boost/asio.hpp>
+
+#include "OSS/OSS.h"
+#include "OSS/UTL/Thread.h"
+#include "OSS/SIP/SIPMessage.h"
+#include "OSS/SIP/SIPTransportSession.h"
+
+
+namespace OSS {
+namespace SIP {
+
+class SIPStack;
+
+namespace B2BUA {
+
+
+class OSS_API SIPB2BAdmissionControl : boost::noncopyable
+  /// Overload control for the B2BUA.
+  ///
+  /// The controller samples three load signals: the depth of the transaction
+  /// thread pool queue, the number of server transactions, and the lag of the
+  /// SIP timer event loop.  From them it derives a load level.
+  ///
+  ///   LEVEL_NORMAL     - every request is admitted
+  ///   LEVEL_OVERLOADED - new dialog-creating requests (INVITE, SUBSCRIBE,
+  ///                      REFER without a To tag) are rejected
+  ///   LEVEL_CRITICAL   - every out-of-dialog request is rejected
+  ///
+  /// In-dialog requests, BYE, CANCEL, ACK and PRACK are always admitted so
+  /// that calls already in progress can complete and release resources.
+  /// Rejected requests get a 503 with a Retry-After header, sent statelessly
+  /// by SIPFSMDispatch before a server transaction is created.
+  ///
+  /// The decision is taken before the request is parsed.  The method is read
+  /// from the start line and the To header is scanned for a tag.  Only a
+  /// rejected request is parsed, to build the 503.
+  ///
+  /// A level is left only when every signal falls below its threshold scaled
+  /// by the hysteresis factor.
+{
+public:
+  enum Level
+  {
+    LEVEL_NORMAL,
+    LEVEL_OVERLOADED,
+    LEVEL_CRITICAL
+  };
+
+  struct Thresholds
+  {
+    Thresholds();
+    double queueOverloaded; /// Fraction of the thread pool queue capacity (default 0.5)
+    double queueCritical; /// Fraction of the thread pool queue capacity (default 0.9)
+    std::size_t transactionsOverloaded; /// Server transactions (0 disables the check)
+    std::size_t transactionsCritical; /// Server transactions (0 disables the check)
+    unsigned long lagOverloaded; /// Event loop lag in milliseconds (default 100)
+    unsigned long lagCritical; /// Event loop lag in milliseconds (default 500)
+    double hysteresis; /// Scale applied to thresholds when leaving a level (default 0.8)
+    unsigned int retryAfter; /// Retry-After value in seconds (default 5)
+  };
+
+  struct Metrics
+  {
+    Level level;
+    OSS::UInt64 admitted;
+    OSS::UInt64 shed;
+    std::size_t queueDepth;
+    std::size_t queueCapacity;
+    std::size_t transactions;
+    unsigned long lag;
+  };
+
+  SIPB2BAdmissionControl(OSS::thread_pool& threadPool, SIPStack& stack);
+    /// Creates the controller.  The event loop probe is started by start().
+
+  ~SIPB2BAdmissionControl();
+    /// Stops the event loop probe
+
+  void start();
+    /// Start sampling the SIP timer event loop
+
+  void stop();
+    /// Stop sampling the SIP timer event loop
+
+  void setEnabled(bool enabled);
+    /// Enable or disable shedding.  Admission counters are maintained either way.
+
+  bool isEnabled() const;
+    /// Returns true if shedding is enabled
+
+  void setThresholds(const Thresholds& thresholds);
+    /// Set the overload thresholds
+
+  Thresholds getThresholds() const;
+    /// Returns the overload thresholds
+
+  SIPMessage::Ptr admit(const SIPMessage::Ptr& pRequest, const SIPTransportSession::Ptr& pTransport);
+    /// Returns a 503 response if the request must be rejected,
+    /// or a null pointer if it is admitted.  pRequest may be unparsed.
+    /// It is parsed only when a response is returned.
+
+  Level getLevel() const;
+    /// Returns the current load level
+
+  Metrics getMetrics() const;
+    /// Returns the admission counters and the last sampled load signals
+
+  static bool peekRequest(const std::string& data, std::string& method, bool& inDialog);
+    /// Reads the method from the start line of an unparsed message and
+    /// sets inDialog if the To header carries a tag.  Returns false for
+    /// responses and for data that does not look like a request.
+
+  static bool isPriorityRequest(const std::string& method, bool inDialog);
+    /// Returns true for requests that are never shed
+
+  static bool isDialogCreatingRequest(const std::string& method, bool inDialog);
+    /// Returns true for INVITE, SUBSCRIBE and REFER without a To tag
+
+  static bool shouldReject(Level level, const std::string& method, bool inDialog);
+    /// Returns true if a request must be shed at the given load level
+
+  static Level computeSignalLevel(double value, double overloaded, double critical, Level current, double hysteresis);
+    /// Returns the level a single load signal maps to.  Thresholds are scaled
+    /// by hysteresis while current is at or above their level.  A threshold
+    /// of zero disables it.
+
+private:
+  Level computeLevel(Level current) const;
+  void onProbeTimer(const boost::system::error_code& e);
+  void scheduleProbe();
+
+  OSS::thread_pool& _threadPool;
+  SIPStack& _stack;
+  mutable OSS::mutex_critic_sec _thresholdsMutex;
+  Thresholds _thresholds;
+  boost::atomic<bool> _enabled;
+  boost::atomic<int> _level;
+  boost::atomic<unsigned long> _lag;
+  boost::atomic<OSS::UInt64> _admitted;
+  boost::atomic<OSS::UInt64> _shed;
+  boost::asio::deadline_timer _probeTimer;
+  boost::posix_time::ptime _probeExpected;
+  bool _probeRunning;
+  bool _probePrimed;
+};
+
+//
+// Inlines
+//
+
+inline void SIPB2BAdmissionControl::setEnabled(bool enabled)
+{
+  _enabled = enabled;
+}
+
+inline bool SIPB2BAdmissionControl::isEnabled() const
+{
+  return _enabled;
+}
+
+inline SIPB2BAdmissionControl::Level SIPB2BAdmissionControl::getLevel() const
+{
+  return static_cast<Level>(_level.load());
+}
+
+
+} } } // OSS::SIP::B2BUA
+
+#endif // ENABLE_FEATURE_B2BUA
+
+#endif // SIP_SIPB2BAdmissionControl_INCLUDED
@@ -0,0 +1,182 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+#ifndef SIPB2BDIALOGCODEC_H
+#define	SIPB2BDIALOGCODEC_H
+
+
+#include "OSS/build.h"
+#if ENABLE_FEATURE_B2BUA
+
+#include <string>
+#include <vector>
+#include <cstring>
+
+#include "OSS/OSS.h"
+#include "OSS/SIP/B2BUA/SIPB2BDialogData.h"
+
+
+namespace OSS {
+namespace SIP {
+namespace B2BUA {
+
+
+struct SIPB2BDialogField
+  /// Non-owning view of a string inside an encoded dialog record.  It is
+  /// only valid while the record buffer is alive.
+{
+  const char* data;
+  std::size_t size;
+
+  SIPB2BDialogField() : data(0), size(0) {}
+
+  bool empty() const;
+  std::string str() const;
+  void assignTo(std::string& value) const;
+  bool operator == (const std::string& value) const;
+};
+
+struct SIPB2BSdpField : SIPB2BDialogField
+  /// SDP body inside an encoded dialog record.  When compressed is set,
+  /// data holds zlib output and originalSize is the length of the SDP.
+{
+  bool compressed;
+  std::size_t originalSize;
+
+  SIPB2BSdpField() : compressed(false), originalSize(0) {}
+
+  bool decode(std::string& sdp) const;
+    /// Copy or inflate the SDP into sdp
+};
+
+struct SIPB2BDialogDataView
+  /// Result of decoding a binary dialog record without copying it
+{
+  struct LegView
+  {
+    SIPB2BDialogField dialogId;
+    SIPB2BDialogField callId;
+    SIPB2BDialogField from;
+    SIPB2BDialogField to;
+    SIPB2BDialogField remoteContact;
+    SIPB2BDialogField localContact;
+    SIPB2BDialogField localRecordRoute;
+    SIPB2BDialogField remoteIp;
+    SIPB2BDialogField transportId;
+    SIPB2BDialogField targetTransport;
+    SIPB2BSdpField localSdp;
+    SIPB2BSdpField remoteSdp;
+    SIPB2BDialogField encryption;
+    std::vector<SIPB2BDialogField> routeSet;
+    bool noRtpProxy;
+    unsigned long localCSeq;
+
+    LegView() : noRtpProxy(false), localCSeq(0) {}
+
+    bool toLegInfo(SIPB2BDialogData::LegInfo& leg) const;
+  };
+
+  unsigned int version;
+  SIPB2BDialogField sessionId;
+  SIPB2BDialogField event;
+  OSS::UInt64 timeStamp;
+  OSS::UInt64 connectTime;
+  OSS::UInt64 disconnectTime;
+  OSS::UInt64 sessionAge;
+  int expires;
+  LegView leg1;
+  LegView leg2;
+
+  SIPB2BDialogDataView();
+
+  bool toDialogData(SIPB2BDialogData& dialog) const;
+    /// Copy the view into an owning SIPB2BDialogData.  Returns false if a
+    /// compressed SDP cannot be inflated.
+};
+
+class SIPB2BDialogCodec
+  /// Versioned binary encoding for SIPB2BDialogData.
+  ///
+  /// A record starts with a NUL byte, the letters "DB", a version byte and
+  /// a flags byte, followed by the fixed-width timestamps and the string
+  /// fields in declaration order.  Every string is prefixed with its length
+  /// as a varint.  The leading NUL lets stores tell binary records apart
+  /// from the JSON written by SIPB2BDialogData::toJsonString(), which stays
+  /// the format for logging and debugging.
+{
+public:
+  enum
+  {
+    VERSION = 1,
+    SDP_COMPRESSION_THRESHOLD = 256
+      /// SDP bodies shorter than this are never compressed
+  };
+
+  static void encode(const SIPB2BDialogData& dialog, std::string& record, bool compressSdp = false);
+    /// Encode dialog into record.  With compressSdp set, SDP bodies that
+    /// zlib makes smaller are stored compressed.
+
+  static bool decode(const char* record, std::size_t size, SIPB2BDialogDataView& view);
+    /// Parse a record without copying any string.  Returns false if the
+    /// record is truncated, malformed or of an unknown version.
+
+  static bool decode(const std::string& record, SIPB2BDialogData& dialog);
+    /// Parse a record into an owning SIPB2BDialogData
+
+  static bool isBinary(const std::string& record);
+    /// Returns true if record carries the binary record signature
+};
+
+//
+// Inlines
+//
+
+inline bool SIPB2BDialogField::empty() const
+{
+  return size == 0;
+}
+
+inline std::string SIPB2BDialogField::str() const
+{
+  return std::string(data, size);
+}
+
+inline void SIPB2BDialogField::assignTo(std::string& value) const
+{
+  value.assign(data, size);
+}
+
+inline bool SIPB2BDialogField::operator == (const std::string& value) const
+{
+  return value.size() == size && (size == 0 || std::memcmp(value.data(), data, size) == 0);
+}
+
+inline bool SIPB2BDialogCodec::isBinary(const std::string& record)
+{
+  return record.size() >= 5 && record[0] == '\0' && record[1] == 'D' && record[2] == 'B';
+}
+
+
+} } } // OSS::SIP::B2BUA
+
+#endif // ENABLE_FEATURE_B2BUA
+
+#endif	// SIPB2BDIALOGCODEC_H
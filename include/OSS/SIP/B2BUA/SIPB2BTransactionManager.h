@@ -41,6 +41,7 @@
 #include "OSS/SIP/B2BUA/SIPB2BTransaction.h"
 #include "OSS/SIP/B2BUA/SIPB2BHandler.h"
 #include "OSS/SIP/B2BUA/SIPB2BUserAgentHandlerList.h"
+#include "OSS/SIP/B2BUA/SIPB2BAdmissionControl.h"
 
 
 namespace OSS {
@@ -372,9 +373,14 @@ public:
   bool isSubscriptionPending(const std::string& callId) const;
   
   int getMaxThreadCount() const;
+
+  SIPB2BAdmissionControl& admissionControl();
+    /// Returns the overload controller.  Use it to set thresholds
+    /// and to read the admitted and shed counters.
   
 private:
   OSS::thread_pool _threadPool;
+  SIPB2BAdmissionControl _admissionControl;
   OSS::mutex_critic_sec _csDialogsMutex;
   bool _useSourceAddressForResponses;
   MessageHandlers _handlers;
@@ -448,6 +454,11 @@ inline int SIPB2BTransactionManager::getMaxThreadCount() const
   return _maxThreadCount;
 }
 
+inline SIPB2BAdmissionControl& SIPB2BTransactionManager::admissionControl()
+{
+  return _admissionControl;
+}
+
 
 } } } // OSS::SIP::B2BUA
 
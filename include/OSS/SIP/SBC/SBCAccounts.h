@@ -27,6 +27,7 @@
 
 #include "OSS/SIP/SBC/SBCWorkSpaceManager.h"
 #include "OSS/SIP/SBC/SBCAccountRecord.h"
+#include "OSS/UTL/ExpireHashMap.h"
 
 
 namespace OSS {
@@ -39,6 +40,16 @@ class SBCAccounts
 public:
   typedef std::map<std::string, SBCAccountRecord> VolatileAccounts;
   typedef std::set<std::string> Realms;
+  typedef OSS::ExpireHashMap<SBCAccountRecord> AccountCache;
+
+  enum
+  {
+    ACCOUNT_CACHE_EXPIRE_MS = 60000
+      /// Accounts read from the workspace are reused for this long.
+      /// During an authentication storm this keeps the workspace out of
+      /// the hot path and the precomputed A1 hash in memory.
+  };
+
   SBCAccounts();
   
   ~SBCAccounts();
@@ -48,11 +59,24 @@ public:
   const SBCWorkSpaceManager::WorkSpace& workspace() const;
   
   bool findAccount(const std::string& identity, SBCAccountRecord& account) const;
+    /// Find the account for identity.  Volatile accounts are searched
+    /// first, then the account cache and finally the workspace.
   
   bool addAccount(SBCAccountRecord& account);
+    /// Store the account in the workspace and refresh the cached copy
+  
+  bool removeAccount(const std::string& identity);
+    /// Delete the account from the workspace and drop the cached copy
   
   bool addVolatileAccount(SBCAccountRecord& account);
   
+  bool removeVolatileAccount(const std::string& identity);
+  
+  void invalidateAccount(const std::string& identity);
+    /// Drop the cached copy of an account.  Call this after the workspace
+    /// record was changed without going through addAccount() or
+    /// removeAccount().
+  
   bool isKnownRealm(const std::string& realm) const;
   
   bool isKnownIdentity(const std::string& identity) const;
@@ -64,6 +88,7 @@ private:
   SBCWorkSpaceManager::WorkSpace _workspace;
   VolatileAccounts _volatileAccounts;
   mutable OSS::mutex_critic_sec _volatileAccountsMutex;
+  mutable AccountCache _accountCache;
   Realms _realms;
   bool _hasDeterminedRealms;
   
@@ -50,6 +50,12 @@ public:
   
   bool isAuthorized(const SIPMessage::Ptr& pRequest, const SBCAccountRecord& record);
 
+  bool isAuthorized(const SIPMessage::Ptr& pRequest, const SBCAccountRecord& record, bool& isStale);
+    /// Verify the digest response.  isStale is set if the response is
+    /// correct but the nonce expired, was replayed or was not issued by
+    /// us.  The client is then challenged with stale=true so it retries
+    /// with the credentials it already has.
+
   SBCAccounts& accounts();
 private:
   SBCAccounts _accounts;
@@ -27,6 +27,7 @@
 #include "OSS/SIP/SBC/SBCWorkSpaceManager.h"
 #include "OSS/SIP/SBC/SBCCDREvent.h"
 #include "OSS/SIP/SBC/SBCCDRRecord.h"
+#include "OSS/SIP/SBC/SBCCDRPipeline.h"
 #include "OSS/UTL/BlockingQueue.h"
 #include "OSS/UTL/LogFile.h"
 #include "OSS/SIP/SBC/SBCChannelLimits.h"
@@ -87,6 +88,9 @@ public:
   
   OSS::UTL::LogFile& logger();
   
+  SBCCDRPipeline& pipeline();
+    /// Asynchronous writer for completed call records
+  
   SBCChannelLimits& channelLimits();
   SBCDomainLimits& domainLimits();
   
@@ -94,6 +98,7 @@ public:
   
 protected:
   void onHandleEvent();
+  void initializePipeline();
   
 private:  
   EventQueue _eventQueue;
@@ -103,6 +108,7 @@ private:
   SBCWorkSpaceManager::WorkSpace _pCDRDb;
   unsigned int _cdrLifeTime;
   OSS::UTL::LogFile _logger;
+  SBCCDRPipeline _pipeline;
   SBCChannelLimits _channelLimits;
   SBCDomainLimits _domainLimits;
 };
@@ -164,6 +170,11 @@ inline OSS::UTL::LogFile& SBCCDRManager::logger()
   return _logger;
 }
 
+inline SBCCDRPipeline& SBCCDRManager::pipeline()
+{
+  return _pipeline;
+}
+
 inline SBCChannelLimits& SBCCDRManager::channelLimits()
 {
   return _channelLimits;
@@ -0,0 +1,187 @@
+// OSS Software Solutions Application Programmer Interface
+// Package: Karoo
+// Author: Joegen E. Baclor - mailto:joegen@ossapp.com
+//
+// Copyright (c) OSS Software Solutions
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "OSS Software Solutions OSS API General License Agreement".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+#ifndef SBCCDRPIPELINE_H_INCLUDED
+#define	SBCCDRPIPELINE_H_INCLUDED
+
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/atomic.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include "OSS/UTL/RingBuffer.h"
+#include "OSS/UTL/LogFile.h"
+#include "OSS/UTL/Thread.h"
+#include "OSS/Persistent/RedisClient.h"
+#include "OSS/ZMQ/ZMQSocket.h"
+
+
+namespace OSS {
+namespace SIP {
+namespace SBC {
+
+
+class SBCCDRSink : boost::noncopyable
+  /// Destination for batches of CDR records.  Sinks are only ever
+  /// called from the pipeline writer thread.
+{
+public:
+  typedef boost::shared_ptr<SBCCDRSink> Ptr;
+  typedef std::vector<std::string> Batch;
+
+  virtual ~SBCCDRSink() {}
+
+  virtual const char* name() const = 0;
+
+  virtual bool write(const Batch& batch) = 0;
+    /// Write all records in the batch.  Returns false on failure.
+};
+
+
+class SBCCDRFileSink : public SBCCDRSink
+  /// Writes records to a rotated log file
+{
+public:
+  SBCCDRFileSink(OSS::UTL::LogFile& logFile);
+  const char* name() const;
+  bool write(const Batch& batch);
+private:
+  OSS::UTL::LogFile& _logFile;
+};
+
+
+class SBCCDRRedisSink : public SBCCDRSink
+  /// Appends records to a redis list using one RPUSH per batch
+{
+public:
+  SBCCDRRedisSink(const std::string& host, int port, const std::string& password, int db, const std::string& listName);
+  const char* name() const;
+  bool write(const Batch& batch);
+private:
+  OSS::Persistent::RedisClient _client;
+  std::string _password;
+  int _db;
+  std::string _listName;
+  bool _isConnected;
+};
+
+
+class SBCCDRZMQSink : public SBCCDRSink
+  /// Publishes each record on a ZeroMQ PUB socket
+{
+public:
+  SBCCDRZMQSink(const std::string& bindAddress);
+  const char* name() const;
+  bool write(const Batch& batch);
+private:
+  OSS::ZMQ::ZMQSocket _socket;
+  std::string _bindAddress;
+  bool _isBound;
+};
+
+
+class SBCCDRPipeline : boost::noncopyable
+  /// Asynchronous CDR writer.
+  ///
+  /// Call hooks hand records to a bounded lock-free ring and return at
+  /// once.  A single writer thread drains the ring in batches and hands
+  /// each batch to every registered sink.  A stalled sink therefore only
+  /// delays the writer thread and never the signaling threads.  When the
+  /// ring is full, the drop policy decides whether the record is discarded
+  /// or whether the producer waits a bounded amount of time for room.
+{
+public:
+  enum DropPolicy
+  {
+    DROP_NEWEST,  /// Discard the record that does not fit
+    BLOCK         /// Wait up to the block timeout, then discard
+  };
+
+  struct Metrics
+  {
+    Metrics();
+    OSS::UInt64 enqueued;
+    OSS::UInt64 written;
+      /// Records accepted by every sink
+    OSS::UInt64 dropped;
+    OSS::UInt64 batches;
+      /// Batches accepted by every sink
+    OSS::UInt64 sinkErrors;
+    std::size_t depth;
+    std::size_t highWatermark;
+    std::size_t capacity;
+  };
+
+  SBCCDRPipeline(std::size_t capacity = 65536, std::size_t maxBatchSize = 512, unsigned int flushIntervalMs = 250);
+
+  ~SBCCDRPipeline();
+
+  void addSink(const SBCCDRSink::Ptr& pSink);
+    /// Register a sink.  Must be called before start().
+
+  void setDropPolicy(DropPolicy policy, unsigned int blockTimeoutMs = 0);
+
+  bool start();
+
+  void stop();
+    /// Stop the writer thread after flushing what is still queued
+
+  bool enqueue(const std::string& record);
+    /// Queue a record.  Returns false if it was dropped.
+
+  Metrics getMetrics() const;
+
+private:
+  void run();
+  std::size_t drain(SBCCDRSink::Batch& batch);
+  void flush(SBCCDRSink::Batch& batch);
+
+  typedef std::vector<SBCCDRSink::Ptr> Sinks;
+
+  OSS::RingBuffer<std::string*> _ring;
+  std::size_t _maxBatchSize;
+  unsigned int _flushIntervalMs;
+  DropPolicy _dropPolicy;
+  unsigned int _blockTimeoutMs;
+  Sinks _sinks;
+  boost::thread* _pWriterThread;
+  boost::atomic<bool> _isTerminating;
+  boost::mutex _wakeupMutex;
+  boost::condition_variable _wakeup;
+  boost::mutex _spaceMutex;
+  boost::condition_variable _space;
+    /// Signalled by the writer when it frees room for blocked producers
+  boost::atomic<std::size_t> _blockedProducers;
+  boost::atomic<OSS::UInt64> _enqueued;
+  boost::atomic<OSS::UInt64> _written;
+  boost::atomic<OSS::UInt64> _dropped;
+  boost::atomic<OSS::UInt64> _batches;
+  boost::atomic<OSS::UInt64> _sinkErrors;
+  boost::atomic<std::size_t> _highWatermark;
+  OSS::UInt64 _lastReportedDrops;
+};
+
+
+} } } // OSS::SIP::SBC
+
+#endif // SBCCDRPIPELINE_H_INCLUDED
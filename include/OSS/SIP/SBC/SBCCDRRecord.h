@@ -67,6 +67,7 @@ public:
   bool writeToWorkSpace(SBCWorkSpace& workspace, const std::string& key, unsigned int expire);
   bool readFromWorkSpace(SBCWorkSpace& workspace, const std::string& key);
   bool writeToLogFile(OSS::UTL::LogFile& logFile);
+  std::string toCsvString() const;
   void toJson(json::Object& object);
   
 protected:
@@ -28,7 +28,8 @@
 #include "OSS/SIP/B2BUA/SIPB2BTransaction.h"
 #include "OSS/UTL/BlockingQueue.h"
 #include "OSS/UTL/LogFile.h"
-#include <Poco/ExpireCache.h>
+#include "OSS/UTL/ExpireHashMap.h"
+#include "OSS/SIP/SBC/SBCDialPrefixTrie.h"
 
 
 namespace OSS {
@@ -42,11 +43,8 @@ class SBCManager;
 class SBCChannelLimits
 {
 public: 
-  typedef Poco::ExpireCache<std::string, std::string> ExpireCache;
-  typedef boost::shared_ptr<ExpireCache> ExpireCachePtr;
-  typedef std::map<std::string, ExpireCachePtr> ChannelMap;
-  typedef std::map<std::string, std::size_t> Limits;
-  typedef std::map<std::string, std::string> PrefixAliases;
+  typedef SBCDialPrefixTrie::Prefix Prefix;
+  typedef OSS::ExpireHashMap<Prefix*> ActiveCalls;
   
   SBCChannelLimits();
   
@@ -65,15 +63,12 @@ public:
   std::size_t getCallCount(const std::string& prefix);
   
 protected:
-  void resolveAliasPrefix(const std::string& dialString, std::string& prefix);
+  void updateWorkSpace(Prefix* pPrefix, std::size_t count);
+  static void onCallExpired(const std::string& key, Prefix*& pPrefix);
   
 private:
-  ChannelMap _prefixes;
-  OSS::mutex_critic_sec _prefixesMutex;
-  std::size_t _shortestPrefix;
-  Poco::Timestamp::TimeDiff _cacheExpire;
-  Limits _limits;
-  PrefixAliases _aliases;
+  SBCDialPrefixTrie _prefixes;
+  ActiveCalls _activeCalls;
   SBCManager* _pManager;
   SBCWorkSpaceManager::WorkSpace _systemDb;
 };
@@ -0,0 +1,128 @@
+// OSS Software Solutions Application Programmer Interface
+// Package: Karoo
+// Author: Joegen E. Baclor - mailto:joegen@ossapp.com
+//
+// Copyright (c) OSS Software Solutions
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "OSS Software Solutions OSS API General License Agreement".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef SBCDIALPREFIXTRIE_H_INCLUDED
+#define	SBCDIALPREFIXTRIE_H_INCLUDED
+
+
+#include <string>
+#include <vector>
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+#include "OSS/UTL/Thread.h"
+
+
+namespace OSS {
+namespace SIP {
+namespace SBC {
+
+
+class SBCDialPrefixTrie : boost::noncopyable
+  /// Longest prefix matcher for dial strings.
+  ///
+  /// Each node has one child per dialable character (0-9, *, # and +).
+  /// Nodes are never removed once inserted so lookups walk the trie
+  /// without taking any lock.  Insertions and removals are serialized
+  /// internally.  A removed prefix is only unpublished.  Its object stays
+  /// valid until the trie is destroyed since readers may still hold it.
+{
+public:
+  enum
+  {
+    DIAL_CHAR_COUNT = 13
+  };
+
+  struct Prefix : boost::noncopyable
+  {
+    Prefix(const std::string& prefix_, std::size_t channelLimit_);
+    const std::string prefix;
+    boost::atomic<std::size_t> channelLimit;
+    boost::atomic<std::size_t> callCount;
+  };
+
+  SBCDialPrefixTrie();
+
+  ~SBCDialPrefixTrie();
+
+  Prefix* insert(const std::string& prefix, std::size_t channelLimit);
+    /// Insert a prefix or update the limit of an existing one.
+    /// Returns 0 if the prefix is empty or has non dialable characters.
+
+  bool alias(const std::string& aliasPrefix, Prefix* pPrefix);
+    /// Make aliasPrefix resolve to an existing prefix
+
+  bool remove(const std::string& prefix);
+    /// Stop matching prefix and every alias that resolves to it.
+    /// Returns false if prefix is not registered.
+
+  Prefix* match(const std::string& dialString) const;
+    /// Returns the longest prefix (or alias) of dialString or 0 if none.
+    /// This is a single walk of at most dialString.length() nodes.
+
+  Prefix* find(const std::string& prefix) const;
+    /// Returns the prefix with an exact match, ignoring aliases
+
+  std::size_t size() const;
+    /// Returns the number of registered prefixes
+
+  static int charIndex(char c);
+    /// Returns the child index of a dial character or -1
+
+private:
+  struct Node : boost::noncopyable
+  {
+    Node();
+    boost::atomic<Node*> children[DIAL_CHAR_COUNT];
+    boost::atomic<Prefix*> pPrefix;
+    bool isAlias;
+  };
+
+  Node* walk(const std::string& prefix, bool create);
+  static void unalias(Node* pNode, Prefix* pPrefix);
+  static void destroy(Node* pNode);
+
+  Node* _pRoot;
+  std::vector<Prefix*> _prefixes;
+  std::size_t _size;
+  mutable OSS::mutex_critic_sec _mutex;
+};
+
+//
+// Inlines
+//
+
+inline int SBCDialPrefixTrie::charIndex(char c)
+{
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  else if (c == '*')
+    return 10;
+  else if (c == '#')
+    return 11;
+  else if (c == '+')
+    return 12;
+  return -1;
+}
+
+} } } // OSS::SIP::SBC
+
+#endif // SBCDIALPREFIXTRIE_H_INCLUDED
@@ -39,6 +39,7 @@
 #include "OSS/UTL/Cache.h"
 #include "OSS/UTL/CoreUtils.h"
 #include "OSS/UTL/Thread.h"
+#include "OSS/UTL/ExpiryIndex.h"
 
 
 namespace OSS {
@@ -184,6 +185,9 @@ public:
   int getStateFileMaxLifeTime() const;
     /// Return the maximum state file lifetime.
 
+  void removeStateFile(const boost::filesystem::path& stateFile);
+    /// Delete a state file and drop it from the expiry index
+
   static void updateRouteSet(const OSS::Persistent::DataType& dialog, const OSS::SIP::SIPMessage::Ptr& pMsg, OSS::Net::IPAddress& targetAddress, const std::string& logId);
     /// update the configured route-set from a dialog object
 
@@ -192,9 +196,22 @@ private:
     /// The monitor thread task
 
   void flushStale();
-    /// Flush state-files more than a day old
-  
-  
+    /// Delete a bounded batch of state files whose lifetime has elapsed
+
+  void indexStateFile(const boost::filesystem::path& stateFile, const std::string& callId = std::string());
+    /// Push the expiry of a state file that was just written.  The Call-ID
+    /// is remembered so expiry does not have to load the file to find it.
+
+  void seedExpiryIndex();
+    /// One-time scan of the state directory used when no expiry journal
+    /// exists yet, for example right after an upgrade.
+
+  enum
+  {
+    FLUSH_INTERVAL_MS = 1000,
+    FLUSH_BATCH_SIZE = 256
+  };
+
   OSS::semaphore _exitSync;
   boost::thread* _pThread;
   mutable OSS::mutex_critic_sec _csDialogsMutex;
@@ -202,6 +219,7 @@ private:
   SBCManager* _pManager;
   int _stateFileMaxLifeTime;
   boost::filesystem::path _stateDir;
+  OSS::ExpiryIndex _expiryIndex;
 };
 
 
@@ -25,6 +25,8 @@
 #define	SBCMEDIAPROXY_H_INCLUDED
 
 
+#include <map>
+#include <vector>
 #include "OSS/SIP/SBC/SBCMediaProxyClient.h"
 #include "OSS/RTP/RTPProxyManager.h"
 
@@ -57,25 +59,51 @@ public:
   bool getSDP(const std::string& sessionId, std::string& lastOffer, std::string& lastAnswer);
   
   bool initialize(bool remoteRtpEnabled = false);
+    /// Initialize the media proxy.  If remoteRtpEnabled is true and no node
+    /// was added using addNode(), the five legacy loopback nodes are used.
+
+  bool addNode(const std::string& address, unsigned int weight = 1);
+    /// Add a remote media proxy node.  Must be called prior to initialize().
+    /// Weight scales the number of points the node owns in the hash ring.
+    /// Returns false if the address was already added.  Nodes are read from
+    /// the media_proxy_nodes array of the user agent configuration.
   
   bool removeSession(const std::string& sessionId);
   
   bool setMaxSession(unsigned int maxSession);
   
   unsigned int getMaxSession() const;
+    /// Returns the combined capacity of all remote nodes, or the local
+    /// capacity if remote media proxy is disabled.
   
   unsigned int getSessionCount() const;
   
+  typedef std::vector<SBCMediaProxyClient*> Nodes;
+  typedef std::map<OSS::UInt32, std::size_t> HashRing;
+  struct Affinity
+  {
+    std::size_t node;
+    OSS::UInt64 expires;
+  };
+  typedef std::map<std::string, Affinity> SessionAffinity;
+
 protected:
   SBCMediaProxyClient* getNode(const std::string& sessionId, bool& spillOver);
-  SBCMediaProxyClient _node0;
-  SBCMediaProxyClient _node1;
-  SBCMediaProxyClient _node2;
-  SBCMediaProxyClient _node3;
-  SBCMediaProxyClient _node4;
+  SBCMediaProxyClient* findNode(const std::string& sessionId) const;
+  void releaseNode(const std::string& sessionId);
+  void expireAffinity(OSS::UInt64 now);
+  void buildRing();
+
+  Nodes _nodes;
+  std::vector<unsigned int> _weights;
+  HashRing _ring;
+  SessionAffinity _sessionAffinity;
+  mutable OSS::mutex_read_write _sessionAffinityMutex;
+  OSS::UInt64 _nextAffinitySweep;
   SBCManager* _pManager;
   OSS::RTP::RTPProxyManager _rtp;
   bool _remoteRtpEnabled;
+  unsigned int _maxSession;
 };
 
 //
@@ -25,6 +25,9 @@
 #define	SBCMEDIAPROXYCLIENT_H_INCLUDED
 
 
+#include <map>
+#include <deque>
+#include <boost/shared_ptr.hpp>
 #include "OSS/ZMQ/zmq.hpp"
 #include "OSS/UTL/Thread.h"
 #include "OSS/RTP/RTPProxyManager.h"
@@ -35,14 +38,32 @@ namespace SIP {
 namespace SBC {
 
   
-class SBCMediaProxyClient
+class SBCMediaProxyClient : boost::noncopyable
+  /// Asynchronous RPC channel to a remote media proxy node.
+  ///
+  /// Requests are multiplexed over a single DEALER socket owned by a
+  /// dedicated I/O thread.  Each request carries a correlation id frame
+  /// ahead of the empty envelope delimiter so that REP and ROUTER based
+  /// responders echo it back untouched.  Any number of requests may be in
+  /// flight at the same time and callers only block on their own reply.
 {
 public:
-  SBCMediaProxyClient(int nodeIndex);
+  typedef boost::function<void(bool, json::Object&)> ResultHandler;
+    /// Completion handler for asynchronous requests.  The first argument
+    /// is false if the request failed or timed out.
+
+  SBCMediaProxyClient(const std::string& address);
+    /// Creates a client for an arbitrary ZeroMQ endpoint
   
   ~SBCMediaProxyClient();
   
   bool sendRequest(const std::string& logId, const std::string& cmd, const json::Object& params, json::Object& result);
+    /// Send a request and wait for the result.  Only the calling thread
+    /// is blocked.  Other requests sent to the same node proceed in parallel.
+
+  bool sendRequest(const std::string& logId, const std::string& cmd, const json::Object& params, const ResultHandler& handler);
+    /// Queue a request and return immediately.  The handler is invoked
+    /// from the I/O thread when the response arrives or the request expires.
   
   bool handleSDP(
     const std::string& logId,
@@ -67,15 +88,64 @@ public:
   bool getSDP(const std::string& sessionId, std::string& lastOffer, std::string& lastAnswer);
   
   bool initialize();
+
+  void stop();
+    /// Stop the I/O thread.  Requests are refused from then on.
+
+  const std::string& getAddress() const;
+
+  bool isAvailable() const;
+    /// Returns false if the node has recently failed to respond.  Once
+    /// the probe interval elapsed a single caller is told the node is
+    /// available so that its request can find out whether it recovered.
+    /// The interval doubles every time the probe times out.
+
+  std::size_t getPendingCount() const;
+    /// Returns the number of requests currently in flight
   
 protected:
-  OSS::mutex_critic_sec _mutex;
+  struct PendingRequest
+  {
+    typedef boost::shared_ptr<PendingRequest> Ptr;
+    PendingRequest();
+    std::string logId;
+    std::string cmd;
+    std::string packet;
+    OSS::UInt64 correlationId;
+    OSS::UInt64 expires;
+    ResultHandler handler;
+    json::Object result;
+    bool ok;
+    OSS::semaphore done;
+  };
+  typedef std::map<OSS::UInt64, PendingRequest::Ptr> PendingRequests;
+  typedef std::deque<PendingRequest::Ptr> OutboundQueue;
+
+  bool queueRequest(const PendingRequest::Ptr& pRequest, const json::Object& params);
+  void runIoLoop();
+  bool flushOutbound(zmq::socket_t& socket);
+  void readResponses(zmq::socket_t& socket);
+  void expireRequests();
+  void completeRequest(const PendingRequest::Ptr& pRequest, bool ok);
+  void updateSessionCount(json::Object& result);
+  void wakeup();
+
+  mutable OSS::mutex_critic_sec _mutex;
   zmq::context_t _context;
-  zmq::socket_t* _pSocket;
+  std::string _address;
+  boost::thread* _pIoThread;
+  int _wakeupPipe[2];
   bool _isConnected;
+  bool _isTerminating;
+  bool _isStopped;
   unsigned int _maxSession;
   unsigned int _sessionCount;
-  int _nodeIndex;
+  unsigned int _consecutiveTimeouts;
+  mutable OSS::UInt64 _nextProbe;
+  OSS::UInt64 _probeInterval;
+  OSS::UInt64 _correlationId;
+  OutboundQueue _outbound;
+  PendingRequests _pending;
 };
 
 //
@@ -91,6 +161,11 @@ inline unsigned int SBCMediaProxyClient::getSessionCount() const
   return _sessionCount;
 }
 
+inline const std::string& SBCMediaProxyClient::getAddress() const
+{
+  return _address;
+}
+
 } } } // OSS::SIP::SBC
 
 
@@ -33,6 +33,16 @@ namespace SIP {
 class OSS_API SIPDigestAuth
 {
 public:
+  enum NonceStatus
+  {
+    NONCE_VALID,
+    NONCE_STALE,
+      /// The nonce was issued by us but its lifetime has elapsed
+    NONCE_REPLAYED,
+      /// The nonce count did not increase since the last request
+    NONCE_INVALID
+  };
+
   SIPDigestAuth();
     /// Creates a new digest authenticator
 
@@ -64,7 +74,35 @@ public:
     /// Create an authorization with QoP
   
   static void setSecretKey(const std::string& key);
-    /// Set the secret key used to generate nonce
+    /// Set the secret key used to generate nonce.  Safe to call while
+    /// other threads create or validate nonces.
+
+  static std::string digestCreateSignedNonce(const std::string& key);
+    /// Create a nonce that can be validated without keeping state.  The nonce
+    /// carries its creation time followed by an HMAC-SHA1 of the time and
+    /// the key, signed with the secret key.
+
+  static NonceStatus digestValidateNonce(
+    const std::string& nonce,
+    const std::string& key,
+    const std::string& nonceCount = std::string());
+    /// Validate a nonce created by digestCreateSignedNonce() for the same key.
+    /// If nonceCount is not empty it must be greater than the last count
+    /// seen for this nonce.  Counts are remembered in a fixed size table
+    /// so old nonces are eventually forgotten.  Call this only after the
+    /// digest response was verified so that forged requests cannot
+    /// advance the count of a legitimate nonce.
+
+  static NonceStatus digestConsumeNonce(
+    const std::string& nonce,
+    const std::string& key);
+    /// Validate a nonce for a digest without qop and mark it used.  Such
+    /// a digest carries no nonce count so the nonce is accepted once and
+    /// any later use is reported as NONCE_REPLAYED.
+
+  static void setNonceLifetime(unsigned int seconds);
+    /// Set the number of seconds a signed nonce remains valid.
+    /// The default is 300 seconds.
 };
 
 
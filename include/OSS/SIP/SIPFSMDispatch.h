@@ -98,6 +98,16 @@ public:
   
   SIPTransaction::ThrottleRequestCallback& throttleRequestHandler();
 
+  SIPTransaction::RequestAdmissionCallback& requestAdmissionHandler();
+    /// Handler consulted for every incoming message before it is parsed.
+    /// If it returns a response, the message must have been parsed by the
+    /// handler.  Unless the request is a retransmission for an existing
+    /// server transaction, the response is sent statelessly and the request
+    /// is discarded before any transaction state is allocated.
+
+  std::size_t getServerTransactionCount();
+    /// Returns the number of active IST and NIST transactions
+
   UnknownTransactionCallback& ackOr2xxTransactionHandler();
     /// Handler for SIP messages not linked to a transaction
 
@@ -121,6 +131,13 @@ public:
   bool getEnableIctForking() const;
     // Returns true if ICT forking is enabled
 private:
+  bool admitRequest(
+    const SIPMessage::Ptr& pMsg,
+    const SIPTransportSession::Ptr& pTransport,
+    const SIPMessage::Ptr& pResponse,
+    const std::string& id,
+    SIPTransaction::Type transactionType);
+
   SIPTransportService _transport;
   SIPIctPool _ict;
   SIPNictPool _nict;
@@ -128,6 +145,7 @@ private:
   SIPNistPool _nist;
   SIPTransaction::RequestCallback _requestHandler;
   SIPTransaction::ThrottleRequestCallback _throttleRequestHandler;
+  SIPTransaction::RequestAdmissionCallback _requestAdmissionHandler;
   UnknownTransactionCallback _ackOr2xxTransactionHandler;
   StringPairCache _istBlocker;
   bool _enableIctForking;
@@ -163,6 +181,16 @@ inline SIPTransaction::ThrottleRequestCallback& SIPFSMDispatch::throttleRequestH
   return _throttleRequestHandler;
 }
 
+inline SIPTransaction::RequestAdmissionCallback& SIPFSMDispatch::requestAdmissionHandler()
+{
+  return _requestAdmissionHandler;
+}
+
+inline std::size_t SIPFSMDispatch::getServerTransactionCount()
+{
+  return _ist.getSize() + _nist.getSize();
+}
+
 inline SIPFSMDispatch::UnknownTransactionCallback& SIPFSMDispatch::ackOr2xxTransactionHandler()
 {
   return _ackOr2xxTransactionHandler;
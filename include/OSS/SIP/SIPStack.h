@@ -283,6 +283,13 @@ public:
   void setThrottleRequestHandler(const SIPTransaction::ThrottleRequestCallback& handler);
     /// This function set a handler to allow applications to delay transacton handling
 
+  void setRequestAdmissionHandler(const SIPTransaction::RequestAdmissionCallback& handler);
+    /// This function sets a handler that may reject new requests statelessly
+    /// before a server transaction is created.  See SIPFSMDispatch::requestAdmissionHandler().
+
+  std::size_t getServerTransactionCount();
+    /// Returns the number of active server transactions
+
   void setAckOr2xxTransactionHandler(const SIPFSMDispatch::UnknownTransactionCallback& handler);
     /// This function sets the callback handler for ACK and 200 OK retranmissions.
     ///
@@ -395,6 +402,16 @@ inline void SIPStack::setThrottleRequestHandler(const SIPTransaction::ThrottleRe
   _fsmDispatch.throttleRequestHandler() = handler;
 }
 
+inline void SIPStack::setRequestAdmissionHandler(const SIPTransaction::RequestAdmissionCallback& handler)
+{
+  _fsmDispatch.requestAdmissionHandler() = handler;
+}
+
+inline std::size_t SIPStack::getServerTransactionCount()
+{
+  return _fsmDispatch.getServerTransactionCount();
+}
+
 inline void SIPStack::setAckOr2xxTransactionHandler(const SIPFSMDispatch::UnknownTransactionCallback& handler)
 {
   _fsmDispatch.ackOr2xxTransactionHandler() = handler;
@@ -28,6 +28,8 @@
 #include <boost/shared_ptr.hpp>
 #include <boost/enable_shared_from_this.hpp>
 #include <queue>
+#include <deque>
+#include <vector>
 #include "OSS/SIP/SIP.h"
 #include "OSS/SIP/SIPMessage.h"
 #include "OSS/SIP/SIPTransportSession.h"
@@ -136,6 +138,10 @@ private:
 
   void readSome();
     /// read some bytes into the buffer
+
+  void flushOutbound();
+    /// Start a write for as many queued messages as fit in one batch.
+    /// Must be called with _writeMutex held and no write in flight.
   
 protected:
   void handleConnectTimeout(const boost::system::error_code& e);
@@ -177,6 +183,15 @@ protected:
   Pending _pending;
   OSS::mutex_critic_sec _pendingMutex;
   bool _isStopping;
+  std::deque<std::string> _outbound;
+    /// Messages waiting for the current write to complete
+  std::vector<std::string> _inflight;
+    /// Messages handed to the current gathered write
+  std::string _inflightRecord;
+    /// Coalesced batch for TLS so that it goes out as a single record
+  std::size_t _outboundBytes;
+  bool _isWriting;
+  OSS::mutex_critic_sec _writeMutex;
 };
 
 
@@ -26,6 +26,7 @@
 #include <map>
 #include <boost/asio.hpp>
 #include <boost/noncopyable.hpp>
+#include <boost/unordered_map.hpp>
 #include "SIPStreamedConnection.h"
 #include "OSS/UTL/Thread.h"
 
@@ -84,13 +85,38 @@ public:
     /// Set the port max.  the default is 12000
 
   SIPStreamedConnection::Ptr findConnectionByAddress(const OSS::Net::IPAddress& target);
-    /// Find a connection to a specific target if it exists
+    /// Find a connection to a specific target if it exists.  This is a hash
+    /// lookup on the remote ip and port that only takes the read lock of one
+    /// index shard.
 
   SIPStreamedConnection::Ptr findConnectionById(OSS::UInt64 identifier);
 private:
+  enum
+  {
+    ADDRESS_SHARD_COUNT = 64
+  };
+
+  typedef boost::unordered_map<std::string, SIPStreamedConnection::Ptr> AddressIndex;
+
+  struct AddressShard
+  {
+    OSS::mutex_read_write mutex;
+    AddressIndex connections;
+  };
+
+  static std::string getAddressKey(const OSS::Net::IPAddress& address);
+    /// Binary (address, scope, port) key.  The transport is implied since
+    /// each transport has its own manager.
+
+  AddressShard& getAddressShard(const std::string& key);
+  void indexConnection(const SIPStreamedConnection::Ptr& conn);
+  void unindexConnection(const SIPStreamedConnection::Ptr& conn);
+
   OSS::mutex_read_write _rwConnectionsMutex;
   OSS::UInt64 _currentIdentifier;
   std::map<OSS::UInt64, SIPStreamedConnection::Ptr> _connections;
+  std::map<OSS::UInt64, std::string> _addressKeys;
+  AddressShard _addressShards[ADDRESS_SHARD_COUNT];
   SIPTransportSession::Dispatch _dispatch;
   unsigned short _portBase;
   unsigned short _portMax;
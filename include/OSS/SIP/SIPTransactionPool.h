@@ -107,6 +107,9 @@ public:
   SIPFSMDispatch* dispatch();
     /// Returns a raw pointer to the FSMDispatch
 
+  std::size_t getSize();
+    /// Returns the number of transactions in the pool
+
   void stop();
     /// Forcibly terminate all transactions
 
@@ -160,6 +160,14 @@ public:
     /// Creates a new client transport based 
     /// on local and remote address tuples
 
+  SIPTransportSession::Ptr createClientTransport(
+    const OSS::SIP::SIPMessage::Ptr& pMsg,
+    const OSS::Net::IPEndPoint& localAddress,
+    const OSS::Net::IPEndPoint& remoteAddress,
+    const std::string& proto,
+    const std::string& transportId = std::string());
+    /// Creates a new client transport from packed endpoints
+
   SIPTransportSession::Ptr createClientTcpTransport(
     const OSS::Net::IPAddress& localAddress,
     const OSS::Net::IPAddress& remoteAddress);
@@ -205,6 +213,10 @@ public:
     const OSS::Net::IPAddress& target);
     /// send UDP Keep-alive packet
 
+  void sendUDPKeepAlive(const OSS::Net::IPEndPoint& localInterface,
+    const OSS::Net::IPEndPoint& target);
+    /// send UDP Keep-alive packet using packed endpoints
+
   bool isLocalTransport(const std::string& proto, const std::string& ip,
     const std::string& port) const;
     /// Returns true if the transport is a registered listener
@@ -273,6 +285,13 @@ public:
 #if ENABLE_FEATURE_WEBSOCKETS  
   void setWSPortRange(unsigned short base, unsigned short max);
     /// Set the WebSocket port range.  Applies to both WebSocket and WebSocket Secure transports
+
+  void setWSShardCount(std::size_t shardCount);
+    /// Set the number of io_service shards used by WebSocket and WebSocket Secure
+    /// listeners added after this call.  Defaults to a single shard.
+
+  std::size_t getWSShardCount() const;
+    /// Return the number of io_service shards used by WebSocket listeners
 #endif
 
   unsigned short getTCPPortBase() const;
@@ -343,6 +362,7 @@ private:
   bool _wssEnabled;
   unsigned short _wsPortBase;
   unsigned short _wsPortMax;
+  std::size_t _wsShardCount;
 #endif
   bool _udpEnabled;
   bool _tcpEnabled;
@@ -436,6 +456,16 @@ inline void SIPTransportService::setWSPortRange(unsigned short base, unsigned sh
   _wsPortBase = base;
   _wsPortMax = max;
 }
+
+inline void SIPTransportService::setWSShardCount(std::size_t shardCount)
+{
+  _wsShardCount = shardCount ? shardCount : 1;
+}
+
+inline std::size_t SIPTransportService::getWSShardCount() const
+{
+  return _wsShardCount;
+}
 #endif
 
 
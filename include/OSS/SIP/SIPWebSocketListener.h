@@ -54,6 +54,7 @@
 #include "OSS/build.h"
 #if ENABLE_FEATURE_WEBSOCKETS
 
+#include <vector>
 #include <boost/noncopyable.hpp>
 #include "OSS/SIP/SIPListener.h"
 #include "OSS/SIP/SIPWebSocketConnection.h"
@@ -120,19 +121,29 @@ public:
   
   virtual bool canBeRestarted() const;
     /// returns true if the listener can safely be restarted
+
+  void setShardCount(std::size_t shardCount);
+    /// Set the number of server shards.  Each shard owns an endpoint with its
+    /// own io_service, acceptor and thread.  The acceptors share the listening
+    /// port through SO_REUSEPORT so the kernel spreads new connections,
+    /// and their frame parsing, across shards.  Takes effect on the next run().
+
+  std::size_t getShardCount() const;
+    /// Returns the number of server shards
  
 protected:
-  void run_server();
+  typedef std::vector<websocketpp::server*> ServerEndPoints;
+
   void run_client();
 
   websocketpp::server::handler::ptr _pServerAcceptHandler;
-  websocketpp::server* _pServerEndPoint;
+  ServerEndPoints _serverEndPoints;
+  std::size_t _shardCount;
 
   SIPWebSocketConnectionManager& _connectionManager;
   boost::asio::ip::tcp::resolver _resolver;
   /// The resolver service;
 
-  boost::thread* _pServerThread;
   boost::thread* _pClientThread;
 };
 
@@ -141,6 +152,16 @@ protected:
 // Inlines
 //
 
+inline void SIPWebSocketListener::setShardCount(std::size_t shardCount)
+{
+  _shardCount = shardCount ? shardCount : 1;
+}
+
+inline std::size_t SIPWebSocketListener::getShardCount() const
+{
+  return _shardCount;
+}
+
 } } // OSS::SIP
 
 #endif // ENABLE_FEATURE_WEBSOCKETS
@@ -0,0 +1,129 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+//
+
+
+#ifndef OSS_STUNBINDINGRESPONDER_H
+#define	OSS_STUNBINDINGRESPONDER_H
+
+#include "OSS/build.h"
+#if ENABLE_FEATURE_STUN
+
+#include <boost/asio.hpp>
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "OSS/OSS.h"
+#include "OSS/UTL/Thread.h"
+
+
+namespace OSS {
+namespace STUN {
+
+
+class OSS_API STUNBindingResponder : boost::noncopyable
+  /// Answers RFC 5389 binding requests without owning a socket.
+  ///
+  /// The responder parses a datagram and writes the reply into a caller
+  /// supplied buffer so it can run directly in the receive path of whatever
+  /// socket the request arrived on.  It is used by STUNBindingServer and by
+  /// the RTP relay to answer ICE connectivity checks on the media port.
+  ///
+  /// Short-term credentials are registered per local ICE username fragment.
+  /// The HMAC-SHA1 inner and outer key pads are hashed once when the
+  /// credential is added so that each MESSAGE-INTEGRITY costs two SHA-1
+  /// compression passes over the message and no key setup.
+  ///
+  /// Classic RFC 3489 binding requests (no magic cookie) are answered with
+  /// MAPPED-ADDRESS.  CHANGE-REQUEST is not supported.
+{
+public:
+  struct Stats
+  {
+    OSS::UInt64 requests;
+    OSS::UInt64 responses;
+    OSS::UInt64 errorResponses;
+    OSS::UInt64 authFailures;
+    OSS::UInt64 discarded;
+  };
+
+  STUNBindingResponder();
+
+  ~STUNBindingResponder();
+
+  void setCredential(const std::string& localUserFragment, const std::string& password);
+    /// Register the short-term credential for an ICE username fragment.
+    /// Requests whose USERNAME starts with "localUserFragment:" are
+    /// authenticated with password.
+
+  void removeCredential(const std::string& localUserFragment);
+    /// Remove a credential
+
+  void setRequireAuthentication(bool requireAuthentication);
+    /// If true, requests without MESSAGE-INTEGRITY are rejected with 400.
+    /// The default is false so plain keep-alives are also answered.
+
+  Stats getStats() const;
+    /// Returns the request and response counters
+
+  std::size_t processRequest(
+    const char* request,
+    std::size_t requestLength,
+    const boost::asio::ip::udp::endpoint& source,
+    char* response,
+    std::size_t responseSize);
+    /// Process a single datagram and write the reply to response.
+    /// Returns the size of the reply or 0 if nothing must be sent.
+
+  struct Credential;
+  typedef boost::shared_ptr<Credential> CredentialPtr;
+
+private:
+  typedef boost::unordered_map<std::string, CredentialPtr> Credentials;
+
+  CredentialPtr findCredential(const char* username, std::size_t length) const;
+
+  bool _requireAuthentication;
+  mutable OSS::mutex_read_write _credentialsMutex;
+  Credentials _credentials;
+  boost::atomic<OSS::UInt64> _requests;
+  boost::atomic<OSS::UInt64> _responses;
+  boost::atomic<OSS::UInt64> _errorResponses;
+  boost::atomic<OSS::UInt64> _authFailures;
+  boost::atomic<OSS::UInt64> _discarded;
+};
+
+//
+// Inlines
+//
+
+inline void STUNBindingResponder::setRequireAuthentication(bool requireAuthentication)
+{
+  _requireAuthentication = requireAuthentication;
+}
+
+
+} } // OSS::STUN
+
+
+#endif // ENABLE_FEATURE_STUN
+
+#endif // OSS_STUNBINDINGRESPONDER_H
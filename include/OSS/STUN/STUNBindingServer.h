@@ -0,0 +1,97 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+//
+
+
+#ifndef OSS_STUNBINDINGSERVER_H
+#define	OSS_STUNBINDINGSERVER_H
+
+#include "OSS/build.h"
+#if ENABLE_FEATURE_STUN
+
+#include <vector>
+#include <boost/asio.hpp>
+#include <boost/atomic.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "OSS/OSS.h"
+#include "OSS/Net/IPAddress.h"
+#include "OSS/UTL/Thread.h"
+#include "OSS/STUN/STUNBindingResponder.h"
+
+
+namespace OSS {
+namespace STUN {
+
+
+class OSS_API STUNBindingServer : public STUNBindingResponder
+  /// A multi-threaded RFC 5389 binding responder intended for ICE
+  /// connectivity checks and keep-alives.
+  ///
+  /// Each worker thread owns a UDP socket bound to the same address with
+  /// SO_REUSEPORT so the kernel spreads datagrams across workers without any
+  /// shared state on the receive path.  On Linux, workers read and answer
+  /// datagrams in batches using recvmmsg() and sendmmsg().
+  ///
+  /// CHANGE-REQUEST is not supported; use STUNServer with a secondary
+  /// address for NAT type discovery.
+{
+public:
+  enum
+  {
+    BATCH_SIZE = 32,
+    MAX_DATAGRAM_SIZE = 1500
+  };
+
+  STUNBindingServer();
+
+  ~STUNBindingServer();
+
+  bool initialize(const OSS::Net::IPAddress& address, std::size_t threadCount = 0);
+    /// Open threadCount sockets bound to address.  If threadCount is zero,
+    /// one socket per hardware thread is opened.  Returns false if the
+    /// sockets could not be bound.
+
+  void run();
+    /// Start the worker threads
+
+  void stop();
+    /// Stop the worker threads and close the sockets
+
+private:
+  typedef boost::shared_ptr<boost::asio::ip::udp::socket> SocketPtr;
+
+  void runWorker(std::size_t index);
+  void runWorkerBatched(int fd);
+  void runWorkerSimple(boost::asio::ip::udp::socket& socket);
+
+  boost::asio::io_service _ioService;
+  std::vector<SocketPtr> _sockets;
+  std::vector<boost::thread*> _threads;
+  OSS::Net::IPAddress _address;
+  boost::atomic<bool> _isRunning;
+};
+
+
+} } // OSS::STUN
+
+
+#endif // ENABLE_FEATURE_STUN
+
+#endif // OSS_STUNBINDINGSERVER_H
@@ -75,6 +75,17 @@ namespace Proto {
   const UInt16 ServerName       = 0x8022;
   const UInt16 SecondaryAddress = 0x8050; // Non standard extention
 
+  // RFC 5389 / RFC 5245 (ICE) attributes
+  const UInt16 XorMappedAddressRfc5389 = 0x0020;
+  const UInt16 Priority         = 0x0024;
+  const UInt16 UseCandidate     = 0x0025;
+  const UInt16 Fingerprint      = 0x8028;
+  const UInt16 IceControlled    = 0x8029;
+  const UInt16 IceControlling   = 0x802A;
+
+  const UInt32 MagicCookie      = 0x2112A442;
+  const UInt32 FingerprintXor   = 0x5354554E;
+
   // define types for a stun message
   const UInt16 BindRequestMsg               = 0x0001;
   const UInt16 BindResponseMsg              = 0x0101;
@@ -82,6 +93,7 @@ namespace Proto {
   const UInt16 SharedSecretRequestMsg       = 0x0002;
   const UInt16 SharedSecretResponseMsg      = 0x0102;
   const UInt16 SharedSecretErrorResponseMsg = 0x0112;
+  const UInt16 BindIndicationMsg            = 0x0011;
 
   // Define enum with different types of NAT
   typedef enum
@@ -255,6 +267,10 @@ namespace Proto {
 
   int stunRandomPort();
 
+  UInt32 OSS_API stunCrc32(const char* buf, unsigned int bufLen);
+    /// Returns the CRC-32 (ISO 3309) of the buffer.  The RFC 5389 FINGERPRINT
+    /// attribute value is this checksum XOR'ed with FingerprintXor.
+
 } } } // OSS::STUN::Proto
 
 
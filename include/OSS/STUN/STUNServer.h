@@ -29,6 +29,7 @@
 #include "OSS/OSS.h"
 #include "OSS/Net/IPAddress.h"
 #include "OSS/UTL/Thread.h"
+#include "OSS/STUN/STUNBindingServer.h"
 
 namespace OSS {
 namespace STUN {
@@ -43,10 +44,20 @@ public:
   bool initialize(
     const OSS::Net::IPAddress& primary,
     const OSS::Net::IPAddress& secondary);
+    /// Initialize the server.  If secondary is not a valid address, only
+    /// binding requests are served using the multi-threaded
+    /// STUNBindingServer.  Otherwise the RFC 3489 server is used so
+    /// that CHANGE-REQUEST can be honored for NAT discovery.
 
   void run();
+    /// Start serving.  The RFC 3489 server loop runs on its own thread
+    /// since it does not return until stop() is called.
 
   void stop();
+
+  STUNBindingServer& bindingServer();
+    /// Returns the binding server.  Credentials for ICE connectivity
+    /// checks are registered here.
 private:
 
   void internal_run();
@@ -54,9 +65,20 @@ private:
   OSS::Net::IPAddress _primaryIp;
   OSS::Net::IPAddress _secondaryIp;
   OSS_HANDLE _config;
-  OSS::semaphore _exitSync;
+  boost::thread* _pServerThread;
+  STUNBindingServer _bindingServer;
+  bool _useBindingServer;
 };
 
+//
+// Inlines
+//
+
+inline STUNBindingServer& STUNServer::bindingServer()
+{
+  return _bindingServer;
+}
+
 } } // OSS::STUN
 
 
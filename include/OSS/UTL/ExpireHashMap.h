@@ -0,0 +1,424 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef OSS_EXPIREHASHMAP_H_INCLUDED
+#define OSS_EXPIREHASHMAP_H_INCLUDED
+
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <boost/functional/hash.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+
+#include "OSS/OSS.h"
+#include "OSS/UTL/Thread.h"
+#include "OSS/UTL/CoreUtils.h"
+
+
+namespace OSS {
+
+
+class OSS_API ExpireHashMapBase : boost::noncopyable
+  /// Base class of all expiring hash maps.  Registered maps are swept
+  /// by a single background thread shared by the whole process.
+{
+public:
+  ExpireHashMapBase();
+  virtual ~ExpireHashMapBase();
+  virtual void sweep() = 0;
+    /// Remove all expired entries.  Called from the sweeper thread.
+
+protected:
+  void enableSweep();
+    /// Register this map with the background sweeper
+
+  void disableSweep();
+    /// Unregister this map from the background sweeper.  Once this returns,
+    /// sweep() will no longer be called.  Derived classes must call this
+    /// in their destructor before their members are destroyed.
+};
+
+
+template <typename T>
+class ExpireHashMap : public ExpireHashMapBase
+  /// A sharded open-addressing hash map whose entries expire a fixed
+  /// amount of time after they were last added.
+  ///
+  /// Each shard is a linear probing table guarded by its own mutex so
+  /// that threads working on different keys seldom contend.  Expired
+  /// entries are removed lazily when they are looked up and periodically
+  /// by the background sweeper.  Removal uses backward shift deletion so
+  /// there are no tombstones to degrade probe lengths.
+{
+public:
+  typedef boost::function<void(const std::string&, T&)> ExpireHandler;
+    /// Invoked whenever an entry expires.  The handler is called while
+    /// the shard is locked so it must not call back into the map.
+
+  ExpireHashMap(OSS::UInt64 expireMillis, std::size_t shardCount = 64);
+
+  ~ExpireHashMap();
+
+  void setExpireHandler(const ExpireHandler& handler);
+    /// Set the expire handler.  Must be called before the map is used.
+
+  bool add(const std::string& key, const T& value);
+    /// Insert or overwrite an entry.  This resets the expiration.
+    /// Returns true if the key was not yet in the map.
+
+  bool get(const std::string& key, T& value) const;
+    /// Copy the value to the value argument.  Returns false if not found.
+
+  bool pop(const std::string& key, T& value);
+    /// Copy the value and remove the entry.  Returns false if not found.
+
+  void remove(const std::string& key);
+
+  bool has(const std::string& key) const;
+
+  void clear();
+
+  std::size_t size() const;
+    /// Number of entries including those that expired but are not swept yet
+
+  void sweep();
+
+private:
+  struct Entry
+  {
+    Entry() : hash(0), expires(0), used(false) {}
+    std::size_t hash;
+    OSS::UInt64 expires;
+    std::string key;
+    T value;
+    bool used;
+  };
+
+  struct Shard
+  {
+    Shard() : size(0) {}
+    OSS::mutex_critic_sec mutex;
+    std::vector<Entry> slots;
+    std::size_t size;
+  };
+
+  static std::size_t hashOf(const std::string& key);
+  Shard& shardOf(std::size_t hash) const;
+  static std::size_t find(const Shard& shard, std::size_t hash, const std::string& key);
+  static void erase(Shard& shard, std::size_t index);
+  void expire(Shard& shard, std::size_t index) const;
+  static void grow(Shard& shard);
+  static const std::size_t npos = static_cast<std::size_t>(-1);
+
+  OSS::UInt64 _expireMillis;
+  std::size_t _shardMask;
+  Shard* _shards;
+  ExpireHandler _expireHandler;
+};
+
+//
+// Inlines
+//
+
+template <typename T>
+ExpireHashMap<T>::ExpireHashMap(OSS::UInt64 expireMillis, std::size_t shardCount) :
+  _expireMillis(expireMillis),
+  _shardMask(0),
+  _shards(0)
+{
+  std::size_t count = 1;
+  while (count < shardCount)
+    count <<= 1;
+  _shardMask = count - 1;
+  _shards = new Shard[count];
+  enableSweep();
+}
+
+template <typename T>
+ExpireHashMap<T>::~ExpireHashMap()
+{
+  disableSweep();
+  delete [] _shards;
+}
+
+template <typename T>
+void ExpireHashMap<T>::setExpireHandler(const ExpireHandler& handler)
+{
+  _expireHandler = handler;
+}
+
+template <typename T>
+void ExpireHashMap<T>::expire(Shard& shard, std::size_t index) const
+{
+  if (_expireHandler)
+    _expireHandler(shard.slots[index].key, shard.slots[index].value);
+  erase(shard, index);
+}
+
+template <typename T>
+std::size_t ExpireHashMap<T>::hashOf(const std::string& key)
+{
+  //
+  // Finalize the hash so that both the low bits (slot) and the
+  // high bits (shard) are well distributed
+  //
+  OSS::UInt64 hash = boost::hash<std::string>()(key);
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ULL;
+  hash ^= hash >> 33;
+  return static_cast<std::size_t>(hash);
+}
+
+template <typename T>
+typename ExpireHashMap<T>::Shard& ExpireHashMap<T>::shardOf(std::size_t hash) const
+{
+  //
+  // Slots are selected using the low bits so use the high bits for the shard
+  //
+  return _shards[(hash >> (sizeof(std::size_t) * 8 - 16)) & _shardMask];
+}
+
+template <typename T>
+std::size_t ExpireHashMap<T>::find(const Shard& shard, std::size_t hash, const std::string& key)
+{
+  if (shard.slots.empty())
+    return npos;
+  std::size_t mask = shard.slots.size() - 1;
+  for (std::size_t i = hash & mask; shard.slots[i].used; i = (i + 1) & mask)
+  {
+    if (shard.slots[i].hash == hash && shard.slots[i].key == key)
+      return i;
+  }
+  return npos;
+}
+
+template <typename T>
+void ExpireHashMap<T>::erase(Shard& shard, std::size_t index)
+{
+  std::size_t mask = shard.slots.size() - 1;
+  std::size_t hole = index;
+  std::size_t next = index;
+  while (true)
+  {
+    next = (next + 1) & mask;
+    Entry& entry = shard.slots[next];
+    if (!entry.used)
+      break;
+    //
+    // Leave the entry where it is if its home slot lies cyclically
+    // within (hole, next].  Otherwise it can move back into the hole.
+    //
+    std::size_t home = entry.hash & mask;
+    bool inRange = hole <= next ? (hole < home && home <= next) : (hole < home || home <= next);
+    if (inRange)
+      continue;
+    Entry& target = shard.slots[hole];
+    target.hash = entry.hash;
+    target.expires = entry.expires;
+    target.key.swap(entry.key);
+    std::swap(target.value, entry.value);
+    target.used = true;
+    hole = next;
+  }
+  shard.slots[hole] = Entry();
+  --shard.size;
+}
+
+template <typename T>
+void ExpireHashMap<T>::grow(Shard& shard)
+{
+  std::vector<Entry> old;
+  old.swap(shard.slots);
+  shard.slots.resize(old.empty() ? 16 : old.size() * 2);
+  std::size_t mask = shard.slots.size() - 1;
+  for (typename std::vector<Entry>::iterator iter = old.begin(); iter != old.end(); iter++)
+  {
+    if (!iter->used)
+      continue;
+    std::size_t i = iter->hash & mask;
+    while (shard.slots[i].used)
+      i = (i + 1) & mask;
+    Entry& target = shard.slots[i];
+    target.hash = iter->hash;
+    target.expires = iter->expires;
+    target.key.swap(iter->key);
+    std::swap(target.value, iter->value);
+    target.used = true;
+  }
+}
+
+template <typename T>
+bool ExpireHashMap<T>::add(const std::string& key, const T& value)
+{
+  std::size_t hash = hashOf(key);
+  OSS::UInt64 expires = OSS::getTime() + _expireMillis;
+  Shard& shard = shardOf(hash);
+  OSS::mutex_critic_sec_lock lock(shard.mutex);
+  std::size_t index = find(shard, hash, key);
+  if (index != npos)
+  {
+    bool expired = shard.slots[index].expires <= OSS::getTime();
+    if (expired && _expireHandler)
+      _expireHandler(shard.slots[index].key, shard.slots[index].value);
+    shard.slots[index].value = value;
+    shard.slots[index].expires = expires;
+    return expired;
+  }
+
+  if ((shard.size + 1) * 4 > shard.slots.size() * 3)
+    grow(shard);
+
+  std::size_t mask = shard.slots.size() - 1;
+  std::size_t i = hash & mask;
+  while (shard.slots[i].used)
+    i = (i + 1) & mask;
+  Entry& entry = shard.slots[i];
+  entry.hash = hash;
+  entry.expires = expires;
+  entry.key = key;
+  entry.value = value;
+  entry.used = true;
+  ++shard.size;
+  return true;
+}
+
+template <typename T>
+bool ExpireHashMap<T>::get(const std::string& key, T& value) const
+{
+  std::size_t hash = hashOf(key);
+  Shard& shard = shardOf(hash);
+  OSS::mutex_critic_sec_lock lock(shard.mutex);
+  std::size_t index = find(shard, hash, key);
+  if (index == npos)
+    return false;
+  if (shard.slots[index].expires <= OSS::getTime())
+  {
+    expire(shard, index);
+    return false;
+  }
+  value = shard.slots[index].value;
+  return true;
+}
+
+template <typename T>
+bool ExpireHashMap<T>::pop(const std::string& key, T& value)
+{
+  std::size_t hash = hashOf(key);
+  Shard& shard = shardOf(hash);
+  OSS::mutex_critic_sec_lock lock(shard.mutex);
+  std::size_t index = find(shard, hash, key);
+  if (index == npos)
+    return false;
+  if (shard.slots[index].expires <= OSS::getTime())
+  {
+    expire(shard, index);
+    return false;
+  }
+  std::swap(value, shard.slots[index].value);
+  erase(shard, index);
+  return true;
+}
+
+template <typename T>
+void ExpireHashMap<T>::remove(const std::string& key)
+{
+  std::size_t hash = hashOf(key);
+  Shard& shard = shardOf(hash);
+  OSS::mutex_critic_sec_lock lock(shard.mutex);
+  std::size_t index = find(shard, hash, key);
+  if (index != npos)
+    erase(shard, index);
+}
+
+template <typename T>
+bool ExpireHashMap<T>::has(const std::string& key) const
+{
+  std::size_t hash = hashOf(key);
+  Shard& shard = shardOf(hash);
+  OSS::mutex_critic_sec_lock lock(shard.mutex);
+  std::size_t index = find(shard, hash, key);
+  if (index == npos)
+    return false;
+  if (shard.slots[index].expires <= OSS::getTime())
+  {
+    expire(shard, index);
+    return false;
+  }
+  return true;
+}
+
+template <typename T>
+void ExpireHashMap<T>::clear()
+{
+  for (Shard* iter = _shards; iter != _shards + _shardMask + 1; iter++)
+  {
+    OSS::mutex_critic_sec_lock lock(iter->mutex);
+    std::vector<Entry>().swap(iter->slots);
+    iter->size = 0;
+  }
+}
+
+template <typename T>
+std::size_t ExpireHashMap<T>::size() const
+{
+  std::size_t total = 0;
+  for (Shard* iter = _shards; iter != _shards + _shardMask + 1; iter++)
+  {
+    OSS::mutex_critic_sec_lock lock(iter->mutex);
+    total += iter->size;
+  }
+  return total;
+}
+
+template <typename T>
+void ExpireHashMap<T>::sweep()
+{
+  //
+  // Only one shard is locked at a time so writers are never held
+  // for more than a single shard scan.
+  //
+  for (Shard* iter = _shards; iter != _shards + _shardMask + 1; iter++)
+  {
+    OSS::mutex_critic_sec_lock lock(iter->mutex);
+    if (!iter->size)
+      continue;
+    OSS::UInt64 now = OSS::getTime();
+    std::size_t i = 0;
+    while (i < iter->slots.size())
+    {
+      //
+      // Do not advance after an erase.  Backward shift may have moved
+      // another entry into this slot.
+      //
+      if (iter->slots[i].used && iter->slots[i].expires <= now)
+        expire(*iter, i);
+      else
+        ++i;
+    }
+  }
+}
+
+} // OSS
+
+#endif // OSS_EXPIREHASHMAP_H_INCLUDED
@@ -0,0 +1,151 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef OSS_EXPIRYINDEX_H_INCLUDED
+#define OSS_EXPIRYINDEX_H_INCLUDED
+
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+#include <boost/filesystem.hpp>
+
+#include "OSS/OSS.h"
+
+
+namespace OSS {
+
+
+class OSS_API ExpiryIndex : boost::noncopyable
+  /// Time-bucketed index of keys that are due for removal at a deadline.
+  ///
+  /// Owners register each key (typically a state file name) when it is
+  /// created and refresh it whenever it is rewritten.  Cleanup then asks
+  /// for the keys that are due, in bounded batches, instead of walking and
+  /// stat'ing a directory.  Deadlines are rounded up to the bucket size so
+  /// a key expires at most one bucket late and never early.
+  ///
+  /// When a journal is open every change is appended to it as a small
+  /// binary record so the index survives a restart.  The journal is
+  /// rewritten with only the live entries when it is opened and when the
+  /// owner's housekeeping thread calls compactIfStale().
+{
+public:
+  struct Entry
+  {
+    std::string key;
+    std::string data;
+      /// Opaque value stored with the key, for example a Call-ID
+    OSS::UInt64 expires;
+      /// Deadline in seconds since the epoch
+  };
+
+  typedef std::vector<Entry> Entries;
+
+  explicit ExpiryIndex(unsigned int bucketSeconds = 60);
+
+  ~ExpiryIndex();
+
+  bool open(const boost::filesystem::path& journal);
+    /// Load the journal if it exists and record every later change in it.
+    /// Returns false if the journal cannot be written.  The in-memory index
+    /// keeps working either way.
+
+  void close();
+    /// Stop journaling.  The entries stay in memory.
+
+  void add(const std::string& key, OSS::UInt64 expires, const std::string& data = std::string());
+    /// Insert key or move it to a new deadline, replacing its data
+
+  bool touch(const std::string& key, OSS::UInt64 expires);
+    /// Move an existing key to a new deadline and keep its data.  Returns
+    /// false if the key is not indexed.
+
+  bool remove(const std::string& key);
+    /// Forget key.  Returns false if it was not indexed.
+
+  std::size_t popExpired(OSS::UInt64 now, std::size_t maxCount, Entries& expired);
+    /// Remove up to maxCount entries that are due at now and append them to
+    /// expired, oldest bucket first.  Returns the number of entries added.
+
+  bool has(const std::string& key) const;
+
+  std::size_t size() const;
+
+  bool isOpen() const;
+
+  void compact();
+    /// Rewrite the journal with only the live entries
+
+  bool compactIfStale();
+    /// Rewrite the journal if stale records outnumber live ones.  The
+    /// rewrite holds the index lock through an fsync, so call this from a
+    /// housekeeping thread.  Returns true if the journal was rewritten.
+
+private:
+  struct Record
+  {
+    OSS::UInt64 expires;
+    OSS::UInt64 bucket;
+    std::string data;
+  };
+
+  typedef boost::unordered_map<std::string, Record> Records;
+  typedef boost::unordered_set<std::string> Keys;
+  typedef std::map<OSS::UInt64, Keys> Buckets;
+
+  OSS::UInt64 bucketOf(OSS::UInt64 expires) const;
+  void insert(const std::string& key, OSS::UInt64 expires, const std::string& data);
+  bool erase(const std::string& key);
+  void load(const boost::filesystem::path& journal);
+  bool rewrite();
+  void journalAdd(char type, const std::string& key, OSS::UInt64 expires, const std::string& data);
+  void journalRemove(const std::string& key);
+  void journalFlush();
+
+  unsigned int _bucketSeconds;
+  Records _records;
+  Buckets _buckets;
+  mutable boost::mutex _mutex;
+  boost::filesystem::path _journalPath;
+  std::FILE* _journal;
+  std::size_t _journalRecords;
+};
+
+
+//
+// Inlines
+//
+
+inline OSS::UInt64 ExpiryIndex::bucketOf(OSS::UInt64 expires) const
+{
+  return (expires + _bucketSeconds - 1) / _bucketSeconds;
+}
+
+
+} // OSS
+
+#endif // OSS_EXPIRYINDEX_H_INCLUDED
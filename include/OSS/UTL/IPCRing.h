@@ -0,0 +1,187 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef OSS_IPCRING_H_INCLUDED
+#define OSS_IPCRING_H_INCLUDED
+
+
+#include <string>
+#include <boost/noncopyable.hpp>
+
+#include "OSS/OSS.h"
+
+
+namespace OSS {
+
+
+class IPCRing : boost::noncopyable
+  /// Shared-memory ring of variable-length records for passing data between
+  /// processes.
+  ///
+  /// The process that calls create() owns the segment and is the consumer.
+  /// Any number of processes may attach with open() and write.  Producers
+  /// reserve space with a single compare-and-swap and publish the record by
+  /// storing its header last, so a single producer never waits on another
+  /// and multiple producers only contend on the reservation cursor.
+  ///
+  /// Readers get a view into the ring with read(Record&) and hand the space
+  /// back with release().  Idle readers and writers sleep on a futex in the
+  /// shared segment instead of polling.
+  ///
+  /// A producer that dies after reserving space but before committing would
+  /// stop the reader at its record.  Producers mark the reservation with the
+  /// record size right after the compare-and-swap, so the reader can skip a
+  /// record that stays uncommitted for longer than the reclaim timeout.  A
+  /// producer stalled past the timeout loses its record.  If the reservation
+  /// was never marked, the ring is shut down as corrupt.  A record header
+  /// with an impossible size or flags is treated the same way.
+{
+public:
+  struct Record
+  {
+    const char* data;
+    std::size_t size;
+    OSS::UInt64 next;
+      /// Ring position after this record.  Used by release().
+
+    Record() : data(0), size(0), next(0) {}
+  };
+
+  IPCRing();
+
+  ~IPCRing();
+
+  bool create(const std::string& name, std::size_t capacity);
+    /// Create the shared-memory segment named name (for example "/sbc-cdr")
+    /// and become its consumer.  An existing segment with the same name is
+    /// replaced.  The capacity is rounded up to a power of two.
+
+  bool open(const std::string& name);
+    /// Attach to a segment created by another process as a producer
+
+  void shutdown();
+    /// Mark the ring closed and wake every blocked reader and writer.  Call
+    /// this and join local reader threads before close().
+
+  void close();
+    /// Detach from the segment.  The owner also shuts the ring down and
+    /// unlinks its name.
+
+  bool write(const char* data, std::size_t size, bool blocking = true);
+    /// Append a record.  Returns false if the record can never fit, the ring
+    /// is closed or, when not blocking, the ring is full.
+
+  bool write(const std::string& data, bool blocking = true);
+
+  bool read(Record& record, bool blocking = true);
+    /// Return a view of the oldest record.  The view stays valid until
+    /// release() is called for it.  Records must be released in order.
+
+  void release(const Record& record);
+    /// Give the space used by record back to the producers
+
+  bool read(std::string& data, bool blocking = true);
+    /// Copying read for callers that need to keep the data
+
+  bool isOpen() const;
+
+  bool isOwner() const;
+
+  std::size_t capacity() const;
+    /// Usable bytes in the ring
+
+  std::size_t maxRecordSize() const;
+    /// Largest payload write() accepts
+
+  const std::string& getName() const;
+
+  void setReclaimTimeout(unsigned long milliseconds);
+    /// Set how long the reader waits for an uncommitted record before it
+    /// reclaims the space.  The default is 5 seconds.
+
+  unsigned long getReclaimTimeout() const;
+
+private:
+  struct Header;
+
+  bool map(int fd, std::size_t size);
+  char* at(OSS::UInt64 position) const;
+  bool isValidRecord(OSS::UInt64 position, OSS::UInt64 word) const;
+  bool reclaim(OSS::UInt64 position, OSS::UInt64 word);
+  void markCorrupt(OSS::UInt64 position, OSS::UInt64 word);
+
+  std::string _name;
+  Header* _pHeader;
+  char* _pData;
+  std::size_t _mapSize;
+  OSS::UInt64 _mask;
+  bool _isOwner;
+  unsigned long _reclaimTimeout;
+  OSS::UInt64 _stallPosition;
+  OSS::UInt64 _stallSince;
+};
+
+//
+// Inlines
+//
+
+inline bool IPCRing::write(const std::string& data, bool blocking)
+{
+  return write(data.data(), data.size(), blocking);
+}
+
+inline bool IPCRing::isOpen() const
+{
+  return _pHeader != 0;
+}
+
+inline bool IPCRing::isOwner() const
+{
+  return _isOwner;
+}
+
+inline std::size_t IPCRing::capacity() const
+{
+  return _pHeader ? (std::size_t)(_mask + 1) : 0;
+}
+
+inline const std::string& IPCRing::getName() const
+{
+  return _name;
+}
+
+inline void IPCRing::setReclaimTimeout(unsigned long milliseconds)
+{
+  _reclaimTimeout = milliseconds;
+}
+
+inline unsigned long IPCRing::getReclaimTimeout() const
+{
+  return _reclaimTimeout;
+}
+
+inline char* IPCRing::at(OSS::UInt64 position) const
+{
+  return _pData + (position & _mask);
+}
+
+} // OSS
+
+#endif // OSS_IPCRING_H_INCLUDED
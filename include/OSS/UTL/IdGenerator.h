@@ -0,0 +1,81 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+#ifndef OSS_IDGENERATOR_H_INCLUDED
+#define OSS_IDGENERATOR_H_INCLUDED
+
+
+#include <string>
+
+#include "OSS/OSS.h"
+
+
+namespace OSS {
+
+
+class OSS_API IdGenerator
+  /// Fast generator for SIP branches, tags and Call-IDs.
+  ///
+  /// Every thread owns a ChaCha20 keystream keyed from getrandom() or
+  /// /dev/urandom, so identifiers cannot be predicted from earlier ones,
+  /// generating one takes no lock and, with the buffer variants, allocates
+  /// nothing.  Output uses 5 random bits per character from a lower case
+  /// alphanumeric alphabet, which is valid in every SIP token.
+{
+public:
+  enum
+  {
+    BRANCH_LENGTH = 31,
+      /// "z9hG4bK" followed by 24 random characters (120 bits)
+    TAG_LENGTH = 16,
+      /// 80 random bits
+    CALL_ID_LENGTH = 32
+      /// 160 random bits
+  };
+
+  static OSS::UInt64 next();
+    /// Next 64 random bits for the calling thread
+
+  static char* generate(char* buffer, std::size_t length);
+    /// Write length random characters followed by a null terminator.
+    /// buffer must hold length + 1 bytes.
+
+  static char* createBranch(char* buffer);
+    /// Write an RFC 3261 magic cookie branch.  buffer must hold
+    /// BRANCH_LENGTH + 1 bytes.
+
+  static char* createTag(char* buffer);
+    /// buffer must hold TAG_LENGTH + 1 bytes
+
+  static char* createCallId(char* buffer);
+    /// buffer must hold CALL_ID_LENGTH + 1 bytes
+
+  static std::string createBranch();
+
+  static std::string createTag();
+
+  static std::string createCallId();
+};
+
+
+} // OSS
+
+#endif // OSS_IDGENERATOR_H_INCLUDED
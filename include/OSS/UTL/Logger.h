@@ -26,6 +26,7 @@
 #include <string>
 #include <boost/filesystem.hpp>
 #include <boost/function.hpp>
+#include <boost/atomic.hpp>
 
 #include "OSS/OSS.h"
 
@@ -47,14 +48,32 @@ enum LogPriority
 
 typedef boost::function<void(const std::string&, LogPriority)> ExternalLogger;
 
+extern OSS_API boost::atomic<int> log_gate_level;
+  /// The lowest priority (highest numeric value) that can currently produce
+  /// output.  It is recomputed whenever the level, the external logger or the
+  /// enable flags change.  Do not modify directly.
+
+inline bool log_is_enabled(LogPriority priority)
+  /// Returns true if a message with the given priority would be written.
+  /// The OSS_LOG_* macros test this before formatting so that a disabled
+  /// level only costs a branch.
+{
+  return priority <= log_gate_level.load(boost::memory_order_relaxed);
+}
+
 void OSS_API logger_init(
   const std::string& path,
   LogPriority level = OSS::PRIO_INFORMATION,
   const std::string& format = "%Y-%m-%d %H:%M:%S %s: [%p] %t",
   const std::string& compress = "true",
   const std::string& purgeCount = "7",
-  const std::string& times = "UTC");
-  /// Initialize the logging subsystem from the config specified
+  const std::string& times = "UTC",
+  bool async = false);
+  /// Initialize the logging subsystem from the config specified.
+  ///
+  /// If async is true, messages are queued in per-thread lock-free buffers
+  /// and a single writer thread formats them and writes them to the rotated
+  /// file.  Fatal and critical messages are always written synchronously.
 
 void logger_init_external(const ExternalLogger& externalLogger);
 
@@ -79,9 +98,12 @@ void OSS_API log_fatal(const std::string& log);
 
 #define OSS_LOG_FATAL(log) \
 { \
-  std::ostringstream strm; \
-  strm << log; \
-  OSS::log_fatal(strm.str()); \
+  if (OSS::log_is_enabled(OSS::PRIO_FATAL)) \
+  { \
+    std::ostringstream strm; \
+    strm << log; \
+    OSS::log_fatal(strm.str()); \
+  } \
 }
 
 void OSS_API log_critical(const std::string& log);
@@ -89,9 +111,12 @@ void OSS_API log_critical(const std::string& log);
 
 #define OSS_LOG_CRITICAL(log) \
 { \
-  std::ostringstream strm; \
-  strm << log; \
-  OSS::log_critical(strm.str()); \
+  if (OSS::log_is_enabled(OSS::PRIO_CRITICAL)) \
+  { \
+    std::ostringstream strm; \
+    strm << log; \
+    OSS::log_critical(strm.str()); \
+  } \
 }
 
 void OSS_API log_error(const std::string& log);
@@ -106,9 +131,12 @@ void OSS_API log_enable_logging(bool yes);
 
 #define OSS_LOG_ERROR(log) \
 { \
-  std::ostringstream strm; \
-  strm << log; \
-  OSS::log_error(strm.str()); \
+  if (OSS::log_is_enabled(OSS::PRIO_ERROR)) \
+  { \
+    std::ostringstream strm; \
+    strm << log; \
+    OSS::log_error(strm.str()); \
+  } \
 }
 
 void OSS_API log_warning(const std::string& log);
@@ -116,9 +144,12 @@ void OSS_API log_warning(const std::string& log);
 
 #define OSS_LOG_WARNING(log) \
 { \
-  std::ostringstream strm; \
-  strm << log; \
-  OSS::log_warning(strm.str()); \
+  if (OSS::log_is_enabled(OSS::PRIO_WARNING)) \
+  { \
+    std::ostringstream strm; \
+    strm << log; \
+    OSS::log_warning(strm.str()); \
+  } \
 }
 
 void OSS_API log_notice(const std::string& log);
@@ -126,9 +157,12 @@ void OSS_API log_notice(const std::string& log);
 
 #define OSS_LOG_NOTICE(log) \
 { \
-  std::ostringstream strm; \
-  strm << log; \
-  OSS::log_notice(strm.str()); \
+  if (OSS::log_is_enabled(OSS::PRIO_NOTICE)) \
+  { \
+    std::ostringstream strm; \
+    strm << log; \
+    OSS::log_notice(strm.str()); \
+  } \
 }
 
 void OSS_API log_information(const std::string& log);
@@ -136,9 +170,12 @@ void OSS_API log_information(const std::string& log);
 
 #define OSS_LOG_INFO(log) \
 { \
-  std::ostringstream strm; \
-  strm << log; \
-  OSS::log_information(strm.str()); \
+  if (OSS::log_is_enabled(OSS::PRIO_INFORMATION)) \
+  { \
+    std::ostringstream strm; \
+    strm << log; \
+    OSS::log_information(strm.str()); \
+  } \
 }
 
 
@@ -147,9 +184,12 @@ void OSS_API log_debug(const std::string& log);
 
 #define OSS_LOG_DEBUG(log) \
 { \
-  std::ostringstream strm; \
-  strm << log; \
-  OSS::log_debug(strm.str()); \
+  if (OSS::log_is_enabled(OSS::PRIO_DEBUG)) \
+  { \
+    std::ostringstream strm; \
+    strm << log; \
+    OSS::log_debug(strm.str()); \
+  } \
 }
 
 void OSS_API log_trace(const std::string& log);
@@ -157,9 +197,12 @@ void OSS_API log_trace(const std::string& log);
 
 #define OSS_LOG_TRACE(log) \
 { \
-  std::ostringstream strm; \
-  strm << log; \
-  OSS::log_trace(strm.str()); \
+  if (OSS::log_is_enabled(OSS::PRIO_TRACE)) \
+  { \
+    std::ostringstream strm; \
+    strm << log; \
+    OSS::log_trace(strm.str()); \
+  } \
 }
 
 #ifdef _DEBUG
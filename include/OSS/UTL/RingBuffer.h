@@ -0,0 +1,192 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+#ifndef OSS_RINGBUFFER_H_INCLUDED
+#define OSS_RINGBUFFER_H_INCLUDED
+
+
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+
+#include "OSS/OSS.h"
+
+
+namespace OSS {
+
+
+#define OSS_CACHE_LINE_SIZE 64
+
+
+template <typename T>
+class RingBuffer : boost::noncopyable
+  /// Bounded lock-free multi-producer queue.
+  ///
+  /// Each slot carries a sequence number that tells producers and consumers
+  /// whether the slot is free or holds data for the current lap around the
+  /// ring.  Producers and consumers only contend on their own cursor, never
+  /// on a lock.  The capacity is rounded up to a power of two.
+  ///
+  /// Safe for any number of producers.  Multiple consumers are also safe
+  /// although the intended use is a single draining thread.
+{
+public:
+  explicit RingBuffer(std::size_t capacity);
+
+  ~RingBuffer();
+
+  bool tryEnqueue(const T& data);
+    /// Returns false if the ring is full
+
+  bool tryDequeue(T& data);
+    /// Returns false if the ring is empty
+
+  std::size_t size() const;
+    /// Approximate number of items in the ring
+
+  std::size_t capacity() const;
+
+  bool empty() const;
+
+private:
+  struct Slot
+  {
+    boost::atomic<std::size_t> sequence;
+    T data;
+  };
+
+  char _pad0[OSS_CACHE_LINE_SIZE];
+  Slot* _slots;
+  std::size_t _mask;
+  char _pad1[OSS_CACHE_LINE_SIZE];
+  boost::atomic<std::size_t> _enqueuePos;
+  char _pad2[OSS_CACHE_LINE_SIZE];
+  boost::atomic<std::size_t> _dequeuePos;
+  char _pad3[OSS_CACHE_LINE_SIZE];
+};
+
+//
+// Inlines
+//
+
+template <typename T>
+RingBuffer<T>::RingBuffer(std::size_t capacity) :
+  _slots(0),
+  _mask(0),
+  _enqueuePos(0),
+  _dequeuePos(0)
+{
+  std::size_t size = 2;
+  while (size < capacity)
+    size <<= 1;
+  _mask = size - 1;
+  _slots = new Slot[size];
+  for (std::size_t i = 0; i < size; i++)
+    _slots[i].sequence.store(i, boost::memory_order_relaxed);
+}
+
+template <typename T>
+RingBuffer<T>::~RingBuffer()
+{
+  delete [] _slots;
+}
+
+template <typename T>
+bool RingBuffer<T>::tryEnqueue(const T& data)
+{
+  std::size_t pos = _enqueuePos.load(boost::memory_order_relaxed);
+  Slot* pSlot;
+  while (true)
+  {
+    pSlot = &_slots[pos & _mask];
+    std::size_t seq = pSlot->sequence.load(boost::memory_order_acquire);
+    std::ptrdiff_t diff = (std::ptrdiff_t)seq - (std::ptrdiff_t)pos;
+    if (diff == 0)
+    {
+      if (_enqueuePos.compare_exchange_weak(pos, pos + 1, boost::memory_order_relaxed))
+        break;
+    }
+    else if (diff < 0)
+    {
+      return false;
+    }
+    else
+    {
+      pos = _enqueuePos.load(boost::memory_order_relaxed);
+    }
+  }
+  pSlot->data = data;
+  pSlot->sequence.store(pos + 1, boost::memory_order_release);
+  return true;
+}
+
+template <typename T>
+bool RingBuffer<T>::tryDequeue(T& data)
+{
+  std::size_t pos = _dequeuePos.load(boost::memory_order_relaxed);
+  Slot* pSlot;
+  while (true)
+  {
+    pSlot = &_slots[pos & _mask];
+    std::size_t seq = pSlot->sequence.load(boost::memory_order_acquire);
+    std::ptrdiff_t diff = (std::ptrdiff_t)seq - (std::ptrdiff_t)(pos + 1);
+    if (diff == 0)
+    {
+      if (_dequeuePos.compare_exchange_weak(pos, pos + 1, boost::memory_order_relaxed))
+        break;
+    }
+    else if (diff < 0)
+    {
+      return false;
+    }
+    else
+    {
+      pos = _dequeuePos.load(boost::memory_order_relaxed);
+    }
+  }
+  data = pSlot->data;
+  pSlot->data = T();
+  pSlot->sequence.store(pos + _mask + 1, boost::memory_order_release);
+  return true;
+}
+
+template <typename T>
+std::size_t RingBuffer<T>::size() const
+{
+  std::size_t enqueuePos = _enqueuePos.load(boost::memory_order_relaxed);
+  std::size_t dequeuePos = _dequeuePos.load(boost::memory_order_relaxed);
+  return enqueuePos > dequeuePos ? enqueuePos - dequeuePos : 0;
+}
+
+template <typename T>
+std::size_t RingBuffer<T>::capacity() const
+{
+  return _mask + 1;
+}
+
+template <typename T>
+bool RingBuffer<T>::empty() const
+{
+  return size() == 0;
+}
+
+} // OSS
+
+#endif // OSS_RINGBUFFER_H_INCLUDED
@@ -271,6 +271,7 @@ inline bool ServiceOptions::parseOptions(bool verbose)
         "0 (EMERG) 1 (ALERT) 2 (CRIT) 3 (ERR) 4 (WARNING) 5 (NOTICE) 6 (INFO) 7 (DEBUG)"
               , GeneralOption);
       addOptionFlag("log-no-compress", ": Specify if logs will be compressed after rotation.", GeneralOption);
+      addOptionFlag("log-async", ": Write logs from a background thread instead of the logging thread.", GeneralOption);
       addOptionInt("log-purge-count", ": Specify the number of archive to maintain.", GeneralOption);
       addOptionString("log-pattern", ": Specify the pattern of the log headers. Default is \"%Y-%m-%d %H:%M:%S %s: [%p] %t\"", GeneralOption);
       addOptionString("log-times", ": Specifies whether times are adjusted for local time or taken as they are in UTC. Supported values are \"local\" and \"UTC\"", GeneralOption);
@@ -396,6 +397,8 @@ inline void ServiceOptions::prepareLogger()
   if (hasOption("log-no-compress", true))
     compress = false;
 
+  bool async = hasOption("log-async", true);
+
   getOption("log-purge-count", purgeCount, purgeCount);
   getOption("log-pattern", pattern, pattern);
   getOption("log-times", times, times);
@@ -404,7 +407,7 @@ inline void ServiceOptions::prepareLogger()
   {
     if (!getOption("log-level", priorityLevel))
       priorityLevel = 6;
-    OSS::logger_init(logFile, (OSS::LogPriority)priorityLevel, pattern, compress ? "true" : "false", boost::lexical_cast<std::string>(purgeCount), times);
+    OSS::logger_init(logFile, (OSS::LogPriority)priorityLevel, pattern, compress ? "true" : "false", boost::lexical_cast<std::string>(purgeCount), times, async);
   }
   else
   {
@@ -0,0 +1,180 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare 
+// derivative works of the Software, all subject to the 
+// "GNU Lesser General Public License (LGPL)".
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef OSS_TASKEXECUTOR_H_INCLUDED
+#define OSS_TASKEXECUTOR_H_INCLUDED
+
+
+#include <vector>
+#include <string>
+#include <boost/noncopyable.hpp>
+#include <boost/function.hpp>
+#include <boost/atomic.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/tss.hpp>
+
+#include "OSS/OSS.h"
+#include "OSS/UTL/Thread.h"
+
+
+namespace OSS {
+
+
+class OSS_API TaskExecutor : boost::noncopyable
+  /// An elastic work-stealing executor.
+  ///
+  /// Each worker owns a bounded circular deque of preallocated task slots.
+  /// Tasks scheduled from a worker thread go to that worker's deque.  Tasks
+  /// scheduled from any other thread are spread round-robin, or placed on
+  /// the worker selected by an affinity key (eg. a Call-ID) so that related
+  /// work tends to run on the same core.  Workers pop from the front of
+  /// their own deque and, when it is empty, steal from the back of the
+  /// others before going idle.
+  ///
+  /// The executor starts with workerCount threads and adds a worker, up to
+  /// maxWorkers, whenever a task is queued while every worker is busy.
+  /// Workers are not retired once started.
+  ///
+  /// Admission is bounded by the total number of slots.  schedule() only
+  /// fails when every slot is taken and the pool can no longer grow, so a
+  /// burst is queued and absorbed by idle workers rather than rejected.
+{
+public:
+  typedef boost::function<void()> Task;
+
+  TaskExecutor(std::size_t workerCount, std::size_t queueSize = 1024, std::size_t maxWorkers = 0);
+    /// Creates the executor and starts workerCount threads.  Each worker
+    /// can hold queueSize pending tasks.  The pool grows on demand up to
+    /// maxWorkers threads.  A maxWorkers of zero keeps the size fixed.
+
+  ~TaskExecutor();
+    /// Stops the workers.  Tasks that have not started are discarded.
+
+  int schedule(const Task& task);
+    /// Queue a task.  Returns the number of pending tasks if successful
+    /// or -1 if the executor is full or stopped.
+
+  int schedule(const Task& task, const std::string& affinityKey);
+    /// Queue a task on the worker selected by affinityKey.  The key is a
+    /// placement hint.  An idle worker may still steal the task.
+
+  void join();
+    /// Waits until there are no pending or running tasks.
+
+  void stop();
+    /// Stops all workers.  Called by the destructor.
+
+  std::size_t getWorkerCount() const;
+    /// Returns the number of worker threads
+
+  std::size_t getMaxWorkerCount() const;
+    /// Returns the number of worker threads the pool may grow to
+
+  std::size_t getPendingCount() const;
+    /// Returns the number of queued tasks that have not started
+
+  std::size_t getActiveCount() const;
+    /// Returns the number of tasks currently running
+
+  std::size_t getCapacity() const;
+    /// Returns the maximum number of queued tasks
+
+  std::size_t getStolenCount() const;
+    /// Returns the number of tasks executed by a worker other than the one
+    /// they were queued on
+
+protected:
+  struct Worker
+  {
+    Worker(std::size_t index, std::size_t size);
+    ~Worker();
+    bool pushBack(const Task& task);
+    bool popFront(Task& task);
+    bool popBack(Task& task);
+
+    OSS::mutex_critic_sec mutex;
+    Task* slots;
+    std::size_t index;
+    std::size_t size;
+    std::size_t head;
+    std::size_t count;
+    boost::thread* thread;
+  };
+
+  static void releaseWorker(Worker* pWorker);
+  bool grow();
+  int enqueue(const Task& task, std::size_t home);
+  bool dequeue(std::size_t index, Task& task);
+  void run(std::size_t index);
+
+  std::vector<Worker*> _workers;
+  boost::thread_specific_ptr<Worker> _currentWorker;
+  std::size_t _queueSize;
+  OSS::mutex_critic_sec _growMutex;
+  boost::atomic<std::size_t> _workerCount;
+  boost::atomic<std::size_t> _capacity;
+  boost::atomic<bool> _isRunning;
+  boost::atomic<std::size_t> _pending;
+  boost::atomic<std::size_t> _active;
+  boost::atomic<std::size_t> _stolen;
+  boost::atomic<std::size_t> _nextWorker;
+  boost::atomic<std::size_t> _idleCount;
+  boost::mutex _idleMutex;
+  boost::condition_variable _idleCondition;
+};
+
+//
+// Inlines
+//
+
+inline std::size_t TaskExecutor::getWorkerCount() const
+{
+  return _workerCount.load(boost::memory_order_acquire);
+}
+
+inline std::size_t TaskExecutor::getMaxWorkerCount() const
+{
+  return _workers.size();
+}
+
+inline std::size_t TaskExecutor::getPendingCount() const
+{
+  return _pending;
+}
+
+inline std::size_t TaskExecutor::getActiveCount() const
+{
+  return _active;
+}
+
+inline std::size_t TaskExecutor::getCapacity() const
+{
+  return _capacity;
+}
+
+inline std::size_t TaskExecutor::getStolenCount() const
+{
+  return _stolen;
+}
+
+
+} // OSS
+
+#endif // OSS_TASKEXECUTOR_H_INCLUDED
@@ -141,7 +141,12 @@ public:
 
   int schedule(boost::function<void()> task);
     /// Schedule a task for execution.  Returns the number of
-    /// currently used thread if successful or -1 if unsuccessful.
+    /// pending tasks if successful or -1 if the queue is full.
+
+  int schedule(boost::function<void()> task, const std::string& affinityKey);
+    /// Schedule a task on the worker selected by affinityKey (eg. a Call-ID).
+    /// Returns the number of pending tasks if successful or -1 if the queue
+    /// is full.
   
   void schedule(boost::function<void()> task, int millis);
     /// Schedule a task for execution (with delay). 
@@ -154,6 +159,15 @@ public:
     /// Schedule a task with a void* argument.  Returns the number of
     /// currently used thread if successful or -1 if unsuccessful.
 
+  std::size_t get_pending_count() const;
+    /// Returns the number of queued tasks that have not started
+
+  std::size_t get_active_count() const;
+    /// Returns the number of tasks currently running
+
+  std::size_t get_capacity() const;
+    /// Returns the maximum number of queued tasks
+
   static void static_join();
     /// Waits for all threads in the deafult thread pool to complete.
 
@@ -0,0 +1,359 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include "OSS/SIP/B2BUA/SIPB2BAdmissionControl.h"
+#if ENABLE_FEATURE_B2BUA
+
+#include <algorithm>
+#include <boost/bind.hpp>
+
+#include "OSS/SIP/SIPStack.h"
+#include "OSS/UTL/Logger.h"
+#include "OSS/UTL/CoreUtils.h"
+
+
+namespace OSS {
+namespace SIP {
+namespace B2BUA {
+
+
+static const long ADMISSION_PROBE_INTERVAL_MS = 100;
+
+static const char* admission_level_name(int level)
+{
+  switch (level)
+  {
+  case SIPB2BAdmissionControl::LEVEL_OVERLOADED:
+    return "OVERLOADED";
+  case SIPB2BAdmissionControl::LEVEL_CRITICAL:
+    return "CRITICAL";
+  default:
+    return "NORMAL";
+  }
+}
+
+SIPB2BAdmissionControl::Level SIPB2BAdmissionControl::computeSignalLevel(
+  double value, double overloaded, double critical, Level current, double hysteresis)
+{
+  //
+  // A threshold is scaled down by the hysteresis factor while we are
+  // already at or above its level so that the level does not flap
+  //
+  if (critical > 0 && value >= critical * (current >= LEVEL_CRITICAL ? hysteresis : 1.0))
+    return LEVEL_CRITICAL;
+  if (overloaded > 0 && value >= overloaded * (current >= LEVEL_OVERLOADED ? hysteresis : 1.0))
+    return LEVEL_OVERLOADED;
+  return LEVEL_NORMAL;
+}
+
+SIPB2BAdmissionControl::Thresholds::Thresholds() :
+  queueOverloaded(0.5),
+  queueCritical(0.9),
+  transactionsOverloaded(0),
+  transactionsCritical(0),
+  lagOverloaded(100),
+  lagCritical(500),
+  hysteresis(0.8),
+  retryAfter(5)
+{
+}
+
+SIPB2BAdmissionControl::SIPB2BAdmissionControl(OSS::thread_pool& threadPool, SIPStack& stack) :
+  _threadPool(threadPool),
+  _stack(stack),
+  _enabled(true),
+  _level(LEVEL_NORMAL),
+  _lag(0),
+  _admitted(0),
+  _shed(0),
+  _probeTimer(stack.transport().ioService()),
+  _probeRunning(false),
+  _probePrimed(false)
+{
+}
+
+SIPB2BAdmissionControl::~SIPB2BAdmissionControl()
+{
+  stop();
+}
+
+void SIPB2BAdmissionControl::start()
+{
+  if (_probeRunning)
+    return;
+  _probeRunning = true;
+  _probePrimed = false;
+  scheduleProbe();
+}
+
+void SIPB2BAdmissionControl::stop()
+{
+  if (!_probeRunning)
+    return;
+  _probeRunning = false;
+  boost::system::error_code ignored;
+  _probeTimer.cancel(ignored);
+}
+
+void SIPB2BAdmissionControl::scheduleProbe()
+{
+  _probeExpected = boost::posix_time::microsec_clock::universal_time() + boost::posix_time::milliseconds(ADMISSION_PROBE_INTERVAL_MS);
+  _probeTimer.expires_at(_probeExpected);
+  _probeTimer.async_wait(boost::bind(&SIPB2BAdmissionControl::onProbeTimer, this, boost::asio::placeholders::error));
+}
+
+void SIPB2BAdmissionControl::onProbeTimer(const boost::system::error_code& e)
+{
+  if (e || !_probeRunning)
+    return;
+
+  //
+  // The probe is armed before the io service runs so the first sample
+  // measures startup time rather than lag.  Discard it.
+  //
+  long lag = 0;
+  if (_probePrimed)
+  {
+    lag = (boost::posix_time::microsec_clock::universal_time() - _probeExpected).total_milliseconds();
+    if (lag < 0)
+      lag = 0;
+  }
+  _probePrimed = true;
+  _lag = lag;
+
+  int current = _level;
+  int level = computeLevel(static_cast<Level>(current));
+  if (level != current)
+  {
+    _level = level;
+    Metrics metrics = getMetrics();
+    OSS_LOG_WARNING("SIPB2BAdmissionControl - Load level changed from " << admission_level_name(current)
+      << " to " << admission_level_name(level)
+      << " queue: " << metrics.queueDepth << "/" << metrics.queueCapacity
+      << " transactions: " << metrics.transactions
+      << " lag: " << metrics.lag << " ms"
+      << " admitted: " << metrics.admitted
+      << " shed: " << metrics.shed);
+  }
+
+  scheduleProbe();
+}
+
+SIPB2BAdmissionControl::Level SIPB2BAdmissionControl::computeLevel(Level current) const
+{
+  Thresholds thresholds = getThresholds();
+  std::size_t capacity = _threadPool.get_capacity();
+  double queueRatio = capacity ? (double)_threadPool.get_pending_count() / (double)capacity : 0;
+
+  Level level = computeSignalLevel(queueRatio,
+    thresholds.queueOverloaded, thresholds.queueCritical, current, thresholds.hysteresis);
+
+  if (thresholds.transactionsOverloaded || thresholds.transactionsCritical)
+  {
+    level = std::max(level, computeSignalLevel((double)_stack.getServerTransactionCount(),
+      (double)thresholds.transactionsOverloaded, (double)thresholds.transactionsCritical, current, thresholds.hysteresis));
+  }
+
+  level = std::max(level, computeSignalLevel((double)_lag.load(),
+    (double)thresholds.lagOverloaded, (double)thresholds.lagCritical, current, thresholds.hysteresis));
+
+  return level;
+}
+
+void SIPB2BAdmissionControl::setThresholds(const Thresholds& thresholds)
+{
+  OSS::mutex_critic_sec_lock lock(_thresholdsMutex);
+  _thresholds = thresholds;
+}
+
+SIPB2BAdmissionControl::Thresholds SIPB2BAdmissionControl::getThresholds() const
+{
+  OSS::mutex_critic_sec_lock lock(_thresholdsMutex);
+  return _thresholds;
+}
+
+bool SIPB2BAdmissionControl::peekRequest(const std::string& data, std::string& method, bool& inDialog)
+{
+  method = std::string();
+  inDialog = false;
+
+  std::size_t start = data.find_first_not_of("\r\n");
+  if (start == std::string::npos)
+    return false;
+  std::size_t end = data.find(' ', start);
+  if (end == std::string::npos || end == start)
+    return false;
+  method = data.substr(start, end - start);
+  if (OSS::string_starts_with(method, "SIP/"))
+  {
+    method = std::string();
+    return false;
+  }
+
+  //
+  // Walk the header lines until the blank line that ends them.  Only the
+  // To header (or its compact form) is of interest.
+  //
+  std::size_t pos = data.find('\n', end);
+  while (pos != std::string::npos)
+  {
+    std::size_t lineStart = pos + 1;
+    std::size_t lineEnd = data.find('\n', lineStart);
+    std::string line = data.substr(lineStart, lineEnd == std::string::npos ? std::string::npos : lineEnd - lineStart);
+    OSS::string_trim(line);
+    if (line.empty())
+      break;
+
+    std::size_t colon = line.find(':');
+    if (colon != std::string::npos)
+    {
+      std::string name = line.substr(0, colon);
+      OSS::string_trim(name);
+      OSS::string_to_lower(name);
+      if (name == "to" || name == "t")
+      {
+        //
+        // Parameters of the header follow the closing bracket of the URI
+        // if there is one.  Spaces around the separators are allowed.
+        //
+        std::string params = line.substr(colon + 1);
+        std::size_t bracket = params.rfind('>');
+        if (bracket != std::string::npos)
+          params = params.substr(bracket + 1);
+        params.erase(std::remove(params.begin(), params.end(), ' '), params.end());
+        params.erase(std::remove(params.begin(), params.end(), '\t'), params.end());
+        OSS::string_to_lower(params);
+        inDialog = params.find(";tag=") != std::string::npos;
+        break;
+      }
+    }
+    pos = lineEnd;
+  }
+  return true;
+}
+
+bool SIPB2BAdmissionControl::isPriorityRequest(const std::string& method, bool inDialog)
+{
+  std::string lower = method;
+  OSS::string_to_lower(lower);
+  if (lower == "bye" || lower == "cancel" || lower == "ack" || lower == "prack")
+  {
+    return true;
+  }
+  return inDialog;
+}
+
+bool SIPB2BAdmissionControl::isDialogCreatingRequest(const std::string& method, bool inDialog)
+{
+  if (inDialog)
+    return false;
+
+  std::string lower = method;
+  OSS::string_to_lower(lower);
+  return lower == "invite" || lower == "subscribe" || lower == "refer";
+}
+
+bool SIPB2BAdmissionControl::shouldReject(Level level, const std::string& method, bool inDialog)
+{
+  if (isPriorityRequest(method, inDialog))
+    return false;
+  if (level == LEVEL_CRITICAL)
+    return true;
+  return level == LEVEL_OVERLOADED && isDialogCreatingRequest(method, inDialog);
+}
+
+SIPMessage::Ptr SIPB2BAdmissionControl::admit(const SIPMessage::Ptr& pRequest, const SIPTransportSession::Ptr& pTransport)
+{
+  SIPMessage::Ptr pResponse;
+  try
+  {
+    std::string method;
+    bool inDialog = false;
+    if (!peekRequest(pRequest->data(), method, inDialog))
+      return pResponse;
+
+    if (!_enabled || isPriorityRequest(method, inDialog))
+    {
+      _admitted.fetch_add(1, boost::memory_order_relaxed);
+      return pResponse;
+    }
+
+    //
+    // The thread pool queue can fill up faster than the probe interval.
+    // Check it here as well since it only costs two atomic loads.
+    //
+    Level level = getLevel();
+    Thresholds thresholds = getThresholds();
+    std::size_t capacity = _threadPool.get_capacity();
+    if (capacity)
+    {
+      double queueRatio = (double)_threadPool.get_pending_count() / (double)capacity;
+      level = std::max(level, computeSignalLevel(queueRatio,
+        thresholds.queueOverloaded, thresholds.queueCritical, level, thresholds.hysteresis));
+    }
+
+    if (!shouldReject(level, method, inDialog))
+    {
+      _admitted.fetch_add(1, boost::memory_order_relaxed);
+      return pResponse;
+    }
+
+    //
+    // The response needs the Via, From, To, Call-ID and CSeq of the request
+    // so a rejected request is the only one parsed here
+    //
+    if (pRequest->startLine().empty())
+      pRequest->parse();
+
+    _shed.fetch_add(1, boost::memory_order_relaxed);
+    pResponse = pRequest->createResponse(SIPMessage::CODE_503_ServiceUnavailable, "Overloaded");
+    pResponse->hdrSet(OSS::SIP::HDR_RETRY_AFTER, OSS::string_from_number(thresholds.retryAfter));
+    pResponse->commitData();
+    OSS_LOG_DEBUG(pRequest->createContextId(true) << "SIPB2BAdmissionControl::admit - Rejecting " << method
+      << " from " << pTransport->getRemoteAddress().toIpPortString() << " load level " << admission_level_name(level));
+  }
+  catch(const OSS::Exception& e)
+  {
+    //
+    // A request we cannot respond to is left to the transaction layer
+    //
+    OSS_LOG_WARNING("SIPB2BAdmissionControl::admit - " << e.message());
+    pResponse = SIPMessage::Ptr();
+  }
+  return pResponse;
+}
+
+SIPB2BAdmissionControl::Metrics SIPB2BAdmissionControl::getMetrics() const
+{
+  Metrics metrics;
+  metrics.level = getLevel();
+  metrics.admitted = _admitted;
+  metrics.shed = _shed;
+  metrics.queueDepth = _threadPool.get_pending_count();
+  metrics.queueCapacity = _threadPool.get_capacity();
+  metrics.transactions = _stack.getServerTransactionCount();
+  metrics.lag = _lag;
+  return metrics;
+}
+
+
+} } } // OSS::SIP::B2BUA
+
+#endif // ENABLE_FEATURE_B2BUA
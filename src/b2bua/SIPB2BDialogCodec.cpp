@@ -0,0 +1,386 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+#include "OSS/SIP/B2BUA/SIPB2BDialogCodec.h"
+
+#if ENABLE_FEATURE_B2BUA
+
+#include <zlib.h>
+
+
+namespace OSS {
+namespace SIP {
+namespace B2BUA {
+
+
+static const std::size_t HEADER_SIZE = 5;
+static const OSS::UInt8 FLAG_SDP_COMPRESSED = 0x01;
+static const OSS::UInt8 SDP_RAW = 0;
+static const OSS::UInt8 SDP_ZLIB = 1;
+
+//
+// Writer helpers
+//
+
+static void put_varint(std::string& out, OSS::UInt64 value)
+{
+  while (value >= 0x80)
+  {
+    out.push_back((char)((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  out.push_back((char)value);
+}
+
+static void put_u64(std::string& out, OSS::UInt64 value)
+{
+  char bytes[8];
+  for (int i = 0; i < 8; i++)
+    bytes[i] = (char)((value >> (i * 8)) & 0xFF);
+  out.append(bytes, sizeof(bytes));
+}
+
+static void put_string(std::string& out, const std::string& value)
+{
+  put_varint(out, value.size());
+  out.append(value);
+}
+
+static bool put_sdp(std::string& out, const std::string& sdp, bool compress)
+{
+  if (compress && sdp.size() >= SIPB2BDialogCodec::SDP_COMPRESSION_THRESHOLD)
+  {
+    uLongf compressedSize = compressBound(sdp.size());
+    std::string compressed(compressedSize, '\0');
+    if (compress2((Bytef*)&compressed[0], &compressedSize,
+      (const Bytef*)sdp.data(), sdp.size(), Z_BEST_SPEED) == Z_OK && compressedSize < sdp.size())
+    {
+      out.push_back((char)SDP_ZLIB);
+      put_varint(out, sdp.size());
+      put_varint(out, compressedSize);
+      out.append(compressed.data(), compressedSize);
+      return true;
+    }
+  }
+  out.push_back((char)SDP_RAW);
+  put_string(out, sdp);
+  return false;
+}
+
+static std::size_t leg_size(const SIPB2BDialogData::LegInfo& leg)
+{
+  std::size_t size = leg.dialogId.size() + leg.callId.size() + leg.from.size() +
+    leg.to.size() + leg.remoteContact.size() + leg.localContact.size() +
+    leg.localRecordRoute.size() + leg.remoteIp.size() + leg.transportId.size() +
+    leg.targetTransport.size() + leg.localSdp.size() + leg.remoteSdp.size() +
+    leg.encryption.size() + 64;
+  for (std::vector<std::string>::const_iterator iter = leg.routeSet.begin(); iter != leg.routeSet.end(); iter++)
+    size += iter->size() + 4;
+  return size;
+}
+
+static OSS::UInt8 put_leg(std::string& out, const SIPB2BDialogData::LegInfo& leg, bool compressSdp)
+{
+  OSS::UInt8 flags = 0;
+  put_string(out, leg.dialogId);
+  put_string(out, leg.callId);
+  put_string(out, leg.from);
+  put_string(out, leg.to);
+  put_string(out, leg.remoteContact);
+  put_string(out, leg.localContact);
+  put_string(out, leg.localRecordRoute);
+  put_string(out, leg.remoteIp);
+  put_string(out, leg.transportId);
+  put_string(out, leg.targetTransport);
+  if (put_sdp(out, leg.localSdp, compressSdp))
+    flags |= FLAG_SDP_COMPRESSED;
+  if (put_sdp(out, leg.remoteSdp, compressSdp))
+    flags |= FLAG_SDP_COMPRESSED;
+  put_string(out, leg.encryption);
+  out.push_back(leg.noRtpProxy ? 1 : 0);
+  put_varint(out, leg.localCSeq);
+  put_varint(out, leg.routeSet.size());
+  for (std::vector<std::string>::const_iterator iter = leg.routeSet.begin(); iter != leg.routeSet.end(); iter++)
+    put_string(out, *iter);
+  return flags;
+}
+
+//
+// Reader helpers
+//
+
+struct RecordReader
+{
+  const char* current;
+  const char* end;
+
+  RecordReader(const char* data, std::size_t size) : current(data), end(data + size) {}
+
+  bool getByte(OSS::UInt8& value)
+  {
+    if (current >= end)
+      return false;
+    value = (OSS::UInt8)*current++;
+    return true;
+  }
+
+  bool getVarint(OSS::UInt64& value)
+  {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+      OSS::UInt8 byte;
+      if (!getByte(byte))
+        return false;
+      value |= (OSS::UInt64)(byte & 0x7F) << shift;
+      if (!(byte & 0x80))
+        return true;
+    }
+    return false;
+  }
+
+  bool getU64(OSS::UInt64& value)
+  {
+    if (end - current < 8)
+      return false;
+    value = 0;
+    for (int i = 0; i < 8; i++)
+      value |= (OSS::UInt64)(OSS::UInt8)current[i] << (i * 8);
+    current += 8;
+    return true;
+  }
+
+  bool getBytes(std::size_t size, SIPB2BDialogField& field)
+  {
+    if ((std::size_t)(end - current) < size)
+      return false;
+    field.data = current;
+    field.size = size;
+    current += size;
+    return true;
+  }
+
+  bool getField(SIPB2BDialogField& field)
+  {
+    OSS::UInt64 size;
+    return getVarint(size) && getBytes((std::size_t)size, field);
+  }
+
+  bool getSdp(SIPB2BSdpField& field)
+  {
+    OSS::UInt8 encoding;
+    if (!getByte(encoding))
+      return false;
+    if (encoding == SDP_RAW)
+    {
+      field.compressed = false;
+      if (!getField(field))
+        return false;
+      field.originalSize = field.size;
+      return true;
+    }
+    else if (encoding == SDP_ZLIB)
+    {
+      OSS::UInt64 originalSize;
+      if (!getVarint(originalSize))
+        return false;
+      field.compressed = true;
+      field.originalSize = (std::size_t)originalSize;
+      return getField(field);
+    }
+    return false;
+  }
+
+  bool getLeg(SIPB2BDialogDataView::LegView& leg)
+  {
+    OSS::UInt8 noRtpProxy;
+    OSS::UInt64 localCSeq;
+    OSS::UInt64 routeCount;
+
+    if (!getField(leg.dialogId) ||
+      !getField(leg.callId) ||
+      !getField(leg.from) ||
+      !getField(leg.to) ||
+      !getField(leg.remoteContact) ||
+      !getField(leg.localContact) ||
+      !getField(leg.localRecordRoute) ||
+      !getField(leg.remoteIp) ||
+      !getField(leg.transportId) ||
+      !getField(leg.targetTransport) ||
+      !getSdp(leg.localSdp) ||
+      !getSdp(leg.remoteSdp) ||
+      !getField(leg.encryption) ||
+      !getByte(noRtpProxy) ||
+      !getVarint(localCSeq) ||
+      !getVarint(routeCount))
+    {
+      return false;
+    }
+
+    //
+    // Every route costs at least one byte so this also bounds the reserve
+    //
+    if (routeCount > (OSS::UInt64)(end - current))
+      return false;
+
+    leg.noRtpProxy = noRtpProxy != 0;
+    leg.localCSeq = (unsigned long)localCSeq;
+    leg.routeSet.clear();
+    leg.routeSet.reserve((std::size_t)routeCount);
+    for (OSS::UInt64 i = 0; i < routeCount; i++)
+    {
+      SIPB2BDialogField route;
+      if (!getField(route))
+        return false;
+      leg.routeSet.push_back(route);
+    }
+    return true;
+  }
+};
+
+bool SIPB2BSdpField::decode(std::string& sdp) const
+{
+  if (!compressed)
+  {
+    assignTo(sdp);
+    return true;
+  }
+
+  sdp.resize(originalSize);
+  if (originalSize == 0)
+    return true;
+
+  uLongf decodedSize = originalSize;
+  if (uncompress((Bytef*)&sdp[0], &decodedSize, (const Bytef*)data, size) != Z_OK || decodedSize != originalSize)
+  {
+    sdp.clear();
+    return false;
+  }
+  return true;
+}
+
+bool SIPB2BDialogDataView::LegView::toLegInfo(SIPB2BDialogData::LegInfo& leg) const
+{
+  dialogId.assignTo(leg.dialogId);
+  callId.assignTo(leg.callId);
+  from.assignTo(leg.from);
+  to.assignTo(leg.to);
+  remoteContact.assignTo(leg.remoteContact);
+  localContact.assignTo(leg.localContact);
+  localRecordRoute.assignTo(leg.localRecordRoute);
+  remoteIp.assignTo(leg.remoteIp);
+  transportId.assignTo(leg.transportId);
+  targetTransport.assignTo(leg.targetTransport);
+  encryption.assignTo(leg.encryption);
+  leg.noRtpProxy = noRtpProxy;
+  leg.localCSeq = localCSeq;
+  leg.routeSet.resize(routeSet.size());
+  for (std::size_t i = 0; i < routeSet.size(); i++)
+    routeSet[i].assignTo(leg.routeSet[i]);
+  return localSdp.decode(leg.localSdp) && remoteSdp.decode(leg.remoteSdp);
+}
+
+SIPB2BDialogDataView::SIPB2BDialogDataView() :
+  version(0),
+  timeStamp(0),
+  connectTime(0),
+  disconnectTime(0),
+  sessionAge(0),
+  expires(0)
+{
+}
+
+bool SIPB2BDialogDataView::toDialogData(SIPB2BDialogData& dialog) const
+{
+  sessionId.assignTo(dialog.sessionId);
+  event.assignTo(dialog.event);
+  dialog.timeStamp = timeStamp;
+  dialog.connectTime = connectTime;
+  dialog.disconnectTime = disconnectTime;
+  dialog.sessionAge = sessionAge;
+  dialog.expires = expires;
+  return leg1.toLegInfo(dialog.leg1) && leg2.toLegInfo(dialog.leg2);
+}
+
+void SIPB2BDialogCodec::encode(const SIPB2BDialogData& dialog, std::string& record, bool compressSdp)
+{
+  record.clear();
+  record.reserve(HEADER_SIZE + 48 + dialog.sessionId.size() + dialog.event.size() +
+    leg_size(dialog.leg1) + leg_size(dialog.leg2));
+
+  record.push_back('\0');
+  record.push_back('D');
+  record.push_back('B');
+  record.push_back((char)VERSION);
+  record.push_back(0);
+
+  put_u64(record, dialog.timeStamp);
+  put_u64(record, dialog.connectTime);
+  put_u64(record, dialog.disconnectTime);
+  put_u64(record, dialog.sessionAge);
+  put_varint(record, (OSS::UInt32)dialog.expires);
+  put_string(record, dialog.sessionId);
+  put_string(record, dialog.event);
+
+  OSS::UInt8 flags = put_leg(record, dialog.leg1, compressSdp);
+  flags |= put_leg(record, dialog.leg2, compressSdp);
+  record[HEADER_SIZE - 1] = (char)flags;
+}
+
+bool SIPB2BDialogCodec::decode(const char* record, std::size_t size, SIPB2BDialogDataView& view)
+{
+  if (size < HEADER_SIZE || record[0] != '\0' || record[1] != 'D' || record[2] != 'B')
+    return false;
+
+  view.version = (OSS::UInt8)record[3];
+  if (view.version != VERSION)
+    return false;
+
+  RecordReader reader(record + HEADER_SIZE, size - HEADER_SIZE);
+  OSS::UInt64 expires;
+  if (!reader.getU64(view.timeStamp) ||
+    !reader.getU64(view.connectTime) ||
+    !reader.getU64(view.disconnectTime) ||
+    !reader.getU64(view.sessionAge) ||
+    !reader.getVarint(expires) ||
+    !reader.getField(view.sessionId) ||
+    !reader.getField(view.event) ||
+    !reader.getLeg(view.leg1) ||
+    !reader.getLeg(view.leg2))
+  {
+    return false;
+  }
+  view.expires = (int)(OSS::UInt32)expires;
+  return reader.current == reader.end;
+}
+
+bool SIPB2BDialogCodec::decode(const std::string& record, SIPB2BDialogData& dialog)
+{
+  SIPB2BDialogDataView view;
+  if (!decode(record.data(), record.size(), view))
+    return false;
+  return view.toDialogData(dialog);
+}
+
+
+} } } // OSS::SIP::B2BUA
+
+#endif // ENABLE_FEATURE_B2BUA
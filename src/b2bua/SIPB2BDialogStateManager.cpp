@@ -21,6 +21,7 @@
 
 
 #include "OSS/SIP/B2BUA/SIPB2BDialogStateManager.h"
+#include "OSS/SIP/B2BUA/SIPB2BDialogCodec.h"
 
 
 namespace OSS {
@@ -42,9 +43,7 @@ bool SIPB2BDialogDataStoreCb::dbPersist(const DialogData& dialogData)
   else
   {
     mutex_critic_sec_lock lock(_storageMutex);
-    std::string data;
-    dialogData.toJsonString(data);
-    _dialogs[dialogData.sessionId] = data;
+    SIPB2BDialogCodec::encode(dialogData, _dialogs[dialogData.sessionId]);
     return true;
   }
 }
@@ -61,7 +60,13 @@ void SIPB2BDialogDataStoreCb::dbGetAll(DialogList& dialogs)
     for (Storage::const_iterator iter = _dialogs.begin(); iter != _dialogs.end(); iter++)
     {
       DialogData dialog;
-      dialog.fromJsonString(iter->second);
+      if (!SIPB2BDialogCodec::isBinary(iter->second))
+        dialog.fromJsonString(iter->second);
+      else if (!SIPB2BDialogCodec::decode(iter->second, dialog))
+      {
+        OSS_LOG_ERROR("SIPB2BDialogDataStoreCb::dbGetAll - Unable to decode dialog " << iter->first);
+        continue;
+      }
       dialogs.push_back(dialog);
     }
   }
@@ -86,6 +91,34 @@ void SIPB2BDialogDataStoreCb::dbRemoveAllDialogs(const std::string& callId)
   {
     removeAllDialogs(callId);
   }
+  else if (!getAll)
+  {
+    //
+    // Match the Call-ID against the encoded records directly instead of
+    // decoding every dialog into a copy
+    //
+    mutex_critic_sec_lock lock(_storageMutex);
+    for (Storage::iterator iter = _dialogs.begin(); iter != _dialogs.end();)
+    {
+      bool matched = false;
+      SIPB2BDialogDataView view;
+      if (SIPB2BDialogCodec::decode(iter->second.data(), iter->second.size(), view))
+      {
+        matched = view.leg1.callId == callId;
+      }
+      else if (!SIPB2BDialogCodec::isBinary(iter->second))
+      {
+        DialogData dialog;
+        dialog.fromJsonString(iter->second);
+        matched = dialog.leg1.callId == callId;
+      }
+
+      if (matched)
+        _dialogs.erase(iter++);
+      else
+        ++iter;
+    }
+  }
   else
   {
     std::vector<std::string> deleteThese;
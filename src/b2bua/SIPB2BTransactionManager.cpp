@@ -34,14 +34,18 @@ namespace B2BUA {
 
 SIPB2BTransactionManager::SIPB2BTransactionManager(int minThreadcount, int maxThreadCount) :
   _threadPool(minThreadcount, maxThreadCount),
+  _admissionControl(_threadPool, stack()),
   _useSourceAddressForResponses(false),
   _pDefaultHandler(0),
   _maxThreadCount(maxThreadCount)  
 {
+  stack().setRequestAdmissionHandler(boost::bind(&SIPB2BAdmissionControl::admit, &_admissionControl, _1, _2));
+  _admissionControl.start();
 }
 
 SIPB2BTransactionManager::~SIPB2BTransactionManager()
 {
+  _admissionControl.stop();
 }
 
 void SIPB2BTransactionManager::initialize(const boost::filesystem::path& cfgDirectory)
@@ -107,7 +111,7 @@ void SIPB2BTransactionManager::handleRequest(
   else
   {
 #if SEND_ERROR_ON_B2BUA_THREAD_DEPLETION
-    if (_threadPool.schedule(boost::bind(&SIPB2BTransaction::runTask, b2bTransaction)) == -1)
+    if (_threadPool.schedule(boost::bind(&SIPB2BTransaction::runTask, b2bTransaction), pMsg->hdrGet(OSS::SIP::HDR_CALL_ID)) == -1)
     {
       OSS::log_error(pMsg->createContextId(true) + "No available thread to handle SIPB2BTransactionManager::handleRequest");
       SIPMessage::Ptr serverError = pMsg->createResponse(500, "Thread Resource Depleted");
@@ -116,12 +120,13 @@ void SIPB2BTransactionManager::handleRequest(
     }
 #else
     //
-    // The idea here is that if the threadpool runs out of threads, then we will directly
+    // The idea here is that if the threadpool queue is full, then we will directly
     // call runTask using the current thread which would effectively block the transport.
     // This is a good thing because blocking the transport yields our threadpool
-    // allowing it to recover.
+    // allowing it to recover.  Transactions are keyed on the Call-ID so that
+    // requests within the same dialog tend to land on the same worker.
     //
-    if (_threadPool.schedule(boost::bind(&SIPB2BTransaction::runTask, b2bTransaction)) == -1)
+    if (_threadPool.schedule(boost::bind(&SIPB2BTransaction::runTask, b2bTransaction), pMsg->hdrGet(OSS::SIP::HDR_CALL_ID)) == -1)
       b2bTransaction->runTask();
 #endif
   }
@@ -142,14 +147,14 @@ void SIPB2BTransactionManager::handleAckOr2xxTransaction(
   SIPB2BHandler::Ptr pHandler = findHandler(SIPB2BHandler::TYPE_INVITE);
   if (pHandler)
   {
-    if (_threadPool.schedule(boost::bind(&SIPB2BHandler::onProcessAckOr2xxRequest, pHandler, pMsg, pTransport)) == -1)
+    if (_threadPool.schedule(boost::bind(&SIPB2BHandler::onProcessAckOr2xxRequest, pHandler, pMsg, pTransport), pMsg->hdrGet(OSS::SIP::HDR_CALL_ID)) == -1)
     {
       OSS::log_error(pMsg->createContextId(true) + "No available thread to handle SIPB2BTransactionManager::handleAckOr2xxTransaction");
     }
   }
   else if (_pDefaultHandler)
   {
-    if (_threadPool.schedule(boost::bind(&SIPB2BHandler::onProcessAckOr2xxRequest, _pDefaultHandler, pMsg, pTransport)) == -1)
+    if (_threadPool.schedule(boost::bind(&SIPB2BHandler::onProcessAckOr2xxRequest, _pDefaultHandler, pMsg, pTransport), pMsg->hdrGet(OSS::SIP::HDR_CALL_ID)) == -1)
     {
       OSS::log_error(pMsg->createContextId(true) + "No available thread to handle SIPB2BTransactionManager::handleAckOr2xxTransaction");
     }
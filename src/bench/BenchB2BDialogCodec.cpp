@@ -0,0 +1,133 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+//
+// Dialog persist/load cost: the binary SIPB2BDialogCodec record against a
+// JSON round trip through json::Writer and json::Reader.
+//
+// toJsonString() is not used for the JSON side.  It writes unquoted keys
+// that json::Reader rejects, so timing it would mostly measure the parse
+// error.
+//
+// Usage: oss_core-bench-dialogcodec [records]
+//
+
+
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+
+#include "OSS/SIP/B2BUA/SIPB2BDialogCodec.h"
+#include "OSS/UTL/CoreUtils.h"
+
+
+using OSS::SIP::B2BUA::SIPB2BDialogData;
+using OSS::SIP::B2BUA::SIPB2BDialogCodec;
+
+
+static const char* BENCH_SDP =
+  "v=0\r\n"
+  "o=FreeSWITCH 1410664034 1410664035 IN IP4 172.31.1.9\r\n"
+  "s=FreeSWITCH\r\n"
+  "c=IN IP4 107.23.34.40\r\n"
+  "t=0 0\r\n"
+  "m=audio 30466 RTP/AVP 0 101\r\n"
+  "c=IN IP4 107.23.34.40\r\n"
+  "a=rtpmap:0 PCMU/8000\r\n"
+  "a=rtpmap:101 telephone-event/8000\r\n"
+  "a=fmtp:101 0-16\r\n"
+  "a=silenceSupp:off - - - -\r\n"
+  "a=ptime:20\r\n"
+  "a=x-sipx-ntap:X172.31.1.9-107.23.34.40;2296\r\n";
+
+static void fill_dialog(SIPB2BDialogData& dialog)
+{
+  //
+  // A typical two-leg dialog with SDP on both sides
+  //
+  dialog.sessionId = "4147414987334546318926127303";
+  dialog.timeStamp = 1410675320642ULL;
+  dialog.connectTime = 1410675320643ULL;
+  dialog.disconnectTime = 1410675320644ULL;
+  dialog.sessionAge = 1410675320645ULL;
+  dialog.expires = 3600;
+  dialog.leg1.callId = "OTU2YWMzOGZiMDJkM2Q2NmRiZmNhNTk0OTQ1MDk3ZTA.";
+  dialog.leg1.from = "<sip:32017@ezuce.com;transport=UDP>;tag=Xg67jHjDemXjF";
+  dialog.leg1.to = "<sip:2017@ezuce.com;transport=UDP>;tag=2ed94c23";
+  dialog.leg1.remoteContact = "<sip:2017@192.168.1.10:58959;transport=UDP>";
+  dialog.leg1.remoteIp = "192.168.1.10:58959";
+  dialog.leg1.transportId = "0";
+  dialog.leg1.targetTransport = "udp";
+  dialog.leg1.localSdp = BENCH_SDP;
+  dialog.leg1.localCSeq = 7;
+  dialog.leg2 = dialog.leg1;
+  dialog.leg2.remoteSdp = BENCH_SDP;
+  dialog.leg2.noRtpProxy = true;
+  dialog.leg2.routeSet.push_back("<sip:107.23.34.40:5060;lr>");
+  dialog.leg2.routeSet.push_back("<sip:10.0.0.1;lr>");
+}
+
+int main(int argc, char** argv)
+{
+  std::size_t count = argc > 1 ? std::strtoul(argv[1], 0, 10) : 100000;
+  if (!count)
+  {
+    std::cerr << "Usage: " << argv[0] << " [records]" << std::endl;
+    return 1;
+  }
+
+  SIPB2BDialogData dialog;
+  fill_dialog(dialog);
+
+  std::string json;
+  std::string record;
+  SIPB2BDialogCodec::encode(dialog, record);
+
+  OSS::UInt64 start = OSS::getTime();
+  for (std::size_t i = 0; i < count; i++)
+  {
+    json::Object object;
+    dialog.toJsonObject(object);
+    std::ostringstream out;
+    json::Writer::Write(object, out);
+    json = out.str();
+
+    json::Object parsed;
+    std::istringstream in(json);
+    json::Reader::Read(parsed, in);
+    SIPB2BDialogData decoded;
+    decoded.fromJsonObject(parsed);
+  }
+  OSS::UInt64 jsonTime = OSS::getTime() - start;
+
+  start = OSS::getTime();
+  for (std::size_t i = 0; i < count; i++)
+  {
+    SIPB2BDialogData decoded;
+    SIPB2BDialogCodec::encode(dialog, record);
+    SIPB2BDialogCodec::decode(record, decoded);
+  }
+  OSS::UInt64 binaryTime = OSS::getTime() - start;
+
+  std::cout << "Dialog persist/load " << count << " records: JSON " << jsonTime << " ms "
+    << json.size() << " bytes, binary " << binaryTime << " ms " << record.size() << " bytes" << std::endl;
+  return 0;
+}
@@ -0,0 +1,84 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+//
+// CacheManager add/get throughput from many threads.
+//
+// Usage: oss_core-bench-cache [entries] [threads]
+//
+
+
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+
+#include "OSS/UTL/Cache.h"
+#include "OSS/UTL/CoreUtils.h"
+
+
+static void cache_bench_add(OSS::CacheManager* pCache, const std::vector<std::string>* pKeys, std::size_t offset, std::size_t step)
+{
+  for (std::size_t i = offset; i < pKeys->size(); i += step)
+    pCache->add((*pKeys)[i], i);
+}
+
+static void cache_bench_get(OSS::CacheManager* pCache, const std::vector<std::string>* pKeys, std::size_t offset, std::size_t step)
+{
+  for (std::size_t i = offset; i < pKeys->size(); i += step)
+    pCache->get((*pKeys)[i]);
+}
+
+static double cache_bench_run(boost::function<void(std::size_t, std::size_t)> task, std::size_t entries, std::size_t threadCount)
+{
+  OSS::UInt64 start = OSS::getTime();
+  boost::thread_group threads;
+  for (std::size_t i = 0; i < threadCount; i++)
+    threads.create_thread(boost::bind(task, i, threadCount));
+  threads.join_all();
+  OSS::UInt64 elapsed = OSS::getTime() - start;
+  return elapsed ? (entries * 1000.0) / elapsed : 0;
+}
+
+int main(int argc, char** argv)
+{
+  std::size_t entries = argc > 1 ? std::strtoul(argv[1], 0, 10) : 1000000;
+  std::size_t threadCount = argc > 2 ? std::strtoul(argv[2], 0, 10) : 16;
+  if (!entries || !threadCount)
+  {
+    std::cerr << "Usage: " << argv[0] << " [entries] [threads]" << std::endl;
+    return 1;
+  }
+
+  std::vector<std::string> keys;
+  keys.reserve(entries);
+  for (std::size_t i = 0; i < entries; i++)
+    keys.push_back(OSS::string_create_uuid());
+
+  OSS::CacheManager cache(60);
+  double addRate = cache_bench_run(boost::bind(cache_bench_add, &cache, &keys, _1, _2), entries, threadCount);
+  double getRate = cache_bench_run(boost::bind(cache_bench_get, &cache, &keys, _1, _2), entries, threadCount);
+
+  std::cout << "CacheManager " << entries << " entries, " << threadCount << " threads: "
+    << (unsigned long)addRate << " add/s " << (unsigned long)getRate << " get/s" << std::endl;
+  return cache.has(keys.front()) ? 0 : 1;
+}
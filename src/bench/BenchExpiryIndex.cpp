@@ -0,0 +1,107 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+//
+// ExpiryIndex add and popExpired cost, in memory and with a journal.
+//
+// Usage: oss_core-bench-expiryindex [keys] [journal]
+//
+
+
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+#include "OSS/UTL/ExpiryIndex.h"
+#include "OSS/UTL/CoreUtils.h"
+
+
+static void expiry_bench_run(const std::vector<std::string>& keys, const char* journal)
+{
+  OSS::ExpiryIndex index(60);
+  if (journal)
+  {
+    boost::filesystem::remove(journal);
+    if (!index.open(journal))
+    {
+      std::cerr << "Unable to open " << journal << std::endl;
+      return;
+    }
+  }
+
+  OSS::UInt64 start = OSS::getTime();
+  for (std::size_t i = 0; i < keys.size(); i++)
+  {
+    index.add(keys[i], 1000 + (i % 3600), keys[i]);
+  }
+  OSS::UInt64 added = OSS::getTime();
+
+  //
+  // Half of the deadlines are due.  Drain them in the same batch size the
+  // SBC housekeeping thread uses.
+  //
+  OSS::ExpiryIndex::Entries expired;
+  std::size_t batches = 0;
+  while (index.popExpired(1000 + 1800, 256, expired) > 0)
+  {
+    batches++;
+  }
+  OSS::UInt64 popped = OSS::getTime();
+
+  index.compactIfStale();
+  OSS::UInt64 compacted = OSS::getTime();
+
+  const char* label = journal ? "ExpiryIndex (journal)" : "ExpiryIndex (memory)";
+  std::cout << label << " add " << keys.size() << " keys: " << added - start << " ms, pop "
+    << expired.size() << " due keys in " << batches << " batches: " << popped - added << " ms";
+  if (journal)
+  {
+    std::cout << ", compact: " << compacted - popped << " ms";
+    boost::filesystem::remove(journal);
+  }
+  std::cout << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  std::size_t count = argc > 1 ? std::strtoul(argv[1], 0, 10) : 300000;
+  const char* journal = argc > 2 ? argv[2] : "/tmp/oss_core-bench-expiryindex.journal";
+  if (!count)
+  {
+    std::cerr << "Usage: " << argv[0] << " [keys] [journal]" << std::endl;
+    return 1;
+  }
+
+  std::vector<std::string> keys;
+  keys.reserve(count);
+  for (std::size_t i = 0; i < count; i++)
+  {
+    std::ostringstream strm;
+    strm << "session-" << i;
+    keys.push_back(strm.str());
+  }
+
+  expiry_bench_run(keys, 0);
+  expiry_bench_run(keys, journal);
+  return 0;
+}
@@ -0,0 +1,116 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+//
+// json::Reader and json::Writer against FastReader and FastWriter on a
+// JSON-RPC style document carrying an SDP body.
+//
+// Usage: oss_core-bench-fastjson [documents]
+//
+
+
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+
+#include "OSS/JSON/Json.h"
+#include "OSS/JSON/FastJson.h"
+#include "OSS/UTL/CoreUtils.h"
+
+
+using OSS::JSON::FastReader;
+using OSS::JSON::FastWriter;
+
+
+static const char* BENCH_DOCUMENT =
+  "{\n"
+  "  \"jsonrpc\" : \"2.0\",\n"
+  "  \"id\" : 42,\n"
+  "  \"params\" : {\n"
+  "    \"sdp\" : \"v=0\\r\\no=Z 0 0 IN IP4 192.168.1.10\\r\\ns=Z\\r\\nc=IN IP4 192.168.1.10\\r\\nt=0 0\\r\\nm=audio 8000 RTP/AVP 0 101\\r\\n\",\n"
+  "    \"quote\" : \"say \\\"hi\\\" \\\\ \\/ \\u00e9\\ud83d\\ude00\",\n"
+  "    \"ratio\" : -1.25e2,\n"
+  "    \"enabled\" : true,\n"
+  "    \"disabled\" : false,\n"
+  "    \"nothing\" : null,\n"
+  "    \"ports\" : [ 10000, 10002, 10004 ],\n"
+  "    \"empty\" : {},\n"
+  "    \"none\" : []\n"
+  "  }\n"
+  "}\n";
+
+int main(int argc, char** argv)
+{
+  std::size_t count = argc > 1 ? std::strtoul(argv[1], 0, 10) : 20000;
+  if (!count)
+  {
+    std::cerr << "Usage: " << argv[0] << " [documents]" << std::endl;
+    return 1;
+  }
+
+  //
+  // json::Reader does not understand \u escapes so feed both readers the
+  // document as json::Writer formats it
+  //
+  json::Object object;
+  FastReader::Read(object, std::string(BENCH_DOCUMENT));
+  std::ostringstream documentStrm;
+  json::Writer::Write(object, documentStrm);
+  std::string document = documentStrm.str();
+
+  OSS::UInt64 start = OSS::getTime();
+  for (std::size_t i = 0; i < count; i++)
+  {
+    json::Object parsed;
+    std::stringstream strm;
+    strm << document;
+    json::Reader::Read(parsed, strm);
+  }
+  OSS::UInt64 readerTime = OSS::getTime() - start;
+
+  start = OSS::getTime();
+  for (std::size_t i = 0; i < count; i++)
+  {
+    json::Object parsed;
+    FastReader::Read(parsed, document);
+  }
+  OSS::UInt64 fastReaderTime = OSS::getTime() - start;
+
+  start = OSS::getTime();
+  for (std::size_t i = 0; i < count; i++)
+  {
+    std::ostringstream strm;
+    json::Writer::Write(object, strm);
+  }
+  OSS::UInt64 writerTime = OSS::getTime() - start;
+
+  start = OSS::getTime();
+  for (std::size_t i = 0; i < count; i++)
+  {
+    std::string out;
+    FastWriter::Write(object, out);
+  }
+  OSS::UInt64 fastWriterTime = OSS::getTime() - start;
+
+  std::cout << count << " documents: Reader " << readerTime << " ms FastReader " << fastReaderTime
+    << " ms, Writer " << writerTime << " ms FastWriter " << fastWriterTime << " ms" << std::endl;
+  return 0;
+}
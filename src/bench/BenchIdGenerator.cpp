@@ -0,0 +1,83 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+//
+// Branch generation throughput: IdGenerator's per-thread ChaCha20 stream
+// against the Poco UUID path (string_create_uuid) it replaced.
+//
+// Usage: oss_core-bench-idgenerator [ids] [threads]
+//
+
+
+#include <iostream>
+#include <cstdlib>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+
+#include "OSS/UTL/IdGenerator.h"
+#include "OSS/UTL/CoreUtils.h"
+
+
+static void id_bench_generator(std::size_t count)
+{
+  char branch[OSS::IdGenerator::BRANCH_LENGTH + 1];
+  for (std::size_t i = 0; i < count; i++)
+    OSS::IdGenerator::createBranch(branch);
+}
+
+static void id_bench_uuid(std::size_t count)
+{
+  for (std::size_t i = 0; i < count; i++)
+  {
+    std::string branch = "z9hG4bK";
+    branch += OSS::string_create_uuid();
+  }
+}
+
+static double id_bench_run(boost::function<void(std::size_t)> task, std::size_t ids, std::size_t threadCount)
+{
+  OSS::UInt64 start = OSS::getTime();
+  boost::thread_group threads;
+  for (std::size_t i = 0; i < threadCount; i++)
+    threads.create_thread(boost::bind(task, ids / threadCount));
+  threads.join_all();
+  OSS::UInt64 elapsed = OSS::getTime() - start;
+  return elapsed ? (ids * 1000.0) / elapsed : 0;
+}
+
+int main(int argc, char** argv)
+{
+  std::size_t ids = argc > 1 ? std::strtoul(argv[1], 0, 10) : 1000000;
+  std::size_t threadCount = argc > 2 ? std::strtoul(argv[2], 0, 10) : 8;
+  if (!ids || !threadCount)
+  {
+    std::cerr << "Usage: " << argv[0] << " [ids] [threads]" << std::endl;
+    return 1;
+  }
+
+  double generatorRate = id_bench_run(id_bench_generator, ids, threadCount);
+  double uuidRate = id_bench_run(id_bench_uuid, ids, threadCount);
+
+  std::cout << "Branch generation " << ids << " ids, " << threadCount << " threads: IdGenerator "
+    << (unsigned long)generatorRate << "/s string_create_uuid " << (unsigned long)uuidRate << "/s" << std::endl;
+  return 0;
+}
@@ -19,6 +19,7 @@
 
 #include "OSS/JS/JSEventLoop.h"
 #include "OSS/JS/JSIsolate.h"
+#include <errno.h>
 
 namespace OSS {
 namespace JS {
@@ -27,6 +28,7 @@ namespace JS {
 JSEventLoop::JSEventLoop(JSIsolate* pIsolate) :
   _isTerminated(false),
   _pIsolate(pIsolate),
+  _epollFd(epoll_create1(EPOLL_CLOEXEC)),
   _fdManager(this),
   _queueManager(this),
   _eventEmitter(this),
@@ -36,10 +38,19 @@ JSEventLoop::JSEventLoop(JSIsolate* pIsolate) :
   _interIsolate(this),
   _garbageCollectionFrequency(30)
 {
+  //
+  // Static Descriptors
+  //
+  addDescriptor(getFd(), POLLIN);
+  addDescriptor(_functionCallback.getFd(), POLLIN);
 }
 
 JSEventLoop::~JSEventLoop()
 {
+  if (_epollFd != -1)
+  {
+    ::close(_epollFd);
+  }
 }
 
 JSIsolate* JSEventLoop::getIsolate()
@@ -47,63 +58,63 @@ JSIsolate* JSEventLoop::getIsolate()
   return _pIsolate;
 }
 
+bool JSEventLoop::addDescriptor(int fd, int events)
+{
+  epoll_event ev;
+  ev.events = events;
+  ev.data.fd = fd;
+  if (::epoll_ctl(_epollFd, EPOLL_CTL_ADD, fd, &ev) == 0)
+  {
+    return true;
+  }
+  return errno == EEXIST && ::epoll_ctl(_epollFd, EPOLL_CTL_MOD, fd, &ev) == 0;
+}
+
+bool JSEventLoop::removeDescriptor(int fd)
+{
+  //
+  // A closed descriptor is dropped by the kernel on its own so failures
+  // here are expected and harmless
+  //
+  epoll_event ev;
+  return ::epoll_ctl(_epollFd, EPOLL_CTL_DEL, fd, &ev) == 0;
+}
+
 void JSEventLoop::processEvents()
 {
-  OSS::UInt64 lastGarbageCollectionTime = 0;
+  const int MAX_EVENTS = 64;
+  epoll_event events[MAX_EVENTS];
+  OSS::UInt64 lastGarbageCollectionTime = OSS::getTime();
+  OSS::UInt64 garbageCollectionInterval = _garbageCollectionFrequency * 1000;
   
   OSS::JS::JSIsolate::Ptr pIsolate = OSS::JS::JSIsolate::getIsolate();
 
-  std::vector<pollfd> descriptors;
-  bool reconstructFdSet = true;
-  
-  //
-  // Static Descriptors
-  //
-  pollfd pfds[3];
-  pfds[0].fd = this->getFd();
-  pfds[0].events = POLLIN;
-  pfds[0].revents = 0;
-  pfds[1].fd = _functionCallback.getFd();
-  pfds[1].events = POLLIN;
-  pfds[1].revents = 0;
-  pfds[2].fd = _timerManager.getFd();
-  pfds[2].events = POLLIN;
-  pfds[2].revents = 0;
   while (!_isTerminated)
   {
-    if (reconstructFdSet)
+    //
+    // Sleep until the next timer is due.  The root isolate also wakes up
+    // for its periodic garbage collection.
+    //
+    int timeout = _timerManager.getTimeout();
+    if (_pIsolate->isRoot())
     {
-      descriptors.clear();
-      descriptors.reserve(_queueManager.getSize() + 3);
-      descriptors.push_back(pfds[0]);
-      descriptors.push_back(pfds[1]);
-      descriptors.push_back(pfds[2]);
-      
-      _queueManager.appendDescriptors(descriptors);
-      _fdManager.appendDescriptors(descriptors);
+      OSS::UInt64 elapsed = OSS::getTime() - lastGarbageCollectionTime;
+      int collectionTimeout = elapsed >= garbageCollectionInterval ? 0 : (int)(garbageCollectionInterval - elapsed);
+      if (timeout == -1 || collectionTimeout < timeout)
+      {
+        timeout = collectionTimeout;
+      }
     }
-    int ret = ::poll(descriptors.data(), descriptors.size(), 100);
+
+    int ret = ::epoll_wait(_epollFd, events, MAX_EVENTS, timeout);
     v8::HandleScope scope;
-    if (ret == -1 || _isTerminated)
+    if (ret == -1 && errno == EINTR)
     {
-      break;
+      continue;
     }
-    else if (ret == 0)
+    else if (ret == -1 || _isTerminated)
     {
-      //
-      // Use the timeout to let V8 perform internal garbage collection tasks
-      //
-      if (_pIsolate->isRoot())
-      {
-        OSS::UInt64 now = OSS::getTime();
-        if (now - lastGarbageCollectionTime > _garbageCollectionFrequency * 1000)
-        {
-          v8::V8::LowMemoryNotification();
-          lastGarbageCollectionTime = now;
-        }
-        while(!v8::V8::IdleNotification());
-        continue;
-      }
+      break;
     }
     
     //
@@ -112,73 +123,54 @@ void JSEventLoop::processEvents()
     if (_pIsolate->isRoot())
     {
       OSS::UInt64 now = OSS::getTime();
-      if (now - lastGarbageCollectionTime > _garbageCollectionFrequency * 1000)
+      if (now - lastGarbageCollectionTime >= garbageCollectionInterval)
       {
         v8::V8::LowMemoryNotification();
         lastGarbageCollectionTime = now;
       }
+      if (ret == 0)
+      {
+        //
+        // Use the timeout to let V8 perform internal garbage collection tasks
+        //
+        while(!v8::V8::IdleNotification());
+      }
     }
-    
-    //
-    // Check if C++ just wants to execute a task in the event loop
-    //
-    if (_taskManager.doOneWork() || _interIsolate.doOneWork())
+
+    _timerManager.processTimers();
+    if (ret == 0)
     {
-      //
-      // Do not reconstruct fdset if we did some tasks
-      //
-      reconstructFdSet = false;
       continue;
     }
     
     //
-    // From this point onwards, we only reconstruct the FD set if we are waken up via the wakeup pipe
+    // Check if C++ just wants to execute a task in the event loop.  Each
+    // task owns one byte in the wakeup pipe, so the pipe is only drained
+    // once no task is left.
     //
-    reconstructFdSet = false;
-    if (descriptors[0].revents & POLLIN)
+    bool didTask = _taskManager.doOneWork() || _interIsolate.doOneWork();
+    
+    for (int i = 0; i < ret && !_isTerminated; i++)
     {
-      this->clearOne();
-      if (_isTerminated)
+      int fd = events[i].data.fd;
+      if (fd == getFd())
       {
-        break;
+        if (!didTask)
+        {
+          this->clearOne();
+        }
       }
-      else
+      else if (fd == _functionCallback.getFd())
       {
-        reconstructFdSet = true;
-        continue;
+        _functionCallback.doOneWork();
       }
-    }
-    else if (descriptors[1].revents & POLLIN)
-    {
-      _functionCallback.doOneWork();
-    }
-    else if (descriptors[2].revents & POLLIN)
-    {
-      _timerManager.doOneWork();
-    }
-    else
-    {
-      bool found = false;
-      std::size_t fdsize = descriptors.size();
-
-      for (std::size_t i = 3; i < fdsize; i++)
+      else if (!_queueManager.dequeue(fd))
       {
-        pollfd& pfd = descriptors[i];
-        int revents = pfd.revents;
-        if (revents & POLLIN)
-        {
-
-          found = _queueManager.dequeue(pfd.fd);
-          if (!found)
-          {
-            found = _fdManager.signalIO(pfd);
-          }
-        }
-        
-        if (found)
-        {
-          break;
-        }
+        pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        pfd.revents = events[i].events & 0xFFFF;
+        _fdManager.signalIO(pfd);
       }
     }
   }
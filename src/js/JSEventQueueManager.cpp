@@ -39,12 +39,14 @@ void JSEventQueueManager::addQueue(QueueObject* pQueue)
 {
   OSS::mutex_lock lock(_queuesMutex);
   _queues[pQueue->_queue.getFd()] = pQueue;
+  getEventLoop()->addDescriptor(pQueue->_queue.getFd(), POLLIN);
 }
 
 void JSEventQueueManager::removeQueue(QueueObject* pQueue)
 {
   OSS::mutex_lock lock(_queuesMutex);
   _queues.erase(pQueue->_queue.getFd());
+  getEventLoop()->removeDescriptor(pQueue->_queue.getFd());
 }
 
 QueueObject* JSEventQueueManager::findQueue(int fd)
@@ -89,21 +91,6 @@ bool JSEventQueueManager::dequeue(int fd)
   return false;
 }
 
-void JSEventQueueManager::appendDescriptors(Descriptors& descriptors)
-{
-  OSS::mutex_lock lock(_queuesMutex);
-  for(QueueObjectMap::iterator iter = _queues.begin(); iter != _queues.end(); iter++)
-  {
-    pollfd fd;
-    fd.fd = iter->first;
-    fd.events = POLLIN;
-    fd.revents = 0;
-    descriptors.push_back(fd);
-  }
-}
-
-
-
 } }
 
 
@@ -41,7 +41,8 @@ JSFileDescriptorManager::~JSFileDescriptorManager()
 void JSFileDescriptorManager::addFileDescriptor(int fd, v8::Handle<v8::Value> ioHandler, int events)
 {
   OSS::mutex_critic_sec_lock lock(_descriptorsMutex);
-  _descriptors[fd] = JSFileDescriptor::Ptr(new JSFileDescriptor(ioHandler, fd, events));
+  _descriptors[fd] = JSFileDescriptor::Ptr(new JSFileDescriptor(ioHandler, fd, events & 0xFFFF));
+  getEventLoop()->addDescriptor(fd, events);
 }
 
 bool JSFileDescriptorManager::removeFileDescriptor(int fd)
@@ -50,6 +51,7 @@ bool JSFileDescriptorManager::removeFileDescriptor(int fd)
   if (_descriptors.find(fd) != _descriptors.end())
   {
     _descriptors.erase(fd);
+    getEventLoop()->removeDescriptor(fd);
     return true;
   }
   return false;
@@ -66,15 +68,6 @@ JSFileDescriptor::Ptr JSFileDescriptorManager::findDescriptor(int fd)
   return JSFileDescriptor::Ptr();
 }
 
-void JSFileDescriptorManager::appendDescriptors(Descriptors& descriptors)
-{
-  OSS::mutex_critic_sec_lock lock(_descriptorsMutex);
-  for (DescriptorMap::const_iterator iter = _descriptors.begin(); iter != _descriptors.end(); iter++)
-  {
-    descriptors.push_back(iter->second->pollFd());
-  }
-}
-
 bool JSFileDescriptorManager::signalIO(pollfd pfd)
 {
   _descriptorsMutex.lock();
@@ -98,7 +91,12 @@ JS_METHOD_IMPL(JSFileDescriptorManager::monitor_descriptor)
   js_method_declare_isolate(pIsolate);
   js_method_arg_declare_uint32(fd, 0);
   js_method_arg_assert_function(1);
-  pIsolate->eventLoop()->fdManager().addFileDescriptor(fd, js_method_arg(1), POLLIN);
+  int events = POLLIN;
+  if (js_method_arg_length() > 2 && js_method_arg(2)->BooleanValue())
+  {
+    events |= EPOLLET;
+  }
+  pIsolate->eventLoop()->fdManager().addFileDescriptor(fd, js_method_arg(1), events);
   pIsolate->eventLoop()->wakeup();
   return JSUndefined();
 }
@@ -20,6 +20,7 @@
 #include "OSS/JS/JSInterIsolateCallManager.h"
 #include "OSS/JS/JSIsolate.h"
 #include "OSS/JS/JSEventLoop.h"
+#include "OSS/JS/JSUtil.h"
 
 
 namespace OSS {
@@ -62,10 +63,32 @@ bool JSInterIsolateCallManager::doOneWork()
   {
     return false;
   }
-  
+  processCall(pCall);
+  return true;
+}
+
+void JSInterIsolateCallManager::dispatch(const JSInterIsolateCall::Ptr& pCall)
+{
+  if (getIsolate()->isThreadSelf())
+  {
+    //
+    // We are already running inside the target isolate.  Hand the call
+    // straight to the handler instead of queueing it behind other work.
+    //
+    processCall(pCall);
+  }
+  else
+  {
+    enqueue(pCall);
+    getEventLoop()->wakeup();
+  }
+}
+
+void JSInterIsolateCallManager::processCall(const JSInterIsolateCall::Ptr& pCall)
+{
   js_enter_scope();
   JSLocalObjectHandle pUserData = getIsolate()->wrapExternalPointer(pCall->getUserData());
-  JSValueHandle request = getIsolate()->parseJSON(pCall->json());
+  JSValueHandle request = js_object_from_json(pCall->getRequest());
   JSArgumentVector jsonArg;
   jsonArg.push_back(request);
   jsonArg.push_back(pUserData);
@@ -78,45 +101,40 @@ bool JSInterIsolateCallManager::doOneWork()
     pCall->_cb->Dispose();
     delete pCall->_cb;
     pCall->_cb = 0;
-    return true;
+    return;
   }
   
   if (_handler.empty())
   {
-    //
-    // return true here so that the event loop knows we processed something
-    //
     pCall->setValue("{error: 'No handler set'}");
-    return true;
+    return;
   }
   
 
   JSValueHandle result =  _handler.value()->Call(getGlobal(), jsonArg.size(), jsonArg.data());
 
+  if (!result.IsEmpty() && result->IsObject() && !result->IsArray() && js_object_to_json(result->ToObject(), pCall->_result))
+  {
+    pCall->setValue();
+    return;
+  }
+
+  //
+  // Handlers may still return a JSON string
+  //
   std::string value;
   if (!result.IsEmpty() && result->IsString())
   {
     value = js_handle_as_std_string(result);
   }
   pCall->setValue(value);
-  return true;
 }
 
 bool JSInterIsolateCallManager::execute(const Request& request, Result& result, uint32_t timeout, void* userData)
 {
-  bool delegateToSelf = getIsolate()->isThreadSelf();
   JSInterIsolateCall::Ptr pCall(new JSInterIsolateCall(request, timeout, userData));
-  enqueue(pCall);
+  dispatch(pCall);
 
-  if (delegateToSelf)
-  {
-    doOneWork();
-  }
-  else
-  {
-    getEventLoop()->wakeup();
-  }
-  
   if (!pCall->waitForResult())
   {
     return false;
@@ -146,18 +164,8 @@ void JSInterIsolateCallManager::notify(const std::string& requestStr, void* user
 
 void JSInterIsolateCallManager::notify(const Request& request, void* userData)
 {
-  bool delegateToSelf = getIsolate()->isThreadSelf();
   JSInterIsolateCall::Ptr pCall(new JSInterIsolateCall(request, 0, userData));
-  enqueue(pCall);
-
-  if (delegateToSelf)
-  {
-    doOneWork();
-  }
-  else
-  {
-    getEventLoop()->wakeup();
-  }
+  dispatch(pCall);
 }
 
 void JSInterIsolateCallManager::notify(const std::string& requestStr, void* userData, JSPersistentFunctionHandle* cb)
@@ -171,17 +179,8 @@ void JSInterIsolateCallManager::notify(const std::string& requestStr, void* user
 
 void JSInterIsolateCallManager::notify(const Request& request, void* userData, JSPersistentFunctionHandle* cb)
 {
-  bool delegateToSelf = getIsolate()->isThreadSelf();
   JSInterIsolateCall::Ptr pCall(new JSInterIsolateCall(request, 0, userData, cb));
-  enqueue(pCall);
-  if (delegateToSelf)
-  {
-    doOneWork();
-  }
-  else
-  {
-    getEventLoop()->wakeup();
-  }
+  dispatch(pCall);
 }
 
 } }
@@ -21,6 +21,8 @@
 #include "OSS/JS/JS.h"
 #include "OSS/JS/JSTimerManager.h"
 #include "OSS/JS/JSEventLoop.h"
+#include "OSS/JS/JSIsolate.h"
+#include <time.h>
 
 
 namespace OSS {
@@ -28,7 +30,7 @@ namespace JS {
 
 
 JSTimerManager::JSTimerManager(JSEventLoop* pEventLoop) :
-  JSFunctionCallbackQueue(pEventLoop),
+  JSEventLoopComponent(pEventLoop),
   _timerIdCounter(0)
 {
 }
@@ -37,21 +39,39 @@ JSTimerManager::~JSTimerManager()
 {
 }
 
+OSS::UInt64 JSTimerManager::getMonotonicTime()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (OSS::UInt64)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
 int JSTimerManager::scheduleTimer(int expire, const v8::Handle<v8::Value>& callback)
 {
   OSS::mutex_critic_sec_lock lock(_timersMutex);
   int id = ++_timerIdCounter;
-  JSTimer::Ptr pTimer = JSTimer::Ptr(new JSTimer(this, id, expire,  callback));
-  _timers[id] = pTimer;
-  return id;
+  return addTimer(new JSTimer(this, id, expire, callback), expire);
 }
 
 int JSTimerManager::scheduleTimer(int expire, const v8::Handle<v8::Value>& callback, const v8::Handle<v8::Value>& args)
 {
   OSS::mutex_critic_sec_lock lock(_timersMutex);
   int id = ++_timerIdCounter;
-  JSTimer::Ptr pTimer = JSTimer::Ptr(new JSTimer(this, id, expire,  callback,  args));
-  _timers[id] = pTimer;
+  return addTimer(new JSTimer(this, id, expire, callback, args), expire);
+}
+
+int JSTimerManager::addTimer(JSTimer* pTimer, int expire)
+{
+  int id = pTimer->getIdentifier();
+  _timers[id] = JSTimer::Ptr(pTimer);
+  _deadlines.push(Deadline(getMonotonicTime() + (expire > 0 ? expire : 0), id));
+  if (!getIsolate()->isThreadSelf())
+  {
+    //
+    // The loop may be sleeping on a later deadline
+    //
+    getEventLoop()->wakeup();
+  }
   return id;
 }
 
@@ -60,7 +80,7 @@ void JSTimerManager::cancelTimer(int timerId)
   JSTimer::Ptr pTimer = removeTimer(timerId);
   if (pTimer)
   {
-    dynamic_cast<JSTimer*>(pTimer.get())->cancel();
+    pTimer->dispose();
   }
 }
 
@@ -72,11 +92,60 @@ JSTimer::Ptr JSTimerManager::removeTimer(int timerId)
   if (iter != _timers.end())
   {
     pTimer = iter->second;
-    _timers.erase(timerId);
+    _timers.erase(iter);
   }
   return pTimer;
 }
 
+int JSTimerManager::getTimeout()
+{
+  OSS::mutex_critic_sec_lock lock(_timersMutex);
+  while (!_deadlines.empty() && _timers.find(_deadlines.top().second) == _timers.end())
+  {
+    _deadlines.pop();
+  }
+  if (_deadlines.empty())
+  {
+    return -1;
+  }
+  OSS::UInt64 now = getMonotonicTime();
+  OSS::UInt64 deadline = _deadlines.top().first;
+  return deadline > now ? (int)(deadline - now) : 0;
+}
+
+bool JSTimerManager::processTimers()
+{
+  OSS::UInt64 now = getMonotonicTime();
+  bool fired = false;
+  while (true)
+  {
+    JSTimer::Ptr pTimer;
+    {
+      OSS::mutex_critic_sec_lock lock(_timersMutex);
+      if (_deadlines.empty() || _deadlines.top().first > now)
+      {
+        break;
+      }
+      int id = _deadlines.top().second;
+      _deadlines.pop();
+      TimerMap::iterator iter = _timers.find(id);
+      if (iter == _timers.end())
+      {
+        continue;
+      }
+      pTimer = iter->second;
+      _timers.erase(iter);
+    }
+    //
+    // Callbacks run without the lock so they can schedule or cancel timers
+    //
+    pTimer->autoDisposeOnExecute() = true;
+    pTimer->execute();
+    fired = true;
+  }
+  return fired;
+}
+
 } } // OSSJS
 
 
@@ -396,5 +396,199 @@ std::string get_stack_trace(v8::Handle<v8::Message> message, uint32_t bufLen)
   return std::string(chars, size);
 }
 
+//
+// JSON conversion
+//
+
+static const int JS_JSON_MAX_DEPTH = 64;
+
+class JSValueFromJson : public OSS::JSON::ConstVisitor
+{
+public:
+  v8::Handle<v8::Value> value;
+
+  void Visit(const OSS::JSON::Array& array)
+  {
+    v8::Handle<v8::Array> result = v8::Array::New(array.Size());
+    uint32_t index = 0;
+    for (OSS::JSON::Array::const_iterator iter = array.Begin(); iter != array.End(); ++iter, ++index)
+    {
+      v8::HandleScope scope;
+      JSValueFromJson element;
+      iter->Accept(element);
+      result->Set(index, element.value);
+    }
+    value = result;
+  }
+
+  void Visit(const OSS::JSON::Object& object)
+  {
+    v8::Handle<v8::Object> result = v8::Object::New();
+    for (OSS::JSON::Object::const_iterator iter = object.Begin(); iter != object.End(); ++iter)
+    {
+      v8::HandleScope scope;
+      JSValueFromJson element;
+      iter->element.Accept(element);
+      result->Set(v8::String::New(iter->name.data(), iter->name.size()), element.value);
+    }
+    value = result;
+  }
+
+  void Visit(const OSS::JSON::Number& number)
+  {
+    value = v8::Number::New(number.Value());
+  }
+
+  void Visit(const OSS::JSON::String& string)
+  {
+    value = v8::String::New(string.Value().data(), string.Value().size());
+  }
+
+  void Visit(const OSS::JSON::Boolean& boolean)
+  {
+    value = v8::Boolean::New(boolean.Value());
+  }
+
+  void Visit(const OSS::JSON::Null& null)
+  {
+    value = v8::Null();
+  }
+};
+
+v8::Handle<v8::Value> js_value_from_json(const OSS::JSON::UnknownElement& element)
+{
+  v8::HandleScope scope;
+  JSValueFromJson visitor;
+  element.Accept(visitor);
+  return scope.Close(visitor.value);
+}
+
+v8::Handle<v8::Object> js_object_from_json(const OSS::JSON::Object& object)
+{
+  v8::HandleScope scope;
+  JSValueFromJson visitor;
+  visitor.Visit(object);
+  return scope.Close(visitor.value->ToObject());
+}
+
+static bool js_value_to_json(const v8::Handle<v8::Value>& value, OSS::JSON::UnknownElement& element, int depth);
+
+static bool js_object_to_json(const v8::Handle<v8::Object>& object, OSS::JSON::Object& json, int depth)
+{
+  v8::Handle<v8::Array> names = object->GetOwnPropertyNames();
+  for (uint32_t i = 0; i < names->Length(); i++)
+  {
+    v8::HandleScope scope;
+    v8::Handle<v8::Value> name = names->Get(i);
+    v8::Handle<v8::Value> member = object->Get(name);
+    if (member->IsUndefined() || member->IsFunction())
+    {
+      //
+      // JSON.stringify drops these from objects
+      //
+      continue;
+    }
+    v8::String::Utf8Value key(name);
+    OSS::JSON::Object::iterator iter = json.Insert(OSS::JSON::Object::Member(std::string(*key, key.length())));
+    if (!js_value_to_json(member, iter->element, depth + 1))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool js_value_to_json(const v8::Handle<v8::Value>& value, OSS::JSON::UnknownElement& element, int depth)
+{
+  if (depth > JS_JSON_MAX_DEPTH)
+  {
+    //
+    // Most likely a cyclic structure
+    //
+    return false;
+  }
+
+  if (value->IsString())
+  {
+    v8::String::Utf8Value str(value);
+    OSS::JSON::String& json = element;
+    json.Value().assign(*str, str.length());
+  }
+  else if (value->IsNumber())
+  {
+    double number = value->NumberValue();
+    if (number != number || number - number != 0)
+    {
+      //
+      // NaN and Infinity serialize as null
+      //
+      element = OSS::JSON::Null();
+    }
+    else
+    {
+      element = OSS::JSON::Number(number);
+    }
+  }
+  else if (value->IsBoolean())
+  {
+    element = OSS::JSON::Boolean(value->BooleanValue());
+  }
+  else if (value->IsArray())
+  {
+    v8::Handle<v8::Array> array = v8::Handle<v8::Array>::Cast(value);
+    OSS::JSON::Array& json = element;
+    json.Resize(array->Length());
+    for (uint32_t i = 0; i < array->Length(); i++)
+    {
+      v8::HandleScope scope;
+      v8::Handle<v8::Value> item = array->Get(i);
+      if (item->IsUndefined() || item->IsFunction())
+      {
+        continue;
+      }
+      if (!js_value_to_json(item, json[i], depth + 1))
+      {
+        return false;
+      }
+    }
+  }
+  else if (value->IsObject() && !value->IsFunction())
+  {
+    v8::Handle<v8::Object> object = value->ToObject();
+    v8::Handle<v8::Value> toJSON = object->Get(v8::String::NewSymbol("toJSON"));
+    if (toJSON->IsFunction())
+    {
+      //
+      // Dates and user types that customize their JSON form
+      //
+      v8::Handle<v8::Value> custom = v8::Handle<v8::Function>::Cast(toJSON)->Call(object, 0, 0);
+      if (custom.IsEmpty())
+      {
+        return false;
+      }
+      return js_value_to_json(custom, element, depth + 1);
+    }
+    OSS::JSON::Object& json = element;
+    return js_object_to_json(object, json, depth);
+  }
+  else
+  {
+    element = OSS::JSON::Null();
+  }
+  return true;
+}
+
+bool js_value_to_json(const v8::Handle<v8::Value>& value, OSS::JSON::UnknownElement& element)
+{
+  v8::HandleScope scope;
+  return js_value_to_json(value, element, 0);
+}
+
+bool js_object_to_json(const v8::Handle<v8::Object>& object, OSS::JSON::Object& json)
+{
+  v8::HandleScope scope;
+  return js_object_to_json(object, json, 0);
+}
+
 } } // OS::JS
 #endif // ENABLE_FEATURE_V8
@@ -119,9 +119,19 @@ static v8::Handle<v8::Value> __monitor_descriptor(const v8::Arguments& args)
 
   _enableAsync = true;
   
+  //
+  // An optional third argument requests edge-triggered notification.  The
+  // handler must then read until the descriptor would block.
+  //
+  int events = POLLIN;
+  if (args.Length() > 2 && args[2]->BooleanValue())
+  {
+    events |= EPOLLET;
+  }
+
   js_method_declare_isolate(pIsolate);
   OSS::JS::JSEventLoop* pEventLoop = pIsolate->eventLoop();
-  pEventLoop->fdManager().addFileDescriptor(args[0]->ToInt32()->Value(), args[1], POLLIN);
+  pEventLoop->fdManager().addFileDescriptor(args[0]->ToInt32()->Value(), args[1], events);
   Async::__wakeup_pipe();
   return v8::Undefined();
 }
@@ -22,6 +22,9 @@
 #include "OSS/UTL/Logger.h"
 #include "OSS/JS/modules/BufferObject.h"
 
+#include <cstring>
+#include <algorithm>
+
 using OSS::JS::JSObjectWrap;
 
 
@@ -39,21 +42,28 @@ JS_CLASS_INTERFACE(BufferObject, "Buffer")
   JS_CLASS_METHOD_DEFINE(BufferObject, "equals", equals);
   JS_CLASS_METHOD_DEFINE(BufferObject, "resize", resize);
   JS_CLASS_METHOD_DEFINE(BufferObject, "clear", clear);
-  JS_CLASS_INDEX_ACCESSOR_DEFINE(BufferObject, getAt, setAt); 
+  JS_CLASS_METHOD_DEFINE(BufferObject, "slice", slice);
   JS_CLASS_INTERFACE_END(BufferObject); 
 }
 
-BufferObject::BufferObject()
+BufferObject::BufferObject() :
+  _storage(new ByteArray()),
+  _offset(0),
+  _size(0)
 {
 }
 
 BufferObject::BufferObject(const BufferObject& obj) :
-  _buffer(obj._buffer)
+  _storage(new ByteArray(obj._storage->begin() + obj._offset, obj._storage->begin() + obj._offset + obj._size)),
+  _offset(0),
+  _size(obj._size)
 {
 }
 
 BufferObject::BufferObject(std::size_t size) :
-  _buffer(size)
+  _storage(new ByteArray(size)),
+  _offset(0),
+  _size(size)
 {
 }
 
@@ -61,6 +71,32 @@ BufferObject::~BufferObject()
 {
 }
 
+void BufferObject::exposeData()
+{
+  //
+  // v8 reads and writes the elements straight from our memory.  This has to
+  // be repeated whenever the storage is reallocated or the size changes.
+  //
+  static unsigned char empty = 0;
+  handle_->SetIndexedPropertiesToExternalArrayData(_size ? data() : &empty, v8::kExternalUnsignedByteArray, _size);
+}
+
+bool BufferObject::resize(std::size_t size)
+{
+  if (size == _size)
+  {
+    return true;
+  }
+  if (isShared())
+  {
+    return false;
+  }
+  _storage->resize(_offset + size);
+  _size = size;
+  exposeData();
+  return true;
+}
+
 JSValueHandle BufferObject::createNew(uint32_t size)
 {
   JSValueHandle funcArgs[1];
@@ -68,6 +104,17 @@ JSValueHandle BufferObject::createNew(uint32_t size)
   return BufferObject::_constructor->CallAsConstructor(1, funcArgs);
 }
 
+JSValueHandle BufferObject::createNew(const char* data, std::size_t size)
+{
+  JSValueHandle result = createNew(size);
+  BufferObject* pBuffer = js_unwrap_object(BufferObject, result->ToObject());
+  if (pBuffer && size)
+  {
+    std::memcpy(pBuffer->data(), data, size);
+  }
+  return result;
+}
+
 bool BufferObject::isBuffer(JSValueHandle value)
 {
   return !value.IsEmpty() && value->IsObject() &&
@@ -86,22 +133,23 @@ JS_CONSTRUCTOR_IMPL(BufferObject)
   else if (js_method_arg_length() == 1 && js_method_arg_is_string(0))
   {
     std::string str = js_method_arg_as_std_string(0);
-    pBuffer = new BufferObject();
-    if (!js_string_to_byte_array(str, pBuffer->_buffer, true))
+    if (str.empty())
     {
-      delete pBuffer;
       js_throw("Invalid String Elements");
     }
+    pBuffer = new BufferObject(str.size());
+    std::memcpy(pBuffer->data(), str.data(), str.size());
   }
   else if (js_method_arg_length() == 1 && js_method_arg_is_array(0))
   {
     JSArrayHandle array = js_method_arg_as_array(0);
     pBuffer = new BufferObject();
-    if (!js_int_array_to_byte_array(array, pBuffer->_buffer, true))
+    if (!js_int_array_to_byte_array(array, *pBuffer->_storage, true))
     {
       delete pBuffer;
       js_throw("Invalid Array Elements");
     }
+    pBuffer->_size = pBuffer->_storage->size();
   }
   else if (js_method_arg_length() == 1 && BufferObject::isBuffer(js_method_arg_as_object(0)))
   {
@@ -122,13 +170,14 @@ JS_CONSTRUCTOR_IMPL(BufferObject)
   }
   
   pBuffer->Wrap(js_method_arg_self());
+  pBuffer->exposeData();
   
   return js_method_arg_self();
 }
 
 JS_METHOD_IMPL(BufferObject::size)
 {
-  return JSInteger(js_method_arg_unwrap_self(BufferObject)->_buffer.size());
+  return JSInteger(js_method_arg_unwrap_self(BufferObject)->_size);
 }
 
 JS_METHOD_IMPL(BufferObject::fromArray)
@@ -143,10 +192,17 @@ JS_METHOD_IMPL(BufferObject::fromArray)
     resize = js_method_arg_as_bool(1);
   }
   BufferObject* pBuffer = js_method_arg_unwrap_self(BufferObject);
-  if (!js_int_array_to_byte_array(array, pBuffer->_buffer, resize))
+  ByteArray bytes;
+  if (!js_int_array_to_byte_array(array, bytes, true))
   {
     js_throw("Invalid Array Elements");
   }
+  if (resize && !pBuffer->resize(bytes.size()))
+  {
+    js_throw("Unable to resize a shared Buffer");
+  }
+  std::memset(pBuffer->data(), 0, pBuffer->_size);
+  std::memcpy(pBuffer->data(), bytes.data(), std::min(bytes.size(), pBuffer->_size));
   return JSUndefined();
 }
 
@@ -161,11 +217,17 @@ JS_METHOD_IMPL(BufferObject::fromString)
     js_method_arg_assert_bool(1);
     resize = js_method_arg_as_bool(1);
   }
-  BufferObject* pBuffer = js_method_arg_unwrap_self(BufferObject);
-  if (!js_string_to_byte_array(str, pBuffer->_buffer, resize))
+  if (str.empty())
   {
     js_throw("Invalid Array Elements");
   }
+  BufferObject* pBuffer = js_method_arg_unwrap_self(BufferObject);
+  if (resize && !pBuffer->resize(str.size()))
+  {
+    js_throw("Unable to resize a shared Buffer");
+  }
+  std::memset(pBuffer->data(), 0, pBuffer->_size);
+  std::memcpy(pBuffer->data(), str.data(), std::min(str.size(), pBuffer->_size));
   return JSUndefined();
 }
 
@@ -187,25 +249,14 @@ JS_METHOD_IMPL(BufferObject::fromBuffer)
   
   BufferObject* theirs = js_method_arg_unwrap_object(BufferObject, 0);
   BufferObject* ours = js_method_arg_unwrap_self(BufferObject);
-  if (resize)
+  if (resize && !ours->resize(theirs->_size))
   {
-    ours->_buffer = theirs->_buffer;
-  }
-  else
-  {
-    std::size_t bufLen = ours->_buffer.size();
-    for (std::size_t i = 0; i < theirs->_buffer.size(); i++)
-    {
-      if (i < bufLen)
-      {
-        ours->_buffer[i] = theirs->_buffer[i];
-      }
-      else
-      {
-        break;
-      }
-    }
+    js_throw("Unable to resize a shared Buffer");
   }
+  //
+  // The two may be slices of the same memory
+  //
+  std::memmove(ours->data(), theirs->data(), std::min(ours->_size, theirs->_size));
   return JSUndefined();
 }
 
@@ -213,14 +264,18 @@ JS_METHOD_IMPL(BufferObject::toArray)
 {
   BufferObject* pBuffer = js_method_arg_unwrap_self(BufferObject);
   
-  uint32_t size = 0;
-  if (js_method_arg_length() == 1)
+  uint32_t size = pBuffer->_size;
+  if (js_method_arg_length() == 1 && js_method_arg_as_uint32(0) && js_method_arg_as_uint32(0) < size)
   {
     size = js_method_arg_as_uint32(0);
   }
   
-  JSArrayHandle output = JSArray(size ? size : pBuffer->_buffer.size());
-  js_byte_array_to_int_array(pBuffer->_buffer, output, size);
+  JSArrayHandle output = JSArray(size);
+  const unsigned char* data = pBuffer->data();
+  for (uint32_t i = 0; i < size; i++)
+  {
+    output->Set(i, v8::Int32::New(data[i]));
+  }
   return output;
 }
 
@@ -228,13 +283,13 @@ JS_METHOD_IMPL(BufferObject::toString)
 {
   BufferObject* pBuffer = js_method_arg_unwrap_self(BufferObject);
   
-  uint32_t size = pBuffer->_buffer.size();
-  if (js_method_arg_length() == 1)
+  std::size_t size = pBuffer->_size;
+  if (js_method_arg_length() == 1 && js_method_arg_as_uint32(0) < size)
   {
     size = js_method_arg_as_uint32(0);
   }
-  std::string str((const char*)pBuffer->_buffer.data(), size);
-  return JSString(str.c_str(), strlen(str.c_str()));
+  const char* data = (const char*)pBuffer->data();
+  return JSString(data, strnlen(data, size));
 }
 
 JS_METHOD_IMPL(BufferObject::equals) 
@@ -248,7 +303,7 @@ JS_METHOD_IMPL(BufferObject::equals)
   }
   BufferObject* theirs = js_method_arg_unwrap_object(BufferObject, 0);
   BufferObject* ours = js_method_arg_unwrap_self(BufferObject);
-  return JSBoolean(ours->_buffer == theirs->_buffer);
+  return JSBoolean(ours->_size == theirs->_size && std::memcmp(ours->data(), theirs->data(), ours->_size) == 0);
 }
 
 JS_METHOD_IMPL(BufferObject::resize)
@@ -257,50 +312,59 @@ JS_METHOD_IMPL(BufferObject::resize)
   js_method_arg_assert_size_eq(1);
   js_method_arg_assert_uint32(0);
   uint32_t size = js_method_arg_as_uint32(0);
-  buf->buffer().resize(size);
+  if (!buf->resize(size))
+  {
+    js_throw("Unable to resize a shared Buffer");
+  }
   return JSUndefined();
 }
 
 JS_METHOD_IMPL(BufferObject::clear)
 {
   BufferObject* buf = js_method_arg_unwrap_self(BufferObject);
-  buf->buffer().clear();
+  if (!buf->resize(0))
+  {
+    js_throw("Unable to resize a shared Buffer");
+  }
   return JSUndefined();
 }
 
-JS_METHOD_IMPL(BufferObject::isBufferObject)
-{
-  return JSBoolean(BufferObject::isBuffer(js_method_arg(0)));
-}
-
-//
-// Properties
-//
-JS_INDEX_GETTER_IMPL(BufferObject::getAt)
+JS_METHOD_IMPL(BufferObject::slice)
 {
-  BufferObject* pBuffer = js_getter_info_unwrap_self(BufferObject);
-  if (index >= pBuffer->_buffer.size())
+  //
+  // slice(start, end) returns a Buffer over the same memory, like
+  // TypedArray.subarray().  Writes through either one are seen by both.
+  //
+  BufferObject* pBuffer = js_method_arg_unwrap_self(BufferObject);
+  std::size_t start = 0;
+  std::size_t end = pBuffer->_size;
+  if (js_method_arg_length() >= 1)
   {
-    js_throw("Index Out Of Range");
+    js_method_arg_assert_uint32(0);
+    start = std::min<std::size_t>(js_method_arg_as_uint32(0), pBuffer->_size);
   }
-  return JSUInt32(pBuffer->_buffer[js_getter_index()]);
-}
-
-JS_INDEX_SETTER_IMPL(BufferObject::setAt)
-{
-  BufferObject* pBuffer = js_setter_info_unwrap_self(BufferObject);
-  
-  if (js_setter_index() >= pBuffer->_buffer.size())
+  if (js_method_arg_length() >= 2)
   {
-    js_throw("Index Out Of Range");
+    js_method_arg_assert_uint32(1);
+    end = std::min<std::size_t>(js_method_arg_as_uint32(1), pBuffer->_size);
   }
-  uint32_t val = js_setter_value_as_uint32();
-  if (val > 256)
+  if (end < start)
   {
-    js_throw("Invalid Argument");
+    end = start;
   }
-  pBuffer->_buffer[js_setter_index()] = val;
-  return JSUndefined();
+  
+  JSObjectHandle result = BufferObject::_constructor->NewInstance();
+  BufferObject* pSlice = js_unwrap_object(BufferObject, result);
+  pSlice->_storage = pBuffer->_storage;
+  pSlice->_offset = pBuffer->_offset + start;
+  pSlice->_size = end - start;
+  pSlice->exposeData();
+  return result;
+}
+
+JS_METHOD_IMPL(BufferObject::isBufferObject)
+{
+  return JSBoolean(BufferObject::isBuffer(js_method_arg(0)));
 }
 
 
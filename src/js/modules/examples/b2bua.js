@@ -180,6 +180,20 @@ sbc.on_initialize_user_agent(function(){
                  domain : "demo.webrtc.local",
                  max_channels : 30
              }
+         ],
+        /****************************************************************************
+         * RTP may be relayed by remote media proxy nodes instead of in process.    *
+         * Sessions are spread across the nodes using a consistent hash.  A node    *
+         * with a higher weight receives proportionally more sessions.  If remote   *
+         * RTP is enabled without any node, the local nodes on ports 40590 to 40594 *
+         * are used.                                                                *
+         ****************************************************************************/
+         enable_remote_rtp : false,
+         media_proxy_nodes : [
+             {
+                 address : "tcp://127.0.0.1:40590",
+                 weight : 1
+             }
          ]
     }
 });
@@ -56,3 +56,13 @@ console.log("Buffer fromArray checked");
 buf4.fromBuffer(buf2);
 assert.ok(buf2.equals(buf4));
 console.log("Buffer assignment checked");
+
+//
+// Slices share memory with the buffer they were taken from
+//
+var buf5 = buf2.slice(2, 6);
+assert.ok(buf5.size() === 4);
+assert.ok(buf5[0] === 2);
+buf5[0] = 200;
+assert.ok(buf2[2] === 200);
+console.log("Buffer slice checked");
@@ -99,8 +99,7 @@ JS_METHOD_IMPL(FileObject::_fmemopen)
   js_assert(pFile->_pFile, "Invalid Argument");
   JSValueHandle result = BufferObject::createNew(len);
   BufferObject* pBuffer = js_unwrap_object(BufferObject, result->ToObject());
-  ByteArray& buf = pBuffer->buffer();
-  pFile->_pFile = ::fmemopen(buf.data(), buf.size(), options.c_str());
+  pFile->_pFile = ::fmemopen(pBuffer->data(), pBuffer->size(), options.c_str());
   return JSBoolean(pFile->_pFile != 0);
 }
 
@@ -167,12 +166,15 @@ JS_METHOD_IMPL(FileObject::_fread)
   js_assert(pFile->_pFile, "Invalid Argument");
   JSValueHandle result = BufferObject::createNew(len);
   BufferObject* pBuffer = js_unwrap_object(BufferObject, result->ToObject());
-  ByteArray& buf = pBuffer->buffer();
-  std::size_t ret = ::fread(buf.data(), buf.size(), len, pFile->_pFile);
+  std::size_t ret = ::fread(pBuffer->data(), 1, len, pFile->_pFile);
   if (!ret)
   {
     return JSUndefined();
   }
+  if (ret < (std::size_t)len)
+  {
+    pBuffer->resize(ret);
+  }
   return result;
 }
 
@@ -200,7 +202,7 @@ JS_METHOD_IMPL(FileObject::_fwrite)
   else if (js_method_arg_is_buffer(0))
   {
     BufferObject* pBuffer = js_method_arg_unwrap_object(BufferObject, 0);
-    return JSInt32(::fwrite(pBuffer->buffer().data(), 1, pBuffer->buffer().size(), pFile->_pFile));
+    return JSInt32(::fwrite(pBuffer->data(), 1, pBuffer->size(), pFile->_pFile));
   }
   
   return JSException("Invalid Argument");
@@ -216,14 +218,13 @@ JS_METHOD_IMPL(FileObject::_fgets)
   js_assert(pFile->_pFile, "Invalid Argument");
   JSValueHandle result = BufferObject::createNew(len);
   BufferObject* pBuffer = js_unwrap_object(BufferObject, result->ToObject());
-  ByteArray& buf = pBuffer->buffer();
   
-  char* line = ::fgets((char*)buf.data(), buf.size(), pFile->_pFile);
+  char* line = ::fgets((char*)pBuffer->data(), pBuffer->size(), pFile->_pFile);
   if (!line)
   {
     return JSUndefined();
   }
-  buf.resize(strlen(line));
+  pBuffer->resize(strlen(line));
   return result;
 }
 
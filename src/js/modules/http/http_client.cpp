@@ -374,7 +374,7 @@ public:
     try
     {
       std::istream& strm = *_client->getInputStream();
-      strm.read((char*)_buf->buffer().data(), _size);
+      strm.read((char*)_buf->data(), _size);
       OSS::JS::JSEventArgument json("read_ready", _client->getEventFd());
       json.addUInt32(strm.gcount());
       _client->getIsolate()->eventLoop()->eventEmitter().emit(json);
@@ -441,7 +441,7 @@ JS_METHOD_IMPL(HttpClientObject::write)
   if (self->_output)
   {
     std::ostream& strm = *self->_output;
-    return JSBoolean(!strm.write((char*)buf->buffer().data(), size).fail());
+    return JSBoolean(!strm.write((char*)buf->data(), size).fail());
   }
   
   return JSBoolean(false);
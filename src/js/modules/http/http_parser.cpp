@@ -346,7 +346,7 @@ JS_METHOD_IMPL(HttpParserObject::parse)
   js_method_arg_assert_buffer(0);
   BufferObject* pBuffer = js_method_arg_as_buffer(0);
   HttpParserObject* pParser = js_method_arg_unwrap_self(HttpParserObject);
-  return JSUInt32(http_parser_execute(&pParser->_parser, &_settings, (const char*)pBuffer->buffer().data(), pBuffer->buffer().size()));
+  return JSUInt32(http_parser_execute(&pParser->_parser, &_settings, (const char*)pBuffer->data(), pBuffer->size()));
 }
 
 JS_EXPORTS_INIT()
@@ -341,7 +341,7 @@ JS_METHOD_IMPL(HttpServerObject::_read)
   js_method_arg_declare_int32(streamId, 0);
   js_method_arg_declare_external_object(BufferObject, buf, 1);
   js_method_arg_declare_uint32(size, 2);
-  return JSUInt32(self->read(streamId, (char*)buf->buffer().data(), size));
+  return JSUInt32(self->read(streamId, (char*)buf->data(), size));
 }
 
 JS_METHOD_IMPL(HttpServerObject::_write)
@@ -350,7 +350,7 @@ JS_METHOD_IMPL(HttpServerObject::_write)
   js_method_arg_declare_int32(streamId, 0);
   js_method_arg_declare_external_object(BufferObject, buf, 1);
   js_method_arg_declare_uint32(size, 2);
-  return JSUInt32(self->write(streamId, (char*)buf->buffer().data(), size));
+  return JSUInt32(self->write(streamId, (char*)buf->data(), size));
 }
 
 JS_METHOD_IMPL(HttpServerObject::_listen)
@@ -20,6 +20,7 @@
 #include "OSS/JS/modules/IsolateObject.h"
 #include "OSS/JS/JSIsolateManager.h"
 #include "OSS/JS/JSEventLoop.h"
+#include "OSS/JS/JSUtil.h"
 #include "OSS/UTL/Logger.h"
 
 using OSS::JS::JSIsolateManager;
@@ -115,6 +116,20 @@ JS_METHOD_IMPL(IsolateObject::execute)
 {
   js_enter_scope();
   js_method_arg_declare_self(IsolateObject, pSelf);
+  if (js_method_arg_is_object(0) && !js_method_arg_is_array(0))
+  {
+    //
+    // Objects are converted directly without going through a JSON string
+    //
+    js_method_arg_declare_uint32(timeout, 1);
+    OSS::JSON::Object request, result;
+    if (!OSS::JS::js_object_to_json(js_method_arg(0)->ToObject(), request) ||
+      !pSelf->_pIsolate->eventLoop()->interIsolate().execute(request, result, timeout, 0))
+    {
+      return JSUndefined();
+    }
+    return OSS::JS::js_object_from_json(result);
+  }
   js_method_arg_declare_string(request, 0);
   js_method_arg_declare_uint32(timeout, 1);
   std::string result;
@@ -129,6 +144,15 @@ JS_METHOD_IMPL(IsolateObject::notify)
 {
   js_enter_scope();
   js_method_arg_declare_self(IsolateObject, pSelf);
+  if (js_method_arg_is_object(0) && !js_method_arg_is_array(0))
+  {
+    OSS::JSON::Object request;
+    if (OSS::JS::js_object_to_json(js_method_arg(0)->ToObject(), request))
+    {
+      pSelf->_pIsolate->eventLoop()->interIsolate().notify(request, 0);
+    }
+    return JSUndefined();
+  }
   js_method_arg_declare_string(request, 0);
   pSelf->_pIsolate->eventLoop()->interIsolate().notify(request, 0);
   return JSUndefined();
@@ -137,8 +161,17 @@ JS_METHOD_IMPL(IsolateObject::notify)
 JS_METHOD_IMPL(notifyParentIsolate)
 {
   js_enter_scope();
-  js_method_arg_declare_string(request, 0);
   OSS::JS::JSIsolate::Ptr pIsolate = OSS::JS::JSIsolateManager::instance().getIsolate(); 
+  if (js_method_arg_is_object(0) && !js_method_arg_is_array(0))
+  {
+    OSS::JSON::Object request;
+    if (pIsolate && !pIsolate->isRoot() && OSS::JS::js_object_to_json(js_method_arg(0)->ToObject(), request))
+    {
+      pIsolate->getParentIsolate()->notify(request, 0);
+    }
+    return JSUndefined();
+  }
+  js_method_arg_declare_string(request, 0);
   if (pIsolate && !pIsolate->isRoot())
   {
     pIsolate->getParentIsolate()->notify(request, 0);
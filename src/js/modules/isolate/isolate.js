@@ -13,7 +13,7 @@ var inter_isolate_handler = function(request, userData, handler, defaultHandler)
       response.error = new Object();
       response.error.code = -32601;
       response.error.message = "Method not found";
-      return JSON.stringify(response);
+      return response;
     } else {
       result = defaultHandler(request, userData);
     }
@@ -26,10 +26,10 @@ var inter_isolate_handler = function(request, userData, handler, defaultHandler)
     var response = new Object();
     response.error = new Object();
     response.error.code = -32603;
-    response.error.message = e;
-    return JSON.stringify(response);
+    response.error.message = e.toString();
+    return response;
   }
-  return JSON.stringify(result);
+  return result;
 }
 
 exports.interIsolateHandler = function(request, userData) {
@@ -92,21 +92,14 @@ var Isolate = function(threadId) {
     if (!timeout) {
       timeout = 0;
     }
-    var json = JSON.stringify(request);
-    var result = isolate.execute(json, timeout);
-    if (result) {
-      return JSON.parse(result);
-    } else {
-      return undefined;
-    }
+    return isolate.execute(request, timeout);
   }
 
   _this.notify = function(method, args) {
     var request = new Object();
     request.method = method;
     request.arguments = args;
-    var json = JSON.stringify(request);
-    isolate.notify(json);
+    isolate.notify(request);
   }
 }
 
@@ -117,8 +110,7 @@ exports.notifyParentIsolate = function(method, args, id) {
   if (id) {
       request.id = id;
   }
-  var json = JSON.stringify(request);
-  _isolate.notifyParentIsolate(json);
+  _isolate.notifyParentIsolate(request);
 }
 
 exports.Isolate = Isolate;
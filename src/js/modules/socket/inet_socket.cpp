@@ -82,7 +82,7 @@ JS_METHOD_IMPL(__sendto_inet_dgram_socket)
   std::string service = js_method_arg_as_std_string(4);
   int32_t flags = js_method_arg_as_int32(5);
   
-  int32_t ret = sendto_inet_dgram_socket(fd, pBuffer->buffer().data(), size, host.c_str(), service.c_str(), flags);
+  int32_t ret = sendto_inet_dgram_socket(fd, pBuffer->data(), size, host.c_str(), service.c_str(), flags);
   
   return JSInt32(ret);
 }
@@ -102,7 +102,7 @@ JS_METHOD_IMPL(__recvfrom_inet_dgram_socket)
   
   memset(HOST_BUF, 0, HOST_BUF_SIZE);
   memset(SERVICE_BUF, 0, SERVICE_BUF_SIZE);
-  uint32_t ret = recvfrom_inet_dgram_socket(fd, (void*)pBuffer->buffer().data(), size, HOST_BUF, HOST_BUF_SIZE, SERVICE_BUF, SERVICE_BUF_SIZE, flags, LIBSOCKET_NUMERIC);
+  uint32_t ret = recvfrom_inet_dgram_socket(fd, (void*)pBuffer->data(), size, HOST_BUF, HOST_BUF_SIZE, SERVICE_BUF, SERVICE_BUF_SIZE, flags, LIBSOCKET_NUMERIC);
   
   JSObjectHandle result = JSObject();
   result->Set(JSLiteral("size"), JSUInt32(ret));
@@ -64,7 +64,7 @@ JS_METHOD_IMPL(__write)
   else if (js_method_arg_is_buffer(1))
   {
     BufferObject* pBuffer = js_method_arg_unwrap_object(BufferObject, 1);
-    return JSInt32(::write(fd, pBuffer->buffer().data(), size ? size : pBuffer->buffer().size()));
+    return JSInt32(::write(fd, pBuffer->data(), size ? size : pBuffer->size()));
   }
   
   return JSException("Invalid Argument");
@@ -114,8 +114,7 @@ JS_METHOD_IMPL(__read)
     JSValueHandle result = BufferObject::createNew(len);
     BufferObject* pBuffer = js_unwrap_object(BufferObject, result->ToObject());
 
-    ByteArray& buf = pBuffer->buffer();
-    std::size_t ret = ::read(fd, buf.data(), buf.size());
+    std::size_t ret = ::read(fd, pBuffer->data(), pBuffer->size());
     if (!ret)
     {
       return JSUndefined();
@@ -129,12 +128,11 @@ JS_METHOD_IMPL(__read)
     //
     js_method_arg_assert_buffer(2);
     BufferObject* pBuffer = js_method_arg_unwrap_object(BufferObject, 2);
-    if (len > pBuffer->buffer().size())
+    if (len > pBuffer->size())
     {
       js_throw("Length paramater exceeds buffer size");
     }
-    ByteArray& buf = pBuffer->buffer();
-    std::size_t ret = ::read(fd, buf.data(), len);
+    std::size_t ret = ::read(fd, pBuffer->data(), len);
     return JSInt32(ret);
   }
   return JSUndefined();
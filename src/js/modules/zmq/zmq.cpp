@@ -18,6 +18,7 @@
 //
 
 #include <list>
+#include <cstring>
 #include "OSS/JS/JSPlugin.h"
 #include "OSS/JS/modules/ZMQSocketObject.h"
 #include "OSS/JS/modules/BufferObject.h"
@@ -187,7 +188,7 @@ static bool __get_buffer_arg(const v8::Arguments& args, std::string& value)
     return false;
   }
   BufferObject* pBuffer = JSObjectWrap::Unwrap<BufferObject>(args[0]->ToObject());
-  std::copy(pBuffer->buffer().begin(), pBuffer->buffer().end(), std::back_inserter(value));
+  value.append((const char*)pBuffer->data(), pBuffer->size());
   return true;
 }
 
@@ -279,11 +280,11 @@ v8::Handle<v8::Value> ZMQSocketObject::receive(const v8::Arguments& args)
     {
       result = args[0];
       pBuffer = JSObjectWrap::Unwrap<BufferObject>(args[0]->ToObject());
-      if (msg.size() > pBuffer->buffer().size())
+      if (msg.size() > pBuffer->size())
       {
         return v8::ThrowException(v8::Exception::Error(v8::String::New("Size of read buffer is too small")));
       }
-      std::copy(msg.begin(), msg.end(), pBuffer->buffer().begin());
+      std::memcpy(pBuffer->data(), msg.data(), msg.size());
     }
     else
     {
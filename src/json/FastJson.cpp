@@ -0,0 +1,678 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "OSS/JSON/FastJson.h"
+
+
+namespace OSS {
+namespace JSON {
+
+
+//
+// Scanning helpers
+//
+
+static inline unsigned int ctz32(unsigned int value)
+{
+  return (unsigned int)__builtin_ctz(value);
+}
+
+static const char* find_quote_or_escape(const char* current, const char* end)
+  // Returns the first '"' or '\\' in [current, end) or end
+{
+#if defined(__SSE2__)
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i escape = _mm_set1_epi8('\\');
+  while (end - current >= 16)
+  {
+    __m128i chunk = _mm_loadu_si128((const __m128i*)current);
+    int mask = _mm_movemask_epi8(_mm_or_si128(
+      _mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, escape)));
+    if (mask)
+      return current + ctz32(mask);
+    current += 16;
+  }
+#endif
+  while (current < end && *current != '"' && *current != '\\')
+    ++current;
+  return current;
+}
+
+static inline bool needs_escape(unsigned char ch)
+{
+  return ch == '"' || ch == '\\' || ch < 0x20;
+}
+
+static const char* find_needs_escape(const char* current, const char* end)
+  // Returns the first character in [current, end) that has to be escaped
+{
+#if defined(__SSE2__)
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i escape = _mm_set1_epi8('\\');
+  const __m128i control = _mm_set1_epi8(0x1F);
+  while (end - current >= 16)
+  {
+    __m128i chunk = _mm_loadu_si128((const __m128i*)current);
+    __m128i special = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, escape)),
+      _mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control));
+    int mask = _mm_movemask_epi8(special);
+    if (mask)
+      return current + ctz32(mask);
+    current += 16;
+  }
+#endif
+  while (current < end && !needs_escape((unsigned char)*current))
+    ++current;
+  return current;
+}
+
+static inline bool is_space(char ch)
+{
+  return ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t' || ch == '\v' || ch == '\f';
+}
+
+static inline bool is_number_char(char ch)
+{
+  return (ch >= '0' && ch <= '9') || ch == '.' || ch == 'e' || ch == 'E' || ch == '-' || ch == '+';
+}
+
+static void append_utf8(std::string& out, unsigned long codePoint)
+{
+  if (codePoint < 0x80)
+  {
+    out.push_back((char)codePoint);
+  }
+  else if (codePoint < 0x800)
+  {
+    out.push_back((char)(0xC0 | (codePoint >> 6)));
+    out.push_back((char)(0x80 | (codePoint & 0x3F)));
+  }
+  else if (codePoint < 0x10000)
+  {
+    out.push_back((char)(0xE0 | (codePoint >> 12)));
+    out.push_back((char)(0x80 | ((codePoint >> 6) & 0x3F)));
+    out.push_back((char)(0x80 | (codePoint & 0x3F)));
+  }
+  else
+  {
+    out.push_back((char)(0xF0 | (codePoint >> 18)));
+    out.push_back((char)(0x80 | ((codePoint >> 12) & 0x3F)));
+    out.push_back((char)(0x80 | ((codePoint >> 6) & 0x3F)));
+    out.push_back((char)(0x80 | (codePoint & 0x3F)));
+  }
+}
+
+//
+// Parser
+//
+
+class FastParser
+{
+public:
+  FastParser(const char* data, std::size_t size) :
+    _begin(data),
+    _current(data),
+    _end(data + size),
+    _depth(0)
+  {
+  }
+
+  void parseDocument(json::UnknownElement& element)
+  {
+    skipSpace();
+    parseValue(element);
+    expectEnd();
+  }
+
+  void parseDocument(json::Object& object)
+  {
+    skipSpace();
+    expectToken('{', "{");
+    parseObject(object);
+    expectEnd();
+  }
+
+  void parseDocument(json::Array& array)
+  {
+    skipSpace();
+    expectToken('[', "[");
+    parseArray(array);
+    expectEnd();
+  }
+
+private:
+  json::Reader::Location location(const char* position) const
+  {
+    json::Reader::Location loc;
+    for (const char* current = _begin; current < position; ++current)
+    {
+      if (*current == '\n')
+      {
+        ++loc.m_nLine;
+        loc.m_nLineOffset = 0;
+      }
+      else
+      {
+        ++loc.m_nLineOffset;
+      }
+    }
+    loc.m_nDocOffset = (unsigned int)(position - _begin);
+    return loc;
+  }
+
+  void scanError(const std::string& message) const
+  {
+    throw json::Reader::ScanException(message, location(_current));
+  }
+
+  void parseError(const std::string& message, const char* tokenBegin) const
+  {
+    throw json::Reader::ParseException(message, location(tokenBegin), location(_current));
+  }
+
+  void skipSpace()
+  {
+    while (_current < _end && is_space(*_current))
+      ++_current;
+  }
+
+  void expectToken(char ch, const char* name)
+  {
+    if (_current >= _end)
+      parseError("Unexpected End of token stream", _current);
+    if (*_current != ch)
+      parseError(std::string("Expected token: ") + name, _current);
+    ++_current;
+  }
+
+  void expectEnd()
+  {
+    skipSpace();
+    if (_current != _end)
+      parseError("Expected End of token stream", _current);
+  }
+
+  void expectLiteral(const char* literal, std::size_t size)
+  {
+    if ((std::size_t)(_end - _current) < size || std::memcmp(_current, literal, size) != 0)
+      scanError(std::string("Expected string: ") + literal);
+    _current += size;
+  }
+
+  void parseValue(json::UnknownElement& element)
+  {
+    if (_current >= _end)
+      parseError("Unexpected end of token stream", _current);
+
+    switch (*_current)
+    {
+    case '{':
+      {
+        ++_current;
+        json::Object& object = element;
+        parseObject(object);
+        break;
+      }
+    case '[':
+      {
+        ++_current;
+        json::Array& array = element;
+        parseArray(array);
+        break;
+      }
+    case '"':
+      {
+        json::String& string = element;
+        parseString(string.Value());
+        break;
+      }
+    case 't':
+      {
+        expectLiteral("true", 4);
+        element = json::Boolean(true);
+        break;
+      }
+    case 'f':
+      {
+        expectLiteral("false", 5);
+        element = json::Boolean(false);
+        break;
+      }
+    case 'n':
+      {
+        expectLiteral("null", 4);
+        element = json::Null();
+        break;
+      }
+    default:
+      if (*_current == '-' || (*_current >= '0' && *_current <= '9'))
+      {
+        json::Number& number = element;
+        number.Value() = parseNumber();
+      }
+      else
+      {
+        scanError(std::string("Unexpected character in stream: ") + *_current);
+      }
+    }
+  }
+
+  void enter()
+  {
+    if (++_depth > FastReader::MAX_DEPTH)
+      parseError("Maximum nesting depth exceeded", _current);
+  }
+
+  void parseObject(json::Object& object)
+  {
+    enter();
+    skipSpace();
+    if (_current < _end && *_current == '}')
+    {
+      ++_current;
+      --_depth;
+      return;
+    }
+
+    std::string name;
+    for (;;)
+    {
+      skipSpace();
+      const char* tokenBegin = _current;
+      if (_current >= _end || *_current != '"')
+        parseError("Unexpected token: expected member name", tokenBegin);
+      name.clear();
+      parseString(name);
+
+      skipSpace();
+      expectToken(':', ":");
+      skipSpace();
+
+      json::Object::iterator member;
+      try
+      {
+        member = object.Insert(json::Object::Member(name));
+      }
+      catch (json::Exception&)
+      {
+        parseError("Duplicate object member token: " + name, tokenBegin);
+      }
+      parseValue(member->element);
+
+      skipSpace();
+      if (_current < _end && *_current == ',')
+      {
+        ++_current;
+        continue;
+      }
+      expectToken('}', "}");
+      break;
+    }
+    --_depth;
+  }
+
+  void parseArray(json::Array& array)
+  {
+    enter();
+    skipSpace();
+    if (_current < _end && *_current == ']')
+    {
+      ++_current;
+      --_depth;
+      return;
+    }
+
+    for (;;)
+    {
+      skipSpace();
+      json::Array::iterator element = array.Insert(json::UnknownElement());
+      parseValue(*element);
+
+      skipSpace();
+      if (_current < _end && *_current == ',')
+      {
+        ++_current;
+        continue;
+      }
+      expectToken(']', "]");
+      break;
+    }
+    --_depth;
+  }
+
+  unsigned long parseHex4()
+  {
+    if (_end - _current < 4)
+      scanError("Truncated \\u escape sequence");
+    unsigned long value = 0;
+    for (int i = 0; i < 4; i++)
+    {
+      char ch = *_current++;
+      value <<= 4;
+      if (ch >= '0' && ch <= '9')
+        value |= ch - '0';
+      else if (ch >= 'a' && ch <= 'f')
+        value |= ch - 'a' + 10;
+      else if (ch >= 'A' && ch <= 'F')
+        value |= ch - 'A' + 10;
+      else
+        scanError("Invalid \\u escape sequence");
+    }
+    return value;
+  }
+
+  void parseString(std::string& value)
+  {
+    ++_current;
+    for (;;)
+    {
+      const char* special = find_quote_or_escape(_current, _end);
+      value.append(_current, special - _current);
+      _current = special;
+
+      if (_current >= _end)
+        scanError("Expected string: \"");
+
+      if (*_current == '"')
+      {
+        ++_current;
+        return;
+      }
+
+      //
+      // Escape sequence
+      //
+      ++_current;
+      if (_current >= _end)
+        scanError("Expected string: \"");
+      char ch = *_current++;
+      switch (ch)
+      {
+      case '/':  value.push_back('/');  break;
+      case '"':  value.push_back('"');  break;
+      case '\\': value.push_back('\\'); break;
+      case 'b':  value.push_back('\b'); break;
+      case 'f':  value.push_back('\f'); break;
+      case 'n':  value.push_back('\n'); break;
+      case 'r':  value.push_back('\r'); break;
+      case 't':  value.push_back('\t'); break;
+      case 'u':
+        {
+          unsigned long codePoint = parseHex4();
+          if (codePoint >= 0xD800 && codePoint <= 0xDBFF &&
+            _end - _current >= 6 && _current[0] == '\\' && _current[1] == 'u')
+          {
+            const char* mark = _current;
+            _current += 2;
+            unsigned long low = parseHex4();
+            if (low >= 0xDC00 && low <= 0xDFFF)
+              codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+            else
+              _current = mark;
+          }
+          append_utf8(value, codePoint);
+          break;
+        }
+      default:
+        scanError(std::string("Unrecognized escape sequence found in string: \\") + ch);
+      }
+    }
+  }
+
+  double parseNumber()
+  {
+    const char* tokenBegin = _current;
+    while (_current < _end && is_number_char(*_current))
+      ++_current;
+    std::size_t size = _current - tokenBegin;
+
+    //
+    // Plain integers that fit a double exactly skip strtod
+    //
+    const char* digits = tokenBegin;
+    bool negative = *digits == '-';
+    if (negative)
+      ++digits;
+    std::size_t digitCount = tokenBegin + size - digits;
+    if (digitCount > 0 && digitCount <= 15)
+    {
+      OSS::UInt64 integer = 0;
+      const char* current = digits;
+      for (; current < _current && *current >= '0' && *current <= '9'; ++current)
+        integer = integer * 10 + (*current - '0');
+      if (current == _current)
+        return negative ? -(double)integer : (double)integer;
+    }
+
+    char buffer[64];
+    std::string longBuffer;
+    const char* number = buffer;
+    if (size < sizeof(buffer))
+    {
+      std::memcpy(buffer, tokenBegin, size);
+      buffer[size] = '\0';
+    }
+    else
+    {
+      longBuffer.assign(tokenBegin, size);
+      number = longBuffer.c_str();
+    }
+
+    char* numberEnd = 0;
+    double value = std::strtod(number, &numberEnd);
+    if (numberEnd != number + size)
+      parseError("Unexpected character in NUMBER", tokenBegin);
+    return value;
+  }
+
+  const char* _begin;
+  const char* _current;
+  const char* _end;
+  unsigned int _depth;
+};
+
+void FastReader::Read(json::Object& object, const char* data, std::size_t size)
+{
+  FastParser parser(data, size);
+  parser.parseDocument(object);
+}
+
+void FastReader::Read(json::Array& array, const char* data, std::size_t size)
+{
+  FastParser parser(data, size);
+  parser.parseDocument(array);
+}
+
+void FastReader::Read(json::UnknownElement& element, const char* data, std::size_t size)
+{
+  FastParser parser(data, size);
+  parser.parseDocument(element);
+}
+
+//
+// Writer
+//
+
+FastWriter::FastWriter(std::string& out) :
+  _out(out)
+{
+}
+
+void FastWriter::Write(const json::Object& object, std::string& out)
+{
+  FastWriter writer(out);
+  writer.write(object);
+}
+
+void FastWriter::Write(const json::Array& array, std::string& out)
+{
+  FastWriter writer(out);
+  writer.write(array);
+}
+
+void FastWriter::Write(const json::UnknownElement& element, std::string& out)
+{
+  FastWriter writer(out);
+  element.Accept(writer);
+}
+
+void FastWriter::write(const json::Object& object)
+{
+  _out.push_back('{');
+  for (json::Object::const_iterator iter = object.Begin(); iter != object.End(); ++iter)
+  {
+    if (iter != object.Begin())
+      _out.push_back(',');
+    write(iter->name);
+    _out.push_back(':');
+    iter->element.Accept(*this);
+  }
+  _out.push_back('}');
+}
+
+void FastWriter::write(const json::Array& array)
+{
+  _out.push_back('[');
+  for (json::Array::const_iterator iter = array.Begin(); iter != array.End(); ++iter)
+  {
+    if (iter != array.Begin())
+      _out.push_back(',');
+    iter->Accept(*this);
+  }
+  _out.push_back(']');
+}
+
+void FastWriter::write(const std::string& value)
+{
+  static const char hex[] = "0123456789abcdef";
+
+  _out.reserve(_out.size() + value.size() + 2);
+  _out.push_back('"');
+  const char* current = value.data();
+  const char* end = current + value.size();
+  for (;;)
+  {
+    const char* special = find_needs_escape(current, end);
+    _out.append(current, special - current);
+    if (special == end)
+      break;
+
+    unsigned char ch = (unsigned char)*special;
+    switch (ch)
+    {
+    case '"':  _out.append("\\\"", 2); break;
+    case '\\': _out.append("\\\\", 2); break;
+    case '\b': _out.append("\\b", 2);  break;
+    case '\f': _out.append("\\f", 2);  break;
+    case '\n': _out.append("\\n", 2);  break;
+    case '\r': _out.append("\\r", 2);  break;
+    case '\t': _out.append("\\t", 2);  break;
+    default:
+      {
+        char escaped[6] = { '\\', 'u', '0', '0', hex[ch >> 4], hex[ch & 0x0F] };
+        _out.append(escaped, sizeof(escaped));
+      }
+    }
+    current = special + 1;
+  }
+  _out.push_back('"');
+}
+
+void FastWriter::write(double value)
+{
+  char buffer[32];
+
+  if (value != value || value - value != 0)
+  {
+    //
+    // NaN and infinity have no JSON representation
+    //
+    _out.append("null", 4);
+    return;
+  }
+
+  if (value == std::floor(value) && std::fabs(value) < 1e15)
+  {
+    OSS::UInt64 integer = (OSS::UInt64)std::fabs(value);
+    char* end = buffer + sizeof(buffer);
+    char* current = end;
+    do
+    {
+      *--current = (char)('0' + integer % 10);
+      integer /= 10;
+    } while (integer);
+    if (value < 0)
+      *--current = '-';
+    _out.append(current, end - current);
+    return;
+  }
+
+  int size = snprintf(buffer, sizeof(buffer), "%.15g", value);
+  if (std::strtod(buffer, 0) != value)
+    size = snprintf(buffer, sizeof(buffer), "%.17g", value);
+  _out.append(buffer, size);
+}
+
+void FastWriter::Visit(const json::Array& array)
+{
+  write(array);
+}
+
+void FastWriter::Visit(const json::Object& object)
+{
+  write(object);
+}
+
+void FastWriter::Visit(const json::Number& number)
+{
+  write(number.Value());
+}
+
+void FastWriter::Visit(const json::String& string)
+{
+  write(string.Value());
+}
+
+void FastWriter::Visit(const json::Boolean& boolean)
+{
+  if (boolean.Value())
+    _out.append("true", 4);
+  else
+    _out.append("false", 5);
+}
+
+void FastWriter::Visit(const json::Null&)
+{
+  _out.append("null", 4);
+}
+
+
+} } // OSS::JSON
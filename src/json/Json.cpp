@@ -14,9 +14,7 @@ bool json_parse_string(const std::string& jsonString, OSS::JSON::Object& object,
 {
   try
   {
-    std::stringstream ostr;
-    ostr << jsonString;
-    OSS::JSON::Reader::Read(object, ostr);
+    OSS::JSON::FastReader::Read(object, jsonString);
   }
   catch(OSS::JSON::Exception& e_)
   {
@@ -36,9 +34,8 @@ bool json_object_to_string(const OSS::JSON::Object& object, std::string& jsonStr
 {
   try
   {
-    std::stringstream ostr;
-    OSS::JSON::Writer::Write(object, ostr);
-    jsonString = ostr.str();
+    jsonString.clear();
+    OSS::JSON::FastWriter::Write(object, jsonString);
   }
   catch(OSS::JSON::Exception& e_)
   {
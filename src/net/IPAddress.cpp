@@ -107,6 +107,28 @@ IPAddress::IPAddress(const IPAddress& address)
   _alias = address._alias;
 }
 
+IPAddress::IPAddress(const IPEndPoint& endpoint) :
+  _externalAddress(endpoint.externalAddress()),
+  _port(endpoint.port),
+  _cidr(endpoint.cidr),
+  _isVirtual(endpoint.isVirtual()),
+  _protocol(endpoint.protocol <= UnknownTransport ? (Protocol)endpoint.protocol : UnknownTransport),
+  _alias(endpoint.alias())
+{
+  if (endpoint.isV4())
+  {
+    address_v4::bytes_type bytes;
+    std::memcpy(bytes.data(), endpoint.address, bytes.size());
+    _address = address_v4(bytes);
+  }
+  else if (endpoint.isV6())
+  {
+    address_v6::bytes_type bytes;
+    std::memcpy(bytes.data(), endpoint.address, bytes.size());
+    _address = address_v6(bytes, endpoint.scopeId);
+  }
+}
+
 IPAddress::IPAddress(const std::string& address, unsigned short port) :
   _cidr(0),
   _isVirtual(false),
@@ -144,6 +166,32 @@ IPAddress::IPAddress(const std::string& address, unsigned short port, Protocol p
 
 
 
+IPEndPoint IPAddress::toEndPoint() const
+{
+  IPEndPoint endpoint;
+  if (_address.is_v4())
+  {
+    address_v4::bytes_type bytes = _address.to_v4().to_bytes();
+    std::memcpy(endpoint.address, bytes.data(), bytes.size());
+    endpoint.family = IPEndPoint::V4;
+  }
+  else if (_address.is_v6())
+  {
+    address_v6 v6 = _address.to_v6();
+    address_v6::bytes_type bytes = v6.to_bytes();
+    std::memcpy(endpoint.address, bytes.data(), bytes.size());
+    endpoint.scopeId = (OSS::UInt32)v6.scope_id();
+    endpoint.family = IPEndPoint::V6;
+  }
+  endpoint.port = _port;
+  endpoint.protocol = (OSS::UInt8)_protocol;
+  endpoint.cidr = (OSS::UInt8)_cidr;
+  endpoint.flags = _isVirtual ? IPEndPoint::Virtual : 0;
+  endpoint.externalId = IPEndPoint::intern(_externalAddress);
+  endpoint.aliasId = IPEndPoint::intern(_alias);
+  return endpoint;
+}
+
 void IPAddress::swap(IPAddress& address)
 {
   std::swap(_address, address._address);
@@ -0,0 +1,89 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+#include <boost/functional/hash.hpp>
+
+#include "OSS/Net/IPEndPoint.h"
+
+
+namespace OSS {
+namespace Net {
+
+
+static const std::size_t MAX_INTERNED_STRINGS = 0x10000;
+static const std::size_t INTERN_INDEX_SIZE = MAX_INTERNED_STRINGS * 2;
+
+static const std::string* gInternedStrings[MAX_INTERNED_STRINGS];
+  // Id to string.  A slot is published before its id can be found in the
+  // index.  Slot 0 is never written and stands for the empty string.
+
+static OSS::UInt16 gInternIndex[INTERN_INDEX_SIZE];
+  // Open addressed hash of the strings to their ids.  Zero marks a free
+  // slot.  Slots are claimed with a compare and swap and never change
+  // afterwards.
+
+static std::size_t gInternedCount = 0;
+
+OSS::UInt16 IPEndPoint::intern(const std::string& value)
+{
+  if (value.empty())
+    return 0;
+
+  std::size_t slot = boost::hash<std::string>()(value) & (INTERN_INDEX_SIZE - 1);
+  OSS::UInt16 newId = 0;
+  for (std::size_t probes = 0; probes < INTERN_INDEX_SIZE; probes++)
+  {
+    OSS::UInt16 id = __atomic_load_n(&gInternIndex[slot], __ATOMIC_ACQUIRE);
+    if (!id)
+    {
+      if (!newId)
+      {
+        //
+        // Publish the string under a fresh id before offering it to the
+        // index.  If another thread wins the slot with the same string the
+        // id is simply never handed out.
+        //
+        std::size_t next = __atomic_add_fetch(&gInternedCount, 1, __ATOMIC_RELAXED);
+        if (next >= MAX_INTERNED_STRINGS)
+          return 0;
+        newId = (OSS::UInt16)next;
+        __atomic_store_n(&gInternedStrings[newId], new std::string(value), __ATOMIC_RELEASE);
+      }
+      if (__atomic_compare_exchange_n(&gInternIndex[slot], &id, newId, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        return newId;
+    }
+
+    if (internedString(id) == value)
+      return id;
+    slot = (slot + 1) & (INTERN_INDEX_SIZE - 1);
+  }
+  return 0;
+}
+
+const std::string& IPEndPoint::internedString(OSS::UInt16 id)
+{
+  static const std::string empty;
+  const std::string* value = __atomic_load_n(&gInternedStrings[id], __ATOMIC_ACQUIRE);
+  return value ? *value : empty;
+}
+
+
+} } // OSS::Net
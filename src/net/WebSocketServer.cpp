@@ -52,7 +52,7 @@ public:
 
   void on_message(websocketpp::server::connection_ptr pConnection, websocketpp::server::handler::message_ptr pMsg)
   {
-    std::string payload = pMsg->get_payload();
+    const std::string& payload = pMsg->get_payload();
     _listener.handleMessage(pConnection, payload);
   }
   
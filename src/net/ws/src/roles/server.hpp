@@ -199,7 +199,15 @@ public:
        // ignored, as it is always overwriten later by the listen() member func
        m_acceptor(m),
        m_state(IDLE),
-       m_timer(m,boost::posix_time::seconds(0)) {}
+       m_timer(m,boost::posix_time::seconds(0)),
+       m_reuse_port(false) {}
+    
+    // Allow several endpoints, each with its own io_service, to bind the
+    // same address. The kernel then load balances incoming connections
+    // between their acceptors. Must be called before listen.
+    void set_reuse_port(bool value) {
+        m_reuse_port = value;
+    }
     
     void start_listen(uint16_t port, size_t num_threads = 1);
     void start_listen(const boost::asio::ip::tcp::endpoint& e, size_t num_threads = 1);
@@ -270,6 +278,7 @@ private:
     state                           m_state;
     
     boost::asio::deadline_timer     m_timer;
+    bool                            m_reuse_port;
 
     std::vector< boost::shared_ptr<boost::thread> > m_listening_threads;
 };
@@ -285,6 +294,12 @@ void server<endpoint>::start_listen(const boost::asio::ip::tcp::endpoint& e,size
         
         m_acceptor.open(e.protocol());
         m_acceptor.set_option(boost::asio::socket_base::reuse_address(true));
+#if defined(SO_REUSEPORT)
+        if (m_reuse_port) {
+            typedef boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT> reuse_port;
+            m_acceptor.set_option(reuse_port(true));
+        }
+#endif
         m_acceptor.bind(e);
         m_acceptor.listen();
     
@@ -0,0 +1,263 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include "OSS/Persistent/RedisAsyncWriter.h"
+
+#if OSS_HAVE_HIREDIS
+
+#include <algorithm>
+#include <boost/bind.hpp>
+
+
+namespace OSS {
+namespace Persistent {
+
+
+RedisAsyncWriter::Metrics::Metrics() :
+  enqueued(0),
+  written(0),
+  dropped(0),
+  failed(0),
+  batches(0)
+{
+}
+
+RedisAsyncWriter::RedisAsyncWriter(const std::string& tcpHost, int tcpPort, std::size_t maxQueueSize, std::size_t maxBatchSize) :
+  _client(tcpHost, tcpPort),
+  _db(0),
+  _transaction(false),
+  _maxQueueSize(maxQueueSize),
+  _maxBatchSize(maxBatchSize ? maxBatchSize : 1),
+  _pWriterThread(0),
+  _isTerminating(false),
+  _enqueued(0),
+  _written(0),
+  _dropped(0),
+  _failed(0),
+  _batches(0),
+  _lastReportedDrops(0)
+{
+}
+
+RedisAsyncWriter::~RedisAsyncWriter()
+{
+  stop();
+}
+
+bool RedisAsyncWriter::start(const std::string& password, int db, bool transaction)
+{
+  if (_pWriterThread)
+  {
+    return false;
+  }
+
+  _password = password;
+  _db = db;
+  _transaction = transaction;
+
+  if (!_client.connect(_password, _db))
+  {
+    OSS_LOG_ERROR("[REDIS] RedisAsyncWriter::start - Unable to connect.  Will retry on the next batch.");
+  }
+
+  _isTerminating = false;
+  _pWriterThread = new boost::thread(boost::bind(&RedisAsyncWriter::run, this));
+  return true;
+}
+
+void RedisAsyncWriter::stop()
+{
+  if (!_pWriterThread)
+  {
+    return;
+  }
+
+  {
+    boost::lock_guard<boost::mutex> lock(_queueMutex);
+    _isTerminating = true;
+  }
+  _wakeup.notify_one();
+  _pWriterThread->join();
+  delete _pWriterThread;
+  _pWriterThread = 0;
+  _client.disconnect();
+}
+
+bool RedisAsyncWriter::enqueue(const Command& command)
+{
+  bool wasEmpty = false;
+  {
+    boost::lock_guard<boost::mutex> lock(_queueMutex);
+    if (!_pWriterThread || _isTerminating || _queue.size() >= _maxQueueSize)
+    {
+      _dropped.fetch_add(1, boost::memory_order_relaxed);
+      return false;
+    }
+    wasEmpty = _queue.empty();
+    _queue.push_back(command);
+  }
+  _enqueued.fetch_add(1, boost::memory_order_relaxed);
+
+  //
+  // The writer only sleeps while the queue is empty.  Anything queued while
+  // it is busy with a round trip goes out together in the next batch.
+  //
+  if (wasEmpty)
+  {
+    _wakeup.notify_one();
+  }
+  return true;
+}
+
+bool RedisAsyncWriter::set(const std::string& key, const std::string& value, int expires)
+{
+  Command command;
+  if (expires == -1)
+  {
+    command.reserve(3);
+    command.push_back("SET");
+    command.push_back(key);
+    command.push_back(value);
+  }
+  else
+  {
+    command.reserve(4);
+    command.push_back("SETEX");
+    command.push_back(key);
+    command.push_back(OSS::string_from_number<int>(expires));
+    command.push_back(value);
+  }
+  return enqueue(command);
+}
+
+bool RedisAsyncWriter::hset(const std::string& key, const std::string& name, const std::string& value)
+{
+  Command command;
+  command.reserve(4);
+  command.push_back("HSET");
+  command.push_back(key);
+  command.push_back(name);
+  command.push_back(value);
+  return enqueue(command);
+}
+
+bool RedisAsyncWriter::expire(const std::string& key, int seconds)
+{
+  Command command;
+  command.reserve(3);
+  command.push_back("EXPIRE");
+  command.push_back(key);
+  command.push_back(OSS::string_from_number<int>(seconds));
+  return enqueue(command);
+}
+
+bool RedisAsyncWriter::del(const std::string& key)
+{
+  Command command;
+  command.reserve(2);
+  command.push_back("DEL");
+  command.push_back(key);
+  return enqueue(command);
+}
+
+std::size_t RedisAsyncWriter::getQueueSize() const
+{
+  boost::lock_guard<boost::mutex> lock(_queueMutex);
+  return _queue.size();
+}
+
+RedisAsyncWriter::Metrics RedisAsyncWriter::getMetrics() const
+{
+  Metrics metrics;
+  metrics.enqueued = _enqueued.load(boost::memory_order_relaxed);
+  metrics.written = _written.load(boost::memory_order_relaxed);
+  metrics.dropped = _dropped.load(boost::memory_order_relaxed);
+  metrics.failed = _failed.load(boost::memory_order_relaxed);
+  metrics.batches = _batches.load(boost::memory_order_relaxed);
+  return metrics;
+}
+
+void RedisAsyncWriter::flush(Commands& batch)
+{
+  //
+  // Split oversized rounds so a burst does not build one huge request and
+  // reply buffer.
+  //
+  Commands chunk;
+  for (std::size_t offset = 0; offset < batch.size(); offset += _maxBatchSize)
+  {
+    std::size_t end = std::min(batch.size(), offset + _maxBatchSize);
+    chunk.clear();
+    chunk.reserve(end - offset);
+    for (std::size_t i = offset; i < end; i++)
+    {
+      chunk.push_back(Command());
+      chunk.back().swap(batch[i]);
+    }
+
+    if (_client.pipeline(chunk, _transaction))
+    {
+      _written.fetch_add(chunk.size(), boost::memory_order_relaxed);
+    }
+    else
+    {
+      _failed.fetch_add(chunk.size(), boost::memory_order_relaxed);
+      OSS_LOG_ERROR("[REDIS] RedisAsyncWriter::flush - Failed to write " << chunk.size() << " commands");
+    }
+    _batches.fetch_add(1, boost::memory_order_relaxed);
+  }
+  batch.clear();
+}
+
+void RedisAsyncWriter::run()
+{
+  Commands batch;
+
+  while (true)
+  {
+    {
+      boost::unique_lock<boost::mutex> lock(_queueMutex);
+      while (_queue.empty() && !_isTerminating)
+      {
+        _wakeup.wait(lock);
+      }
+      if (_queue.empty() && _isTerminating)
+      {
+        break;
+      }
+      batch.swap(_queue);
+    }
+
+    flush(batch);
+
+    OSS::UInt64 dropped = _dropped.load(boost::memory_order_relaxed);
+    if (dropped != _lastReportedDrops)
+    {
+      OSS_LOG_WARNING("[REDIS] RedisAsyncWriter::run - Queue full.  Dropped " << dropped - _lastReportedDrops
+        << " commands (total " << dropped << ", capacity " << _maxQueueSize << ")");
+      _lastReportedDrops = dropped;
+    }
+  }
+}
+
+
+} } // OSS::Persistent
+
+#endif // OSS_HAVE_HIREDIS
@@ -18,6 +18,9 @@
 //
 
 #include "OSS/Persistent/RedisClient.h"
+#include "OSS/Persistent/RedisAsyncWriter.h"
+#include "OSS/JSON/FastJson.h"
+#include <algorithm>
 
 #if OSS_HAVE_HIREDIS
 
@@ -515,9 +518,8 @@ bool RedisClient::set(const std::string& key, const json::Object& value, int exp
 {
   try
   {
-    std::ostringstream strm;
-    json::Writer::Write(value, strm);
-    std::string buff = strm.str();
+    std::string buff;
+    OSS::JSON::FastWriter::Write(value, buff);
     return set(key, buff, expires);
   }
   catch(std::exception& error)
@@ -764,6 +766,7 @@ bool RedisClient::hset(const std::string& key, const std::string& name, const st
   std::vector<std::string> args;
   args.push_back("HSET");
   args.push_back(key);
+  args.push_back(name);
   args.push_back(value);
   std::string status = getStatusString(args);
   return status == "0" || status == "1";
@@ -807,9 +810,7 @@ bool RedisClient::get(const std::string& key, json::Object& value) const
     return false;
   try
   {
-    std::stringstream strm;
-    strm << buff;
-    json::Reader::Read(value, strm);
+    OSS::JSON::FastReader::Read(value, buff);
   }
   catch(std::exception& error)
   {
@@ -832,11 +833,36 @@ bool RedisClient::getAll(std::vector<std::string>& values, const std::string& pa
 {
   std::vector<std::string> keys;
   getKeys(pattern, keys);
-  for (std::vector<std::string>::const_iterator iter = keys.begin(); iter != keys.end(); iter++)
-  {
-    std::string value;
-    if (get(*iter, value))
-      values.push_back(value);
+
+  //
+  // Fetch the values in pipelined batches instead of one GET round trip per
+  // key.  The batch size keeps a single reply buffer from growing unbounded.
+  //
+  Commands commands;
+  std::vector<std::string> replies;
+  for (std::size_t offset = 0; offset < keys.size(); offset += PIPELINE_BATCH_SIZE)
+  {
+    std::size_t end = std::min(keys.size(), offset + (std::size_t)PIPELINE_BATCH_SIZE);
+    commands.clear();
+    commands.reserve(end - offset);
+    for (std::size_t i = offset; i < end; i++)
+    {
+      commands.push_back(Command());
+      commands.back().reserve(2);
+      commands.back().push_back("GET");
+      commands.back().push_back(keys[i]);
+    }
+
+    replies.clear();
+    executePipeline(commands, false, &replies);
+    for (std::vector<std::string>::iterator iter = replies.begin(); iter != replies.end(); iter++)
+    {
+      if (!iter->empty())
+      {
+        values.push_back(std::string());
+        values.back().swap(*iter);
+      }
+    }
   }
 
   return !values.empty();
@@ -852,11 +878,8 @@ bool RedisClient::getAll(std::vector<json::Object>& values, const std::string& p
   {
     try
     {
-      std::stringstream strm;
-      strm << *iter;
-      json::Object value;
-      json::Reader::Read(value, strm);
-      values.push_back(value);
+      values.push_back(json::Object());
+      OSS::JSON::FastReader::Read(values.back(), *iter);
     }
     catch(std::exception& e)
     {
@@ -902,12 +925,242 @@ bool RedisClient::hmget(const std::string& key, const std::vector<std::string>&
 }
 
 bool RedisClient::getKeys(const std::string& pattern, std::vector<std::string>& keys)
+{
+  keys.clear();
+  return scan(pattern, keys);
+}
+
+bool RedisClient::scan(const std::string& pattern, std::vector<std::string>& keys, std::size_t count) const
 {
   std::vector<std::string> args;
-  args.push_back("KEYS");
+  args.push_back("SCAN");
+  args.push_back("0");
+  args.push_back("MATCH");
   args.push_back(pattern);
-  keys = getReplyStringArray(args);
-  return !keys.empty();
+  args.push_back("COUNT");
+  args.push_back(OSS::string_from_number<std::size_t>(count ? count : (std::size_t)SCAN_COUNT));
+
+  std::size_t first = keys.size();
+  do
+  {
+    redisReply* reply = const_cast<RedisClient*>(this)->execute(args);
+    if (!reply || reply->type != REDIS_REPLY_ARRAY || reply->elements != 2 ||
+      !reply->element[0] || reply->element[0]->type != REDIS_REPLY_STRING)
+    {
+      OSS_LOG_ERROR("[REDIS] RedisClient::scan - Unexpected reply for pattern " << pattern);
+      const_cast<RedisClient*>(this)->freeReply(reply);
+      break;
+    }
+
+    args[1] = std::string(reply->element[0]->str, reply->element[0]->len);
+
+    redisReply* batch = reply->element[1];
+    if (batch && batch->type == REDIS_REPLY_ARRAY)
+    {
+      for (size_t i = 0; i < batch->elements; i++)
+      {
+        redisReply* item = batch->element[i];
+        if (item && item->type == REDIS_REPLY_STRING && item->len > 0)
+        {
+          keys.push_back(std::string(item->str, item->len));
+        }
+      }
+    }
+    const_cast<RedisClient*>(this)->freeReply(reply);
+  } while (args[1] != "0");
+
+  //
+  // SCAN may report a key more than once if the table is rehashed while we
+  // iterate.
+  //
+  std::sort(keys.begin() + first, keys.end());
+  keys.erase(std::unique(keys.begin() + first, keys.end()), keys.end());
+
+  return keys.size() > first;
+}
+
+bool RedisClient::pipeline(const Commands& commands, bool transaction)
+{
+  return executePipeline(commands, transaction, 0);
+}
+
+bool RedisClient::pipeline(const Commands& commands, std::vector<std::string>& replies, bool transaction)
+{
+  replies.clear();
+  return executePipeline(commands, transaction, &replies);
+}
+
+bool RedisClient::executePipeline(const Commands& commands, bool transaction, std::vector<std::string>* replies)
+{
+  if (commands.empty())
+  {
+    return true;
+  }
+
+  mutex_lock lock(_mutex);
+
+  if (!_context && !connect())
+  {
+    OSS_LOG_ERROR("[REDIS] Connect FAILED.  Unable to create a new context for pipeline.");
+    return false;
+  }
+
+  std::size_t next = 0;
+  if (sendPipeline(commands, next, transaction, replies))
+  {
+    return true;
+  }
+
+  //
+  // Same policy as execute().  Retry once after a dropped connection, but
+  // only with the commands that never got a reply.  The ones before them
+  // were applied and must not run twice.  A transaction has no partial
+  // replies to go by and EXEC may already have run, so it is not retried.
+  //
+  if (!transaction && next < commands.size() &&
+    _context && (_context->err == REDIS_ERR_EOF || _context->err == REDIS_ERR_IO) && connect())
+  {
+    if (sendPipeline(commands, next, transaction, replies))
+    {
+      return true;
+    }
+    OSS_LOG_ERROR("[REDIS] Pipeline Retry FAILED.  - " << _lastError);
+  }
+
+  return false;
+}
+
+bool RedisClient::sendPipeline(const Commands& commands, std::size_t& next, bool transaction, std::vector<std::string>* replies)
+{
+  //
+  // Queue everything in the hiredis output buffer first.  Nothing is
+  // written to the socket until the first redisGetReply() call.
+  //
+  std::vector<const char*> argv;
+  std::vector<size_t> argvlen;
+
+  if (transaction)
+  {
+    const char* multi = "MULTI";
+    size_t multilen = 5;
+    redisAppendCommandArgv(_context, 1, &multi, &multilen);
+  }
+
+  std::size_t pending = 0;
+  for (Commands::const_iterator iter = commands.begin() + next; iter != commands.end(); iter++)
+  {
+    argv.clear();
+    argvlen.clear();
+    for (Command::const_iterator arg = iter->begin(); arg != iter->end(); arg++)
+    {
+      argv.push_back(arg->data());
+      argvlen.push_back(arg->size());
+    }
+    if (argv.empty())
+    {
+      continue;
+    }
+    redisAppendCommandArgv(_context, (int)argv.size(), &argv[0], &argvlen[0]);
+    pending++;
+  }
+
+  if (transaction)
+  {
+    const char* exec = "EXEC";
+    size_t execlen = 4;
+    redisAppendCommandArgv(_context, 1, &exec, &execlen);
+    pending += 2;
+  }
+
+  //
+  // Read back one reply per queued command.  Every reply has to be consumed
+  // even after an error reply or the next caller would read ours.  next
+  // tracks the first command that has not been answered yet.
+  //
+  bool ok = true;
+  for (std::size_t i = 0; i < pending; i++)
+  {
+    redisReply* reply = 0;
+    if (redisGetReply(_context, (void**)&reply) != REDIS_OK || !reply)
+    {
+      if (strlen(_context->errstr))
+      {
+        _lastError = _context->errstr;
+      }
+      if (_lastError.empty())
+      {
+        _lastError = "Unknown exception";
+      }
+      return false;
+    }
+
+    if (reply->type == REDIS_REPLY_ERROR)
+    {
+      _lastError = std::string(reply->str, reply->len);
+      ok = false;
+    }
+
+    redisReply** results = &reply;
+    std::size_t resultCount = 1;
+    if (transaction)
+    {
+      //
+      // Only the EXEC reply carries results.  MULTI and the per-command
+      // QUEUED statuses are skipped.
+      //
+      if (i != pending - 1)
+      {
+        freeReply(reply);
+        continue;
+      }
+      if (reply->type != REDIS_REPLY_ARRAY)
+      {
+        freeReply(reply);
+        return false;
+      }
+      results = reply->element;
+      resultCount = reply->elements;
+      next = commands.size();
+    }
+    else
+    {
+      while (commands[next].empty())
+      {
+        next++;
+      }
+      next++;
+    }
+
+    for (std::size_t j = 0; j < resultCount; j++)
+    {
+      redisReply* result = results[j];
+      if (result && result->type == REDIS_REPLY_ERROR)
+      {
+        _lastError = std::string(result->str, result->len);
+        ok = false;
+      }
+      if (!replies)
+      {
+        continue;
+      }
+      if (result && (result->type == REDIS_REPLY_STRING || result->type == REDIS_REPLY_STATUS))
+      {
+        replies->push_back(std::string(result->str, result->len));
+      }
+      else if (result && result->type == REDIS_REPLY_INTEGER)
+      {
+        replies->push_back(OSS::string_from_number<long long>(result->integer));
+      }
+      else
+      {
+        replies->push_back(std::string());
+      }
+    }
+    freeReply(reply);
+  }
+
+  next = commands.size();
+  return ok;
 }
 
 bool RedisClient::del(const std::string& key)
@@ -930,10 +1183,18 @@ bool RedisClient::hdel(const std::string& key, const std::string& field)
 }
 
 RedisBroadcastClient::RedisBroadcastClient() :
-  _defaultClient(0)
+  _defaultClient(0),
+  _asyncWrites(false),
+  _asyncTransaction(false)
 {
 }
 
+void RedisBroadcastClient::setAsyncWrites(bool asyncWrites, bool transaction)
+{
+  _asyncWrites = asyncWrites;
+  _asyncTransaction = transaction;
+}
+
 RedisBroadcastClient::~RedisBroadcastClient()
 {
   disconnect();
@@ -987,12 +1248,31 @@ bool RedisBroadcastClient::connect(const std::string& tcpHost, int tcpPort, cons
       }
     }
     _pool[key.str()] = client;
+
+    if (_asyncWrites)
+    {
+      //
+      // The writer gets its own connection so queued writes never wait
+      // behind reads issued on the synchronous client.
+      //
+      RedisAsyncWriter* writer = new RedisAsyncWriter(tcpHost, tcpPort);
+      writer->start(password, db, _asyncTransaction);
+      _writers[key.str()] = writer;
+    }
   }
   return true;
 }
 
 void RedisBroadcastClient::disconnect()
 {
+  for (Writers::iterator iter = _writers.begin(); iter != _writers.end(); iter++)
+  {
+    RedisAsyncWriter* writer = iter->second;
+    writer->stop();
+    delete writer;
+  }
+  _writers.clear();
+
   for (Pool::iterator iter = _pool.begin(); iter != _pool.end(); iter++)
   {
     RedisClient* client = iter->second;
@@ -1004,12 +1284,30 @@ void RedisBroadcastClient::disconnect()
 
 bool RedisBroadcastClient::set(const std::string& key, const json::Object& value, int expires)
 {
+  if (!_writers.empty())
+  {
+    //
+    // Serialize once for every server instead of once per client
+    //
+    std::string buff;
+    try
+    {
+      OSS::JSON::FastWriter::Write(value, buff);
+    }
+    catch(std::exception& error)
+    {
+      return false;
+    }
+    return set(key, buff, expires);
+  }
+
+  bool ok = false;
   for (Pool::iterator iter = _pool.begin(); iter != _pool.end(); iter++)
   {
     RedisClient* client = iter->second;
-    client->set(key, value, expires);
+    ok ? client->set(key, value, expires) : ok = client->set(key, value, expires);
   }
-  return true;
+  return ok;
 }
 
 bool RedisBroadcastClient::set(const std::string& key, const std::string& value, int expires)
@@ -1017,6 +1315,12 @@ bool RedisBroadcastClient::set(const std::string& key, const std::string& value,
   bool ok = false;
   for (Pool::iterator iter = _pool.begin(); iter != _pool.end(); iter++)
   {
+    Writers::iterator writer = _writers.find(iter->first);
+    if (writer != _writers.end())
+    {
+      ok = writer->second->set(key, value, expires) || ok;
+      continue;
+    }
     RedisClient* client = iter->second;
     ok ? client->set(key, value, expires) : ok = client->set(key, value, expires);
   }
@@ -1028,6 +1332,12 @@ bool RedisBroadcastClient::hset(const std::string& key, const std::string& name,
   bool ok = false;
   for (Pool::iterator iter = _pool.begin(); iter != _pool.end(); iter++)
   {
+    Writers::iterator writer = _writers.find(iter->first);
+    if (writer != _writers.end())
+    {
+      ok = writer->second->hset(key, name, value) || ok;
+      continue;
+    }
     RedisClient* client = iter->second;
     ok ? client->hset(key, name, value) : ok = client->hset(key, name, value);
   }
@@ -1155,6 +1465,12 @@ bool RedisBroadcastClient::del(const std::string& key)
 {
   for (Pool::iterator iter = _pool.begin(); iter != _pool.end(); iter++)
   {
+    Writers::iterator writer = _writers.find(iter->first);
+    if (writer != _writers.end())
+    {
+      writer->second->del(key);
+      continue;
+    }
     RedisClient* client = iter->second;
     client->del(key);
   }
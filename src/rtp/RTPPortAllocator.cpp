@@ -0,0 +1,356 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include "OSS/RTP/RTPPortAllocator.h"
+
+#if ENABLE_FEATURE_RTP
+
+#include <vector>
+#include <algorithm>
+#include "OSS/UTL/Thread.h"
+#include "OSS/UTL/Logger.h"
+
+
+namespace OSS {
+namespace RTP {
+
+
+struct RTPPortAllocator::State : boost::noncopyable
+{
+  unsigned short portBase;
+  unsigned short portMax;
+  std::size_t portCount;
+  std::size_t poolSize;
+  std::vector<OSS::UInt64> free;
+  std::vector<OSS::UInt64> cooling[COOLING_BITMAPS];
+  OSS::UInt32 epoch;
+  OSS::UInt32 cursor;
+  OSS::mutex_critic_sec poolsMutex;
+  std::vector<ThreadPool*> pools;
+
+  State() : portBase(0), portMax(0), portCount(0), poolSize(0), epoch(0), cursor(0) {}
+
+  bool toIndex(unsigned short port, std::size_t& index) const;
+  std::size_t claim(unsigned short* ports, std::size_t count);
+  unsigned short steal();
+};
+
+struct RTPPortAllocator::ThreadPool
+{
+  boost::shared_ptr<State> pState;
+  unsigned short ports[THREAD_POOL_SIZE];
+    // Zero marks an empty slot.  Other threads may empty a slot at any
+    // time so every access is atomic.
+
+  ThreadPool(const boost::shared_ptr<State>& pState_) : pState(pState_)
+  {
+    std::fill(ports, ports + THREAD_POOL_SIZE, 0);
+  }
+
+  unsigned short pop();
+};
+
+
+RTPPortAllocator::RTPPortAllocator() :
+  _pState(new State()),
+  _threadPool(&RTPPortAllocator::releaseThreadPool)
+{
+}
+
+RTPPortAllocator::~RTPPortAllocator()
+{
+}
+
+bool RTPPortAllocator::open(unsigned short portBase, unsigned short portMax)
+{
+  State& state = *_pState;
+  if (state.portCount || portMax <= portBase)
+  {
+    return false;
+  }
+
+  //
+  // Each entry is a data port followed by its control port, so the last
+  // pair must end at or before portMax.
+  //
+  std::size_t portCount = ((std::size_t)portMax - portBase + 1) / 2;
+  std::size_t words = (portCount + 63) / 64;
+
+  state.portBase = portBase;
+  state.portMax = portMax;
+  state.free.assign(words, 0);
+  for (std::size_t i = 0; i < COOLING_BITMAPS; i++)
+  {
+    state.cooling[i].assign(words, 0);
+  }
+  for (std::size_t i = 0; i < portCount; i++)
+  {
+    state.free[i / 64] |= ((OSS::UInt64)1 << (i % 64));
+  }
+
+  //
+  // One pooled port per 64 pairs keeps most of a small range in the shared
+  // free list where every thread can reach it.
+  //
+  state.poolSize = std::min((std::size_t)THREAD_POOL_SIZE, portCount / 64 + 1);
+  state.portCount = portCount;
+  return true;
+}
+
+bool RTPPortAllocator::isOpen() const
+{
+  return _pState->portCount != 0;
+}
+
+unsigned short RTPPortAllocator::getPortBase() const
+{
+  return _pState->portBase;
+}
+
+unsigned short RTPPortAllocator::getPortMax() const
+{
+  return _pState->portMax;
+}
+
+unsigned short RTPPortAllocator::allocate()
+{
+  State& state = *_pState;
+  if (!state.portCount)
+  {
+    return 0;
+  }
+
+  ThreadPool* pPool = _threadPool.get();
+  if (!pPool || pPool->pState != _pState)
+  {
+    //
+    // A pool with another state was left by an allocator that used to live
+    // at this address.  reset() hands it to releaseThreadPool().
+    //
+    pPool = new ThreadPool(_pState);
+    _threadPool.reset(pPool);
+    OSS::mutex_critic_sec_lock lock(state.poolsMutex);
+    state.pools.push_back(pPool);
+  }
+
+  unsigned short port = pPool->pop();
+  if (port)
+  {
+    return port;
+  }
+
+  unsigned short claimed[THREAD_POOL_SIZE];
+  std::size_t count = state.claim(claimed, state.poolSize);
+  if (count)
+  {
+    for (std::size_t i = 1; i < count; i++)
+    {
+      __atomic_store_n(&pPool->ports[i - 1], claimed[i], __ATOMIC_RELEASE);
+    }
+    return claimed[0];
+  }
+
+  port = state.steal();
+  if (!port)
+  {
+    OSS_LOG_WARNING("RTPPortAllocator::allocate - No free ports between " << state.portBase << " and " << state.portMax);
+  }
+  return port;
+}
+
+void RTPPortAllocator::release(unsigned short port)
+{
+  State& state = *_pState;
+  std::size_t index = 0;
+  if (!state.toIndex(port, index))
+  {
+    return;
+  }
+
+  OSS::UInt32 epoch = __atomic_load_n(&state.epoch, __ATOMIC_ACQUIRE);
+  __atomic_fetch_or(&state.cooling[epoch % COOLING_BITMAPS][index / 64], (OSS::UInt64)1 << (index % 64), __ATOMIC_RELEASE);
+}
+
+bool RTPPortAllocator::reserve(unsigned short port)
+{
+  State& state = *_pState;
+  std::size_t index = 0;
+  if (!state.toIndex(port, index))
+  {
+    return false;
+  }
+
+  OSS::UInt64 bit = (OSS::UInt64)1 << (index % 64);
+  return (__atomic_fetch_and(&state.free[index / 64], ~bit, __ATOMIC_ACQ_REL) & bit) != 0;
+}
+
+void RTPPortAllocator::recycle()
+{
+  State& state = *_pState;
+  if (!state.portCount)
+  {
+    return;
+  }
+
+  //
+  // Releases go to the bitmap of the current epoch.  Move to the next one,
+  // which was emptied by the previous call, and return the ports released
+  // during the epoch before the current one.  Those have cooled down for
+  // at least one full interval.
+  //
+  OSS::UInt32 epoch = __atomic_add_fetch(&state.epoch, 1, __ATOMIC_ACQ_REL);
+  std::vector<OSS::UInt64>& cooled = state.cooling[(epoch + 1) % COOLING_BITMAPS];
+  for (std::size_t i = 0; i < cooled.size(); i++)
+  {
+    OSS::UInt64 bits = __atomic_exchange_n(&cooled[i], 0, __ATOMIC_ACQ_REL);
+    if (bits)
+    {
+      __atomic_fetch_or(&state.free[i], bits, __ATOMIC_RELEASE);
+    }
+  }
+}
+
+std::size_t RTPPortAllocator::available() const
+{
+  const State& state = *_pState;
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < state.free.size(); i++)
+  {
+    count += __builtin_popcountll(__atomic_load_n(&state.free[i], __ATOMIC_RELAXED));
+  }
+  return count;
+}
+
+std::size_t RTPPortAllocator::State::claim(unsigned short* ports, std::size_t count)
+{
+  //
+  // Start each search at a different word so threads spread over the range
+  // and recently released ports are the last to be picked up again.
+  //
+  std::size_t words = free.size();
+  std::size_t start = __atomic_fetch_add(&cursor, 1, __ATOMIC_RELAXED) % words;
+  std::size_t claimed = 0;
+  for (std::size_t i = 0; i < words && claimed < count; i++)
+  {
+    std::size_t word = (start + i) % words;
+    OSS::UInt64 current = __atomic_load_n(&free[word], __ATOMIC_ACQUIRE);
+    OSS::UInt64 taken = 0;
+    while (current)
+    {
+      taken = 0;
+      OSS::UInt64 bits = current;
+      for (std::size_t n = claimed; bits && n < count; n++)
+      {
+        taken |= bits & (~bits + 1);
+        bits &= bits - 1;
+      }
+
+      if (__atomic_compare_exchange_n(&free[word], &current, current & ~taken, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+      {
+        break;
+      }
+      taken = 0;
+    }
+
+    while (taken)
+    {
+      std::size_t index = word * 64 + __builtin_ctzll(taken);
+      ports[claimed++] = (unsigned short)(portBase + index * 2);
+      taken &= taken - 1;
+    }
+  }
+  return claimed;
+}
+
+unsigned short RTPPortAllocator::State::steal()
+{
+  //
+  // The free list is empty.  Take an unused port from another thread's
+  // pool rather than fail while ports sit idle.
+  //
+  OSS::mutex_critic_sec_lock lock(poolsMutex);
+  for (std::vector<ThreadPool*>::iterator iter = pools.begin(); iter != pools.end(); iter++)
+  {
+    unsigned short port = (*iter)->pop();
+    if (port)
+    {
+      return port;
+    }
+  }
+  return 0;
+}
+
+bool RTPPortAllocator::State::toIndex(unsigned short port, std::size_t& index) const
+{
+  if (!portCount || port < portBase || ((port - portBase) & 1))
+  {
+    return false;
+  }
+
+  index = (port - portBase) / 2;
+  return index < portCount;
+}
+
+unsigned short RTPPortAllocator::ThreadPool::pop()
+{
+  for (std::size_t i = THREAD_POOL_SIZE; i > 0; i--)
+  {
+    if (__atomic_load_n(&ports[i - 1], __ATOMIC_RELAXED))
+    {
+      unsigned short port = __atomic_exchange_n(&ports[i - 1], 0, __ATOMIC_ACQ_REL);
+      if (port)
+      {
+        return port;
+      }
+    }
+  }
+  return 0;
+}
+
+void RTPPortAllocator::releaseThreadPool(ThreadPool* pPool)
+{
+  //
+  // Called by boost::thread_specific_ptr when the owning thread exits,
+  // possibly after the allocator is gone.  The pool keeps the state alive.
+  // Ports that were claimed but never handed out go straight back to the
+  // free list.
+  //
+  State& state = *pPool->pState;
+  {
+    OSS::mutex_critic_sec_lock lock(state.poolsMutex);
+    state.pools.erase(std::remove(state.pools.begin(), state.pools.end(), pPool), state.pools.end());
+  }
+
+  for (std::size_t i = 0; i < THREAD_POOL_SIZE; i++)
+  {
+    std::size_t index = 0;
+    unsigned short port = pPool->ports[i];
+    if (port && state.toIndex(port, index))
+    {
+      __atomic_fetch_or(&state.free[index / 64], (OSS::UInt64)1 << (index % 64), __ATOMIC_RELEASE);
+    }
+  }
+  delete pPool;
+}
+
+
+} } // OSS::RTP
+
+#endif // ENABLE_FEATURE_RTP
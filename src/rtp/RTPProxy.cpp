@@ -37,6 +37,8 @@ RTPProxy::RTPProxy(Type type, RTPProxyManager* pManager, RTPProxySession* pSessi
   _pLeg1Socket(0),
   _pLeg2Socket(0),
   _adjustSenderFromPacketSource(true),
+  _pLeg1ReadEndPoint(&_senderEndPointLeg1),
+  _pLeg2ReadEndPoint(&_senderEndPointLeg2),
   _leg1Resizer(this, 1),
   _leg2Resizer(this, 2),
   _leg1Reset(false),
@@ -125,11 +127,13 @@ void RTPProxy::start()
     resetLeg2();
     return;
   }
+  _pLeg1ReadEndPoint = &_senderEndPointLeg1;
   _pLeg1Socket->async_receive_from(boost::asio::buffer(_leg1Buffer), _senderEndPointLeg1,
     boost::bind(&RTPProxy::handleLeg1FrameRead, shared_from_this(),
       boost::asio::placeholders::error,
         boost::asio::placeholders::bytes_transferred));
 
+  _pLeg2ReadEndPoint = &_senderEndPointLeg2;
   _pLeg2Socket->async_receive_from(boost::asio::buffer(_leg2Buffer), _senderEndPointLeg2,
     boost::bind(&RTPProxy::handleLeg2FrameRead, shared_from_this(),
       boost::asio::placeholders::error,
@@ -236,6 +240,12 @@ void RTPProxy::handleLeg1FrameRead(
   {
     _isInactive = false;
 
+    if (handleNonMediaPacket(1, bytes_transferred))
+    {
+      readLeg1();
+      return;
+    }
+
 #if ENABLE_FEATURE_XOR    
     // _isLeg1XOREncrypted = ((_leg1Buffer[0]>>6)&3) != 2;
     _isLeg1XOREncrypted = OSS::SIP::SIPXOR::isEnabled() ? !validateBuffer(_leg1Buffer, bytes_transferred) : false;
@@ -431,38 +441,165 @@ void RTPProxy::handleLeg1FrameRead(
     }
 #if RTP_THREADED  
     _csLeg2Mutex.unlock();
-
-    _csLeg1Mutex.lock();
 #endif 
-    if (_pLeg1Socket && _pLeg1Socket->is_open())
+    readLeg1();
+    //
+    // Process the resize buffer if we are resizing
+    //
+    processResizerQueue();
+  }
+}
+
+void RTPProxy::readLeg1()
+{
+#if RTP_THREADED  
+  OSS::mutex_critic_sec_lock lock(_csLeg1Mutex);
+#endif
+  if (_pLeg1Socket && _pLeg1Socket->is_open())
+  {
+    if (_leg1Reset)
     {
-      if (_leg1Reset)
-      {
-        _leg1Reset = false;
-        _pLeg1Socket->async_receive_from(boost::asio::buffer(_leg1Buffer), _lastSenderEndPointLeg1,
-        boost::bind(&RTPProxy::handleLeg1FrameRead, shared_from_this(),
-          boost::asio::placeholders::error,
-            boost::asio::placeholders::bytes_transferred));
+      _leg1Reset = false;
+      _pLeg1ReadEndPoint = &_lastSenderEndPointLeg1;
+    }
+    else
+    {
+      _pLeg1ReadEndPoint = &_senderEndPointLeg1;
+    }
+    _pLeg1Socket->async_receive_from(boost::asio::buffer(_leg1Buffer), *_pLeg1ReadEndPoint,
+      boost::bind(&RTPProxy::handleLeg1FrameRead, shared_from_this(),
+        boost::asio::placeholders::error,
+          boost::asio::placeholders::bytes_transferred));
+  }
+}
 
-      }
-      else
-      {
+void RTPProxy::readLeg2()
+{
+#if RTP_THREADED  
+  OSS::mutex_critic_sec_lock lock(_csLeg2Mutex);
+#endif
+  if (_pLeg2Socket && _pLeg2Socket->is_open())
+  {
+    if (_leg2Reset)
+    {
+      _leg2Reset = false;
+      _pLeg2ReadEndPoint = &_senderEndPointLeg2;
+    }
+    else
+    {
+      _pLeg2ReadEndPoint = &_lastSenderEndPointLeg2;
+    }
+    _pLeg2Socket->async_receive_from(boost::asio::buffer(_leg2Buffer), *_pLeg2ReadEndPoint,
+      boost::bind(&RTPProxy::handleLeg2FrameRead, shared_from_this(),
+        boost::asio::placeholders::error,
+          boost::asio::placeholders::bytes_transferred));
+  }
+}
 
-        _pLeg1Socket->async_receive_from(boost::asio::buffer(_leg1Buffer), _senderEndPointLeg1,
-        boost::bind(&RTPProxy::handleLeg1FrameRead, shared_from_this(),
-          boost::asio::placeholders::error,
-            boost::asio::placeholders::bytes_transferred));
+bool RTPProxy::handleNonMediaPacket(int legIndex, std::size_t size)
+{
+  boost::array<char, RTP_PACKET_BUFFER_SIZE>& buffer = legIndex == 1 ? _leg1Buffer : _leg2Buffer;
+  PacketClass packetClass = classifyPacket(buffer.data(), size);
+  if (packetClass != PACKET_STUN && packetClass != PACKET_DTLS)
+    return false;
 
-      }
-    }
-#if RTP_THREADED  
-    _csLeg1Mutex.unlock();
+#if ENABLE_FEATURE_XOR
+  //
+  // Obfuscated media is not RTP version 2 and its first byte can land in
+  // the STUN or DTLS range.  Only demultiplex a leg that cannot carry XOR:
+  // XOR is off for this proxy, or the peer negotiated ICE, which no XOR
+  // peer does.
+  //
+  if (OSS::SIP::SIPXOR::isEnabled() && !_isXORDisabled && !hasICECredentials(legIndex))
+    return false;
 #endif
+
+  if (packetClass == PACKET_STUN)
+  {
+#if ENABLE_FEATURE_STUN
     //
-    // Process the resize buffer if we are resizing
+    // Connectivity checks are answered from the read handler.  Handing
+    // them to another thread would only add latency to the ICE round trip.
     //
-    processResizerQueue();
+#if RTP_THREADED  
+    OSS::mutex_critic_sec_lock lock(legIndex == 1 ? _csLeg1Mutex : _csLeg2Mutex);
+#endif
+    OSS::STUN::STUNBindingResponder* pResponder = legIndex == 1 ? _pLeg1ICEResponder.get() : _pLeg2ICEResponder.get();
+    if (!pResponder)
+      return false;
+
+    boost::asio::ip::udp::socket* pSocket = legIndex == 1 ? _pLeg1Socket : _pLeg2Socket;
+    const boost::asio::ip::udp::endpoint& source = legIndex == 1 ? *_pLeg1ReadEndPoint : *_pLeg2ReadEndPoint;
+    char response[RTP_PACKET_BUFFER_SIZE];
+    std::size_t responseSize = pResponder->processRequest(buffer.data(), size, source, response, sizeof(response));
+    if (!responseSize)
+    {
+      //
+      // Not a binding request for us.  Relay it like any other datagram.
+      //
+      return false;
+    }
+
+    if (pSocket && pSocket->is_open())
+    {
+      boost::system::error_code ec;
+      pSocket->send_to(boost::asio::buffer(response, responseSize), source, 0, ec);
+      if (ec)
+        OSS_LOG_WARNING(_logId << "RTP (" << _identifier << ") Leg " << legIndex << " unable to send STUN response - " << ec.message());
+    }
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  if (packetClass == PACKET_DTLS && _dtlsHandler)
+  {
+    const boost::asio::ip::udp::endpoint& source = legIndex == 1 ? *_pLeg1ReadEndPoint : *_pLeg2ReadEndPoint;
+    return _dtlsHandler(legIndex, buffer.data(), size, source);
+  }
+
+  return false;
+}
+
+bool RTPProxy::hasICECredentials(int legIndex)
+{
+#if ENABLE_FEATURE_STUN
+#if RTP_THREADED  
+  OSS::mutex_critic_sec_lock lock(legIndex == 1 ? _csLeg1Mutex : _csLeg2Mutex);
+#endif
+  return legIndex == 1 ? !!_pLeg1ICEResponder : !!_pLeg2ICEResponder;
+#else
+  return false;
+#endif
+}
+
+void RTPProxy::setICECredentials(int legIndex, const std::string& localUserFragment, const std::string& password)
+{
+#if ENABLE_FEATURE_STUN
+  boost::shared_ptr<OSS::STUN::STUNBindingResponder> pResponder;
+  if (!localUserFragment.empty() && !password.empty())
+  {
+    pResponder = boost::shared_ptr<OSS::STUN::STUNBindingResponder>(new OSS::STUN::STUNBindingResponder());
+    pResponder->setCredential(localUserFragment, password);
+    pResponder->setRequireAuthentication(true);
   }
+
+  if (legIndex == 1)
+  {
+#if RTP_THREADED  
+    OSS::mutex_critic_sec_lock lock(_csLeg1Mutex);
+#endif
+    _pLeg1ICEResponder = pResponder;
+  }
+  else
+  {
+#if RTP_THREADED  
+    OSS::mutex_critic_sec_lock lock(_csLeg2Mutex);
+#endif
+    _pLeg2ICEResponder = pResponder;
+  }
+#endif
 }
 
 bool RTPProxy::isInactive() const
@@ -493,6 +630,12 @@ void RTPProxy::handleLeg2FrameRead(
   {
     _isInactive = false;
 
+    if (handleNonMediaPacket(2, bytes_transferred))
+    {
+      readLeg2();
+      return;
+    }
+
 #if ENABLE_FEATURE_XOR    
     //_isLeg2XOREncrypted = ((_leg2Buffer[0]>>6)&3) != 2;
     _isLeg2XOREncrypted = OSS::SIP::SIPXOR::isEnabled() ? !validateBuffer(_leg2Buffer, bytes_transferred) : false;
@@ -698,30 +841,8 @@ void RTPProxy::handleLeg2FrameRead(
     }
 #if RTP_THREADED  
     _csLeg1Mutex.unlock();
-
-    _csLeg2Mutex.lock();
-#endif
-    if (_pLeg2Socket && _pLeg2Socket->is_open())
-    {
-      if (_leg2Reset)
-      {
-        _leg2Reset = false;
-          _pLeg2Socket->async_receive_from(boost::asio::buffer(_leg2Buffer), _senderEndPointLeg2,
-        boost::bind(&RTPProxy::handleLeg2FrameRead, shared_from_this(),
-          boost::asio::placeholders::error,
-            boost::asio::placeholders::bytes_transferred));
-      }
-      else
-      {
-        _pLeg2Socket->async_receive_from(boost::asio::buffer(_leg2Buffer), _lastSenderEndPointLeg2,
-        boost::bind(&RTPProxy::handleLeg2FrameRead, shared_from_this(),
-          boost::asio::placeholders::error,
-            boost::asio::placeholders::bytes_transferred));
-      }
-    }
-#if RTP_THREADED  
-    _csLeg2Mutex.unlock();
 #endif
+    readLeg2();
     //
     // Process the resize buffer if we are resizing
     //
@@ -31,7 +31,6 @@ RTPProxyManager::RTPProxyManager(int houseKeepingInterval) :
   _houseKeepingTimer(_ioService, boost::posix_time::milliseconds(houseKeepingInterval)),
   _rtpProxyUDPPortBase(30000), //TODO: magic value
   _rtpProxyUDPPortMax(60000), //TODO: magic value
-  _rtpProxyUDPPortCurrent(0),
   _rtpProxyThreadCount(0),
   _readTimeout(0),
   _rtpSessionMax(1000), //TODO: magic value
@@ -47,12 +46,18 @@ RTPProxyManager::RTPProxyManager(int houseKeepingInterval) :
 RTPProxyManager::~RTPProxyManager()
 {
   stop();
+  //
+  // Detach from the session table before the session list is destroyed so
+  // that a clean shutdown leaves the table intact for the next instance.
+  //
+  _sessionTable.close();
 }
 
 void RTPProxyManager::run(int threadCount, int readTimeout)
 {
   _rtpProxyThreadCount = threadCount;
   _readTimeout = readTimeout;
+  openPortAllocator();
   //
   // start the houseKeepingTimer to keep the io_service busy
   //
@@ -74,6 +79,12 @@ bool RTPProxyManager::redisConnect(const std::vector<Persistent::RedisClient::Co
 {
 	//TODO: What if _redisClient is already connected?
 
+  //
+  // Session state is written on every SDP exchange and removed on teardown.
+  // Queue those writes so a redis round trip never holds up SIP processing.
+  //
+  _redisClient.setAsyncWrites(true);
+
   for (std::vector<Persistent::RedisClient::ConnectionInfo>::const_iterator iter = connections.begin(); iter != connections.end(); iter++)
   {
 	  //TODO: This needs to be disconnected on destructor or stop
@@ -93,8 +104,80 @@ bool RTPProxyManager::redisConnect(const std::vector<Persistent::RedisClient::Co
     /// Connect to redis database for state persistence
 #endif
 
+bool RTPProxyManager::openSessionTable(const boost::filesystem::path& file, std::size_t capacity)
+{
+  return _sessionTable.open(file, capacity);
+}
+
+static void reconstruct_from_records(RTPProxyManager* pManager,
+  std::vector<RTPProxyRecord>::const_iterator begin,
+  std::vector<RTPProxyRecord>::const_iterator end,
+  std::vector<RTPProxySession::Ptr>* pSessions)
+{
+  for (std::vector<RTPProxyRecord>::const_iterator iter = begin; iter != end; iter++)
+  {
+    RTPProxySession::Ptr session = RTPProxySession::reconstructFromRecord(pManager, *iter);
+    if (session)
+    {
+      pSessions->push_back(session);
+    }
+  }
+}
+
+void RTPProxyManager::recycleSessionTable()
+{
+  std::vector<RTPProxyRecord> records;
+  _sessionTable.load(records);
+  if (records.empty())
+  {
+    return;
+  }
+
+  //
+  // Rebinding the sockets dominates recovery time.  Split the records
+  // across threads so every session is forwarding again within seconds.
+  // Sessions whose ports can no longer be bound are dropped from the table
+  // by their destructor.
+  //
+  std::size_t threadCount = std::max<std::size_t>(1, std::min<std::size_t>(boost::thread::hardware_concurrency(), records.size()));
+  std::size_t chunkSize = (records.size() + threadCount - 1) / threadCount;
+  std::vector<std::vector<RTPProxySession::Ptr> > sessions(threadCount);
+  boost::thread_group threads;
+  for (std::size_t i = 0; i < threadCount; i++)
+  {
+    std::size_t first = std::min(i * chunkSize, records.size());
+    std::size_t last = std::min(first + chunkSize, records.size());
+    threads.create_thread(boost::bind(&reconstruct_from_records, this,
+      records.begin() + first, records.begin() + last, &sessions[i]));
+  }
+  threads.join_all();
+
+  std::size_t count = 0;
+  OSS::mutex_critic_sec_lock lock(_sessionListMutex);
+  for (std::size_t i = 0; i < sessions.size(); i++)
+  {
+    for (std::vector<RTPProxySession::Ptr>::iterator iter = sessions[i].begin(); iter != sessions[i].end(); iter++)
+    {
+      _sessionList.insert(std::pair<std::string, RTPProxySession::Ptr>((*iter)->getIdentifier(), *iter));
+      count++;
+    }
+  }
+  OSS_LOG_INFO("RTPProxyManager::recycleState - Restored " << count << " of " << records.size() << " sessions from " << OSS::boost_path(_sessionTable.getFile()));
+}
+
 void RTPProxyManager::recycleState()
 {
+  //
+  // Restored sessions reserve the ports they rebind
+  //
+  openPortAllocator();
+
+  if (_sessionTable.isOpen() && _sessionTable.size() > 0)
+  {
+    recycleSessionTable();
+    return;
+  }
+
   if (!_persistStateFiles)
     return;
 
@@ -162,6 +245,21 @@ void RTPProxyManager::recycleState()
     }
   }
 #endif
+
+  //
+  // Move sessions recovered from the older stores into the session table so
+  // the next restart can use it.
+  //
+  if (_sessionTable.isOpen())
+  {
+    OSS::mutex_critic_sec_lock lock(_sessionListMutex);
+    for (RTPProxySessionList::iterator iter = _sessionList.begin(); iter != _sessionList.end(); iter++)
+    {
+      RTPProxyRecord record;
+      iter->second->toRecord(record);
+      _sessionTable.store(record);
+    }
+  }
 }
 
 void RTPProxyManager::stop()
@@ -183,11 +281,33 @@ void RTPProxyManager::onHouseKeepingTimer(const boost::system::error_code& e)
   if (e != boost::asio::error::operation_aborted)
   {
     collectInactiveSessions();
+    _portAllocator.recycle();
     _houseKeepingTimer.expires_from_now(boost::posix_time::milliseconds(_houseKeepingInterval));
     _houseKeepingTimer.async_wait(boost::bind(&RTPProxyManager::onHouseKeepingTimer, this, boost::asio::placeholders::error));
   }
 }
 
+void RTPProxyManager::handleSDP(
+  const std::string& logId,
+  const std::string& sessionId,
+  const OSS::Net::IPEndPoint& sentBy,
+  const OSS::Net::IPEndPoint& packetSourceIP,
+  const OSS::Net::IPEndPoint& packetLocalInterface,
+  const OSS::Net::IPEndPoint& route,
+  const OSS::Net::IPEndPoint& routeLocalInterface,
+  RTPProxySession::RequestType requestType,
+  std::string& sdp,
+  RTPProxy::Attributes& rtpAttribute)
+{
+  handleSDP(logId, sessionId,
+    OSS::Net::IPAddress(sentBy),
+    OSS::Net::IPAddress(packetSourceIP),
+    OSS::Net::IPAddress(packetLocalInterface),
+    OSS::Net::IPAddress(route),
+    OSS::Net::IPAddress(routeLocalInterface),
+    requestType, sdp, rtpAttribute);
+}
+
 void RTPProxyManager::handleSDP(
   const std::string& logId,
   const std::string& sessionId,
@@ -511,21 +631,34 @@ void RTPProxyManager::collectInactiveSessions()
   _sessionListMutex.unlock();
 }
 
+void RTPProxyManager::openPortAllocator()
+{
+  if (_portAllocator.isOpen())
+    return;
+
+  if (_portAllocator.open(_rtpProxyUDPPortBase, _rtpProxyUDPPortMax))
+  {
+    OSS_LOG_INFO("RTPProxyManager - Allocating RTP ports " << _rtpProxyUDPPortBase << "-" << _rtpProxyUDPPortMax);
+  }
+  else
+  {
+    OSS_LOG_ERROR("RTPProxyManager - Invalid RTP port range " << _rtpProxyUDPPortBase << "-" << _rtpProxyUDPPortMax);
+  }
+}
+
 unsigned short RTPProxyManager::getNextAvailablePortTuple()
 {
-  _csPortMutex.lock();
-  if (_rtpProxyUDPPortCurrent == 0)
-  {
-    _rtpProxyUDPPortCurrent = _rtpProxyUDPPortBase + 2; //TODO: magic value
-    _csPortMutex.unlock();
-    return _rtpProxyUDPPortBase;
-  }
-  unsigned short current = _rtpProxyUDPPortCurrent;
-  _rtpProxyUDPPortCurrent += 2; //TODO: magic value
-  if (_rtpProxyUDPPortCurrent > _rtpProxyUDPPortMax)
-    _rtpProxyUDPPortCurrent = _rtpProxyUDPPortBase;
-  _csPortMutex.unlock();
-  return current;
+  return _portAllocator.allocate();
+}
+
+void RTPProxyManager::releasePortTuple(unsigned short port)
+{
+  _portAllocator.release(port);
+}
+
+bool RTPProxyManager::reservePortTuple(unsigned short port)
+{
+  return _portAllocator.reserve(port);
 }
 
 void RTPProxyManager::incrementSessionCount(const std::string& address)
@@ -57,6 +57,20 @@ public:
   std::string& _target;
 };
 
+static void update_ice_credentials(RTPProxyTuple& tuple, const SDPMedia::Ptr& media, int sdpLegIndex)
+{
+  //
+  // ICE attributes are relayed untouched so the peer on the other leg
+  // authenticates its connectivity checks with the credentials found in
+  // this SDP.  Those checks arrive on our socket for the other leg.
+  //
+  std::string userFragment;
+  std::string password;
+  media->getICEUFrag(userFragment);
+  media->getICEPassword(password);
+  tuple.setICECredentials(sdpLegIndex == 1 ? 2 : 1, userFragment, password);
+}
+
 
 RTPProxySession::RTPProxySession(RTPProxyManager* pManager, const std::string& identifier) :
   _state(IDLE),
@@ -85,6 +99,11 @@ RTPProxySession::~RTPProxySession()
 {
   stop();
 
+  if (_pManager->hasSessionTable())
+  {
+    _pManager->sessionTable().remove(_identifier);
+  }
+
 #if ENABLE_FEATURE_CONFIG
   if (!_pManager->hasRtpDb() && _pManager->persistStateFiles())
   {
@@ -106,6 +125,16 @@ void RTPProxySession::stop()
   _fax.stop();
 }
 
+void RTPProxySession::reservePorts()
+{
+  if (_hasOfferedAudioProxy)
+    _audio.reservePorts(_audio.data()._localEndPointLeg1.port(), _audio.data()._localEndPointLeg2.port());
+  if (_hasOfferedVideoProxy)
+    _video.reservePorts(_video.data()._localEndPointLeg1.port(), _video.data()._localEndPointLeg2.port());
+  if (_hasOfferedFaxProxy)
+    _fax.reservePorts(_fax.data()._localEndPointLeg1.port(), _fax.data()._localEndPointLeg2.port());
+}
+
 /*
  * enum RequestType
   {
@@ -129,6 +158,24 @@ void RTPProxySession::stop()
   };
  */
 
+void RTPProxySession::handleSDP(
+  const OSS::Net::IPEndPoint& sentBy,
+  const OSS::Net::IPEndPoint& packetSourceIP,
+  const OSS::Net::IPEndPoint& packetLocalInterface,
+  const OSS::Net::IPEndPoint& route,
+  const OSS::Net::IPEndPoint& routeLocalInterface,
+  RequestType requestType,
+  std::string& sdp,
+  RTPProxy::Attributes& rtpAttribute)
+{
+  handleSDP(OSS::Net::IPAddress(sentBy),
+    OSS::Net::IPAddress(packetSourceIP),
+    OSS::Net::IPAddress(packetLocalInterface),
+    OSS::Net::IPAddress(route),
+    OSS::Net::IPAddress(routeLocalInterface),
+    requestType, sdp, rtpAttribute);
+}
+
 void RTPProxySession::handleSDP(
   const OSS::Net::IPAddress& sentBy,
   const OSS::Net::IPAddress& packetSourceIP,
@@ -556,6 +603,8 @@ void RTPProxySession::handleInitialSDPOffer(
         unsigned short dataPort = audio->getDataPort();
         unsigned short controlPort = audio->getControlPort();
 
+        update_ice_credentials(_audio, audio, 1);
+
         _audio.data().isLeg1XOREncrypted() = rtpAttribute.forcePEAEncryption;
         _audio.control().isLeg1XOREncrypted() = rtpAttribute.forcePEAEncryption;
 
@@ -661,6 +710,8 @@ void RTPProxySession::handleInitialSDPOffer(
         unsigned short dataPort = video->getDataPort();
         unsigned short controlPort = video->getControlPort();
 
+        update_ice_credentials(_video, video, 1);
+
         _video.data().isLeg1XOREncrypted() = rtpAttribute.forcePEAEncryption;
         _video.control().isLeg1XOREncrypted() = rtpAttribute.forcePEAEncryption;
 
@@ -902,6 +953,8 @@ void RTPProxySession::handleInitialSDPAnswer(
       _audio.data().isLeg2XOREncrypted() = rtpAttribute.forcePEAEncryption;
       _audio.control().isLeg2XOREncrypted() = rtpAttribute.forcePEAEncryption;
 
+      update_ice_credentials(_audio, audio, 2);
+
       _isAudioProxyNegotiated = true;
       _audio.start();
       //
@@ -975,6 +1028,8 @@ void RTPProxySession::handleInitialSDPAnswer(
       _video.data().isLeg2XOREncrypted() = rtpAttribute.forcePEAEncryption;
       _video.control().isLeg2XOREncrypted() = rtpAttribute.forcePEAEncryption;
 
+      update_ice_credentials(_video, video, 2);
+
       _isVideoProxyNegotiated = true;
       _video.start();
       //
@@ -1247,6 +1302,7 @@ void RTPProxySession::handleSDPOffer(
       unsigned short controlPort = audio->getControlPort();
       OSS::Net::IPAddress dataAddress;
       OSS::Net::IPAddress controlAddress;
+      update_ice_credentials(_audio, audio, legIndex);
       if (legIndex == 1)
       {
         _audio.data().leg1Destination() = boost::asio::ip::udp::endpoint(mediaAddress.address(), dataPort);
@@ -1345,6 +1401,7 @@ void RTPProxySession::handleSDPOffer(
       unsigned short controlPort = video->getControlPort();
       OSS::Net::IPAddress dataAddress;
       OSS::Net::IPAddress controlAddress;
+      update_ice_credentials(_video, video, legIndex);
       if (legIndex == 1)
       {
         _video.data().leg1Destination() = boost::asio::ip::udp::endpoint(mediaAddress.address(), dataPort);
@@ -1627,6 +1684,7 @@ void RTPProxySession::handleSDPAnswer(
       unsigned short controlPort = audio->getControlPort();
       OSS::Net::IPAddress dataAddress;
       OSS::Net::IPAddress controlAddress;
+      update_ice_credentials(_audio, audio, legIndex);
       if (legIndex == 1)
       {
         _audio.data().leg1Destination() = boost::asio::ip::udp::endpoint(mediaAddress.address(), dataPort);
@@ -1712,6 +1770,7 @@ void RTPProxySession::handleSDPAnswer(
       unsigned short controlPort = video->getControlPort();
       OSS::Net::IPAddress dataAddress;
       OSS::Net::IPAddress controlAddress;
+      update_ice_credentials(_video, video, legIndex);
       if (legIndex == 1)
       {
         _video.data().leg1Destination() = boost::asio::ip::udp::endpoint(mediaAddress.address(), dataPort);
@@ -1866,11 +1925,8 @@ void RTPProxySession::handleSDPAnswer(
   }
 }
 
-#if ENABLE_FEATURE_REDIS
-void RTPProxySession::dumpStateToRedis()
+void RTPProxySession::toRecord(RTPProxyRecord& record)
 {
-  RTPProxyRecord record;
-  
   record.identifier = _identifier.c_str();
   record.logId = _logId.c_str();
   record.leg1Identifier = _leg1Identifier.c_str();
@@ -2116,7 +2172,13 @@ void RTPProxySession::dumpStateToRedis()
       record.fax.control.isLeg2XOREncrypted = fax_control._isLeg2XOREncrypted;
     }
   }
-  
+}
+
+#if ENABLE_FEATURE_REDIS
+void RTPProxySession::dumpStateToRedis()
+{
+  RTPProxyRecord record;
+  toRecord(record);
   record.writeToRedis(_pManager->redisClient(), _identifier);
 }
 #endif
@@ -2124,6 +2186,18 @@ void RTPProxySession::dumpStateToRedis()
 #if ENABLE_FEATURE_CONFIG
 void RTPProxySession::dumpStateFile()
 {
+  //
+  // The session table is local and cheap to update.  It takes the place of
+  // the state file but redis is still written so peers can take over.
+  //
+  bool hasSessionTable = _pManager->hasSessionTable();
+  if (hasSessionTable)
+  {
+    RTPProxyRecord record;
+    toRecord(record);
+    _pManager->sessionTable().store(record);
+  }
+
   //
   // Check if we will be using redis
   //
@@ -2137,7 +2211,7 @@ void RTPProxySession::dumpStateFile()
   //
   // Check if the manager allows persistence of state files to the disc
   //
-  if (!_pManager->persistStateFiles())
+  if (hasSessionTable || !_pManager->persistStateFiles())
     return;
 
   ClassType persistent;
@@ -2448,251 +2522,255 @@ void RTPProxySession::dumpStateFile()
 
 RTPProxySession::Ptr RTPProxySession::reconstructFromRedis(RTPProxyManager* pManager, const std::string& identifier)
 {
-  RTPProxySession* pSession = 0;
-  if (pManager->hasRtpDb())
+  if (!pManager->hasRtpDb())
   {
-    RTPProxyRecord record;
-    if (record.readFromRedis(pManager->redisClient(), identifier))
-    {
-      pSession = new RTPProxySession(pManager, record.identifier);
-      pSession->_logId = record.logId;
-      pSession->_leg1Identifier = record.leg1Identifier;
-      pSession->_leg2Identifier = record.leg2Identifier;
-      pSession->_leg1OriginAddress = record.leg1OriginAddress;
-      pSession->_leg2OriginAddress = record.leg2OriginAddress;
-      pSession->_lastSDPInAck = record.lastSDPInAck;
-      pSession->_isExpectingInitialAnswer = record.isExpectingInitialAnswer;
-      pSession->_hasOfferedAudioProxy = record.hasOfferedAudioProxy;
-      pSession->_hasOfferedVideoProxy = record.hasOfferedVideoProxy;
-      pSession->_hasOfferedFaxProxy = record.hasOfferedFaxProxy;
-      pSession->_isAudioProxyNegotiated = record.isAudioProxyNegotiated;
-      pSession->_isVideoProxyNegotiated = record.isVideoProxyNegotiated;
-      pSession->_isFaxProxyNegotiated = record.isFaxProxyNegotiated;
-      pSession->_verbose = record.verbose;
-      pSession->_state = (State)record.state;
-      pSession->_lastOfferIndex  = record.lastOfferIndex;
-    }
-    else
-    {
-      return RTPProxySession::Ptr();
-    }
-    
-    if (pSession->_hasOfferedAudioProxy)
-    {
-      pSession->_audio.data()._identifier = record.audio.data.identifier;
-      {
-        OSS::Net::IPAddress localEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.audio.data.localEndPointLeg1.c_str());
-        OSS::Net::IPAddress localEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.audio.data.localEndPointLeg2.c_str());
-        OSS::Net::IPAddress senderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.audio.data.senderEndPointLeg1.c_str());
-        OSS::Net::IPAddress senderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.audio.data.senderEndPointLeg2.c_str());
-        OSS::Net::IPAddress lastSenderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.audio.data.lastSenderEndPointLeg1.c_str());
-        OSS::Net::IPAddress lastSenderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.audio.data.lastSenderEndPointLeg2.c_str());
-
-        pSession->_audio.data()._senderEndPointLeg1 =
-          boost::asio::ip::udp::endpoint(senderEndPointLeg1.address(), senderEndPointLeg1.getPort());
-        pSession->_audio.data()._senderEndPointLeg2 =
-          boost::asio::ip::udp::endpoint(senderEndPointLeg2.address(), senderEndPointLeg2.getPort());
+    return RTPProxySession::Ptr();
+  }
 
-        pSession->_audio.data()._lastSenderEndPointLeg1 =
-          boost::asio::ip::udp::endpoint(lastSenderEndPointLeg1.address(), lastSenderEndPointLeg1.getPort());
-        pSession->_audio.data()._lastSenderEndPointLeg2 =
-          boost::asio::ip::udp::endpoint(lastSenderEndPointLeg2.address(), lastSenderEndPointLeg2.getPort());
+  RTPProxyRecord record;
+  if (!record.readFromRedis(pManager->redisClient(), identifier))
+  {
+    return RTPProxySession::Ptr();
+  }
+  return reconstructFromRecord(pManager, record);
+}
+#endif
 
-        pSession->_audio.data()._adjustSenderFromPacketSource = record.audio.data.adjustSenderFromPacketSource;
-        pSession->_audio.data()._leg1Reset = record.audio.data.leg1Reset;
-        pSession->_audio.data()._leg2Reset = record.audio.data.leg2Reset;
-        pSession->_audio.data()._isStarted = record.audio.data.isStarted;
-        pSession->_audio.data()._isInactive = record.audio.data.isInactive;
-        pSession->_audio.data()._isLeg1XOREncrypted = record.audio.data.isLeg1XOREncrypted;
-        pSession->_audio.data()._isLeg2XOREncrypted = record.audio.data.isLeg2XOREncrypted;
-        if (!pSession->_audio.data().open(localEndPointLeg1, localEndPointLeg2))
-        {
-          delete pSession;
-          return RTPProxySession::Ptr();
-        }
-        pSession->_audio.data().start();
+RTPProxySession::Ptr RTPProxySession::reconstructFromRecord(RTPProxyManager* pManager, const RTPProxyRecord& record)
+{
+  RTPProxySession* pSession = new RTPProxySession(pManager, record.identifier);
+  pSession->_logId = record.logId;
+  pSession->_leg1Identifier = record.leg1Identifier;
+  pSession->_leg2Identifier = record.leg2Identifier;
+  pSession->_leg1OriginAddress = record.leg1OriginAddress;
+  pSession->_leg2OriginAddress = record.leg2OriginAddress;
+  pSession->_lastSDPInAck = record.lastSDPInAck;
+  pSession->_isExpectingInitialAnswer = record.isExpectingInitialAnswer;
+  pSession->_hasOfferedAudioProxy = record.hasOfferedAudioProxy;
+  pSession->_hasOfferedVideoProxy = record.hasOfferedVideoProxy;
+  pSession->_hasOfferedFaxProxy = record.hasOfferedFaxProxy;
+  pSession->_isAudioProxyNegotiated = record.isAudioProxyNegotiated;
+  pSession->_isVideoProxyNegotiated = record.isVideoProxyNegotiated;
+  pSession->_isFaxProxyNegotiated = record.isFaxProxyNegotiated;
+  pSession->_verbose = record.verbose;
+  pSession->_state = (State)record.state;
+  pSession->_lastOfferIndex  = record.lastOfferIndex;
+  
+  if (pSession->_hasOfferedAudioProxy)
+  {
+    pSession->_audio.data()._identifier = record.audio.data.identifier;
+    {
+      OSS::Net::IPAddress localEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.audio.data.localEndPointLeg1.c_str());
+      OSS::Net::IPAddress localEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.audio.data.localEndPointLeg2.c_str());
+      OSS::Net::IPAddress senderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.audio.data.senderEndPointLeg1.c_str());
+      OSS::Net::IPAddress senderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.audio.data.senderEndPointLeg2.c_str());
+      OSS::Net::IPAddress lastSenderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.audio.data.lastSenderEndPointLeg1.c_str());
+      OSS::Net::IPAddress lastSenderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.audio.data.lastSenderEndPointLeg2.c_str());
+
+      pSession->_audio.data()._senderEndPointLeg1 =
+        boost::asio::ip::udp::endpoint(senderEndPointLeg1.address(), senderEndPointLeg1.getPort());
+      pSession->_audio.data()._senderEndPointLeg2 =
+        boost::asio::ip::udp::endpoint(senderEndPointLeg2.address(), senderEndPointLeg2.getPort());
+
+      pSession->_audio.data()._lastSenderEndPointLeg1 =
+        boost::asio::ip::udp::endpoint(lastSenderEndPointLeg1.address(), lastSenderEndPointLeg1.getPort());
+      pSession->_audio.data()._lastSenderEndPointLeg2 =
+        boost::asio::ip::udp::endpoint(lastSenderEndPointLeg2.address(), lastSenderEndPointLeg2.getPort());
+
+      pSession->_audio.data()._adjustSenderFromPacketSource = record.audio.data.adjustSenderFromPacketSource;
+      pSession->_audio.data()._leg1Reset = record.audio.data.leg1Reset;
+      pSession->_audio.data()._leg2Reset = record.audio.data.leg2Reset;
+      pSession->_audio.data()._isStarted = record.audio.data.isStarted;
+      pSession->_audio.data()._isInactive = record.audio.data.isInactive;
+      pSession->_audio.data()._isLeg1XOREncrypted = record.audio.data.isLeg1XOREncrypted;
+      pSession->_audio.data()._isLeg2XOREncrypted = record.audio.data.isLeg2XOREncrypted;
+      if (!pSession->_audio.data().open(localEndPointLeg1, localEndPointLeg2))
+      {
+        delete pSession;
+        return RTPProxySession::Ptr();
       }
-
-      pSession->_audio.control()._identifier = record.audio.control.identifier;
+      pSession->_audio.data().start();
+    }
+
+    pSession->_audio.control()._identifier = record.audio.control.identifier;
+    {
+      OSS::Net::IPAddress localEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.audio.control.localEndPointLeg1.c_str());
+      OSS::Net::IPAddress localEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.audio.control.localEndPointLeg2.c_str());
+      OSS::Net::IPAddress senderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.audio.control.senderEndPointLeg1.c_str());
+      OSS::Net::IPAddress senderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.audio.control.senderEndPointLeg2.c_str());
+      OSS::Net::IPAddress lastSenderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.audio.control.lastSenderEndPointLeg1.c_str());
+      OSS::Net::IPAddress lastSenderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.audio.control.lastSenderEndPointLeg2.c_str());
+
+      pSession->_audio.control()._senderEndPointLeg1 =
+        boost::asio::ip::udp::endpoint(senderEndPointLeg1.address(), senderEndPointLeg1.getPort());
+      pSession->_audio.control()._senderEndPointLeg2 =
+        boost::asio::ip::udp::endpoint(senderEndPointLeg2.address(), senderEndPointLeg2.getPort());
+
+      pSession->_audio.control()._lastSenderEndPointLeg1 =
+        boost::asio::ip::udp::endpoint(lastSenderEndPointLeg1.address(), lastSenderEndPointLeg1.getPort());
+      pSession->_audio.control()._lastSenderEndPointLeg2 =
+        boost::asio::ip::udp::endpoint(lastSenderEndPointLeg2.address(), lastSenderEndPointLeg2.getPort());
+
+      pSession->_audio.control()._adjustSenderFromPacketSource = record.audio.control.adjustSenderFromPacketSource;
+      pSession->_audio.control()._leg1Reset = record.audio.control.leg1Reset;
+      pSession->_audio.control()._leg2Reset = record.audio.control.leg2Reset;
+      pSession->_audio.control()._isStarted = record.audio.control.isStarted;
+      pSession->_audio.control()._isInactive = record.audio.control.isInactive;
+      pSession->_audio.control()._isLeg1XOREncrypted = record.audio.control.isLeg1XOREncrypted;
+      pSession->_audio.control()._isLeg2XOREncrypted = record.audio.control.isLeg2XOREncrypted;
+      if (!pSession->_audio.control().open(localEndPointLeg1, localEndPointLeg2))
       {
-        OSS::Net::IPAddress localEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.audio.control.localEndPointLeg1.c_str());
-        OSS::Net::IPAddress localEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.audio.control.localEndPointLeg2.c_str());
-        OSS::Net::IPAddress senderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.audio.control.senderEndPointLeg1.c_str());
-        OSS::Net::IPAddress senderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.audio.control.senderEndPointLeg2.c_str());
-        OSS::Net::IPAddress lastSenderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.audio.control.lastSenderEndPointLeg1.c_str());
-        OSS::Net::IPAddress lastSenderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.audio.control.lastSenderEndPointLeg2.c_str());
-
-        pSession->_audio.control()._senderEndPointLeg1 =
-          boost::asio::ip::udp::endpoint(senderEndPointLeg1.address(), senderEndPointLeg1.getPort());
-        pSession->_audio.control()._senderEndPointLeg2 =
-          boost::asio::ip::udp::endpoint(senderEndPointLeg2.address(), senderEndPointLeg2.getPort());
-
-        pSession->_audio.control()._lastSenderEndPointLeg1 =
-          boost::asio::ip::udp::endpoint(lastSenderEndPointLeg1.address(), lastSenderEndPointLeg1.getPort());
-        pSession->_audio.control()._lastSenderEndPointLeg2 =
-          boost::asio::ip::udp::endpoint(lastSenderEndPointLeg2.address(), lastSenderEndPointLeg2.getPort());
-
-        pSession->_audio.control()._adjustSenderFromPacketSource = record.audio.control.adjustSenderFromPacketSource;
-        pSession->_audio.control()._leg1Reset = record.audio.control.leg1Reset;
-        pSession->_audio.control()._leg2Reset = record.audio.control.leg2Reset;
-        pSession->_audio.control()._isStarted = record.audio.control.isStarted;
-        pSession->_audio.control()._isInactive = record.audio.control.isInactive;
-        pSession->_audio.control()._isLeg1XOREncrypted = record.audio.control.isLeg1XOREncrypted;
-        pSession->_audio.control()._isLeg2XOREncrypted = record.audio.control.isLeg2XOREncrypted;
-        if (!pSession->_audio.control().open(localEndPointLeg1, localEndPointLeg2))
-        {
-          delete pSession;
-          return RTPProxySession::Ptr();
-        }
-        pSession->_audio.control().start();
+        delete pSession;
+        return RTPProxySession::Ptr();
       }
+      pSession->_audio.control().start();
     }
+  }
 
-    if (pSession->_hasOfferedVideoProxy)
-    {
-      pSession->_video.data()._identifier = record.video.data.identifier;
+  if (pSession->_hasOfferedVideoProxy)
+  {
+    pSession->_video.data()._identifier = record.video.data.identifier;
+    {
+      OSS::Net::IPAddress localEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.video.data.localEndPointLeg1.c_str());
+      OSS::Net::IPAddress localEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.video.data.localEndPointLeg2.c_str());
+      OSS::Net::IPAddress senderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.video.data.senderEndPointLeg1.c_str());
+      OSS::Net::IPAddress senderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.video.data.senderEndPointLeg2.c_str());
+      OSS::Net::IPAddress lastSenderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.video.data.lastSenderEndPointLeg1.c_str());
+      OSS::Net::IPAddress lastSenderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.video.data.lastSenderEndPointLeg2.c_str());
+
+      pSession->_video.data()._senderEndPointLeg1 =
+        boost::asio::ip::udp::endpoint(senderEndPointLeg1.address(), senderEndPointLeg1.getPort());
+      pSession->_video.data()._senderEndPointLeg2 =
+        boost::asio::ip::udp::endpoint(senderEndPointLeg2.address(), senderEndPointLeg2.getPort());
+
+      pSession->_video.data()._lastSenderEndPointLeg1 =
+        boost::asio::ip::udp::endpoint(lastSenderEndPointLeg1.address(), lastSenderEndPointLeg1.getPort());
+      pSession->_video.data()._lastSenderEndPointLeg2 =
+        boost::asio::ip::udp::endpoint(lastSenderEndPointLeg2.address(), lastSenderEndPointLeg2.getPort());
+
+      pSession->_video.data()._adjustSenderFromPacketSource = record.video.data.adjustSenderFromPacketSource;
+      pSession->_video.data()._leg1Reset = record.video.data.leg1Reset;
+      pSession->_video.data()._leg2Reset = record.video.data.leg2Reset;
+      pSession->_video.data()._isStarted = record.video.data.isStarted;
+      pSession->_video.data()._isInactive = record.video.data.isInactive;
+      pSession->_video.data()._isLeg1XOREncrypted = record.video.data.isLeg1XOREncrypted;
+      pSession->_video.data()._isLeg2XOREncrypted = record.video.data.isLeg2XOREncrypted;
+      if (!pSession->_video.data().open(localEndPointLeg1, localEndPointLeg2))
       {
-        OSS::Net::IPAddress localEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.video.data.localEndPointLeg1.c_str());
-        OSS::Net::IPAddress localEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.video.data.localEndPointLeg2.c_str());
-        OSS::Net::IPAddress senderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.video.data.senderEndPointLeg1.c_str());
-        OSS::Net::IPAddress senderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.video.data.senderEndPointLeg2.c_str());
-        OSS::Net::IPAddress lastSenderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.video.data.lastSenderEndPointLeg1.c_str());
-        OSS::Net::IPAddress lastSenderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.video.data.lastSenderEndPointLeg2.c_str());
-
-        pSession->_video.data()._senderEndPointLeg1 =
-          boost::asio::ip::udp::endpoint(senderEndPointLeg1.address(), senderEndPointLeg1.getPort());
-        pSession->_video.data()._senderEndPointLeg2 =
-          boost::asio::ip::udp::endpoint(senderEndPointLeg2.address(), senderEndPointLeg2.getPort());
-
-        pSession->_video.data()._lastSenderEndPointLeg1 =
-          boost::asio::ip::udp::endpoint(lastSenderEndPointLeg1.address(), lastSenderEndPointLeg1.getPort());
-        pSession->_video.data()._lastSenderEndPointLeg2 =
-          boost::asio::ip::udp::endpoint(lastSenderEndPointLeg2.address(), lastSenderEndPointLeg2.getPort());
-
-        pSession->_video.data()._adjustSenderFromPacketSource = record.video.data.adjustSenderFromPacketSource;
-        pSession->_video.data()._leg1Reset = record.video.data.leg1Reset;
-        pSession->_video.data()._leg2Reset = record.video.data.leg2Reset;
-        pSession->_video.data()._isStarted = record.video.data.isStarted;
-        pSession->_video.data()._isInactive = record.video.data.isInactive;
-        pSession->_video.data()._isLeg1XOREncrypted = record.video.data.isLeg1XOREncrypted;
-        pSession->_video.data()._isLeg2XOREncrypted = record.video.data.isLeg2XOREncrypted;
-        if (!pSession->_video.data().open(localEndPointLeg1, localEndPointLeg2))
-        {
-          delete pSession;
-          return RTPProxySession::Ptr();
-        }
-        pSession->_video.data().start();
+        delete pSession;
+        return RTPProxySession::Ptr();
       }
-
-      pSession->_video.control()._identifier = record.video.control.identifier;
+      pSession->_video.data().start();
+    }
+
+    pSession->_video.control()._identifier = record.video.control.identifier;
+    {
+      OSS::Net::IPAddress localEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.video.control.localEndPointLeg1.c_str());
+      OSS::Net::IPAddress localEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.video.control.localEndPointLeg2.c_str());
+      OSS::Net::IPAddress senderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.video.control.senderEndPointLeg1.c_str());
+      OSS::Net::IPAddress senderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.video.control.senderEndPointLeg2.c_str());
+      OSS::Net::IPAddress lastSenderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.video.control.lastSenderEndPointLeg1.c_str());
+      OSS::Net::IPAddress lastSenderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.video.control.lastSenderEndPointLeg2.c_str());
+
+      pSession->_video.control()._senderEndPointLeg1 =
+        boost::asio::ip::udp::endpoint(senderEndPointLeg1.address(), senderEndPointLeg1.getPort());
+      pSession->_video.control()._senderEndPointLeg2 =
+        boost::asio::ip::udp::endpoint(senderEndPointLeg2.address(), senderEndPointLeg2.getPort());
+
+      pSession->_video.control()._lastSenderEndPointLeg1 =
+        boost::asio::ip::udp::endpoint(lastSenderEndPointLeg1.address(), lastSenderEndPointLeg1.getPort());
+      pSession->_video.control()._lastSenderEndPointLeg2 =
+        boost::asio::ip::udp::endpoint(lastSenderEndPointLeg2.address(), lastSenderEndPointLeg2.getPort());
+
+      pSession->_video.control()._adjustSenderFromPacketSource = record.video.control.adjustSenderFromPacketSource;
+      pSession->_video.control()._leg1Reset = record.video.control.leg1Reset;
+      pSession->_video.control()._leg2Reset = record.video.control.leg2Reset;
+      pSession->_video.control()._isStarted = record.video.control.isStarted;
+      pSession->_video.control()._isInactive = record.video.control.isInactive;
+      pSession->_video.control()._isLeg1XOREncrypted = record.video.control.isLeg1XOREncrypted;
+      pSession->_video.control()._isLeg2XOREncrypted = record.video.control.isLeg2XOREncrypted;
+      if (!pSession->_video.control().open(localEndPointLeg1, localEndPointLeg2))
       {
-        OSS::Net::IPAddress localEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.video.control.localEndPointLeg1.c_str());
-        OSS::Net::IPAddress localEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.video.control.localEndPointLeg2.c_str());
-        OSS::Net::IPAddress senderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.video.control.senderEndPointLeg1.c_str());
-        OSS::Net::IPAddress senderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.video.control.senderEndPointLeg2.c_str());
-        OSS::Net::IPAddress lastSenderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.video.control.lastSenderEndPointLeg1.c_str());
-        OSS::Net::IPAddress lastSenderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.video.control.lastSenderEndPointLeg2.c_str());
-
-        pSession->_video.control()._senderEndPointLeg1 =
-          boost::asio::ip::udp::endpoint(senderEndPointLeg1.address(), senderEndPointLeg1.getPort());
-        pSession->_video.control()._senderEndPointLeg2 =
-          boost::asio::ip::udp::endpoint(senderEndPointLeg2.address(), senderEndPointLeg2.getPort());
-
-        pSession->_video.control()._lastSenderEndPointLeg1 =
-          boost::asio::ip::udp::endpoint(lastSenderEndPointLeg1.address(), lastSenderEndPointLeg1.getPort());
-        pSession->_video.control()._lastSenderEndPointLeg2 =
-          boost::asio::ip::udp::endpoint(lastSenderEndPointLeg2.address(), lastSenderEndPointLeg2.getPort());
-
-        pSession->_video.control()._adjustSenderFromPacketSource = record.video.control.adjustSenderFromPacketSource;
-        pSession->_video.control()._leg1Reset = record.video.control.leg1Reset;
-        pSession->_video.control()._leg2Reset = record.video.control.leg2Reset;
-        pSession->_video.control()._isStarted = record.video.control.isStarted;
-        pSession->_video.control()._isInactive = record.video.control.isInactive;
-        pSession->_video.control()._isLeg1XOREncrypted = record.video.control.isLeg1XOREncrypted;
-        pSession->_video.control()._isLeg2XOREncrypted = record.video.control.isLeg2XOREncrypted;
-        if (!pSession->_video.control().open(localEndPointLeg1, localEndPointLeg2))
-        {
-          delete pSession;
-          return RTPProxySession::Ptr();
-        }
-        pSession->_video.control().start();
+        delete pSession;
+        return RTPProxySession::Ptr();
       }
+      pSession->_video.control().start();
     }
+  }
 
-    if (pSession->_hasOfferedFaxProxy)
-    {
-      pSession->_fax.data()._identifier = record.fax.data.identifier;
+  if (pSession->_hasOfferedFaxProxy)
+  {
+    pSession->_fax.data()._identifier = record.fax.data.identifier;
+    {
+      OSS::Net::IPAddress localEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.fax.data.localEndPointLeg1.c_str());
+      OSS::Net::IPAddress localEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.fax.data.localEndPointLeg2.c_str());
+      OSS::Net::IPAddress senderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.fax.data.senderEndPointLeg1.c_str());
+      OSS::Net::IPAddress senderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.fax.data.senderEndPointLeg2.c_str());
+      OSS::Net::IPAddress lastSenderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.fax.data.lastSenderEndPointLeg1.c_str());
+      OSS::Net::IPAddress lastSenderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.fax.data.lastSenderEndPointLeg2.c_str());
+
+      pSession->_fax.data()._senderEndPointLeg1 =
+        boost::asio::ip::udp::endpoint(senderEndPointLeg1.address(), senderEndPointLeg1.getPort());
+      pSession->_fax.data()._senderEndPointLeg2 =
+        boost::asio::ip::udp::endpoint(senderEndPointLeg2.address(), senderEndPointLeg2.getPort());
+
+      pSession->_fax.data()._lastSenderEndPointLeg1 =
+        boost::asio::ip::udp::endpoint(lastSenderEndPointLeg1.address(), lastSenderEndPointLeg1.getPort());
+      pSession->_fax.data()._lastSenderEndPointLeg2 =
+        boost::asio::ip::udp::endpoint(lastSenderEndPointLeg2.address(), lastSenderEndPointLeg2.getPort());
+
+      pSession->_fax.data()._adjustSenderFromPacketSource = record.fax.data.adjustSenderFromPacketSource;
+      pSession->_fax.data()._leg1Reset = record.fax.data.leg1Reset;
+      pSession->_fax.data()._leg2Reset = record.fax.data.leg2Reset;
+      pSession->_fax.data()._isStarted = record.fax.data.isStarted;
+      pSession->_fax.data()._isInactive = record.fax.data.isInactive;
+      pSession->_fax.data()._isLeg1XOREncrypted = record.fax.data.isLeg1XOREncrypted;
+      pSession->_fax.data()._isLeg2XOREncrypted = record.fax.data.isLeg2XOREncrypted;
+      if (!pSession->_fax.data().open(localEndPointLeg1, localEndPointLeg2))
       {
-        OSS::Net::IPAddress localEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.fax.data.localEndPointLeg1.c_str());
-        OSS::Net::IPAddress localEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.fax.data.localEndPointLeg2.c_str());
-        OSS::Net::IPAddress senderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.fax.data.senderEndPointLeg1.c_str());
-        OSS::Net::IPAddress senderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.fax.data.senderEndPointLeg2.c_str());
-        OSS::Net::IPAddress lastSenderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.fax.data.lastSenderEndPointLeg1.c_str());
-        OSS::Net::IPAddress lastSenderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.fax.data.lastSenderEndPointLeg2.c_str());
-
-        pSession->_fax.data()._senderEndPointLeg1 =
-          boost::asio::ip::udp::endpoint(senderEndPointLeg1.address(), senderEndPointLeg1.getPort());
-        pSession->_fax.data()._senderEndPointLeg2 =
-          boost::asio::ip::udp::endpoint(senderEndPointLeg2.address(), senderEndPointLeg2.getPort());
-
-        pSession->_fax.data()._lastSenderEndPointLeg1 =
-          boost::asio::ip::udp::endpoint(lastSenderEndPointLeg1.address(), lastSenderEndPointLeg1.getPort());
-        pSession->_fax.data()._lastSenderEndPointLeg2 =
-          boost::asio::ip::udp::endpoint(lastSenderEndPointLeg2.address(), lastSenderEndPointLeg2.getPort());
-
-        pSession->_fax.data()._adjustSenderFromPacketSource = record.fax.data.adjustSenderFromPacketSource;
-        pSession->_fax.data()._leg1Reset = record.fax.data.leg1Reset;
-        pSession->_fax.data()._leg2Reset = record.fax.data.leg2Reset;
-        pSession->_fax.data()._isStarted = record.fax.data.isStarted;
-        pSession->_fax.data()._isInactive = record.fax.data.isInactive;
-        pSession->_fax.data()._isLeg1XOREncrypted = record.fax.data.isLeg1XOREncrypted;
-        pSession->_fax.data()._isLeg2XOREncrypted = record.fax.data.isLeg2XOREncrypted;
-        if (!pSession->_fax.data().open(localEndPointLeg1, localEndPointLeg2))
-        {
-          delete pSession;
-          return RTPProxySession::Ptr();
-        }
-        pSession->_fax.data().start();
+        delete pSession;
+        return RTPProxySession::Ptr();
       }
-
-      pSession->_fax.control()._identifier = record.fax.control.identifier;
+      pSession->_fax.data().start();
+    }
+
+    pSession->_fax.control()._identifier = record.fax.control.identifier;
+    {
+      OSS::Net::IPAddress localEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.fax.control.localEndPointLeg1.c_str());
+      OSS::Net::IPAddress localEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.fax.control.localEndPointLeg2.c_str());
+      OSS::Net::IPAddress senderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.fax.control.senderEndPointLeg1.c_str());
+      OSS::Net::IPAddress senderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.fax.control.senderEndPointLeg2.c_str());
+      OSS::Net::IPAddress lastSenderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.fax.control.lastSenderEndPointLeg1.c_str());
+      OSS::Net::IPAddress lastSenderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.fax.control.lastSenderEndPointLeg2.c_str());
+
+      pSession->_fax.control()._senderEndPointLeg1 =
+        boost::asio::ip::udp::endpoint(senderEndPointLeg1.address(), senderEndPointLeg1.getPort());
+      pSession->_fax.control()._senderEndPointLeg2 =
+        boost::asio::ip::udp::endpoint(senderEndPointLeg2.address(), senderEndPointLeg2.getPort());
+
+      pSession->_fax.control()._lastSenderEndPointLeg1 =
+        boost::asio::ip::udp::endpoint(lastSenderEndPointLeg1.address(), lastSenderEndPointLeg1.getPort());
+      pSession->_fax.control()._lastSenderEndPointLeg2 =
+        boost::asio::ip::udp::endpoint(lastSenderEndPointLeg2.address(), lastSenderEndPointLeg2.getPort());
+
+      pSession->_fax.control()._adjustSenderFromPacketSource = record.fax.control.adjustSenderFromPacketSource;
+      pSession->_fax.control()._leg1Reset = record.fax.control.leg1Reset;
+      pSession->_fax.control()._leg2Reset = record.fax.control.leg2Reset;
+      pSession->_fax.control()._isStarted = record.fax.control.isStarted;
+      pSession->_fax.control()._isInactive = record.fax.control.isInactive;
+      pSession->_fax.control()._isLeg1XOREncrypted = record.fax.control.isLeg1XOREncrypted;
+      pSession->_fax.control()._isLeg2XOREncrypted = record.fax.control.isLeg2XOREncrypted;
+      if (!pSession->_fax.control().open(localEndPointLeg1, localEndPointLeg2))
       {
-        OSS::Net::IPAddress localEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.fax.control.localEndPointLeg1.c_str());
-        OSS::Net::IPAddress localEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.fax.control.localEndPointLeg2.c_str());
-        OSS::Net::IPAddress senderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.fax.control.senderEndPointLeg1.c_str());
-        OSS::Net::IPAddress senderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.fax.control.senderEndPointLeg2.c_str());
-        OSS::Net::IPAddress lastSenderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.fax.control.lastSenderEndPointLeg1.c_str());
-        OSS::Net::IPAddress lastSenderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.fax.control.lastSenderEndPointLeg2.c_str());
-
-        pSession->_fax.control()._senderEndPointLeg1 =
-          boost::asio::ip::udp::endpoint(senderEndPointLeg1.address(), senderEndPointLeg1.getPort());
-        pSession->_fax.control()._senderEndPointLeg2 =
-          boost::asio::ip::udp::endpoint(senderEndPointLeg2.address(), senderEndPointLeg2.getPort());
-
-        pSession->_fax.control()._lastSenderEndPointLeg1 =
-          boost::asio::ip::udp::endpoint(lastSenderEndPointLeg1.address(), lastSenderEndPointLeg1.getPort());
-        pSession->_fax.control()._lastSenderEndPointLeg2 =
-          boost::asio::ip::udp::endpoint(lastSenderEndPointLeg2.address(), lastSenderEndPointLeg2.getPort());
-
-        pSession->_fax.control()._adjustSenderFromPacketSource = record.fax.control.adjustSenderFromPacketSource;
-        pSession->_fax.control()._leg1Reset = record.fax.control.leg1Reset;
-        pSession->_fax.control()._leg2Reset = record.fax.control.leg2Reset;
-        pSession->_fax.control()._isStarted = record.fax.control.isStarted;
-        pSession->_fax.control()._isInactive = record.fax.control.isInactive;
-        pSession->_fax.control()._isLeg1XOREncrypted = record.fax.control.isLeg1XOREncrypted;
-        pSession->_fax.control()._isLeg2XOREncrypted = record.fax.control.isLeg2XOREncrypted;
-        if (!pSession->_fax.control().open(localEndPointLeg1, localEndPointLeg2))
-        {
-          delete pSession;
-          return RTPProxySession::Ptr();
-        }
-        pSession->_fax.control().start();
+        delete pSession;
+        return RTPProxySession::Ptr();
       }
+      pSession->_fax.control().start();
     }
   }
+  pSession->reservePorts();
   return RTPProxySession::Ptr(pSession);
 }
-#endif
 
 #if ENABLE_FEATURE_CONFIG
 RTPProxySession::Ptr RTPProxySession::reconstructFromStateFile(
@@ -2894,6 +2972,7 @@ RTPProxySession::Ptr RTPProxySession::reconstructFromStateFile(
     return RTPProxySession::Ptr();
   }
 
+  pSession->reservePorts();
   return RTPProxySession::Ptr(pSession);
 }
 #endif
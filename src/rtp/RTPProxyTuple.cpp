@@ -32,7 +32,9 @@ RTPProxyTuple::RTPProxyTuple(RTPProxyManager* pManager, RTPProxySession* pSessio
   _control(new RTPProxy(RTPProxy::Control, pManager, pSession, identifier + "-control", isXORDisabled)),//TODO:magic value
   _identifier(identifier),
   _pManager(pManager),
-  _pSession(pSession)
+  _pSession(pSession),
+  _leg1DataPort(0),
+  _leg2DataPort(0)
 {
   
 }
@@ -49,25 +51,55 @@ bool RTPProxyTuple::open(
   OSS::Net::IPAddress& leg1ControlListener,
   OSS::Net::IPAddress& leg2ControlListener)
 {
-	 //TODO:document how retry is calculated
+  //
+  // Ports handed out by the manager are not held by any live session.  A
+  // bind can still fail if another process took the port, so retry with
+  // fresh ports a bounded number of times.
+  //
   int retry = (_pManager->getUDPPortMax() - _pManager->getUDPPortBase()) / 2;
-  
+
+  releasePorts();
   for (int i = 0; i < retry; i++)
   {
-    unsigned short leg1DataPort = _pManager->getNextAvailablePortTuple();
-    unsigned short leg2DataPort = _pManager->getNextAvailablePortTuple();
-    leg1DataListener.setPort(leg1DataPort);
-    leg1ControlListener.setPort(leg1DataPort + 1);
-    leg2DataListener.setPort(leg2DataPort);
-    leg2ControlListener.setPort(leg2DataPort + 1);
+    _leg1DataPort = _pManager->getNextAvailablePortTuple();
+    _leg2DataPort = _pManager->getNextAvailablePortTuple();
+    if (!_leg1DataPort || !_leg2DataPort)
+    {
+      releasePorts();
+      return false;
+    }
+    leg1DataListener.setPort(_leg1DataPort);
+    leg1ControlListener.setPort(_leg1DataPort + 1);
+    leg2DataListener.setPort(_leg2DataPort);
+    leg2ControlListener.setPort(_leg2DataPort + 1);
     if (_data->open(leg1DataListener, leg2DataListener) &&_control->open(leg1ControlListener, leg2ControlListener))
       return true;
     _data->stop();
     _control->stop();
+    releasePorts();
   }
   return false;
 }
 
+void RTPProxyTuple::reservePorts(unsigned short leg1DataPort, unsigned short leg2DataPort)
+{
+  releasePorts();
+  if (_pManager->reservePortTuple(leg1DataPort))
+    _leg1DataPort = leg1DataPort;
+  if (_pManager->reservePortTuple(leg2DataPort))
+    _leg2DataPort = leg2DataPort;
+}
+
+void RTPProxyTuple::releasePorts()
+{
+  if (_leg1DataPort)
+    _pManager->releasePortTuple(_leg1DataPort);
+  if (_leg2DataPort)
+    _pManager->releasePortTuple(_leg2DataPort);
+  _leg1DataPort = 0;
+  _leg2DataPort = 0;
+}
+
 void RTPProxyTuple::start()
 {
   OSS_LOG_INFO(_pSession->logId() << "RTP Session" << _identifier << " STARTED");
@@ -79,6 +111,13 @@ void RTPProxyTuple::stop()
 {
   _data->close();
   _control->close();
+  releasePorts();
+}
+
+void RTPProxyTuple::setICECredentials(int legIndex, const std::string& localUserFragment, const std::string& password)
+{
+  _data->setICECredentials(legIndex, localUserFragment, password);
+  _control->setICECredentials(legIndex, localUserFragment, password);
 }
 
 
@@ -0,0 +1,613 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include "OSS/RTP/RTPSessionTable.h"
+
+#if ENABLE_FEATURE_RTP
+
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <boost/asio/ip/address.hpp>
+#include <boost/static_assert.hpp>
+#include "OSS/Net/IPEndPoint.h"
+#include "OSS/UTL/CoreUtils.h"
+#include "OSS/UTL/Logger.h"
+
+
+namespace OSS {
+namespace RTP {
+
+
+using OSS::Net::IPEndPoint;
+
+static const char RTP_SESSION_TABLE_MAGIC[8] = { 'O', 'S', 'S', 'R', 'T', 'P', 'T', 'B' };
+static const OSS::UInt32 RTP_SESSION_TABLE_VERSION = 1;
+
+enum SessionFlags
+{
+  EXPECTING_INITIAL_ANSWER = 0x0001,
+  OFFERED_AUDIO = 0x0002,
+  OFFERED_VIDEO = 0x0004,
+  OFFERED_FAX = 0x0008,
+  NEGOTIATED_AUDIO = 0x0010,
+  NEGOTIATED_VIDEO = 0x0020,
+  NEGOTIATED_FAX = 0x0040,
+  VERBOSE = 0x0080
+};
+
+enum MediaFlags
+{
+  ADJUST_SENDER = 0x01,
+  LEG1_RESET = 0x02,
+  LEG2_RESET = 0x04,
+  STARTED = 0x08,
+  INACTIVE = 0x10,
+  LEG1_XOR = 0x20,
+  LEG2_XOR = 0x40
+};
+
+enum MediaIndex
+{
+  AUDIO_DATA,
+  AUDIO_CONTROL,
+  VIDEO_DATA,
+  VIDEO_CONTROL,
+  FAX_DATA,
+  FAX_CONTROL,
+  MEDIA_COUNT
+};
+
+static const char* MEDIA_SUFFIX[MEDIA_COUNT] =
+{
+  "-audio-data",
+  "-audio-control",
+  "-video-data",
+  "-video-control",
+  "-fax-data",
+  "-fax-control"
+};
+
+struct SessionMedia
+{
+  IPEndPoint localEndPointLeg1;
+  IPEndPoint localEndPointLeg2;
+  IPEndPoint senderEndPointLeg1;
+  IPEndPoint senderEndPointLeg2;
+  IPEndPoint lastSenderEndPointLeg1;
+  IPEndPoint lastSenderEndPointLeg2;
+  OSS::UInt32 flags;
+  OSS::UInt32 reserved;
+};
+
+struct SessionFields
+{
+  OSS::UInt32 sequence;
+    /// Odd while the slot is being written
+  OSS::UInt32 inUse;
+  OSS::UInt64 timestamp;
+  OSS::Int32 state;
+  OSS::Int32 lastOfferIndex;
+  OSS::UInt32 flags;
+  OSS::UInt32 sdpHash;
+  OSS::UInt32 sdpLength;
+  OSS::UInt32 reserved;
+  char identifier[256];
+  char logId[128];
+  char leg1Identifier[64];
+  char leg2Identifier[64];
+  char leg1OriginAddress[64];
+  char leg2OriginAddress[64];
+  SessionMedia media[MEDIA_COUNT];
+};
+
+struct RTPSessionTable::Header
+{
+  char magic[8];
+  OSS::UInt32 version;
+  OSS::UInt32 slotSize;
+  OSS::UInt32 slotCount;
+  OSS::UInt32 reserved;
+};
+
+struct RTPSessionTable::Slot
+{
+  SessionFields fields;
+  char sdp[RTPSessionTable::SLOT_SIZE - sizeof(SessionFields)];
+    /// The last SDP received in an ACK
+};
+
+
+static OSS::UInt32 sdp_hash(const char* data, std::size_t size)
+{
+  //
+  // FNV-1a.  Only used to detect a torn or truncated SDP copy.
+  //
+  OSS::UInt32 hash = 2166136261u;
+  for (std::size_t i = 0; i < size; i++)
+  {
+    hash ^= (unsigned char)data[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static bool copy_field(char* field, std::size_t size, const std::string& value)
+{
+  if (value.size() >= size)
+  {
+    return false;
+  }
+  std::memcpy(field, value.data(), value.size());
+  std::memset(field + value.size(), 0, size - value.size());
+  return true;
+}
+
+static std::string field_string(const char* field, std::size_t size)
+{
+  return std::string(field, strnlen(field, size));
+}
+
+static void endpoint_from_string(const std::string& value, IPEndPoint& endpoint)
+{
+  //
+  // Records hold endpoints as address:port strings, the format written by
+  // RTPProxySession::toRecord().  Interned names are process-local and are
+  // left empty.
+  //
+  endpoint.clear();
+  std::size_t colon = value.rfind(':');
+  if (colon == std::string::npos)
+  {
+    return;
+  }
+
+  boost::system::error_code error;
+  boost::asio::ip::address address = boost::asio::ip::address::from_string(value.substr(0, colon), error);
+  if (error)
+  {
+    return;
+  }
+
+  if (address.is_v4())
+  {
+    boost::asio::ip::address_v4::bytes_type bytes = address.to_v4().to_bytes();
+    std::memcpy(endpoint.address, bytes.data(), bytes.size());
+    endpoint.family = IPEndPoint::V4;
+  }
+  else
+  {
+    boost::asio::ip::address_v6 v6 = address.to_v6();
+    boost::asio::ip::address_v6::bytes_type bytes = v6.to_bytes();
+    std::memcpy(endpoint.address, bytes.data(), bytes.size());
+    endpoint.scopeId = (OSS::UInt32)v6.scope_id();
+    endpoint.family = IPEndPoint::V6;
+  }
+  endpoint.port = OSS::string_to_number<unsigned short>(value.substr(colon + 1).c_str());
+}
+
+static std::string endpoint_to_string(const IPEndPoint& endpoint)
+{
+  boost::asio::ip::address address;
+  if (endpoint.isV4())
+  {
+    boost::asio::ip::address_v4::bytes_type bytes;
+    std::memcpy(bytes.data(), endpoint.address, bytes.size());
+    address = boost::asio::ip::address_v4(bytes);
+  }
+  else if (endpoint.isV6())
+  {
+    boost::asio::ip::address_v6::bytes_type bytes;
+    std::memcpy(bytes.data(), endpoint.address, bytes.size());
+    address = boost::asio::ip::address_v6(bytes, endpoint.scopeId);
+  }
+  else
+  {
+    return std::string();
+  }
+
+  std::ostringstream strm;
+  strm << address.to_string() << ":" << endpoint.port;
+  return strm.str();
+}
+
+static void media_to_slot(const SBCMediaRecord& record, SessionMedia& media)
+{
+  endpoint_from_string(record.localEndPointLeg1, media.localEndPointLeg1);
+  endpoint_from_string(record.localEndPointLeg2, media.localEndPointLeg2);
+  endpoint_from_string(record.senderEndPointLeg1, media.senderEndPointLeg1);
+  endpoint_from_string(record.senderEndPointLeg2, media.senderEndPointLeg2);
+  endpoint_from_string(record.lastSenderEndPointLeg1, media.lastSenderEndPointLeg1);
+  endpoint_from_string(record.lastSenderEndPointLeg2, media.lastSenderEndPointLeg2);
+  media.flags =
+    (record.adjustSenderFromPacketSource ? ADJUST_SENDER : 0) |
+    (record.leg1Reset ? LEG1_RESET : 0) |
+    (record.leg2Reset ? LEG2_RESET : 0) |
+    (record.isStarted ? STARTED : 0) |
+    (record.isInactive ? INACTIVE : 0) |
+    (record.isLeg1XOREncrypted ? LEG1_XOR : 0) |
+    (record.isLeg2XOREncrypted ? LEG2_XOR : 0);
+  media.reserved = 0;
+}
+
+static void media_from_slot(const SessionMedia& media, const std::string& identifier, SBCMediaRecord& record)
+{
+  record.identifier = identifier;
+  record.localEndPointLeg1 = endpoint_to_string(media.localEndPointLeg1);
+  record.localEndPointLeg2 = endpoint_to_string(media.localEndPointLeg2);
+  record.senderEndPointLeg1 = endpoint_to_string(media.senderEndPointLeg1);
+  record.senderEndPointLeg2 = endpoint_to_string(media.senderEndPointLeg2);
+  record.lastSenderEndPointLeg1 = endpoint_to_string(media.lastSenderEndPointLeg1);
+  record.lastSenderEndPointLeg2 = endpoint_to_string(media.lastSenderEndPointLeg2);
+  record.adjustSenderFromPacketSource = !!(media.flags & ADJUST_SENDER);
+  record.leg1Reset = !!(media.flags & LEG1_RESET);
+  record.leg2Reset = !!(media.flags & LEG2_RESET);
+  record.isStarted = !!(media.flags & STARTED);
+  record.isInactive = !!(media.flags & INACTIVE);
+  record.isLeg1XOREncrypted = !!(media.flags & LEG1_XOR);
+  record.isLeg2XOREncrypted = !!(media.flags & LEG2_XOR);
+}
+
+
+RTPSessionTable::RTPSessionTable() :
+  _pMap(0),
+  _mapSize(0),
+  _pHeader(0)
+{
+}
+
+RTPSessionTable::~RTPSessionTable()
+{
+  close();
+}
+
+bool RTPSessionTable::open(const boost::filesystem::path& file, std::size_t capacity)
+{
+  BOOST_STATIC_ASSERT(sizeof(Slot) == SLOT_SIZE);
+
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  if (_pMap)
+  {
+    return false;
+  }
+
+  if (!capacity)
+  {
+    capacity = DEFAULT_CAPACITY;
+  }
+
+  std::string path = OSS::boost_path(file);
+  int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0600);
+  if (fd == -1)
+  {
+    OSS_LOG_ERROR("RTPSessionTable::open " << path << " failed: " << strerror(errno));
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) == -1)
+  {
+    OSS_LOG_ERROR("RTPSessionTable::open " << path << " fstat failed: " << strerror(errno));
+    ::close(fd);
+    return false;
+  }
+
+  //
+  // Keep the slot count of an existing table if it is larger.  Slots are
+  // page sized and the header takes the first page.
+  //
+  std::size_t existingSlots = 0;
+  if ((std::size_t)st.st_size >= SLOT_SIZE)
+  {
+    Header header;
+    if (::pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) &&
+      std::memcmp(header.magic, RTP_SESSION_TABLE_MAGIC, sizeof(header.magic)) == 0 &&
+      header.version == RTP_SESSION_TABLE_VERSION &&
+      header.slotSize == SLOT_SIZE &&
+      (std::size_t)st.st_size >= (header.slotCount + 1) * (std::size_t)SLOT_SIZE)
+    {
+      existingSlots = header.slotCount;
+    }
+    else
+    {
+      OSS_LOG_WARNING("RTPSessionTable::open " << path << " has an unrecognized layout.  Starting with an empty table.");
+      if (ftruncate(fd, 0) == -1)
+      {
+        OSS_LOG_ERROR("RTPSessionTable::open " << path << " ftruncate failed: " << strerror(errno));
+        ::close(fd);
+        return false;
+      }
+    }
+  }
+
+  std::size_t slotCount = std::max(existingSlots, capacity);
+  std::size_t mapSize = (slotCount + 1) * (std::size_t)SLOT_SIZE;
+  if ((std::size_t)st.st_size < mapSize && ftruncate(fd, mapSize) == -1)
+  {
+    OSS_LOG_ERROR("RTPSessionTable::open " << path << " ftruncate failed: " << strerror(errno));
+    ::close(fd);
+    return false;
+  }
+
+  void* pMap = mmap(0, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (pMap == MAP_FAILED)
+  {
+    OSS_LOG_ERROR("RTPSessionTable::open " << path << " mmap failed: " << strerror(errno));
+    return false;
+  }
+
+  _file = file;
+  _pMap = (char*)pMap;
+  _mapSize = mapSize;
+  _pHeader = (Header*)_pMap;
+  std::memcpy(_pHeader->magic, RTP_SESSION_TABLE_MAGIC, sizeof(_pHeader->magic));
+  _pHeader->version = RTP_SESSION_TABLE_VERSION;
+  _pHeader->slotSize = SLOT_SIZE;
+  _pHeader->slotCount = (OSS::UInt32)slotCount;
+
+  //
+  // Index what the previous process left behind.  Walking the slots only
+  // reads memory, so this is fast even for a full table.
+  //
+  _index.clear();
+  _freeSlots.clear();
+  std::size_t torn = 0;
+  for (OSS::UInt32 i = (OSS::UInt32)slotCount; i > 0; i--)
+  {
+    Slot* pSlot = slot(i - 1);
+    SessionFields& fields = pSlot->fields;
+    if (!fields.inUse)
+    {
+      _freeSlots.push_back(i - 1);
+      continue;
+    }
+
+    if ((fields.sequence & 1) || !fields.identifier[0])
+    {
+      torn++;
+      std::memset((void*)&fields, 0, sizeof(fields));
+      _freeSlots.push_back(i - 1);
+      continue;
+    }
+
+    std::string identifier = field_string(fields.identifier, sizeof(fields.identifier));
+    if (!_index.insert(Index::value_type(identifier, i - 1)).second)
+    {
+      std::memset((void*)&fields, 0, sizeof(fields));
+      _freeSlots.push_back(i - 1);
+    }
+  }
+
+  if (torn)
+  {
+    OSS_LOG_WARNING("RTPSessionTable::open " << path << " discarded " << torn << " partially written sessions");
+  }
+  OSS_LOG_INFO("RTPSessionTable::open " << path << " attached with " << _index.size() << " sessions in " << slotCount << " slots");
+  return true;
+}
+
+void RTPSessionTable::close()
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  if (_pMap)
+  {
+    munmap(_pMap, _mapSize);
+    _pMap = 0;
+    _pHeader = 0;
+    _mapSize = 0;
+  }
+  _index.clear();
+  _freeSlots.clear();
+}
+
+bool RTPSessionTable::isOpen() const
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  return _pMap != 0;
+}
+
+bool RTPSessionTable::store(const RTPProxyRecord& record)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  if (!_pMap || record.identifier.empty())
+  {
+    return false;
+  }
+
+  OSS::UInt32 index = 0;
+  Index::iterator iter = _index.find(record.identifier);
+  if (iter != _index.end())
+  {
+    index = iter->second;
+  }
+  else if (_freeSlots.empty())
+  {
+    OSS_LOG_WARNING("RTPSessionTable::store - Table is full.  Session " << record.identifier << " will not be recoverable.");
+    return false;
+  }
+  else
+  {
+    index = _freeSlots.back();
+  }
+
+  Slot* pSlot = slot(index);
+  SessionFields& fields = pSlot->fields;
+
+  //
+  // Mark the slot as being written.  A restart that finds an odd sequence
+  // knows the copy below did not finish.
+  //
+  OSS::UInt32 sequence = fields.sequence | 1;
+  __atomic_store_n(&fields.sequence, sequence, __ATOMIC_RELEASE);
+
+  bool ok = copy_field(fields.identifier, sizeof(fields.identifier), record.identifier) &&
+    copy_field(fields.logId, sizeof(fields.logId), record.logId) &&
+    copy_field(fields.leg1Identifier, sizeof(fields.leg1Identifier), record.leg1Identifier) &&
+    copy_field(fields.leg2Identifier, sizeof(fields.leg2Identifier), record.leg2Identifier) &&
+    copy_field(fields.leg1OriginAddress, sizeof(fields.leg1OriginAddress), record.leg1OriginAddress) &&
+    copy_field(fields.leg2OriginAddress, sizeof(fields.leg2OriginAddress), record.leg2OriginAddress);
+
+  if (!ok)
+  {
+    OSS_LOG_WARNING("RTPSessionTable::store - Session " << record.identifier << " has a field too large for a slot");
+    std::memset((void*)&fields, 0, sizeof(fields));
+    if (iter != _index.end())
+    {
+      _index.erase(iter);
+      _freeSlots.push_back(index);
+    }
+    return false;
+  }
+
+  fields.inUse = 1;
+  fields.timestamp = OSS::getTime();
+  fields.state = record.state;
+  fields.lastOfferIndex = record.lastOfferIndex;
+  fields.flags =
+    (record.isExpectingInitialAnswer ? EXPECTING_INITIAL_ANSWER : 0) |
+    (record.hasOfferedAudioProxy ? OFFERED_AUDIO : 0) |
+    (record.hasOfferedVideoProxy ? OFFERED_VIDEO : 0) |
+    (record.hasOfferedFaxProxy ? OFFERED_FAX : 0) |
+    (record.isAudioProxyNegotiated ? NEGOTIATED_AUDIO : 0) |
+    (record.isVideoProxyNegotiated ? NEGOTIATED_VIDEO : 0) |
+    (record.isFaxProxyNegotiated ? NEGOTIATED_FAX : 0) |
+    (record.verbose ? VERBOSE : 0);
+
+  media_to_slot(record.audio.data, fields.media[AUDIO_DATA]);
+  media_to_slot(record.audio.control, fields.media[AUDIO_CONTROL]);
+  media_to_slot(record.video.data, fields.media[VIDEO_DATA]);
+  media_to_slot(record.video.control, fields.media[VIDEO_CONTROL]);
+  media_to_slot(record.fax.data, fields.media[FAX_DATA]);
+  media_to_slot(record.fax.control, fields.media[FAX_CONTROL]);
+
+  //
+  // An SDP that does not fit keeps only its hash and length.  It is
+  // dropped on recovery instead of being restored truncated.
+  //
+  fields.sdpLength = (OSS::UInt32)record.lastSDPInAck.size();
+  fields.sdpHash = sdp_hash(record.lastSDPInAck.data(), record.lastSDPInAck.size());
+  std::memcpy(pSlot->sdp, record.lastSDPInAck.data(), std::min(record.lastSDPInAck.size(), sizeof(pSlot->sdp)));
+
+  __atomic_store_n(&fields.sequence, sequence + 1, __ATOMIC_RELEASE);
+
+  if (iter == _index.end())
+  {
+    _freeSlots.pop_back();
+    _index[record.identifier] = index;
+  }
+  return true;
+}
+
+bool RTPSessionTable::remove(const std::string& identifier)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  if (!_pMap)
+  {
+    return false;
+  }
+
+  Index::iterator iter = _index.find(identifier);
+  if (iter == _index.end())
+  {
+    return false;
+  }
+
+  SessionFields& fields = slot(iter->second)->fields;
+  __atomic_store_n(&fields.inUse, 0, __ATOMIC_RELEASE);
+  _freeSlots.push_back(iter->second);
+  _index.erase(iter);
+  return true;
+}
+
+std::size_t RTPSessionTable::load(std::vector<RTPProxyRecord>& records) const
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  std::size_t count = 0;
+  records.reserve(records.size() + _index.size());
+  for (Index::const_iterator iter = _index.begin(); iter != _index.end(); iter++)
+  {
+    const Slot* pSlot = slot(iter->second);
+    const SessionFields& fields = pSlot->fields;
+
+    records.push_back(RTPProxyRecord());
+    RTPProxyRecord& record = records.back();
+    record.identifier = iter->first;
+    record.logId = field_string(fields.logId, sizeof(fields.logId));
+    record.leg1Identifier = field_string(fields.leg1Identifier, sizeof(fields.leg1Identifier));
+    record.leg2Identifier = field_string(fields.leg2Identifier, sizeof(fields.leg2Identifier));
+    record.leg1OriginAddress = field_string(fields.leg1OriginAddress, sizeof(fields.leg1OriginAddress));
+    record.leg2OriginAddress = field_string(fields.leg2OriginAddress, sizeof(fields.leg2OriginAddress));
+    record.isExpectingInitialAnswer = !!(fields.flags & EXPECTING_INITIAL_ANSWER);
+    record.hasOfferedAudioProxy = !!(fields.flags & OFFERED_AUDIO);
+    record.hasOfferedVideoProxy = !!(fields.flags & OFFERED_VIDEO);
+    record.hasOfferedFaxProxy = !!(fields.flags & OFFERED_FAX);
+    record.isAudioProxyNegotiated = !!(fields.flags & NEGOTIATED_AUDIO);
+    record.isVideoProxyNegotiated = !!(fields.flags & NEGOTIATED_VIDEO);
+    record.isFaxProxyNegotiated = !!(fields.flags & NEGOTIATED_FAX);
+    record.verbose = !!(fields.flags & VERBOSE);
+    record.state = fields.state;
+    record.lastOfferIndex = fields.lastOfferIndex;
+    record.timestamp = fields.timestamp;
+
+    media_from_slot(fields.media[AUDIO_DATA], iter->first + MEDIA_SUFFIX[AUDIO_DATA], record.audio.data);
+    media_from_slot(fields.media[AUDIO_CONTROL], iter->first + MEDIA_SUFFIX[AUDIO_CONTROL], record.audio.control);
+    media_from_slot(fields.media[VIDEO_DATA], iter->first + MEDIA_SUFFIX[VIDEO_DATA], record.video.data);
+    media_from_slot(fields.media[VIDEO_CONTROL], iter->first + MEDIA_SUFFIX[VIDEO_CONTROL], record.video.control);
+    media_from_slot(fields.media[FAX_DATA], iter->first + MEDIA_SUFFIX[FAX_DATA], record.fax.data);
+    media_from_slot(fields.media[FAX_CONTROL], iter->first + MEDIA_SUFFIX[FAX_CONTROL], record.fax.control);
+
+    if (fields.sdpLength <= sizeof(pSlot->sdp) && sdp_hash(pSlot->sdp, fields.sdpLength) == fields.sdpHash)
+    {
+      record.lastSDPInAck.assign(pSlot->sdp, fields.sdpLength);
+    }
+    else
+    {
+      OSS_LOG_WARNING("RTPSessionTable::load - Pending ACK SDP for " << iter->first << " was not kept (" << fields.sdpLength << " bytes)");
+    }
+    count++;
+  }
+  return count;
+}
+
+std::size_t RTPSessionTable::size() const
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  return _index.size();
+}
+
+std::size_t RTPSessionTable::capacity() const
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  return _pHeader ? _pHeader->slotCount : 0;
+}
+
+RTPSessionTable::Slot* RTPSessionTable::slot(OSS::UInt32 index) const
+{
+  return (Slot*)(_pMap + (index + 1) * (std::size_t)SLOT_SIZE);
+}
+
+
+} } // OSS::RTP
+
+#endif // ENABLE_FEATURE_RTP
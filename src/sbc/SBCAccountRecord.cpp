@@ -176,7 +176,7 @@ bool SBCAccountRecord::computeAuthenticateChallengeHeader(const std::string& cal
   std::string nonce;
   if (forceNonce.empty())
   {
-    nonce = SIPDigestAuth::digestCreateNonce(callId);
+    nonce = SIPDigestAuth::digestCreateSignedNonce(callId);
   }
   else
   {
@@ -33,6 +33,7 @@ namespace SBC {
   
   
 SBCAccounts::SBCAccounts() :
+  _accountCache(ACCOUNT_CACHE_EXPIRE_MS),
   _hasDeterminedRealms(false)
 {
 }
@@ -99,12 +100,23 @@ bool SBCAccounts::findAccount(const std::string& identity, SBCAccountRecord& acc
     }
   }
   
+  if (_accountCache.get(identity, account))
+  {
+    return true;
+  }
+  
   if (!_workspace || !account.readFromWorkSpace(_workspace, identity))
   {
     return false;
   }
   
-  return account.isValid();
+  if (!account.isValid())
+  {
+    return false;
+  }
+  
+  _accountCache.add(identity, account);
+  return true;
 }
 
 bool SBCAccounts::addAccount(SBCAccountRecord& account)
@@ -126,11 +138,38 @@ bool SBCAccounts::addAccount(SBCAccountRecord& account)
     OSS_LOG_ERROR("SBCAccounts::addAccount - Unable to store account to workspace");
     return false;
   }
+  _accountCache.add(account.getIdentity(), account);
   OSS::mutex_critic_sec_lock lock(_volatileAccountsMutex);
   _realms.insert(account.getRealm());
   return true;
 }
 
+bool SBCAccounts::removeAccount(const std::string& identity)
+{
+  //
+  // Drop the cached copy even if the delete fails so that the next lookup
+  // reflects whatever the workspace holds
+  //
+  _accountCache.remove(identity);
+  if (!_workspace)
+  {
+    OSS_LOG_ERROR("SBCAccounts::removeAccount - Workspace is not set");
+    return false;
+  }
+  
+  if (!_workspace->del(identity))
+  {
+    OSS_LOG_ERROR("SBCAccounts::removeAccount - Unable to delete account " << identity << " from workspace");
+    return false;
+  }
+  return true;
+}
+
+void SBCAccounts::invalidateAccount(const std::string& identity)
+{
+  _accountCache.remove(identity);
+}
+
 bool SBCAccounts::addVolatileAccount(SBCAccountRecord& account)
 {
   if (!account.isValid())
@@ -143,6 +182,12 @@ bool SBCAccounts::addVolatileAccount(SBCAccountRecord& account)
   return true;
 }
 
+bool SBCAccounts::removeVolatileAccount(const std::string& identity)
+{
+  OSS::mutex_critic_sec_lock lock(_volatileAccountsMutex);
+  return _volatileAccounts.erase(identity) > 0;
+}
+
 void SBCAccounts::addRealm(const std::string& realm)
 {
   OSS::mutex_critic_sec_lock lock(_volatileAccountsMutex);
@@ -83,7 +83,8 @@ SIPMessage::Ptr SBCAuthenticator::onAuthenticateTransaction(
   //
   // There is a local account configured.  Check if it is authenticated.
   //
-  if (!isAuthorized(pRequest, account))
+  bool isStale = false;
+  if (!isAuthorized(pRequest, account, isStale))
   {
     SIPMessage::Ptr pChallengeResponse = pRequest->createResponse(pRequest->isRequest("REGISTER") ?
       SIPMessage::CODE_401_Unauthorized :
@@ -100,6 +101,10 @@ SIPMessage::Ptr SBCAuthenticator::onAuthenticateTransaction(
     //
     SIPAuthorization challenge;
     account.computeAuthenticateChallengeHeader(pRequest->hdrGet(OSS::SIP::HDR_CALL_ID), forceNonce, challenge);
+    if (isStale)
+    {
+      challenge.setAuthParam("stale", "true");
+    }
        
     if (pRequest->isRequest("REGISTER"))
     {
@@ -130,6 +135,13 @@ SIPMessage::Ptr SBCAuthenticator::onAuthenticateTransaction(
 
 bool SBCAuthenticator::isAuthorized(const SIPMessage::Ptr& pRequest, const SBCAccountRecord& record)
 {
+  bool isStale = false;
+  return isAuthorized(pRequest, record, isStale);
+}
+
+bool SBCAuthenticator::isAuthorized(const SIPMessage::Ptr& pRequest, const SBCAccountRecord& record, bool& isStale)
+{
+  isStale = false;
   std::string authorizationHeader;
   
   //
@@ -216,7 +228,39 @@ bool SBCAuthenticator::isAuthorized(const SIPMessage::Ptr& pRequest, const SBCAc
       a2Hash);
   }
   
-  return  digestResponse == authorizationResponse.getDigestResponse();
+  if (digestResponse != authorizationResponse.getDigestResponse())
+  {
+    return false;
+  }
+
+  //
+  // The nonce is checked only after the digest matched so a forged
+  // request cannot advance the nonce count.  Nonces forced by the
+  // application are not ours to validate.
+  //
+  std::string forceNonce;
+  if (pRequest->getProperty("force-nonce", forceNonce) && !forceNonce.empty())
+  {
+    return true;
+  }
+
+  //
+  // Without qop there is no nonce count to check so the nonce is single
+  // use.  The client is re-challenged with stale=true and retries with a
+  // fresh nonce.
+  //
+  std::string callId = pRequest->hdrGet(OSS::SIP::HDR_CALL_ID);
+  SIPDigestAuth::NonceStatus nonceStatus = qop.empty() ?
+    SIPDigestAuth::digestConsumeNonce(nonce, callId) :
+    SIPDigestAuth::digestValidateNonce(nonce, callId, authorizationResponse.getNonceCount());
+  if (nonceStatus != SIPDigestAuth::NONCE_VALID)
+  {
+    OSS_LOG_DEBUG(pRequest->createContextId(true) << "SBCAuthenticator::isAuthorized - Rejecting nonce with status " << nonceStatus);
+    isStale = true;
+    return false;
+  }
+
+  return true;
 }
 
 
@@ -32,6 +32,7 @@
 #include "OSS/UTL/Logger.h"
 #include "OSS/SIP/SBC/SBCManager.h"
 #include "OSS/SIP/SBC/SBCDirectories.h"
+#include "OSS/SIP/SBC/SBCConfiguration.h"
 
 
 namespace OSS {
@@ -77,7 +78,7 @@ static void flush_record(SBCCDRManager* pManager, const std::string& sessionId,
   // Delete the old record and save it as a new key with the date
   //
   pManager->cdr()->del(sessionId);
-  cdr.writeToLogFile(pManager->logger());
+  pManager->pipeline().enqueue(cdr.toCsvString());
  
   
   //
@@ -232,6 +233,75 @@ SBCCDRManager::~SBCCDRManager()
     _pEventQueueThread->join();
     delete _pEventQueueThread;
   }
+  
+  //
+  // Flush pending records while the sinks are still alive
+  //
+  _pipeline.stop();
+}
+
+void SBCCDRManager::initializePipeline()
+{
+  _pipeline.addSink(SBCCDRSink::Ptr(new SBCCDRFileSink(_logger)));
+  
+  const OSS::JSON::Object& userAgent = SBCConfiguration::instance()->userAgent();
+  if (!userAgent.Exists("cdr_pipeline"))
+  {
+    _pipeline.start();
+    return;
+  }
+  
+  try
+  {
+    OSS::JSON::Object config = userAgent["cdr_pipeline"];
+    
+    if (config.Exists("drop_policy"))
+    {
+      OSS::JSON::String policy = config["drop_policy"];
+      unsigned int blockTimeout = 100;
+      if (config.Exists("block_timeout_ms"))
+      {
+        OSS::JSON::Number timeout = config["block_timeout_ms"];
+        blockTimeout = (unsigned int)timeout.Value();
+      }
+      _pipeline.setDropPolicy(policy.Value() == "block" ? SBCCDRPipeline::BLOCK : SBCCDRPipeline::DROP_NEWEST, blockTimeout);
+    }
+    
+    if (config.Exists("redis"))
+    {
+      OSS::JSON::Object redis = config["redis"];
+      OSS::JSON::String host = redis["host"];
+      OSS::JSON::Number port = redis["port"];
+      OSS::JSON::String list = redis["list"];
+      std::string password;
+      int db = 0;
+      if (redis.Exists("password"))
+      {
+        OSS::JSON::String value = redis["password"];
+        password = value.Value();
+      }
+      if (redis.Exists("db"))
+      {
+        OSS::JSON::Number value = redis["db"];
+        db = (int)value.Value();
+      }
+      _pipeline.addSink(SBCCDRSink::Ptr(new SBCCDRRedisSink(host.Value(), (int)port.Value(), password, db, list.Value())));
+      OSS_LOG_NOTICE("SBCCDRManager::initializePipeline - Publishing CDR to redis list " << list.Value());
+    }
+    
+    if (config.Exists("zmq_publisher"))
+    {
+      OSS::JSON::String address = config["zmq_publisher"];
+      _pipeline.addSink(SBCCDRSink::Ptr(new SBCCDRZMQSink(address.Value())));
+      OSS_LOG_NOTICE("SBCCDRManager::initializePipeline - Publishing CDR to " << address.Value());
+    }
+  }
+  catch(const std::exception& e)
+  {
+    OSS_LOG_ERROR("SBCCDRManager::initializePipeline - Invalid cdr_pipeline configuration: " << e.what());
+  }
+  
+  _pipeline.start();
 }
   
 void SBCCDRManager::initialize(SBCManager* pSBCManager)
@@ -248,6 +318,11 @@ void SBCCDRManager::initialize(SBCManager* pSBCManager)
   logFilePath << OSS::SIP::SBC::SBCDirectories::instance()->getLogDirectory() << "/cdr.csv";
   _logger.open(logFilePath.str(), OSS::UTL::LogFile::PRIO_NOTICE, "%t");
   
+  //
+  // Start the asynchronous CDR writer
+  //
+  initializePipeline();
+  
   //
   // Start the event queue
   //
@@ -0,0 +1,382 @@
+
+// OSS Software Solutions Application Programmer Interface
+// Package: Karoo
+// Author: Joegen E. Baclor - mailto:joegen@ossapp.com
+//
+// Copyright (c) OSS Software Solutions
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "OSS Software Solutions OSS API General License Agreement".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include "OSS/SIP/SBC/SBCCDRPipeline.h"
+#include "OSS/UTL/Logger.h"
+
+
+namespace OSS {
+namespace SIP {
+namespace SBC {
+
+
+//
+// File sink
+//
+
+SBCCDRFileSink::SBCCDRFileSink(OSS::UTL::LogFile& logFile) :
+  _logFile(logFile)
+{
+}
+
+const char* SBCCDRFileSink::name() const
+{
+  return "file";
+}
+
+bool SBCCDRFileSink::write(const Batch& batch)
+{
+  for (Batch::const_iterator iter = batch.begin(); iter != batch.end(); iter++)
+  {
+    _logFile.notice(*iter);
+  }
+  return true;
+}
+
+//
+// Redis sink
+//
+
+SBCCDRRedisSink::SBCCDRRedisSink(const std::string& host, int port, const std::string& password, int db, const std::string& listName) :
+  _client(host, port),
+  _password(password),
+  _db(db),
+  _listName(listName),
+  _isConnected(false)
+{
+}
+
+const char* SBCCDRRedisSink::name() const
+{
+  return "redis";
+}
+
+bool SBCCDRRedisSink::write(const Batch& batch)
+{
+  if (!_isConnected)
+  {
+    _isConnected = _client.connect(_password, _db);
+    if (!_isConnected)
+    {
+      return false;
+    }
+  }
+
+  //
+  // One RPUSH carries the whole batch.  The client reconnects on its own
+  // after a dropped connection.
+  //
+  OSS::Persistent::RedisClient::Commands commands(1);
+  OSS::Persistent::RedisClient::Command& args = commands.back();
+  args.reserve(batch.size() + 2);
+  args.push_back("RPUSH");
+  args.push_back(_listName);
+  args.insert(args.end(), batch.begin(), batch.end());
+  return _client.pipeline(commands);
+}
+
+//
+// ZeroMQ sink
+//
+
+SBCCDRZMQSink::SBCCDRZMQSink(const std::string& bindAddress) :
+  _socket(OSS::ZMQ::ZMQSocket::PUB),
+  _bindAddress(bindAddress),
+  _isBound(false)
+{
+}
+
+const char* SBCCDRZMQSink::name() const
+{
+  return "zmq";
+}
+
+bool SBCCDRZMQSink::write(const Batch& batch)
+{
+  if (!_isBound)
+  {
+    _isBound = _socket.bind(_bindAddress);
+    if (!_isBound)
+    {
+      return false;
+    }
+  }
+
+  bool ok = true;
+  for (Batch::const_iterator iter = batch.begin(); iter != batch.end(); iter++)
+  {
+    ok = _socket.publish(*iter) && ok;
+  }
+  return ok;
+}
+
+//
+// Pipeline
+//
+
+SBCCDRPipeline::Metrics::Metrics() :
+  enqueued(0),
+  written(0),
+  dropped(0),
+  batches(0),
+  sinkErrors(0),
+  depth(0),
+  highWatermark(0),
+  capacity(0)
+{
+}
+
+SBCCDRPipeline::SBCCDRPipeline(std::size_t capacity, std::size_t maxBatchSize, unsigned int flushIntervalMs) :
+  _ring(capacity),
+  _maxBatchSize(maxBatchSize),
+  _flushIntervalMs(flushIntervalMs),
+  _dropPolicy(DROP_NEWEST),
+  _blockTimeoutMs(0),
+  _pWriterThread(0),
+  _isTerminating(false),
+  _blockedProducers(0),
+  _enqueued(0),
+  _written(0),
+  _dropped(0),
+  _batches(0),
+  _sinkErrors(0),
+  _highWatermark(0),
+  _lastReportedDrops(0)
+{
+}
+
+SBCCDRPipeline::~SBCCDRPipeline()
+{
+  stop();
+
+  std::string* pRecord = 0;
+  while (_ring.tryDequeue(pRecord))
+  {
+    delete pRecord;
+  }
+}
+
+void SBCCDRPipeline::addSink(const SBCCDRSink::Ptr& pSink)
+{
+  OSS_ASSERT(!_pWriterThread);
+  _sinks.push_back(pSink);
+}
+
+void SBCCDRPipeline::setDropPolicy(DropPolicy policy, unsigned int blockTimeoutMs)
+{
+  _dropPolicy = policy;
+  _blockTimeoutMs = blockTimeoutMs;
+}
+
+bool SBCCDRPipeline::start()
+{
+  if (_pWriterThread)
+  {
+    return false;
+  }
+  _isTerminating = false;
+  _pWriterThread = new boost::thread(boost::bind(&SBCCDRPipeline::run, this));
+  return true;
+}
+
+void SBCCDRPipeline::stop()
+{
+  if (!_pWriterThread)
+  {
+    return;
+  }
+
+  {
+    boost::lock_guard<boost::mutex> lock(_wakeupMutex);
+    _isTerminating = true;
+  }
+  _wakeup.notify_one();
+  _pWriterThread->join();
+  delete _pWriterThread;
+  _pWriterThread = 0;
+}
+
+bool SBCCDRPipeline::enqueue(const std::string& record)
+{
+  std::string* pRecord = new std::string(record);
+  bool queued = _ring.tryEnqueue(pRecord);
+
+  if (!queued && _dropPolicy == BLOCK)
+  {
+    //
+    // Give the writer a chance to catch up.  The wait is bounded so a dead
+    // sink can never hold a signaling thread indefinitely.
+    //
+    _wakeup.notify_one();
+    boost::system_time deadline = boost::get_system_time() + boost::posix_time::milliseconds(_blockTimeoutMs);
+    boost::unique_lock<boost::mutex> lock(_spaceMutex);
+    _blockedProducers.fetch_add(1);
+    while (!(queued = _ring.tryEnqueue(pRecord)))
+    {
+      if (!_space.timed_wait(lock, deadline))
+      {
+        queued = _ring.tryEnqueue(pRecord);
+        break;
+      }
+    }
+    _blockedProducers.fetch_sub(1);
+  }
+
+  if (!queued)
+  {
+    delete pRecord;
+    _dropped.fetch_add(1, boost::memory_order_relaxed);
+    return false;
+  }
+
+  _enqueued.fetch_add(1, boost::memory_order_relaxed);
+
+  std::size_t depth = _ring.size();
+  std::size_t highWatermark = _highWatermark.load(boost::memory_order_relaxed);
+  while (depth > highWatermark && !_highWatermark.compare_exchange_weak(highWatermark, depth, boost::memory_order_relaxed));
+
+  //
+  // Only wake the writer once a full batch is waiting.  Anything smaller
+  // is picked up on the next flush interval.
+  //
+  if (depth >= _maxBatchSize)
+  {
+    _wakeup.notify_one();
+  }
+  return true;
+}
+
+std::size_t SBCCDRPipeline::drain(SBCCDRSink::Batch& batch)
+{
+  std::string* pRecord = 0;
+  while (batch.size() < _maxBatchSize && _ring.tryDequeue(pRecord))
+  {
+    batch.push_back(std::string());
+    batch.back().swap(*pRecord);
+    delete pRecord;
+  }
+
+  //
+  // Producers blocked on a full ring check for room under _spaceMutex, so
+  // taking it here before notifying cannot miss one that is about to wait.
+  //
+  if (!batch.empty() && _blockedProducers.load() > 0)
+  {
+    boost::lock_guard<boost::mutex> lock(_spaceMutex);
+    _space.notify_all();
+  }
+  return batch.size();
+}
+
+void SBCCDRPipeline::flush(SBCCDRSink::Batch& batch)
+{
+  if (batch.empty())
+  {
+    return;
+  }
+
+  bool written = true;
+  for (Sinks::iterator iter = _sinks.begin(); iter != _sinks.end(); iter++)
+  {
+    try
+    {
+      if (!(*iter)->write(batch))
+      {
+        written = false;
+        _sinkErrors.fetch_add(1, boost::memory_order_relaxed);
+        OSS_LOG_ERROR("SBCCDRPipeline::flush - " << (*iter)->name() << " sink failed to write " << batch.size() << " records");
+      }
+    }
+    catch(const std::exception& e)
+    {
+      written = false;
+      _sinkErrors.fetch_add(1, boost::memory_order_relaxed);
+      OSS_LOG_ERROR("SBCCDRPipeline::flush - " << (*iter)->name() << " sink exception: " << e.what());
+    }
+  }
+
+  if (written)
+  {
+    _written.fetch_add(batch.size(), boost::memory_order_relaxed);
+    _batches.fetch_add(1, boost::memory_order_relaxed);
+  }
+  batch.clear();
+}
+
+void SBCCDRPipeline::run()
+{
+  SBCCDRSink::Batch batch;
+  batch.reserve(_maxBatchSize);
+
+  while (true)
+  {
+    while (drain(batch) == _maxBatchSize)
+    {
+      flush(batch);
+    }
+    flush(batch);
+
+    OSS::UInt64 dropped = _dropped.load(boost::memory_order_relaxed);
+    if (dropped != _lastReportedDrops)
+    {
+      OSS_LOG_WARNING("SBCCDRPipeline::run - Queue full.  Dropped " << dropped - _lastReportedDrops
+        << " records (total " << dropped << ", capacity " << _ring.capacity() << ")");
+      _lastReportedDrops = dropped;
+    }
+
+    boost::unique_lock<boost::mutex> lock(_wakeupMutex);
+    if (_isTerminating)
+    {
+      break;
+    }
+    if (_ring.size() < _maxBatchSize)
+    {
+      _wakeup.timed_wait(lock, boost::posix_time::milliseconds(_flushIntervalMs));
+    }
+  }
+
+  //
+  // Flush whatever made it in before we were told to stop
+  //
+  while (drain(batch))
+  {
+    flush(batch);
+  }
+}
+
+SBCCDRPipeline::Metrics SBCCDRPipeline::getMetrics() const
+{
+  Metrics metrics;
+  metrics.enqueued = _enqueued.load(boost::memory_order_relaxed);
+  metrics.written = _written.load(boost::memory_order_relaxed);
+  metrics.dropped = _dropped.load(boost::memory_order_relaxed);
+  metrics.batches = _batches.load(boost::memory_order_relaxed);
+  metrics.sinkErrors = _sinkErrors.load(boost::memory_order_relaxed);
+  metrics.depth = _ring.size();
+  metrics.highWatermark = _highWatermark.load(boost::memory_order_relaxed);
+  metrics.capacity = _ring.capacity();
+  return metrics;
+}
+
+
+} } } // OSS::SIP::SBC
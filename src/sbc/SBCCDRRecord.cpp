@@ -191,6 +191,12 @@ bool SBCCDRRecord::writeToWorkSpace(SBCWorkSpace& ws, const std::string& key, un
 
 bool SBCCDRRecord::writeToLogFile(OSS::UTL::LogFile& logFile)
 {  
+  logFile.notice(toCsvString());
+  return true;
+}
+
+std::string SBCCDRRecord::toCsvString() const
+{
   std::ostringstream strm;
   strm << _date << ", ";
   strm << _srcAddress << ", ";
@@ -204,10 +210,7 @@ bool SBCCDRRecord::writeToLogFile(OSS::UTL::LogFile& logFile)
   strm << _setupTime << ", ";
   strm << _connectTime << ", ";
   strm << _disconnectTime;
-  
-  logFile.notice(strm.str());
-  
-  return true;
+  return strm.str();
 }
 
 bool SBCCDRRecord::readFromWorkSpace(SBCWorkSpace& workspace, const std::string& key)
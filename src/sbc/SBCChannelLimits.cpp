@@ -38,7 +38,7 @@ namespace SBC {
   
   
   
-static const Poco::Timestamp::TimeDiff DEFAULT_CACHE_EXPIRE = 60*60*1000;  /// 1 hour lifetime
+static const OSS::UInt64 DEFAULT_CACHE_EXPIRE = 60*60*1000;  /// 1 hour lifetime
 static const char* CHANNEL_COUNT_PREFIX = "sbc.channel-count-";
 static const char* CHANNEL_COUNT_PREFIX_WILD_CARD = "sbc.channel-count-*";
 
@@ -48,10 +48,10 @@ using OSS::Persistent::DataType;
 
   
 SBCChannelLimits::SBCChannelLimits() :
-  _shortestPrefix(0),
-  _cacheExpire(DEFAULT_CACHE_EXPIRE),
+  _activeCalls(DEFAULT_CACHE_EXPIRE),
   _pManager(0)
 {
+  _activeCalls.setExpireHandler(boost::bind(&SBCChannelLimits::onCallExpired, _1, _2));
 }
 
 SBCChannelLimits::~SBCChannelLimits()
@@ -107,8 +107,6 @@ void SBCChannelLimits::initialize(SBCManager* pSBCManager)
  
 void SBCChannelLimits::registerDialPrefix(const std::string& prefix_, std::size_t channelLimit)
 {
-  OSS::mutex_critic_sec_lock lock(_prefixesMutex);
-  
   std::string prefix = prefix_;
   std::vector<std::string> tokens;
   tokens = OSS::string_tokenize(prefix, ",");
@@ -116,136 +114,89 @@ void SBCChannelLimits::registerDialPrefix(const std::string& prefix_, std::size_
   if (tokens.size() > 1)
   {
     prefix = tokens[0];
-    
-    for (std::size_t i = 1; i < tokens.size(); i++)
-    {
-      std::string aliasPrefix = tokens[i];
-      OSS::string_trim(aliasPrefix);
-      
-      _aliases[aliasPrefix] = prefix;
-           
-      if (!_shortestPrefix || _shortestPrefix > aliasPrefix.length())
-      {
-        _shortestPrefix = aliasPrefix.length();
-      }
-    }
   }
+  OSS::string_trim(prefix);
   
-  if (!_shortestPrefix || _shortestPrefix > prefix.length())
+  Prefix* pPrefix = _prefixes.insert(prefix, channelLimit);
+  if (!pPrefix)
   {
-    _shortestPrefix = prefix.length();
+    OSS_LOG_WARNING("SBCChannelLimits::registerDialPrefix - Ignoring non dialable prefix " << prefix);
+    return;
   }
   
-  _prefixes[prefix] =  ExpireCachePtr(new ExpireCache(_cacheExpire));
-  _limits[prefix] = channelLimit;
+  for (std::size_t i = 1; i < tokens.size(); i++)
+  {
+    std::string aliasPrefix = tokens[i];
+    OSS::string_trim(aliasPrefix);
+    if (!_prefixes.alias(aliasPrefix, pPrefix))
+    {
+      OSS_LOG_WARNING("SBCChannelLimits::registerDialPrefix - Ignoring non dialable alias " << aliasPrefix);
+    }
+  }
   
   //
-  // Zero out the workspace counter
+  // Publish the workspace counter
   //
-  std::ostringstream counterKey;
-  counterKey << CHANNEL_COUNT_PREFIX << prefix;
-  json::Object params;
-  params["prefix"] = json::String(prefix);
-  params["max-call-count"] = json::Number(channelLimit);
-  params["active-call-count"] = json::Number(0);
-  
-  if (_systemDb)
-  {
-    _systemDb->set(counterKey.str(), params);
-  }
+  updateWorkSpace(pPrefix, pPrefix->callCount.load());
   
   OSS_LOG_NOTICE("SBCChannelLimits::registerDialPrefix - Enforcing channel limit " << channelLimit << " for prefix " << prefix);
 }
 
-void SBCChannelLimits::resolveAliasPrefix(const std::string& dialString, std::string& prefix)
+void SBCChannelLimits::updateWorkSpace(Prefix* pPrefix, std::size_t count)
 {
-  OSS::mutex_critic_sec_lock lock(_prefixesMutex);
-  std::string lowerBoundKey = OSS::string_left(dialString, _shortestPrefix);
-  std::string lastMatch;
-   
-  for (PrefixAliases::iterator iter = _aliases.lower_bound(lowerBoundKey); iter != _aliases.end(); iter++)
+  if (!_systemDb)
   {
-    if (OSS::string_starts_with(dialString, iter->first.c_str()))
-    {
-      lastMatch = iter->second;
-      break;
-    }
+    return;
   }
   
-  if (!lastMatch.empty())
-  {
-    prefix = lastMatch;
-  }
+  std::ostringstream counterKey;
+  counterKey << CHANNEL_COUNT_PREFIX << pPrefix->prefix;
+  json::Object params;
+  params["prefix"] = json::String(pPrefix->prefix);
+  params["max-call-count"] = json::Number(pPrefix->channelLimit.load());
+  params["active-call-count"] = json::Number(count);
+  _systemDb->set(counterKey.str(), params);
 }
 
-std::size_t SBCChannelLimits::addCall(const std::string& sessionId, const std::string& dialString, std::size_t& channelLimit)
+void SBCChannelLimits::onCallExpired(const std::string& key, Prefix*& pPrefix)
 {
-  std::string alias;
-  resolveAliasPrefix(dialString, alias);
-  
   //
-  // Note:  do not lock the mutex before resolveAliasPrefix() or you will deadlock)
+  // Called with the active call shard locked.  Only touch the counter.
   //
-  OSS::mutex_critic_sec_lock lock(_prefixesMutex);
-  std::string lowerBoundKey = OSS::string_left(dialString, _shortestPrefix);
-  std::size_t count = 0;
-  
-  std::string lastMatch;
-  
-  if (alias.empty())
-  {
-    for (ChannelMap::iterator iter = _prefixes.lower_bound(lowerBoundKey); iter != _prefixes.end(); iter++)
-    {
-      if (OSS::string_starts_with(dialString, iter->first.c_str()))
-      {
-        lastMatch = iter->first;
-        break;
-      }
-    }
-  }
-  else
+  pPrefix->callCount.fetch_sub(1);
+}
+
+std::size_t SBCChannelLimits::addCall(const std::string& sessionId, const std::string& dialString, std::size_t& channelLimit)
+{
+  Prefix* pPrefix = _prefixes.match(dialString);
+  if (!pPrefix)
   {
-    lastMatch = alias;
+    OSS_LOG_INFO("SBCChannelLimits::addCall - " << dialString << " did not match any registrered channel prefix");
+    return 0;
   }
   
-  if (!lastMatch.empty())
+  std::size_t count = 0;
+  if (_activeCalls.add(pPrefix->prefix + ":" + sessionId, pPrefix))
   {
-    ChannelMap::iterator iter = _prefixes.find(lastMatch);
-    if (iter != _prefixes.end())
-    {
-      iter->second->add(sessionId, dialString);
-      count = iter->second->size();
-      channelLimit = _limits[lastMatch];
-      
-      //
-      // Update the workspace counter
-      //
-      std::ostringstream counterKey;
-      counterKey << CHANNEL_COUNT_PREFIX << lastMatch;
-      json::Object params;
-      params["prefix"] = json::String(lastMatch);
-      params["max-call-count"] = json::Number(channelLimit);
-      params["active-call-count"] = json::Number(count);
-      
-      OSS_LOG_INFO("SBCChannelLimits::addCall - " << dialString << " matches channel prefix " << lastMatch << " Current count is " << count);
-      
-      if (_systemDb)
-      {
-        _systemDb->set(counterKey.str(), params);
-      }
-    }
-    
-    if (count > channelLimit)
-    {
-      OSS_LOG_WARNING("SBCChannelLimits::addCall - Channel limit violation for call " << dialString << " Current channel count is already " << count);
-    }
+    count = pPrefix->callCount.fetch_add(1) + 1;
   }
   else
   {
-    OSS_LOG_INFO("SBCChannelLimits::addCall - " << dialString << " did not match any registrered channel prefix");
+    count = pPrefix->callCount.load();
   }
+  channelLimit = pPrefix->channelLimit.load();
   
+  OSS_LOG_INFO("SBCChannelLimits::addCall - " << dialString << " matches channel prefix " << pPrefix->prefix << " Current count is " << count);
+  
+  //
+  // Update the workspace counter
+  //
+  updateWorkSpace(pPrefix, count);
   
+  if (count > channelLimit)
+  {
+    OSS_LOG_WARNING("SBCChannelLimits::addCall - Channel limit violation for call " << dialString << " Current channel count is already " << count);
+  }
   
   return count;
 }
@@ -256,11 +207,10 @@ std::size_t SBCChannelLimits::getCallCount(const std::string& prefix)
   
   if (!prefix.empty())
   {
-    OSS::mutex_critic_sec_lock lock(_prefixesMutex);
-    ChannelMap::iterator iter = _prefixes.find(prefix);
-    if (iter != _prefixes.end())
+    Prefix* pPrefix = _prefixes.find(prefix);
+    if (pPrefix)
     {
-      callCount = iter->second->size();
+      callCount = pPrefix->callCount.load();
       OSS_LOG_INFO("SBCChannelLimits::getCallCount(" << prefix << ") returned " << callCount);
     }
     else
@@ -274,64 +224,30 @@ std::size_t SBCChannelLimits::getCallCount(const std::string& prefix)
   
 std::size_t SBCChannelLimits::removeCall(const std::string& sessionId, const std::string& dialString)
 { 
-  std::string alias;
-  resolveAliasPrefix(dialString, alias);
+  Prefix* pPrefix = _prefixes.match(dialString);
+  if (!pPrefix)
+  {
+    return 0;
+  }
   
-  //
-  // Note:  do not lock the mutex before resolveAliasPrefix() or you will deadlock)
-  //
-  OSS::mutex_critic_sec_lock lock(_prefixesMutex);
-  std::string lowerBoundKey = OSS::string_left(dialString, _shortestPrefix);
   std::size_t count = 0;
-  
-  std::string lastMatch;
-  if (alias.empty())
+  Prefix* pRemoved = 0;
+  if (_activeCalls.pop(pPrefix->prefix + ":" + sessionId, pRemoved))
   {
-    for (ChannelMap::iterator iter = _prefixes.lower_bound(lowerBoundKey); iter != _prefixes.end(); iter++)
-    {
-      if (OSS::string_starts_with(dialString, iter->first.c_str()))
-      {
-        lastMatch = iter->first;
-        break;
-      }
-    }
+    count = pPrefix->callCount.fetch_sub(1) - 1;
   }
   else
   {
-    lastMatch = alias;
+    count = pPrefix->callCount.load();
   }
   
-  if (!lastMatch.empty())
-  {
-    ChannelMap::iterator iter = _prefixes.find(lastMatch);
-    if (iter != _prefixes.end())
-    {
-      iter->second->remove(sessionId);
-      count = iter->second->size();
-      
-      //
-      // Update the workspace counter
-      //
-      int channelLimit = _limits[lastMatch];
-      std::ostringstream counterKey;
-      counterKey << CHANNEL_COUNT_PREFIX << lastMatch;
-      json::Object params;
-      params["prefix"] = json::String(lastMatch);
-      params["max-call-count"] = json::Number(channelLimit);
-      params["active-call-count"] = json::Number(count);
-      
-      if (_systemDb)
-      {
-        _systemDb->set(counterKey.str(), params);
-      }
-    }
-  }
+  //
+  // Update the workspace counter
+  //
+  updateWorkSpace(pPrefix, count);
   
   return count;
 }
 
 
 } } } // OSS::SIP::SBC
-
-
-
@@ -91,6 +91,50 @@ bool SBCConfiguration::initUserAgent()
     OSS::JSON::Boolean val = _userAgent["dialog_state_in_contact_params"];
     SBCContact::_dialogStateInParams = val.Value();
   }
+
+  if (_userAgent.Exists("media_proxy_nodes"))
+  {
+    //
+    // Each node is an object with an address and an optional weight, ie
+    // {"address": "tcp://10.0.0.2:40590", "weight": 2}
+    //
+    try
+    {
+      OSS::JSON::Array nodes = _userAgent["media_proxy_nodes"];
+      int nodeCount = nodes.Size();
+      for (int i = 0; i < nodeCount; i++)
+      {
+        OSS::JSON::Object node = nodes[i];
+        if (!node.Exists("address"))
+        {
+          continue;
+        }
+        OSS::JSON::String address = node["address"];
+        unsigned int weight = 1;
+        if (node.Exists("weight"))
+        {
+          OSS::JSON::Number val = node["weight"];
+          weight = val.Value();
+        }
+        if (!SBCManager::instance()->rtpProxy().addNode(address.Value(), weight))
+        {
+          OSS_LOG_WARNING("SBCConfiguration::initUserAgent - Ignoring media proxy node " << address.Value());
+        }
+      }
+    }
+    catch(...)
+    {
+    }
+  }
+
+  if (_userAgent.Exists("enable_remote_rtp"))
+  {
+    OSS::JSON::Boolean val = _userAgent["enable_remote_rtp"];
+    if (val.Value() && !SBCManager::instance()->rtpProxy().initialize(true))
+    {
+      OSS_LOG_ERROR("SBCConfiguration::initUserAgent - Unable to initialize remote media proxy nodes");
+    }
+  }
   return true;
 }
 
@@ -0,0 +1,202 @@
+
+// OSS Software Solutions Application Programmer Interface
+// Package: Karoo
+// Author: Joegen E. Baclor - mailto:joegen@ossapp.com
+//
+// Copyright (c) OSS Software Solutions
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "OSS Software Solutions OSS API General License Agreement".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+#include "OSS/SIP/SBC/SBCDialPrefixTrie.h"
+
+
+namespace OSS {
+namespace SIP {
+namespace SBC {
+
+
+SBCDialPrefixTrie::Prefix::Prefix(const std::string& prefix_, std::size_t channelLimit_) :
+  prefix(prefix_),
+  channelLimit(channelLimit_),
+  callCount(0)
+{
+}
+
+SBCDialPrefixTrie::Node::Node() :
+  pPrefix(0),
+  isAlias(false)
+{
+  for (int i = 0; i < DIAL_CHAR_COUNT; i++)
+    children[i].store(0, boost::memory_order_relaxed);
+}
+
+SBCDialPrefixTrie::SBCDialPrefixTrie() :
+  _pRoot(new Node()),
+  _size(0)
+{
+}
+
+SBCDialPrefixTrie::~SBCDialPrefixTrie()
+{
+  destroy(_pRoot);
+  for (std::vector<Prefix*>::iterator iter = _prefixes.begin(); iter != _prefixes.end(); iter++)
+    delete *iter;
+}
+
+void SBCDialPrefixTrie::destroy(Node* pNode)
+{
+  if (!pNode)
+    return;
+  for (int i = 0; i < DIAL_CHAR_COUNT; i++)
+    destroy(pNode->children[i].load(boost::memory_order_relaxed));
+  delete pNode;
+}
+
+SBCDialPrefixTrie::Node* SBCDialPrefixTrie::walk(const std::string& prefix, bool create)
+{
+  Node* pNode = _pRoot;
+  for (std::string::const_iterator iter = prefix.begin(); iter != prefix.end(); iter++)
+  {
+    int index = charIndex(*iter);
+    if (index == -1)
+      return 0;
+    Node* pChild = pNode->children[index].load(boost::memory_order_acquire);
+    if (!pChild)
+    {
+      if (!create)
+        return 0;
+      //
+      // Publish the node only after it is fully constructed so that
+      // concurrent readers never observe a partially built child
+      //
+      pChild = new Node();
+      pNode->children[index].store(pChild, boost::memory_order_release);
+    }
+    pNode = pChild;
+  }
+  return pNode;
+}
+
+SBCDialPrefixTrie::Prefix* SBCDialPrefixTrie::insert(const std::string& prefix, std::size_t channelLimit)
+{
+  if (prefix.empty())
+    return 0;
+
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  Node* pNode = walk(prefix, true);
+  if (!pNode)
+    return 0;
+
+  Prefix* pPrefix = pNode->pPrefix.load(boost::memory_order_acquire);
+  if (pPrefix && !pNode->isAlias)
+  {
+    pPrefix->channelLimit.store(channelLimit);
+    return pPrefix;
+  }
+
+  pPrefix = new Prefix(prefix, channelLimit);
+  _prefixes.push_back(pPrefix);
+  _size++;
+  pNode->isAlias = false;
+  pNode->pPrefix.store(pPrefix, boost::memory_order_release);
+  return pPrefix;
+}
+
+bool SBCDialPrefixTrie::alias(const std::string& aliasPrefix, Prefix* pPrefix)
+{
+  if (aliasPrefix.empty() || !pPrefix)
+    return false;
+
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  Node* pNode = walk(aliasPrefix, true);
+  if (!pNode)
+    return false;
+  pNode->isAlias = true;
+  pNode->pPrefix.store(pPrefix, boost::memory_order_release);
+  return true;
+}
+
+bool SBCDialPrefixTrie::remove(const std::string& prefix)
+{
+  if (prefix.empty())
+    return false;
+
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  Node* pNode = walk(prefix, false);
+  if (!pNode || pNode->isAlias)
+    return false;
+
+  Prefix* pPrefix = pNode->pPrefix.load(boost::memory_order_acquire);
+  if (!pPrefix)
+    return false;
+
+  pNode->pPrefix.store(0, boost::memory_order_release);
+  unalias(_pRoot, pPrefix);
+  _size--;
+  return true;
+}
+
+void SBCDialPrefixTrie::unalias(Node* pNode, Prefix* pPrefix)
+{
+  if (!pNode)
+    return;
+  if (pNode->isAlias && pNode->pPrefix.load(boost::memory_order_relaxed) == pPrefix)
+  {
+    pNode->pPrefix.store(0, boost::memory_order_release);
+    pNode->isAlias = false;
+  }
+  for (int i = 0; i < DIAL_CHAR_COUNT; i++)
+    unalias(pNode->children[i].load(boost::memory_order_relaxed), pPrefix);
+}
+
+SBCDialPrefixTrie::Prefix* SBCDialPrefixTrie::match(const std::string& dialString) const
+{
+  Prefix* pMatch = 0;
+  const Node* pNode = _pRoot;
+  for (std::string::const_iterator iter = dialString.begin(); iter != dialString.end(); iter++)
+  {
+    int index = charIndex(*iter);
+    if (index == -1)
+      break;
+    pNode = pNode->children[index].load(boost::memory_order_acquire);
+    if (!pNode)
+      break;
+    Prefix* pPrefix = pNode->pPrefix.load(boost::memory_order_acquire);
+    if (pPrefix)
+      pMatch = pPrefix;
+  }
+  return pMatch;
+}
+
+SBCDialPrefixTrie::Prefix* SBCDialPrefixTrie::find(const std::string& prefix) const
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  Node* pNode = const_cast<SBCDialPrefixTrie*>(this)->walk(prefix, false);
+  if (!pNode || pNode == _pRoot || pNode->isAlias)
+    return 0;
+  return pNode->pPrefix.load(boost::memory_order_acquire);
+}
+
+std::size_t SBCDialPrefixTrie::size() const
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  return _size;
+}
+
+
+} } } // OSS::SIP::SBC
@@ -58,6 +58,12 @@ SBCDialogStateManager::SBCDialogStateManager(SBCManager* pManager) :
 {
 }
 
+//
+// Kept in the state directory.  The leading dot keeps it from ever matching
+// a session-id.
+//
+static const char* EXPIRY_JOURNAL = ".expiry-index";
+
 SBCDialogStateManager::~SBCDialogStateManager()
 {
   stop();
@@ -150,7 +156,7 @@ void SBCDialogStateManager::removeDialog(const std::string& callId, const boost:
   
   if (deleteFile)
   {
-    ClassType::remove(stateFile);
+    removeStateFile(stateFile);
   }
   
   _csDialogsMutex.unlock();
@@ -209,7 +215,7 @@ void SBCDialogStateManager::removeDialog(const SIPMessage::Ptr& pMsg, bool delet
         
         if (deleteFile)
         {
-          ClassType::remove(first);
+          removeStateFile(first);
         }
         
         OSS_LOG_DEBUG("Successfully removed dialog " << callId << " with sessionId " << boost_file_name(first));
@@ -239,7 +245,7 @@ void SBCDialogStateManager::removeDialog(const SIPMessage::Ptr& pMsg, bool delet
           
           if (deleteFile)
           {
-            ClassType::remove(last);
+            removeStateFile(last);
           }
           
           OSS_LOG_DEBUG("Successfully removed dialog " << callId << " with sessionId " << boost_file_name(last));
@@ -562,6 +568,7 @@ void SBCDialogStateManager::onUpdateInitialUASState(
         }
 
         leg1Persistent.persist(stateFile);
+        indexStateFile(stateFile, pResponse->hdrGet("call-id"));
 
         if (pResponse->is2xx())
         {
@@ -583,7 +590,7 @@ void SBCDialogStateManager::onUpdateInitialUASState(
       try
       {
         boost::filesystem::path stateFile = operator/(_stateDir, sessionId);
-        ClassType::remove(stateFile);
+        removeStateFile(stateFile);
       }catch(...){}
     }
   }
@@ -657,6 +664,7 @@ void SBCDialogStateManager::onUpdateInitialUACState(
           }
         }
         leg2Persistent.persist(stateFile);
+        indexStateFile(stateFile);
         return;
       }
       
@@ -785,6 +793,7 @@ void SBCDialogStateManager::onUpdateInitialUACState(
       }
       
       leg2Persistent.persist(stateFile);
+      indexStateFile(stateFile);
     }
     catch(const OSS::Exception& e)
     {
@@ -887,6 +896,7 @@ void SBCDialogStateManager::onUpdateReinviteUASState(
         }
 
         legPersistent.persist(stateFile);
+        indexStateFile(stateFile);
       }
       catch(const OSS::Exception& e)
       {
@@ -985,6 +995,7 @@ void SBCDialogStateManager::onUpdateReinviteUACState(
       }
 
       legPersistent.persist(stateFile);
+      indexStateFile(stateFile);
     }
     catch(const OSS::Exception& e)
     {
@@ -1000,6 +1011,24 @@ void SBCDialogStateManager::run()
   _stateDir = boost::filesystem::path(SBCDirectories::instance()->getDialogStateDirectory());
   if (_pThread)
     OSS_VERIFY(false);
+
+  boost::filesystem::path journal = operator/(_stateDir, EXPIRY_JOURNAL);
+  bool hasJournal = false;
+  try
+  {
+    hasJournal = boost::filesystem::exists(journal);
+  }catch(...){}
+
+  if (!_expiryIndex.open(journal))
+  {
+    OSS_LOG_WARNING("Unable to open state file expiry journal " << OSS::boost_path(journal) << ".  Expiry will not survive a restart.");
+  }
+
+  if (!hasJournal)
+  {
+    seedExpiryIndex();
+  }
+
   _pThread = new boost::thread(boost::bind(&SBCDialogStateManager::runTask, this));
 }
 
@@ -1012,21 +1041,39 @@ void SBCDialogStateManager::stop()
     delete _pThread;
     _pThread = 0;
   }
+  _expiryIndex.close();
 }
 
 void SBCDialogStateManager::runTask()
 {
   OSS::log_information("SBC State File Manager started.");
-  while(!_exitSync.tryWait(60000 * 60))
+  while(!_exitSync.tryWait(FLUSH_INTERVAL_MS))
   {
     flushStale();
   }
   OSS::log_information("SBC State File Manager ended.");
 }
 
-void SBCDialogStateManager::flushStale()
+void SBCDialogStateManager::removeStateFile(const boost::filesystem::path& stateFile)
+{
+  _expiryIndex.remove(boost_file_name(stateFile));
+  ClassType::remove(stateFile);
+}
+
+void SBCDialogStateManager::indexStateFile(const boost::filesystem::path& stateFile, const std::string& callId)
+{
+  OSS::UInt64 expires = OSS::getTime() / 1000 + (OSS::UInt64)_stateFileMaxLifeTime * 60;
+  std::string sessionId = boost_file_name(stateFile);
+  if (!callId.empty() || !_expiryIndex.touch(sessionId, expires))
+  {
+    _expiryIndex.add(sessionId, expires, callId);
+  }
+}
+
+void SBCDialogStateManager::seedExpiryIndex()
 {
-  std::vector<boost::filesystem::path> staleFiles;
+  OSS::log_information("SBC State File Manager indexing existing state files.");
+  std::size_t count = 0;
   try
   {
     boost::filesystem::directory_iterator end_itr; // default construction yields past-the-end
@@ -1034,51 +1081,81 @@ void SBCDialogStateManager::flushStale()
           itr != end_itr;
           ++itr)
     {
-      if (boost::filesystem::is_directory(itr->status()))
+      std::string fileName = boost_file_name(itr->path());
+      if (fileName.empty() || fileName[0] == '.' || !boost::filesystem::is_regular(itr->status()))
       {
         continue;
       }
-      else
-      {
-        boost::filesystem::path currentFile = operator/(_stateDir, boost_file_name(itr->path()));
-        if (boost::filesystem::is_regular(currentFile) && OSS::isFileOlderThan(currentFile, _stateFileMaxLifeTime))
-        {
-          staleFiles.push_back(currentFile);
-        }
-      }
+      OSS::UInt64 modified = (OSS::UInt64)boost::filesystem::last_write_time(itr->path());
+      _expiryIndex.add(fileName, modified + (OSS::UInt64)_stateFileMaxLifeTime * 60);
+      count++;
     }
+  }
+  catch(const std::exception& e)
+  {
+    OSS_LOG_WARNING("SBCDialogStateManager::seedExpiryIndex() Failure - " << e.what());
+  }
+  OSS_LOG_INFO("SBC State File Manager indexed " << count << " existing state files.");
+}
+
+void SBCDialogStateManager::flushStale()
+{
+  //
+  // Only what is due is touched, a bounded batch per tick, so a backlog of
+  // expired files is worked off gradually instead of stalling this thread.
+  // The journal is compacted here too so SIP threads adding entries never
+  // wait on a rewrite.
+  //
+  _expiryIndex.compactIfStale();
+
+  OSS::ExpiryIndex::Entries staleFiles;
+  if (!_expiryIndex.popExpired(OSS::getTime() / 1000, FLUSH_BATCH_SIZE, staleFiles))
+  {
+    return;
+  }
 
-    for (std::vector<boost::filesystem::path>::const_iterator iter = staleFiles.begin();
-      iter != staleFiles.end(); iter++)
+  for (OSS::ExpiryIndex::Entries::const_iterator iter = staleFiles.begin();
+    iter != staleFiles.end(); iter++)
+  {
+    boost::filesystem::path stateFile = operator/(_stateDir, iter->key);
+    std::string callId = iter->data;
+    if (callId.empty())
     {
-      std::string callId;
+      //
+      // Seeded from a directory scan.  The Call-ID is only in the file.
+      //
       try
       {
         ClassType leg1Persistent;
-        if (leg1Persistent.load(*iter))
+        if (leg1Persistent.load(stateFile))
         {
           DataType root = leg1Persistent.self();
           callId = (const char*)root["leg-1"]["call-id"];
         }
       }catch(...){}
-      
-      if (!callId.empty())
-      {
-        _csDialogsMutex.lock();
-        _dialogs.remove(callId);
-        _csDialogsMutex.unlock();
-      }
-      ClassType::remove(*iter);
     }
-  }
-  catch(const OSS::Exception& e)
-  {
-    std::ostringstream logMsg;
-    logMsg << "purge_state_files() Failure - "
-      << e.message();
-    OSS::log_warning(logMsg.str());
+
+    if (!callId.empty())
+    {
+      _csDialogsMutex.lock();
+      _dialogs.remove(callId);
+      _csDialogsMutex.unlock();
+    }
+
+    try
+    {
+      ClassType::remove(stateFile);
+    }
+    catch(const OSS::Exception& e)
+    {
+      std::ostringstream logMsg;
+      logMsg << "purge_state_files() Failure - "
+        << e.message();
+      OSS::log_warning(logMsg.str());
+    }
   }
 }
+
 bool SBCDialogStateManager::findDialog(const SIPB2BTransaction::Ptr& pTransaction, const SIPMessage::Ptr& pMsg, OSS::Persistent::ClassType& dialog)
 {
   boost::filesystem::path stateFile;
@@ -1375,6 +1452,7 @@ SIPMessage::Ptr SBCDialogStateManager::onRouteMidDialogTransaction(
     }
 
     persistent.persist(stateFile);
+    indexStateFile(stateFile);
 
     pMsg->hdrRemove("call-id");
     pMsg->hdrRemove("from");
@@ -1861,6 +1939,7 @@ void SBCDialogStateManager::onRouteAckRequest(
       }
 
       persistent.persist(stateFile);
+      indexStateFile(stateFile);
     }
 
     pMsg->commitData();
@@ -29,6 +29,7 @@
 #include <OSS/SIP/SIPHeaderTokens.h>
 
 #include "OSS/UTL/Logger.h"
+#include "OSS/UTL/IdGenerator.h"
 #include "OSS/SIP/SBC/SBCInviteBehavior.h"
 #include "OSS/SIP/SBC/SBCManager.h"
 #include "OSS/Persistent/ClassType.h"
@@ -463,7 +464,7 @@ void SBCInviteBehavior::setCallIdCorrelation(SIPMessage::Ptr& pRequest, SIPB2BTr
     }
     else if (cid_correlation == "x-cid")
     {
-      std::string callId = OSS::string_create_uuid();
+      std::string callId = OSS::IdGenerator::createCallId();
       std::string xCid = pRequest->hdrGet(OSS::SIP::HDR_CALL_ID);
       pRequest->hdrSet(OSS::SIP::HDR_CALL_ID, callId);
       pRequest->hdrSet("X-CID", xCid);
@@ -998,7 +999,7 @@ void SBCInviteBehavior::onTransactionError(
         // Only a BYE will terminate the dialog
         //
         boost::filesystem::path stateFile = operator/(_stateDir, sessionId);
-        ClassType::remove(stateFile);
+        _pManager->dialogStateManager().removeStateFile(stateFile);
       }
     }catch(...){}
 
@@ -31,60 +31,91 @@ namespace SIP {
 namespace SBC {
   
 #define RTP_PROXY_THREAD_COUNT 30
-  
-static int get_node(const std::string& sessionId, bool& spillOver)
+#define RING_POINTS_PER_WEIGHT 160
+#define DEFAULT_MAX_SESSION 30
+#define AFFINITY_TTL_MS 14400000
+#define AFFINITY_SWEEP_INTERVAL_MS 60000
+
+static const char* LEGACY_NODE_ADDRESSES[] =
 {
-  if (sessionId.size() < 5)
-    return 0;
-  
-  spillOver = false;
-  char c = sessionId.at(4);
+  "tcp://127.0.0.1:40590",
+  "tcp://127.0.0.1:40591",
+  "tcp://127.0.0.1:40592",
+  "tcp://127.0.0.1:40593",
+  "tcp://127.0.0.1:40594"
+};
   
-  switch(c)
-  {
-    case '0':
-      return 0;
-    case '1':
-      return 1;
-    case '2':
-      return 2;
-    case '3':
-      return 3;
-    case '4':
-      return 4;
-    case '5':
-      spillOver = true;
-      return 0;
-    case '6':
-      spillOver = true;
-      return 1;
-    case '7':
-      spillOver = true;
-      return 2;
-    case '8':
-      spillOver = true;
-      return 3;
-    case '9':
-      spillOver = true;
-      return 4;
-  }
-  
-  return 0;
+static OSS::UInt32 ring_hash(const std::string& key)
+{
+  //
+  // string_to_js_hash barely moves the high bits for keys that only differ
+  // in their last characters, which bunches up the points of a node and
+  // consecutive session ids.  The murmur3 finalizer spreads them out.
+  //
+  OSS::UInt32 hash = OSS::string_to_js_hash(key);
+  hash ^= hash >> 16;
+  hash *= 0x85ebca6b;
+  hash ^= hash >> 13;
+  hash *= 0xc2b2ae35;
+  hash ^= hash >> 16;
+  return hash;
 }
-  
+
+static SBCMediaProxy::HashRing::const_iterator ring_owner(const SBCMediaProxy::HashRing& ring, const std::string& sessionId)
+{
+  SBCMediaProxy::HashRing::const_iterator point = ring.lower_bound(ring_hash(sessionId));
+  if (point == ring.end())
+    point = ring.begin();
+  return point;
+}
+
 SBCMediaProxy::SBCMediaProxy(SBCManager* pManager) :
-  _node0(0),
-  _node1(1),
-  _node2(2),
-  _node3(3),
-  _node4(4),
+  _nextAffinitySweep(0),
   _pManager(pManager),
-  _remoteRtpEnabled(false)
+  _remoteRtpEnabled(false),
+  _maxSession(DEFAULT_MAX_SESSION)
 {
 }
   
 SBCMediaProxy::~SBCMediaProxy()
 {
+  for (Nodes::iterator iter = _nodes.begin(); iter != _nodes.end(); iter++)
+    delete *iter;
+}
+
+bool SBCMediaProxy::addNode(const std::string& address, unsigned int weight)
+{
+  if (address.empty() || !weight || !_ring.empty())
+    return false;
+  for (Nodes::const_iterator iter = _nodes.begin(); iter != _nodes.end(); iter++)
+  {
+    if ((*iter)->getAddress() == address)
+      return false;
+  }
+  SBCMediaProxyClient* pNode = new SBCMediaProxyClient(address);
+  pNode->setMaxSession(_maxSession);
+  _nodes.push_back(pNode);
+  _weights.push_back(weight);
+  return true;
+}
+
+void SBCMediaProxy::buildRing()
+{
+  //
+  // Each node owns a number of virtual points proportional to its weight.
+  // Adding or removing a node only moves the sessions hashed to its points.
+  //
+  _ring.clear();
+  for (std::size_t i = 0; i < _nodes.size(); i++)
+  {
+    unsigned int points = _weights[i] * RING_POINTS_PER_WEIGHT;
+    for (unsigned int point = 0; point < points; point++)
+    {
+      std::ostringstream key;
+      key << _nodes[i]->getAddress() << "#" << point;
+      _ring[ring_hash(key.str())] = i;
+    }
+  }
 }
 
 bool SBCMediaProxy::initialize(bool remoteRtpEnabled)
@@ -93,16 +124,18 @@ bool SBCMediaProxy::initialize(bool remoteRtpEnabled)
 
   if (_remoteRtpEnabled)
   {
-    if (!_node0.initialize())
-      return false;
-    if (!_node1.initialize())
-      return false;
-    if (!_node2.initialize())
-      return false;
-    if (!_node3.initialize())
-      return false;
-    if (!_node4.initialize())
-      return false;
+    if (_nodes.empty())
+    {
+      for (std::size_t i = 0; i < sizeof(LEGACY_NODE_ADDRESSES) / sizeof(const char*); i++)
+        addNode(LEGACY_NODE_ADDRESSES[i]);
+    }
+
+    for (Nodes::iterator iter = _nodes.begin(); iter != _nodes.end(); iter++)
+    {
+      if (!(*iter)->initialize())
+        return false;
+    }
+    buildRing();
   }
   else
   {
@@ -111,23 +144,111 @@ bool SBCMediaProxy::initialize(bool remoteRtpEnabled)
   return true;
 }
 
+SBCMediaProxyClient* SBCMediaProxy::findNode(const std::string& sessionId) const
+{
+  if (!_remoteRtpEnabled || _ring.empty())
+    return 0;
+
+  {
+    OSS::mutex_read_lock lock(_sessionAffinityMutex);
+    SessionAffinity::const_iterator iter = _sessionAffinity.find(sessionId);
+    if (iter != _sessionAffinity.end())
+      return _nodes[iter->second.node];
+  }
+
+  return _nodes[ring_owner(_ring, sessionId)->second];
+}
+
 SBCMediaProxyClient* SBCMediaProxy::getNode(const std::string& sessionId, bool& spillOver)
 {
-  if (_remoteRtpEnabled)
+  spillOver = false;
+  if (!_remoteRtpEnabled || _ring.empty())
+    return 0;
+
+  OSS::UInt64 now = OSS::getTime();
+  {
+    OSS::mutex_write_lock lock(_sessionAffinityMutex);
+    SessionAffinity::iterator iter = _sessionAffinity.find(sessionId);
+    if (iter != _sessionAffinity.end())
+    {
+      iter->second.expires = now + AFFINITY_TTL_MS;
+      spillOver = iter->second.node != ring_owner(_ring, sessionId)->second;
+      return _nodes[iter->second.node];
+    }
+  }
+
+  //
+  // Walk the ring clockwise starting from the point owning the session.
+  // The first distinct node that is responsive and has room wins.  Anything
+  // other than the first node visited is a spill-over.
+  //
+  HashRing::const_iterator start = ring_owner(_ring, sessionId);
+
+  std::size_t selected = start->second;
+  std::vector<bool> visited(_nodes.size(), false);
+  std::size_t visitedCount = 0;
+  HashRing::const_iterator point = start;
+  do
+  {
+    std::size_t index = point->second;
+    if (!visited[index])
+    {
+      visited[index] = true;
+      visitedCount++;
+      SBCMediaProxyClient* pNode = _nodes[index];
+      //
+      // Check capacity first.  isAvailable() may hand out the single probe
+      // of a node that stopped responding and it must not be wasted.
+      //
+      if (pNode->getSessionCount() < pNode->getMaxSession() && pNode->isAvailable())
+      {
+        selected = index;
+        break;
+      }
+    }
+    if (++point == _ring.end())
+      point = _ring.begin();
+  } while (point != start && visitedCount < _nodes.size());
+
+  spillOver = selected != start->second;
+
+  //
+  // Pin the session so that later offers, answers and removal reach the
+  // same node even if the load picture changes in the meantime.
+  //
+  OSS::mutex_write_lock lock(_sessionAffinityMutex);
+  Affinity& affinity = _sessionAffinity[sessionId];
+  affinity.node = selected;
+  affinity.expires = now + AFFINITY_TTL_MS;
+  expireAffinity(now);
+  return _nodes[selected];
+}
+
+void SBCMediaProxy::expireAffinity(OSS::UInt64 now)
+{
+  //
+  // Sessions reaped by node inactivity or dialog expiry never reach
+  // removeSession().  Drop pins that have not seen an SDP exchange for
+  // AFFINITY_TTL_MS.  A session that outlives its pin falls back to the
+  // ring owner.  Must be called with _sessionAffinityMutex held.
+  //
+  if (now < _nextAffinitySweep)
+    return;
+  _nextAffinitySweep = now + AFFINITY_SWEEP_INTERVAL_MS;
+
+  for (SessionAffinity::iterator iter = _sessionAffinity.begin(); iter != _sessionAffinity.end();)
   {
-    int node = get_node(sessionId, spillOver);
-    if (node == 0)
-      return &_node0;
-    else if (node == 1)
-      return &_node1;
-    else if (node == 2)
-      return &_node2;
-    else if (node == 3)
-      return &_node3;
-    else if (node == 4)
-      return &_node4;
+    if (iter->second.expires <= now)
+      _sessionAffinity.erase(iter++);
+    else
+      ++iter;
   }
-  return 0;
+}
+
+void SBCMediaProxy::releaseNode(const std::string& sessionId)
+{
+  OSS::mutex_write_lock lock(_sessionAffinityMutex);
+  _sessionAffinity.erase(sessionId);
 }
    
 bool SBCMediaProxy::handleSDP(
@@ -147,6 +268,10 @@ bool SBCMediaProxy::handleSDP(
   SBCMediaProxyClient* pNode = getNode(sessionId, spillOver);
   if (pNode)
   {
+    if (spillOver)
+    {
+      OSS_LOG_INFO(logId << "SBCMediaProxy::handleSDP - session " << sessionId << " spilled over to " << pNode->getAddress());
+    }
     return pNode->handleSDP(logId, sessionId, sentBy, packetSourceIP, packetLocalInterface, route, routeLocalInterface, requestType, sdp, rtpAttribute);
   }
   else
@@ -166,8 +291,7 @@ bool SBCMediaProxy::handleSDP(
 
 bool SBCMediaProxy::getSDP(const std::string& sessionId, std::string& lastOffer, std::string& lastAnswer)
 {
-  bool spillOver = false;
-  SBCMediaProxyClient* pNode = getNode(sessionId, spillOver);
+  SBCMediaProxyClient* pNode = findNode(sessionId);
   if (pNode)
   {
     return pNode->getSDP( sessionId, lastOffer, lastAnswer);
@@ -183,10 +307,10 @@ bool SBCMediaProxy::getSDP(const std::string& sessionId, std::string& lastOffer,
 
 bool SBCMediaProxy::removeSession(const std::string& sessionId)
 {
-  bool spillOver = false;
-  SBCMediaProxyClient* pNode = getNode(sessionId, spillOver);
+  SBCMediaProxyClient* pNode = findNode(sessionId);
   if (pNode)
   {
+    releaseNode(sessionId);
     return pNode->removeSession(sessionId);
   }
   else
@@ -199,28 +323,32 @@ bool SBCMediaProxy::removeSession(const std::string& sessionId)
 
 bool SBCMediaProxy::setMaxSession(unsigned int maxSession)
 {
-  _node0.setMaxSession(maxSession);
-  _node1.setMaxSession(maxSession);
-  _node2.setMaxSession(maxSession);
-  _node3.setMaxSession(maxSession);
-  _node4.setMaxSession(maxSession);
+  _maxSession = maxSession;
+  for (Nodes::iterator iter = _nodes.begin(); iter != _nodes.end(); iter++)
+    (*iter)->setMaxSession(maxSession);
   return true;
 }
 
 unsigned int SBCMediaProxy::getMaxSession() const
 {
-  return _node0.getMaxSession();
+  if (_remoteRtpEnabled)
+  {
+    unsigned int maxSession = 0;
+    for (Nodes::const_iterator iter = _nodes.begin(); iter != _nodes.end(); iter++)
+      maxSession += (*iter)->getMaxSession();
+    return maxSession;
+  }
+  return _maxSession;
 }
   
 unsigned int SBCMediaProxy::getSessionCount() const
 {
   if (_remoteRtpEnabled)
   {
-    return _node0.getSessionCount() +
-      _node1.getSessionCount() +
-      _node2.getSessionCount() +
-      _node3.getSessionCount() +
-      _node4.getSessionCount();
+    unsigned int sessionCount = 0;
+    for (Nodes::const_iterator iter = _nodes.begin(); iter != _nodes.end(); iter++)
+      sessionCount += (*iter)->getSessionCount();
+    return sessionCount;
   }
   else
   {
@@ -228,4 +356,4 @@ unsigned int SBCMediaProxy::getSessionCount() const
   }
 }
 
-} } } //OSS::SIP::SBC
\ No newline at end of file
+} } } //OSS::SIP::SBC
@@ -23,8 +23,14 @@
 
 
 
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <boost/bind.hpp>
 #include "OSS/SIP/SBC/SBCMediaProxyClient.h"
 #include "OSS/UTL/Logger.h"
+#include "OSS/JSON/FastJson.h"
+#include "OSS/UTL/CoreUtils.h"
 #include "OSS/Net/Net.h"
 
 
@@ -36,17 +42,16 @@ namespace SBC {
 // ZeroMQ poll timeout is in microseconds in Version 2
 // and is changed to milliseconds in version 3!!!
 //
-#define RES_USE_POLL 1
-#define ZMQ_READ_TIMEOUT 1000 * 1000 * 2
-
+#if ZMQ_VERSION_MAJOR < 3
+#define ZMQ_POLL_INTERVAL 100 * 1000
+#else
+#define ZMQ_POLL_INTERVAL 100
+#endif
+#define RPC_REQUEST_TIMEOUT_MS 2000
+#define RPC_MAX_CONSECUTIVE_TIMEOUTS 3
+#define RPC_PROBE_INTERVAL_MS 4000
+#define RPC_MAX_PROBE_INTERVAL_MS 64000
 
-static const char * RESPONDER_BIND_ADDRESS_NODE_0 = "tcp://127.0.0.1:40590"; 
-static const char * RESPONDER_BIND_ADDRESS_NODE_1 = "tcp://127.0.0.1:40591"; 
-static const char * RESPONDER_BIND_ADDRESS_NODE_2 = "tcp://127.0.0.1:40592"; 
-static const char * RESPONDER_BIND_ADDRESS_NODE_3 = "tcp://127.0.0.1:40593";
-static const char * RESPONDER_BIND_ADDRESS_NODE_4 = "tcp://127.0.0.1:40594";   
-  
-static const char * RESPONDER_BIND_ADDRESS = "tcp://127.0.0.1:40597";
 static const std::string& CMD_REMOVE_SESSION = "rtp.removeSession";  
 static const std::string& CMD_MAX_SESSION = "rtp.rtpSessionMax";
 static const std::string& CMD_HANDLE_SDP = "rtp.handleSDP";
@@ -57,74 +62,40 @@ void s_free (void *data, void *hint)
 {
   free (data);
 }
-//  Convert string to 0MQ string and send to socket
-static bool s_send (zmq::socket_t & socket, const std::string & data)
-{
-  char * buff = (char*)malloc(data.size());
-  memcpy(buff, data.c_str(), data.size());
-  zmq::message_t message((void*)buff, data.size(), s_free, 0);
-  bool rc = socket.send(message);
-  return (rc);
-}
 
-//  Sends string as 0MQ string, as multipart non-terminal
-static bool s_sendmore (zmq::socket_t & socket, const std::string & data)
+static bool s_send (zmq::socket_t & socket, const std::string & data, int flags)
 {
   char * buff = (char*)malloc(data.size());
   memcpy(buff, data.c_str(), data.size());
   zmq::message_t message((void*)buff, data.size(), s_free, 0);
-  bool rc = socket.send(message, ZMQ_SNDMORE);
+  bool rc = socket.send(message, flags);
   return (rc);
 }
 
-static void s_receive (zmq::socket_t& socket, std::string& value)
+static bool s_has_more(zmq::socket_t& socket)
 {
-  zmq::message_t message;
-  socket.recv(&message);
-  if (!message.size())
-    return;
-  value = std::string(static_cast<char*>(message.data()), message.size());
+#if ZMQ_VERSION_MAJOR < 3
+  int64_t more = 0;
+#else
+  int more = 0;
+#endif
+  size_t moreSize = sizeof(more);
+  socket.getsockopt(ZMQ_RCVMORE, &more, &moreSize);
+  return more != 0;
 }
 
-static zmq::socket_t* create_socket(zmq::context_t& context, int nodeIndex)
+static zmq::socket_t* create_socket(zmq::context_t& context, const std::string& address)
 {
-  zmq::socket_t* pSocket = new zmq::socket_t(context, ZMQ_REQ);
+  if (address.empty())
+    return 0;
+
+  zmq::socket_t* pSocket = new zmq::socket_t(context, ZMQ_DEALER);
   int linger = 0;
   pSocket->setsockopt (ZMQ_LINGER, &linger, sizeof (linger));
   
   try
   {
-    if (nodeIndex == -1)
-    {
-      pSocket->connect(RESPONDER_BIND_ADDRESS);
-    }
-    else if (nodeIndex == 0)
-    {
-      pSocket->connect(RESPONDER_BIND_ADDRESS_NODE_0);
-    }
-    else if (nodeIndex == 1)
-    {
-      pSocket->connect(RESPONDER_BIND_ADDRESS_NODE_1);
-    }
-    else if (nodeIndex == 2)
-    {
-      pSocket->connect(RESPONDER_BIND_ADDRESS_NODE_2);
-    }
-    else if (nodeIndex == 3)
-    {
-      pSocket->connect(RESPONDER_BIND_ADDRESS_NODE_3);
-    }
-    else if (nodeIndex == 4)
-    {
-      pSocket->connect(RESPONDER_BIND_ADDRESS_NODE_4);
-    }
-    else
-    {
-      OSS_LOG_ERROR("SBCMediaProxyClient::connect() - Invalid node index " << nodeIndex);
-      delete pSocket;
-      pSocket = 0;
-    }
- 
+    pSocket->connect(address.c_str());
   }
   catch(const std::exception& e)
   {
@@ -141,99 +112,436 @@ static zmq::socket_t* create_socket(zmq::context_t& context, int nodeIndex)
   return pSocket;
 }
 
+SBCMediaProxyClient::PendingRequest::PendingRequest() :
+  correlationId(0),
+  expires(0),
+  ok(false)
+{
+}
 
-SBCMediaProxyClient::SBCMediaProxyClient(int nodeIndex) :
+SBCMediaProxyClient::SBCMediaProxyClient(const std::string& address) :
   _context(1),
-  _pSocket(0),
+  _address(address),
+  _pIoThread(0),
+  _isConnected(false),
+  _isTerminating(false),
+  _isStopped(false),
   _maxSession(MAX_SESSION),
   _sessionCount(0),
-  _nodeIndex(nodeIndex)
+  _consecutiveTimeouts(0),
+  _nextProbe(0),
+  _probeInterval(RPC_PROBE_INTERVAL_MS),
+  _correlationId(0)
 {
+  _wakeupPipe[0] = _wakeupPipe[1] = -1;
 }
 
 SBCMediaProxyClient::~SBCMediaProxyClient()
 {
-  delete _pSocket;
+  stop();
 }
 
-
 bool SBCMediaProxyClient::initialize()
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  if (_pIoThread)
+    return true;
+
+  if (_address.empty() || _isStopped)
+    return false;
+
+  if (::pipe(_wakeupPipe) != 0)
+  {
+    OSS_LOG_ERROR("SBCMediaProxyClient::initialize() - Unable to create wakeup pipe");
+    return false;
+  }
+  ::fcntl(_wakeupPipe[0], F_SETFL, ::fcntl(_wakeupPipe[0], F_GETFL) | O_NONBLOCK);
+  ::fcntl(_wakeupPipe[1], F_SETFL, ::fcntl(_wakeupPipe[1], F_GETFL) | O_NONBLOCK);
+
+  _isTerminating = false;
+  _pIoThread = new boost::thread(boost::bind(&SBCMediaProxyClient::runIoLoop, this));
+  return true;
+}
+
+void SBCMediaProxyClient::stop()
+{
+  boost::thread* pIoThread = 0;
+  {
+    OSS::mutex_critic_sec_lock lock(_mutex);
+    _isTerminating = true;
+    _isStopped = true;
+    pIoThread = _pIoThread;
+    _pIoThread = 0;
+  }
+
+  if (pIoThread)
+  {
+    wakeup();
+    pIoThread->join();
+    delete pIoThread;
+  }
+
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  if (_wakeupPipe[0] != -1)
+  {
+    ::close(_wakeupPipe[0]);
+    ::close(_wakeupPipe[1]);
+    _wakeupPipe[0] = _wakeupPipe[1] = -1;
+  }
+}
+
+void SBCMediaProxyClient::wakeup()
+{
+  char c = 0;
+  if (_wakeupPipe[1] != -1)
+    (void)::write(_wakeupPipe[1], &c, 1);
+}
+
+bool SBCMediaProxyClient::isAvailable() const
+{
+  {
+    OSS::mutex_critic_sec_lock lock(_mutex);
+    if (!_pIoThread)
+      return false;
+  }
+
+  if (__atomic_load_n(&_consecutiveTimeouts, __ATOMIC_ACQUIRE) < RPC_MAX_CONSECUTIVE_TIMEOUTS)
+    return true;
+
+  //
+  // The node stopped answering.  Once the probe time is reached exactly one
+  // caller wins the exchange and gets to send a request.  A response resets
+  // the timeout count.  Another timeout pushes the next probe further out.
+  //
+  OSS::UInt64 now = OSS::getTime();
+  OSS::UInt64 nextProbe = __atomic_load_n(&_nextProbe, __ATOMIC_ACQUIRE);
+  if (now < nextProbe)
+    return false;
+  return __atomic_compare_exchange_n(&_nextProbe, &nextProbe, now + RPC_REQUEST_TIMEOUT_MS + RPC_PROBE_INTERVAL_MS,
+    false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+std::size_t SBCMediaProxyClient::getPendingCount() const
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  return _pending.size() + _outbound.size();
+}
+
+bool SBCMediaProxyClient::queueRequest(const PendingRequest::Ptr& pRequest, const json::Object& params)
 {
   //
-  // Put initialization code here.  right there isn't any.
+  // Serialize outside of the lock.  The I/O thread only moves bytes.
   //
+  OSS::JSON::FastWriter::Write(params, pRequest->packet);
+  pRequest->expires = OSS::getTime() + RPC_REQUEST_TIMEOUT_MS;
+  OSS_LOG_DEBUG(pRequest->logId << "SBCMediaProxyClient::sendRequest() >>> Command: " << pRequest->cmd << pRequest->packet);
+
+  {
+    OSS::mutex_critic_sec_lock lock(_mutex);
+    if (!_pIoThread || _isTerminating)
+      return false;
+    pRequest->correlationId = ++_correlationId;
+    _pending[pRequest->correlationId] = pRequest;
+    _outbound.push_back(pRequest);
+
+    //
+    // Wake the I/O thread while holding the lock so stop() cannot close
+    // the pipe underneath us.
+    //
+    wakeup();
+  }
   return true;
 }
 
 bool SBCMediaProxyClient::sendRequest(const std::string& logId, const std::string& cmd, const json::Object& params, json::Object& result)
 {
-  OSS::mutex_critic_sec_lock lock(_mutex);
+  //
+  // Starts the I/O thread on first use.  Refused once stop() was called.
+  //
+  if (!initialize())
+    return false;
 
-  if  (!_pSocket)
-    _pSocket = create_socket(_context, _nodeIndex);
-  
-  if (!_pSocket)
+  PendingRequest::Ptr pRequest(new PendingRequest());
+  pRequest->logId = logId;
+  pRequest->cmd = cmd;
+
+  try
+  {
+    if (!queueRequest(pRequest, params))
+      return false;
+  }
+  catch(const std::exception& e)
+  {
+    OSS_LOG_ERROR(logId << "SBCMediaProxyClient::sendRequest() - Exception: " << e.what());
     return false;
-  
+  }
+
+  //
+  // The I/O thread always completes the request, either with the response
+  // or when it expires.  The extra margin only guards against a wedged loop.
+  //
+  if (!pRequest->done.tryWait(RPC_REQUEST_TIMEOUT_MS + 1000))
+  {
+    OSS::mutex_critic_sec_lock lock(_mutex);
+    _pending.erase(pRequest->correlationId);
+    OSS_LOG_ERROR(logId << "SBCMediaProxyClient::sendRequest() - Exception: READ timeout!");
+    return false;
+  }
+
+  if (pRequest->ok)
+    result = pRequest->result;
+  return pRequest->ok;
+}
+
+bool SBCMediaProxyClient::sendRequest(const std::string& logId, const std::string& cmd, const json::Object& params, const ResultHandler& handler)
+{
+  if (!initialize())
+    return false;
+
+  PendingRequest::Ptr pRequest(new PendingRequest());
+  pRequest->logId = logId;
+  pRequest->cmd = cmd;
+  pRequest->handler = handler;
+
   try
   {
-    if (!s_sendmore(*_pSocket, cmd))
+    return queueRequest(pRequest, params);
+  }
+  catch(const std::exception& e)
+  {
+    OSS_LOG_ERROR(logId << "SBCMediaProxyClient::sendRequest() - Exception: " << e.what());
+  }
+  return false;
+}
+
+void SBCMediaProxyClient::completeRequest(const PendingRequest::Ptr& pRequest, bool ok)
+{
+  pRequest->ok = ok;
+  if (ok)
+    updateSessionCount(pRequest->result);
+
+  if (pRequest->handler)
+  {
+    try
     {
-      OSS_LOG_ERROR(logId << "SBCMediaProxyClient::sendRequest() - Exception: SENDMORE failed");
-      delete _pSocket;
-      _pSocket = 0;
-      return false;
+      pRequest->handler(ok, pRequest->result);
     }
-    
-    std::stringstream wstrm;
-    json::Writer::Write(params, wstrm);
-    std::string packet = wstrm.str();
-    OSS_LOG_DEBUG(logId << "SBCMediaProxyClient::sendRequest() >>> Command: " << cmd << packet);
-    if (!s_send(*_pSocket, packet))
+    catch(const std::exception& e)
+    {
+      OSS_LOG_ERROR(pRequest->logId << "SBCMediaProxyClient::completeRequest() - Exception: " << e.what());
+    }
+  }
+  pRequest->done.set();
+}
+
+void SBCMediaProxyClient::updateSessionCount(json::Object& result)
+{
+  if (result.Find("sessionCount") != result.End())
+  {
+    json::Number& sessionCount = result["sessionCount"];
+    _sessionCount = sessionCount.Value();
+  }
+}
+
+void SBCMediaProxyClient::runIoLoop()
+{
+  zmq::socket_t* pSocket = 0;
+
+  while (true)
+  {
+    {
+      OSS::mutex_critic_sec_lock lock(_mutex);
+      if (_isTerminating)
+        break;
+    }
+
+    if (!pSocket)
+    {
+      pSocket = create_socket(_context, _address);
+      if (!pSocket)
+      {
+        OSS::thread_sleep(100);
+        expireRequests();
+        continue;
+      }
+      _isConnected = true;
+    }
+
+    try
+    {
+      zmq::pollitem_t items[] = {
+        { *pSocket, 0, ZMQ_POLLIN, 0 },
+        { 0, _wakeupPipe[0], ZMQ_POLLIN, 0 }
+      };
+      zmq::poll(&items[0], 2, ZMQ_POLL_INTERVAL);
+
+      if (items[1].revents & ZMQ_POLLIN)
+      {
+        char buf[256];
+        while (::read(_wakeupPipe[0], buf, sizeof(buf)) > 0);
+      }
+
+      if (items[0].revents & ZMQ_POLLIN)
+        readResponses(*pSocket);
+
+      if (!flushOutbound(*pSocket))
+      {
+        delete pSocket;
+        pSocket = 0;
+        _isConnected = false;
+      }
+    }
+    catch(const std::exception& e)
     {
-      OSS_LOG_ERROR(logId << "SBCMediaProxyClient::sendRequest() - Exception: SEND failed");
-      delete _pSocket;
-      _pSocket = 0;
+      OSS_LOG_ERROR("SBCMediaProxyClient::runIoLoop() - Exception: " << e.what());
+      delete pSocket;
+      pSocket = 0;
+      _isConnected = false;
+    }
+
+    expireRequests();
+  }
+
+  delete pSocket;
+  _isConnected = false;
+
+  //
+  // Fail whatever is still outstanding so no caller is left waiting
+  //
+  PendingRequests pending;
+  {
+    OSS::mutex_critic_sec_lock lock(_mutex);
+    pending.swap(_pending);
+    _outbound.clear();
+  }
+  for (PendingRequests::iterator iter = pending.begin(); iter != pending.end(); iter++)
+    completeRequest(iter->second, false);
+}
+
+bool SBCMediaProxyClient::flushOutbound(zmq::socket_t& socket)
+{
+  OutboundQueue outbound;
+  {
+    OSS::mutex_critic_sec_lock lock(_mutex);
+    outbound.swap(_outbound);
+  }
+
+  for (OutboundQueue::iterator iter = outbound.begin(); iter != outbound.end(); iter++)
+  {
+    PendingRequest::Ptr pRequest = *iter;
+    std::ostringstream correlationId;
+    correlationId << pRequest->correlationId;
+    if (!s_send(socket, correlationId.str(), ZMQ_SNDMORE) ||
+      !s_send(socket, std::string(), ZMQ_SNDMORE) ||
+      !s_send(socket, pRequest->cmd, ZMQ_SNDMORE) ||
+      !s_send(socket, pRequest->packet, 0))
+    {
+      OSS_LOG_ERROR(pRequest->logId << "SBCMediaProxyClient::sendRequest() - Exception: SEND failed");
+      //
+      // Requeue everything we have not sent yet.  The socket will be recreated.
+      //
+      OSS::mutex_critic_sec_lock lock(_mutex);
+      _outbound.insert(_outbound.begin(), iter, outbound.end());
       return false;
     }
-    
-#if RES_USE_POLL
     //
-    // pool the socket for a response
-    // delete it if no response is received
+    // Release the serialized payload early.  Large SDP bodies add up
+    // when many requests are in flight.
+    //
+    std::string().swap(pRequest->packet);
+  }
+  return true;
+}
+
+void SBCMediaProxyClient::readResponses(zmq::socket_t& socket)
+{
+  while (true)
+  {
+    //
+    // Response envelope is [correlation-id][empty][result]
     //
-    zmq::pollitem_t items[] = { { *_pSocket, 0, ZMQ_POLLIN, 0 } };
-    zmq::poll (&items[0], 1, ZMQ_READ_TIMEOUT);
-            
-    if (items[0].revents & ZMQ_POLLIN) 
+    std::vector<std::string> frames;
+    zmq::message_t message;
+    if (!socket.recv(&message, ZMQ_NOBLOCK))
+      return;
+    frames.push_back(std::string(static_cast<char*>(message.data()), message.size()));
+    while (s_has_more(socket))
+    {
+      zmq::message_t part;
+      socket.recv(&part);
+      frames.push_back(std::string(static_cast<char*>(part.data()), part.size()));
+    }
+
+    if (frames.size() < 2)
     {
-#endif     
-      std::string raw;
-      s_receive(*_pSocket, raw);
-      std::stringstream rstrm;
-      rstrm << raw;
-      OSS_LOG_DEBUG(logId << "SBCMediaProxyClient::sendRequest() <<< Command: " << cmd << raw);
-      json::Reader::Read(result, rstrm);
- #if RES_USE_POLL
+      OSS_LOG_WARNING("SBCMediaProxyClient::readResponses() - Dropping malformed response");
+      continue;
     }
-    else
+
+    OSS::UInt64 correlationId = OSS::string_to_number<OSS::UInt64>(frames.front());
+    PendingRequest::Ptr pRequest;
     {
-      OSS_LOG_ERROR(logId << "SBCMediaProxyClient::sendRequest() - Exception: READ timeout!");
-      delete _pSocket;
-      _pSocket = 0;
-      return false;
+      OSS::mutex_critic_sec_lock lock(_mutex);
+      PendingRequests::iterator iter = _pending.find(correlationId);
+      if (iter == _pending.end())
+        continue; // Expired.  Nobody is waiting for this one anymore
+      pRequest = iter->second;
+      _pending.erase(iter);
     }
-#endif
+    __atomic_store_n(&_consecutiveTimeouts, 0, __ATOMIC_RELEASE);
+    _probeInterval = RPC_PROBE_INTERVAL_MS;
+
+    const std::string& raw = frames.back();
+    OSS_LOG_DEBUG(pRequest->logId << "SBCMediaProxyClient::sendRequest() <<< Command: " << pRequest->cmd << raw);
+    bool ok = true;
+    try
+    {
+      OSS::JSON::FastReader::Read(pRequest->result, raw);
+    }
+    catch(const std::exception& e)
+    {
+      OSS_LOG_ERROR(pRequest->logId << "SBCMediaProxyClient::readResponses() - Exception: " << e.what());
+      ok = false;
+    }
+    completeRequest(pRequest, ok);
   }
-  catch(const std::exception& e)
+}
+
+void SBCMediaProxyClient::expireRequests()
+{
+  std::vector<PendingRequest::Ptr> expired;
+  OSS::UInt64 now = OSS::getTime();
   {
-    OSS_LOG_ERROR(logId << "SBCMediaProxyClient::sendRequest() - Exception: " << e.what());
+    OSS::mutex_critic_sec_lock lock(_mutex);
+    for (PendingRequests::iterator iter = _pending.begin(); iter != _pending.end();)
+    {
+      if (iter->second->expires <= now)
+      {
+        expired.push_back(iter->second);
+        _pending.erase(iter++);
+      }
+      else
+      {
+        ++iter;
+      }
+    }
   }
-  catch(...)
+
+  if (!expired.empty() &&
+    __atomic_add_fetch(&_consecutiveTimeouts, expired.size(), __ATOMIC_ACQ_REL) >= RPC_MAX_CONSECUTIVE_TIMEOUTS)
   {
-    OSS_LOG_ERROR(logId << "SBCMediaProxyClient::sendRequest() - Exception: unknown");
+    //
+    // Only the I/O thread touches the probe interval
+    //
+    __atomic_store_n(&_nextProbe, now + _probeInterval, __ATOMIC_RELEASE);
+    _probeInterval = std::min<OSS::UInt64>(_probeInterval * 2, RPC_MAX_PROBE_INTERVAL_MS);
+  }
+
+  for (std::vector<PendingRequest::Ptr>::iterator iter = expired.begin(); iter != expired.end(); iter++)
+  {
+    OSS_LOG_ERROR((*iter)->logId << "SBCMediaProxyClient::sendRequest() - Exception: READ timeout!");
+    completeRequest(*iter, false);
   }
-  return true;
 }
 
 bool SBCMediaProxyClient::handleSDP(
@@ -298,12 +606,6 @@ bool SBCMediaProxyClient::handleSDP(
           json::String& sdpVal = result["sdp"];
           sdp = sdpVal.Value();
         }
-        
-        if (result.Find("sessionCount") != result.End())
-        {
-          json::Number& sessionCount = result["sessionCount"];
-          _sessionCount = sessionCount.Value();
-        }
       }
     }
   }
@@ -326,14 +628,10 @@ bool SBCMediaProxyClient::removeSession(const std::string& sessionId)
   {
     json::Object params;
     params["sessionId"] = json::String(sessionId);
-    json::Object result;
-    ok =  sendRequest("", CMD_REMOVE_SESSION, params, result);
-
-    if (result.Find("sessionCount") != result.End())
-    {
-      json::Number& sessionCount = result["sessionCount"];
-      _sessionCount = sessionCount.Value();
-    }
+    //
+    // Nobody needs the result of a removal.  Do not hold the caller.
+    //
+    ok =  sendRequest("", CMD_REMOVE_SESSION, params, ResultHandler());
   }
   catch(const std::exception& e)
   {
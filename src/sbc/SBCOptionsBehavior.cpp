@@ -27,6 +27,7 @@
 #include "OSS/SIP/SBC/SBCOptionsBehavior.h"
 #include "OSS/SIP/SBC/SBCRegisterBehavior.h"
 #include "OSS/SIP/SBC/SBCManager.h"
+#include "OSS/UTL/IdGenerator.h"
 
 
 namespace OSS {
@@ -99,8 +100,7 @@ SIPMessage::Ptr SBCOptionsBehavior::onRouteTransaction(
   if (!pRequest->getProperty(OSS::PropertyMap::PROP_TargetTransport, targetTransport) || targetTransport.empty())
     targetTransport = "udp";
   OSS::string_to_upper(targetTransport);
-  std::string viaBranch = "z9hG4bK";
-  viaBranch += OSS::string_create_uuid();
+  std::string viaBranch = OSS::IdGenerator::createBranch();
   std::string newVia = SBCContact::constructVia(_pManager, pRequest, localInterface, targetTransport, viaBranch);
   pRequest->hdrListPrepend("Via", newVia);
 
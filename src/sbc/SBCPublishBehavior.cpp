@@ -26,6 +26,7 @@
 
 #include "OSS/SIP/SBC/SBCPublishBehavior.h"
 #include "OSS/SIP/SBC/SBCManager.h"
+#include "OSS/UTL/IdGenerator.h"
 
 
 namespace OSS {
@@ -95,8 +96,7 @@ SIPMessage::Ptr SBCPublishBehavior::onRouteTransaction(
   if (!pRequest->getProperty(OSS::PropertyMap::PROP_TargetTransport, targetTransport) || targetTransport.empty())
     targetTransport = "udp";
   OSS::string_to_upper(targetTransport);
-  std::string viaBranch = "z9hG4bK";
-  viaBranch += OSS::string_create_uuid();
+  std::string viaBranch = OSS::IdGenerator::createBranch();
   std::string newVia = SBCContact::constructVia(_pManager, pRequest, localInterface, targetTransport, viaBranch);
   pRequest->hdrListPrepend("Via", newVia);
 
@@ -27,6 +27,7 @@
 
 #include "OSS/Net/DNS.h"
 #include "OSS/UTL/Logger.h"
+#include "OSS/UTL/IdGenerator.h"
 #include "OSS/SIP/SBC/SBCRegisterBehavior.h"
 #include "OSS/SIP/SBC/SBCManager.h"
 #include "OSS/SIP/SIPXOR.h"
@@ -228,7 +229,7 @@ void SBCRegisterBehavior::sendOptionsKeepAlive(const std::string& regRecord)
       return;
     }
 
-    std::string callId = OSS::string_create_uuid();
+    std::string callId = OSS::IdGenerator::createCallId();
     size_t hash = OSS::string_hash(callId.c_str());
 
     SIPTo to(aor.str());
@@ -421,8 +422,7 @@ SIPMessage::Ptr SBCRegisterBehavior::onRouteTransaction(
   if (!pRequest->getProperty(OSS::PropertyMap::PROP_TargetTransport, targetTransport) || targetTransport.empty())
     targetTransport = "udp";
   OSS::string_to_upper(targetTransport);
-  std::string viaBranch = "z9hG4bK";
-  viaBranch += OSS::string_create_uuid();
+  std::string viaBranch = OSS::IdGenerator::createBranch();
   std::string newVia = SBCContact::constructVia(_pManager, pRequest, localInterface, targetTransport, viaBranch);
   pRequest->hdrListPrepend("Via", newVia);
 
@@ -1136,7 +1136,7 @@ void SBCRegisterBehavior::sendGatewayKeepAlive(Gateway& gateway)
   }
   gateway.nextSendCounter = gateway.frequencyInSeconds;
 
-  std::string callId = OSS::string_create_uuid();
+  std::string callId = OSS::IdGenerator::createCallId();
   size_t hash = OSS::string_hash(callId.c_str());
     
   OSS::Net::IPAddress target(gateway.targetAdddress);
@@ -59,9 +59,19 @@ void SIPFSMDispatch::onReceivedMessage(SIPMessage::Ptr pMsg, SIPTransportSession
     return;
   }
 
+  //
+  // Admission is decided from the raw start line and To header so that a
+  // request shed under overload does not pay for a full parse first.  The
+  // handler parses the requests it rejects to build the response.
+  //
+  SIPMessage::Ptr pRejection;
+  if (_requestAdmissionHandler)
+    pRejection = _requestAdmissionHandler(pMsg, pTransport);
+
   try
   {
-    pMsg->parse();
+    if (pMsg->startLine().empty())
+      pMsg->parse();
   }
   catch(const OSS::Exception& e)
   {
@@ -78,6 +88,14 @@ void SIPFSMDispatch::onReceivedMessage(SIPMessage::Ptr pMsg, SIPTransportSession
     return;  // don't throw here
              // we don't have control over what we receive from the transport
 
+  if (pRejection && pMsg->isRequest() && !pMsg->isRequest("ACK"))
+  {
+    SIPTransaction::Type type = OSS::string_caseless_starts_with(pMsg->startLine(), "invite") ?
+      SIPTransaction::TYPE_IST : SIPTransaction::TYPE_NIST;
+    if (!admitRequest(pMsg, pTransport, pRejection, id, type))
+      return;
+  }
+
   SIPTransaction::Ptr trn;
   SIPTransaction::Type transactionType = SIPTransaction::TYPE_UNKNOWN;
   if (pMsg->isRequest())
@@ -199,6 +217,45 @@ void SIPFSMDispatch::onReceivedMessage(SIPMessage::Ptr pMsg, SIPTransportSession
   }
 }
 
+bool SIPFSMDispatch::admitRequest(
+  const SIPMessage::Ptr& pMsg,
+  const SIPTransportSession::Ptr& pTransport,
+  const SIPMessage::Ptr& pResponse,
+  const std::string& id,
+  SIPTransaction::Type transactionType)
+{
+  //
+  // Retransmissions of a request that was already admitted belong to
+  // an existing transaction and are never rejected
+  //
+  SIPTransaction::Ptr trn = (transactionType == SIPTransaction::TYPE_IST) ?
+    _ist.findTransaction(id, false) : _nist.findTransaction(id, false);
+  if (trn)
+    return true;
+
+  //
+  // Reject statelessly.  Keeping no transaction state is the point of
+  // shedding so a retransmitted request is simply rejected again.
+  //
+  try
+  {
+    if (pTransport->isReliableTransport())
+    {
+      pTransport->writeMessage(pResponse);
+    }
+    else
+    {
+      OSS::Net::IPAddress remoteAddress = pTransport->getRemoteAddress();
+      pTransport->writeMessage(pResponse, remoteAddress.toString(), OSS::string_from_number(remoteAddress.getPort()));
+    }
+  }
+  catch(const OSS::Exception& e)
+  {
+    OSS_LOG_WARNING(pMsg->createContextId(true) << "SIPFSMDispatch::admitRequest - Unable to send " << pResponse->startLine() << " - " << e.message());
+  }
+  return false;
+}
+
 SIPTransaction::Ptr SIPFSMDispatch::createClientTransaction(const SIPMessage::Ptr& pRequest)
 {
   if (!pRequest->isRequest())
@@ -964,6 +964,16 @@ void SIPStack::initTransportFromConfig(const boost::filesystem::path& cfgFile)
       OSS_LOG_ERROR("Unable to set WebSocket port base " << wsPortBase << "-" << wsPortMax << " Using default values.");
     }
   }
+
+  //
+  // Set the number of io_service shards per WebSocket listener
+  //
+  if (listeners.exists("sip-ws-shard-count"))
+  {
+    unsigned int wsShardCount = listeners["sip-ws-shard-count"];
+    OSS_LOG_INFO("Setting WebSocket shard count to " << wsShardCount);
+    transport().setWSShardCount(wsShardCount);
+  }
 #endif
 
   if (listeners.exists("packet-rate-ratio"))
@@ -1414,6 +1424,16 @@ void SIPStack::initTransportFromJSON(const OSS::JSON::Object& json)
       OSS_LOG_ERROR("Unable to set WebSocket port base " << wsPortBase.Value() << "-" << wsPortMax.Value() << " Using default values.");
     }
   }
+
+  //
+  // Set the number of io_service shards per WebSocket listener
+  //
+  if (json.Exists("sip_ws_shard_count"))
+  {
+    JNum wsShardCount = json["sip_ws_shard_count"];
+    OSS_LOG_INFO("Setting WebSocket shard count to " << wsShardCount.Value());
+    transport().setWSShardCount((std::size_t)wsShardCount.Value());
+  }
 #endif
   
   if (json.Exists("packet_rate_ratio"))
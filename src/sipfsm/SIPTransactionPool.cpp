@@ -88,6 +88,12 @@ SIPTransaction::Ptr SIPTransactionPool::findTransaction(const std::string& id, b
   return trn;
 }
 
+std::size_t SIPTransactionPool::getSize()
+{
+  boost::lock_guard<boost::mutex> lock(_mutex);
+  return _transactionPool.size();
+}
+
 bool SIPTransactionPool::removeTransaction(const std::string &id)
 {
   boost::lock_guard<boost::mutex> lock(_mutex);
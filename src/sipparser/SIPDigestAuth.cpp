@@ -19,16 +19,219 @@
 
 
 #include <vector>
+#include <ctime>
+#include <cstring>
+#include <boost/thread/tss.hpp>
+#include <openssl/evp.h>
+#include <openssl/md5.h>
+#include <openssl/sha.h>
 
 #include "OSS/SIP/SIPDigestAuth.h"
 #include "OSS/SIP/SIPParser.h"
+#include "OSS/UTL/Thread.h"
 
-static std::string MD5_NONCE_KEY = "toadfish";
+static const char* DEFAULT_NONCE_KEY = "toadfish";
+static unsigned int NONCE_LIFETIME = 300;
+static const std::size_t NONCE_TIME_SIZE = 8;
+static const std::size_t NONCE_SIGNATURE_SIZE = SHA_DIGEST_LENGTH * 2;
+static const std::size_t NONCE_REPLAY_SLOTS = 16384;
+static const std::size_t NONCE_REPLAY_LOCKS = 64;
 
 namespace OSS {
 namespace SIP {
 
 
+static const char DIGEST_HEX[] = "0123456789abcdef";
+
+struct DigestPart
+{
+  const char* data;
+  std::size_t size;
+};
+
+struct NonceReplayEntry
+{
+  OSS::UInt64 tag;
+  OSS::UInt32 nonceCount;
+};
+
+static NonceReplayEntry NONCE_REPLAY_TABLE[NONCE_REPLAY_SLOTS];
+static OSS::mutex_critic_sec NONCE_REPLAY_MUTEX[NONCE_REPLAY_LOCKS];
+
+struct DigestScratch : boost::noncopyable
+  /// Digest contexts owned by one thread and reused for every hash
+{
+  DigestScratch() : inner(EVP_MD_CTX_new()), outer(EVP_MD_CTX_new()) {}
+  ~DigestScratch() { EVP_MD_CTX_free(inner); EVP_MD_CTX_free(outer); }
+  EVP_MD_CTX* inner;
+  EVP_MD_CTX* outer;
+};
+
+static boost::thread_specific_ptr<DigestScratch> DIGEST_SCRATCH;
+
+static DigestScratch& digest_scratch()
+{
+  if (!DIGEST_SCRATCH.get())
+    DIGEST_SCRATCH.reset(new DigestScratch());
+  return *DIGEST_SCRATCH;
+}
+
+class NonceSigner : boost::noncopyable
+  /// HMAC-SHA1 with the key pads of the secret hashed once.  The pads are
+  /// copied into per thread contexts under a read lock so that setKey()
+  /// may be called while other threads sign.
+{
+public:
+  NonceSigner() :
+    _inner(EVP_MD_CTX_new()),
+    _outer(EVP_MD_CTX_new())
+  {
+    setKey(DEFAULT_NONCE_KEY);
+  }
+
+  ~NonceSigner()
+  {
+    EVP_MD_CTX_free(_inner);
+    EVP_MD_CTX_free(_outer);
+  }
+
+  void setKey(const std::string& key)
+  {
+    unsigned char block[64];
+    std::memset(block, 0, sizeof(block));
+    if (key.size() > sizeof(block))
+      EVP_Digest(key.data(), key.size(), block, 0, EVP_sha1(), 0);
+    else
+      std::memcpy(block, key.data(), key.size());
+
+    unsigned char innerPad[64];
+    unsigned char outerPad[64];
+    for (std::size_t i = 0; i < sizeof(block); i++)
+    {
+      innerPad[i] = block[i] ^ 0x36;
+      outerPad[i] = block[i] ^ 0x5C;
+    }
+
+    OSS::mutex_write_lock lock(_mutex);
+    _key = key;
+    EVP_DigestInit_ex(_inner, EVP_sha1(), 0);
+    EVP_DigestUpdate(_inner, innerPad, sizeof(innerPad));
+    EVP_DigestInit_ex(_outer, EVP_sha1(), 0);
+    EVP_DigestUpdate(_outer, outerPad, sizeof(outerPad));
+  }
+
+  std::string getKey() const
+  {
+    OSS::mutex_read_lock lock(_mutex);
+    return _key;
+  }
+
+  void sign(const char* time, const std::string& key, char* hex) const
+  {
+    DigestScratch& scratch = digest_scratch();
+    {
+      //
+      // Both pads must come from the same key
+      //
+      OSS::mutex_read_lock lock(_mutex);
+      EVP_MD_CTX_copy_ex(scratch.inner, _inner);
+      EVP_MD_CTX_copy_ex(scratch.outer, _outer);
+    }
+
+    unsigned char digest[SHA_DIGEST_LENGTH];
+    EVP_DigestUpdate(scratch.inner, time, NONCE_TIME_SIZE);
+    EVP_DigestUpdate(scratch.inner, ":", 1);
+    EVP_DigestUpdate(scratch.inner, key.data(), key.size());
+    EVP_DigestFinal_ex(scratch.inner, digest, 0);
+    EVP_DigestUpdate(scratch.outer, digest, sizeof(digest));
+    EVP_DigestFinal_ex(scratch.outer, digest, 0);
+    for (std::size_t i = 0; i < sizeof(digest); i++)
+    {
+      hex[i * 2] = DIGEST_HEX[digest[i] >> 4];
+      hex[i * 2 + 1] = DIGEST_HEX[digest[i] & 0x0F];
+    }
+  }
+
+private:
+  mutable OSS::mutex_read_write _mutex;
+  std::string _key;
+  EVP_MD_CTX* _inner;
+  EVP_MD_CTX* _outer;
+};
+
+static NonceSigner& nonce_signer()
+{
+  static NonceSigner signer;
+  return signer;
+}
+
+static void digest_unquote(const std::string& value, DigestPart& part)
+  /// Same as SIPParser::unquoteString() without copying the string
+{
+  const char* begin = value.data();
+  const char* end = begin + value.size();
+  while (begin < end && ::isspace((unsigned char)*begin))
+    begin++;
+  while (end > begin && ::isspace((unsigned char)*(end - 1)))
+    end--;
+  if (end - begin >= 2 && *begin == '"' && *(end - 1) == '"')
+  {
+    begin++;
+    end--;
+  }
+  part.data = begin;
+  part.size = end - begin;
+}
+
+static void digest_part(const std::string& value, DigestPart& part)
+{
+  part.data = value.data();
+  part.size = value.size();
+}
+
+static std::string digest_md5_hex(const DigestPart* parts, std::size_t count)
+  /// MD5 of the parts joined by ':' returned as lower case hex.  The parts
+  /// are fed to MD5 directly so no intermediate string is built.
+{
+  EVP_MD_CTX* ctx = digest_scratch().inner;
+  EVP_DigestInit_ex(ctx, EVP_md5(), 0);
+  for (std::size_t i = 0; i < count; i++)
+  {
+    if (i)
+      EVP_DigestUpdate(ctx, ":", 1);
+    EVP_DigestUpdate(ctx, parts[i].data, parts[i].size);
+  }
+  unsigned char digest[MD5_DIGEST_LENGTH];
+  EVP_DigestFinal_ex(ctx, digest, 0);
+
+  char hex[MD5_DIGEST_LENGTH * 2];
+  for (std::size_t i = 0; i < MD5_DIGEST_LENGTH; i++)
+  {
+    hex[i * 2] = DIGEST_HEX[digest[i] >> 4];
+    hex[i * 2 + 1] = DIGEST_HEX[digest[i] & 0x0F];
+  }
+  return std::string(hex, sizeof(hex));
+}
+
+static bool digest_parse_hex(const char* hex, std::size_t size, OSS::UInt64& value)
+{
+  value = 0;
+  for (std::size_t i = 0; i < size; i++)
+  {
+    char c = hex[i];
+    value <<= 4;
+    if (c >= '0' && c <= '9')
+      value |= c - '0';
+    else if (c >= 'a' && c <= 'f')
+      value |= c - 'a' + 10;
+    else if (c >= 'A' && c <= 'F')
+      value |= c - 'A' + 10;
+    else
+      return false;
+  }
+  return true;
+}
+
 SIPDigestAuth::SIPDigestAuth()
 {
 }
@@ -39,7 +242,12 @@ SIPDigestAuth::~SIPDigestAuth()
 
 void SIPDigestAuth::setSecretKey(const std::string& key)
 {
-  MD5_NONCE_KEY = key;
+  nonce_signer().setKey(key);
+}
+
+void SIPDigestAuth::setNonceLifetime(unsigned int seconds)
+{
+  NONCE_LIFETIME = seconds;
 }
 
 std::string SIPDigestAuth::digestCreateA1Hash(
@@ -47,38 +255,40 @@ std::string SIPDigestAuth::digestCreateA1Hash(
   const std::string& password,
   const std::string& realm)
 {
-  std::string userName_ = userName;
-  std::string realm_ = realm;
-  SIPParser::unquoteString(userName_);
-  SIPParser::unquoteString(realm_);
-  std::ostringstream input;
-  input << userName_ << ":" << realm_ << ":" << password;
-  return OSS::string_md5_hash(input.str().c_str());
+  DigestPart parts[3];
+  digest_unquote(userName, parts[0]);
+  digest_unquote(realm, parts[1]);
+  digest_part(password, parts[2]);
+  return digest_md5_hex(parts, 3);
 }
     /// Create an A1 MD5 Hash
 
 std::string SIPDigestAuth::digestCreateA2Hash(const std::string& uri, const char* method)
 {
-  std::ostringstream input;
-  input << method << ":" << uri;
-  return OSS::string_md5_hash(input.str().c_str());
+  DigestPart parts[2];
+  parts[0].data = method;
+  parts[0].size = std::strlen(method);
+  digest_part(uri, parts[1]);
+  return digest_md5_hex(parts, 2);
 }
 
 std::string SIPDigestAuth::digestCreateNonce(const std::string& key)
 {
-  std::ostringstream input;
-  input << MD5_NONCE_KEY << ":" << key;
-  return OSS::string_md5_hash(input.str().c_str());
+  std::string secretKey = nonce_signer().getKey();
+  DigestPart parts[2];
+  digest_part(secretKey, parts[0]);
+  digest_part(key, parts[1]);
+  return digest_md5_hex(parts, 2);
 }
 
 std::string SIPDigestAuth::digestCreateAuthorization(const std::string& a1,
     const std::string& nonce, const std::string& a2)
 {
-  std::string nonce_ = nonce;
-  SIPParser::unquoteString(nonce_);
-  std::ostringstream input;
-  input << a1 << ":" << nonce_ << ":" << a2;
-  return OSS::string_md5_hash(input.str().c_str());
+  DigestPart parts[3];
+  digest_part(a1, parts[0]);
+  digest_unquote(nonce, parts[1]);
+  digest_part(a2, parts[2]);
+  return digest_md5_hex(parts, 3);
 }
 
 std::string SIPDigestAuth::digestCreateAuthorizationQop(
@@ -89,22 +299,84 @@ std::string SIPDigestAuth::digestCreateAuthorizationQop(
   const std::string& qop,
   const std::string& a2)
 {
-  std::string nonce_ = nonce;
-  std::string cnonce_ = cnonce;
-  std::string qop_ = qop;
-  SIPParser::unquoteString(nonce_);
-  SIPParser::unquoteString(cnonce_);
-  SIPParser::unquoteString(qop_);
+  DigestPart parts[6];
+  digest_part(a1, parts[0]);
+  digest_unquote(nonce, parts[1]);
+  digest_part(nonceCount, parts[2]);
+  digest_unquote(cnonce, parts[3]);
+  digest_unquote(qop, parts[4]);
+  digest_part(a2, parts[5]);
+  return digest_md5_hex(parts, 6);
+}
+
+std::string SIPDigestAuth::digestCreateSignedNonce(const std::string& key)
+{
+  OSS::UInt32 now = (OSS::UInt32)std::time(0);
+  char nonce[NONCE_TIME_SIZE + NONCE_SIGNATURE_SIZE];
+  for (std::size_t i = 0; i < NONCE_TIME_SIZE; i++)
+    nonce[i] = DIGEST_HEX[(now >> (28 - i * 4)) & 0x0F];
+  nonce_signer().sign(nonce, key, nonce + NONCE_TIME_SIZE);
+  return std::string(nonce, sizeof(nonce));
+}
+
+SIPDigestAuth::NonceStatus SIPDigestAuth::digestValidateNonce(
+  const std::string& nonce,
+  const std::string& key,
+  const std::string& nonceCount)
+{
+  DigestPart value;
+  digest_unquote(nonce, value);
+  if (value.size != NONCE_TIME_SIZE + NONCE_SIGNATURE_SIZE)
+    return NONCE_INVALID;
+
+  OSS::UInt64 issued = 0;
+  if (!digest_parse_hex(value.data, NONCE_TIME_SIZE, issued))
+    return NONCE_INVALID;
 
-  std::ostringstream input;
-  input << a1 << ":"
-          << nonce_ << ":"
-          << nonceCount << ":"
-          << cnonce_ << ":"
-          << qop_ << ":"
-          << a2;
+  char signature[NONCE_SIGNATURE_SIZE];
+  nonce_signer().sign(value.data, key, signature);
+  unsigned char diff = 0;
+  for (std::size_t i = 0; i < NONCE_SIGNATURE_SIZE; i++)
+    diff |= (unsigned char)(signature[i] ^ ::tolower((unsigned char)value.data[NONCE_TIME_SIZE + i]));
+  if (diff)
+    return NONCE_INVALID;
 
-  return OSS::string_md5_hash(input.str().c_str());
+  OSS::UInt64 now = (OSS::UInt32)std::time(0);
+  if (issued > now + 60 || (issued < now && now - issued > NONCE_LIFETIME))
+    return NONCE_STALE;
+
+  if (nonceCount.empty())
+    return NONCE_VALID;
+
+  OSS::UInt64 count = 0;
+  if (nonceCount.size() > 8 || !digest_parse_hex(nonceCount.data(), nonceCount.size(), count) || !count)
+    return NONCE_INVALID;
+
+  //
+  // The signature is uniformly distributed so its leading bits are used
+  // directly as the table index and tag
+  //
+  OSS::UInt64 tag = 0;
+  digest_parse_hex(signature, 16, tag);
+  std::size_t slot = (std::size_t)(tag % NONCE_REPLAY_SLOTS);
+  OSS::mutex_critic_sec_lock lock(NONCE_REPLAY_MUTEX[slot % NONCE_REPLAY_LOCKS]);
+  NonceReplayEntry& entry = NONCE_REPLAY_TABLE[slot];
+  if (entry.tag == tag && count <= entry.nonceCount)
+    return NONCE_REPLAYED;
+  entry.tag = tag;
+  entry.nonceCount = (OSS::UInt32)count;
+  return NONCE_VALID;
+}
+
+SIPDigestAuth::NonceStatus SIPDigestAuth::digestConsumeNonce(
+  const std::string& nonce,
+  const std::string& key)
+{
+  //
+  // Recording the use as the first nonce count makes any reuse fail
+  // the increasing count check
+  //
+  return digestValidateNonce(nonce, key, "00000001");
 }
 
-} } // OSS::SIP
\ No newline at end of file
+} } // OSS::SIP
@@ -19,6 +19,7 @@
 
 
 #include "OSS/UTL/CoreUtils.h"
+#include "OSS/UTL/IdGenerator.h"
 #include "OSS/SIP/SIPParser.h"
 
 
@@ -315,14 +316,12 @@ void SIPParser::getReasonPhrase(
 
 std::string SIPParser::createBranchString()
 {
-  std::stringstream strm;
-  strm << "z9hG4bK" << OSS::string_create_uuid();
-  return strm.str();
+  return OSS::IdGenerator::createBranch();
 }
 
 std::string SIPParser::createTagString()
 {
-  return OSS::string_create_uuid();
+  return OSS::IdGenerator::createTag();
 }
 
 } } //OSS::SIP
@@ -65,6 +65,8 @@ namespace SIP {
   
 
 static const int DEFAULT_STREAMED_CONNECTION_TIMEOUT = 2; // 2 seconds default timeout
+static const std::size_t MAX_WRITE_BATCH_SIZE = 16384; // one TLS record
+static const std::size_t MAX_OUTBOUND_BACKLOG = 1024 * 1024; // slow consumer threshold
   
 
 SIPStreamedConnection::SIPStreamedConnection(
@@ -81,7 +83,9 @@ SIPStreamedConnection::SIPStreamedConnection(
     _connectionManager(manager),
     _pDispatch(0),
     _readExceptionCount(0),
-    _isStopping(false)
+    _isStopping(false),
+    _outboundBytes(0),
+    _isWriting(false)
 {
   _transportScheme = "tcp";
   _pTcpSocket = new boost::asio::ip::tcp::socket(ioService);
@@ -104,7 +108,9 @@ SIPStreamedConnection::SIPStreamedConnection(
     _connectionManager(manager),
     _pDispatch(0),
     _readExceptionCount(0),
-    _isStopping(false)
+    _isStopping(false),
+    _outboundBytes(0),
+    _isWriting(false)
 {
   _transportScheme = "tls";
   _pTlsStream = new ssl_socket(ioService, *_pTlsContext);
@@ -223,17 +229,84 @@ void SIPStreamedConnection::writeMessage(const std::string& buf)
     return;
   }
   
+  OSS::mutex_critic_sec_lock lock(_writeMutex);
+  if (_outboundBytes + buf.size() > MAX_OUTBOUND_BACKLOG)
+  {
+    //
+    // The peer is not reading fast enough.  Queueing more would only grow
+    // memory without bound so treat it like a failed write.
+    //
+    OSS_LOG_WARNING("SIPStreamedConnection::writeMessage() slow consumer (" << getIdentifier() << ") "
+      << _outboundBytes << " bytes queued.  Closing connection.");
+    boost::system::error_code ignored_ec;
+    _pTcpSocket->shutdown(boost::asio::ip::tcp::socket::shutdown_both, ignored_ec);
+    return;
+  }
+  
+  _outbound.push_back(buf);
+  _outboundBytes += buf.size();
+  if (!_isWriting)
+  {
+    flushOutbound();
+  }
+}
+
+void SIPStreamedConnection::flushOutbound()
+{
+  //
+  // Take whole messages until the batch would exceed one TLS record.  A
+  // single larger message still goes out on its own.
+  //
+  std::size_t batchSize = 0;
+  _inflight.clear();
+  while (!_outbound.empty())
+  {
+    std::size_t size = _outbound.front().size();
+    if (!_inflight.empty() && batchSize + size > MAX_WRITE_BATCH_SIZE)
+    {
+      break;
+    }
+    _inflight.push_back(std::string());
+    _inflight.back().swap(_outbound.front());
+    _outbound.pop_front();
+    batchSize += size;
+  }
+  
+  if (_inflight.empty())
+  {
+    return;
+  }
+  
+  _isWriting = true;
   if (_pTlsStream)
   {
+    //
+    // The SSL stream encrypts one buffer per record so coalesce the batch
+    //
+    _inflightRecord.clear();
+    _inflightRecord.reserve(batchSize);
+    for (std::vector<std::string>::const_iterator iter = _inflight.begin(); iter != _inflight.end(); iter++)
+    {
+      _inflightRecord.append(*iter);
+    }
     ssl_socket& sock = *_pTlsStream;
-    boost::asio::async_write(sock, boost::asio::buffer(buf, buf.size()),
+    boost::asio::async_write(sock, boost::asio::buffer(_inflightRecord),
           boost::bind(&SIPStreamedConnection::handleWrite, shared_from_this(),
             boost::asio::placeholders::error, boost::asio::placeholders::bytes_transferred));
   }
   else if (_pTcpSocket)
   {
+    //
+    // Plain TCP gathers the batch with a single writev
+    //
+    std::vector<boost::asio::const_buffer> buffers;
+    buffers.reserve(_inflight.size());
+    for (std::vector<std::string>::const_iterator iter = _inflight.begin(); iter != _inflight.end(); iter++)
+    {
+      buffers.push_back(boost::asio::buffer(*iter));
+    }
     tcp_socket& sock = *_pTcpSocket;
-    boost::asio::async_write(sock, boost::asio::buffer(buf, buf.size()),
+    boost::asio::async_write(sock, buffers,
           boost::bind(&SIPStreamedConnection::handleWrite, shared_from_this(),
             boost::asio::placeholders::error, boost::asio::placeholders::bytes_transferred));
   }
@@ -246,6 +319,27 @@ void SIPStreamedConnection::writeMessage(const std::string& buf, boost::system::
     return;
   }
   
+  OSS::mutex_critic_sec_lock lock(_writeMutex);
+  if (_isWriting)
+  {
+    //
+    // Writing now would land in the middle of a queued message
+    //
+    if (_outboundBytes + buf.size() > MAX_OUTBOUND_BACKLOG)
+    {
+      //
+      // Let the caller know the message never made it to the queue
+      //
+      OSS_LOG_WARNING("SIPStreamedConnection::writeMessage() slow consumer (" << getIdentifier() << ") "
+        << _outboundBytes << " bytes queued.  Dropping message.");
+      ec = boost::asio::error::no_buffer_space;
+      return;
+    }
+    _outbound.push_back(buf);
+    _outboundBytes += buf.size();
+    return;
+  }
+  
   if (_pTlsStream)
   {
     _pTlsStream->write_some(boost::asio::buffer(buf, buf.size()), ec);
@@ -488,7 +582,22 @@ void SIPStreamedConnection::handleWrite(const boost::system::error_code& e, std:
     return;
   }
   
-  if (e)
+  if (!e)
+  {
+    OSS::mutex_critic_sec_lock lock(_writeMutex);
+    for (std::vector<std::string>::const_iterator iter = _inflight.begin(); iter != _inflight.end(); iter++)
+    {
+      _outboundBytes -= iter->size();
+    }
+    _inflight.clear();
+    _inflightRecord.clear();
+    _isWriting = false;
+    if (!_outbound.empty())
+    {
+      flushOutbound();
+    }
+  }
+  else
   {
     // Initiate graceful connection closure.
     OSS_LOG_WARNING("SIPStreamedConnection::handleWrite() Exception " << e.message());
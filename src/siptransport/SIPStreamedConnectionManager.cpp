@@ -54,6 +54,7 @@ void SIPStreamedConnectionManager::add(SIPStreamedConnection::Ptr conn)
   if (!conn->getIdentifier())
     conn->setIdentifier(++_currentIdentifier);
   _connections[conn->getIdentifier()] = conn;
+  indexConnection(conn);
   OSS_LOG_INFO("SIPStreamedConnectionManager Added transport (" << conn->getIdentifier() << ") "
     << conn->getLocalAddress().toIpPortString() <<
     "->" << conn->getRemoteAddress().toIpPortString() << " Count: " << _connections.size() );
@@ -65,6 +66,7 @@ void SIPStreamedConnectionManager::start(SIPStreamedConnection::Ptr conn)
   if (!conn->getIdentifier())
     conn->setIdentifier(++_currentIdentifier);
   _connections[conn->getIdentifier()] = conn;
+  indexConnection(conn);
   conn->start(_dispatch);
   OSS_LOG_INFO("SIPStreamedConnectionManager started reading from transport (" << conn->getIdentifier() << ") "
     << conn->getLocalAddress().toIpPortString() <<
@@ -80,6 +82,7 @@ void SIPStreamedConnectionManager::stop(SIPStreamedConnection::Ptr conn)
     "->" << conn->getRemoteAddress().toIpPortString() << " Count: " << _connections.size() - 1);
 
   _connections.erase(conn->getIdentifier());
+  unindexConnection(conn);
   conn->stop();
 }
 
@@ -92,16 +95,95 @@ void SIPStreamedConnectionManager::stopAll()
     iter->second->stop();
   }
   _connections.clear();
+  _addressKeys.clear();
+  for (std::size_t i = 0; i < ADDRESS_SHARD_COUNT; i++)
+  {
+    OSS::mutex_write_lock shardLock(_addressShards[i].mutex);
+    _addressShards[i].connections.clear();
+  }
+}
+
+std::string SIPStreamedConnectionManager::getAddressKey(const OSS::Net::IPAddress& address)
+{
+  std::string key;
+  const boost::asio::ip::address& ip = address.address();
+  unsigned short port = address.getPort();
+  if (ip.is_v4())
+  {
+    boost::asio::ip::address_v4::bytes_type bytes = ip.to_v4().to_bytes();
+    key.reserve(bytes.size() + sizeof(port));
+    key.append((const char*)bytes.data(), bytes.size());
+  }
+  else
+  {
+    boost::asio::ip::address_v6 v6 = ip.to_v6();
+    boost::asio::ip::address_v6::bytes_type bytes = v6.to_bytes();
+    unsigned long scope = v6.scope_id();
+    key.reserve(bytes.size() + sizeof(scope) + sizeof(port));
+    key.append((const char*)bytes.data(), bytes.size());
+    key.append((const char*)&scope, sizeof(scope));
+  }
+  key.append((const char*)&port, sizeof(port));
+  return key;
+}
+
+SIPStreamedConnectionManager::AddressShard& SIPStreamedConnectionManager::getAddressShard(const std::string& key)
+{
+  return _addressShards[boost::hash<std::string>()(key) & (ADDRESS_SHARD_COUNT - 1)];
+}
+
+void SIPStreamedConnectionManager::indexConnection(const SIPStreamedConnection::Ptr& conn)
+{
+  //
+  // Called with the connections write lock held
+  //
+  OSS::Net::IPAddress remote = conn->getRemoteAddress();
+  if (!remote.isValid())
+  {
+    return;
+  }
+  std::string key = getAddressKey(remote);
+  _addressKeys[conn->getIdentifier()] = key;
+  AddressShard& shard = getAddressShard(key);
+  OSS::mutex_write_lock shardLock(shard.mutex);
+  shard.connections[key] = conn;
+}
+
+void SIPStreamedConnectionManager::unindexConnection(const SIPStreamedConnection::Ptr& conn)
+{
+  //
+  // Called with the connections write lock held.  The key recorded when the
+  // connection was indexed is used since the socket may be gone by now.
+  //
+  std::map<OSS::UInt64, std::string>::iterator keyIter = _addressKeys.find(conn->getIdentifier());
+  if (keyIter == _addressKeys.end())
+  {
+    return;
+  }
+  AddressShard& shard = getAddressShard(keyIter->second);
+  {
+    OSS::mutex_write_lock shardLock(shard.mutex);
+    AddressIndex::iterator iter = shard.connections.find(keyIter->second);
+    //
+    // A newer connection from the same peer may have replaced this one
+    //
+    if (iter != shard.connections.end() && iter->second == conn)
+    {
+      shard.connections.erase(iter);
+    }
+  }
+  _addressKeys.erase(keyIter);
 }
 
 SIPStreamedConnection::Ptr SIPStreamedConnectionManager::findConnectionByAddress(const OSS::Net::IPAddress& target)
 {
-  OSS::mutex_read_lock rlock(_rwConnectionsMutex);
-  for (std::map<OSS::UInt64, SIPStreamedConnection::Ptr>::iterator iter = _connections.begin();
-    iter != _connections.end(); iter++)
+  std::string key = getAddressKey(target);
+  AddressShard& shard = getAddressShard(key);
+  OSS::mutex_read_lock rlock(shard.mutex);
+  AddressIndex::const_iterator iter = shard.connections.find(key);
+  if (iter != shard.connections.end())
   {
-    if (iter->second->getRemoteAddress().compare(target, true))
-      return iter->second;
+    return iter->second;
   }
   return SIPStreamedConnection::Ptr();
 }
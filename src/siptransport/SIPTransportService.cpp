@@ -70,6 +70,7 @@ SIPTransportService::SIPTransportService(const SIPTransportSession::Dispatch& di
   _wssEnabled(true),
   _wsPortBase(10000),
   _wsPortMax(20000),
+  _wsShardCount(1),
 #endif
   _udpEnabled(true),
   _tcpEnabled(true),
@@ -613,6 +614,7 @@ void SIPTransportService::addWSTransport(const std::string& ip, const std::strin
   
   SIPWebSocketListener::Ptr pWsListener = SIPWebSocketListener::Ptr(new SIPWebSocketListener(this, ip, port, _wsConMgr));
   
+  pWsListener->setShardCount(_wsShardCount);
   pWsListener->setVirtual(isVirtualIp);
   pWsListener->setExternalAddress(externalIp);
   pWsListener->subNets() = subnets;
@@ -646,6 +648,7 @@ void SIPTransportService::addWSSTransport(const std::string& ip, const std::stri
   
   SIPWebSocketTlsListener::Ptr pWsListener = SIPWebSocketTlsListener::Ptr(new SIPWebSocketTlsListener(this, ip, port, _wssConMgr));
   
+  pWsListener->setShardCount(_wsShardCount);
   pWsListener->setVirtual(isVirtualIp);
   pWsListener->setExternalAddress(externalIp);
   pWsListener->subNets() = subnets;
@@ -698,6 +701,17 @@ void SIPTransportService::addTLSTransport(const std::string& ip, const std::stri
   OSS_LOG_INFO("TLS SIP Listener " << ip << ":" << port << " (" << externalIp << ") ACTIVE");
 }
 
+SIPTransportSession::Ptr SIPTransportService::createClientTransport(
+  const OSS::SIP::SIPMessage::Ptr& pMsg,
+  const OSS::Net::IPEndPoint& localAddress,
+  const OSS::Net::IPEndPoint& remoteAddress,
+  const std::string& proto,
+  const std::string& transportId)
+{
+  return createClientTransport(pMsg, OSS::Net::IPAddress(localAddress),
+    OSS::Net::IPAddress(remoteAddress), proto, transportId);
+}
+
 SIPTransportSession::Ptr SIPTransportService::createClientTransport(
   const OSS::SIP::SIPMessage::Ptr& pMsg,
   const OSS::Net::IPAddress& localAddress,
@@ -993,6 +1007,12 @@ void SIPTransportService::sendUDPKeepAlive(const OSS::Net::IPAddress& localAddre
   }
 }
 
+void SIPTransportService::sendUDPKeepAlive(const OSS::Net::IPEndPoint& localAddress,
+    const OSS::Net::IPEndPoint& target)
+{
+  sendUDPKeepAlive(OSS::Net::IPAddress(localAddress), OSS::Net::IPAddress(target));
+}
+
 
 SIPUDPListener::Ptr SIPTransportService::findUDPListener(const std::string& key) const
 {
@@ -41,8 +41,12 @@ void SIPWebSocketConnection::ServerReadWriteHandler::on_close(websocketpp::serve
 void SIPWebSocketConnection::ServerReadWriteHandler::on_message(websocketpp::server::connection_ptr pConnection, websocketpp::server::handler::message_ptr pMsg)
 {
   	boost::system::error_code ec;
-  	std::string payload = pMsg->get_payload();
-  	_rConnection.handleRead(ec, payload.size(), &payload);
+  	//
+  	// Hand the parser a view of the frame payload.  handleRead() only reads
+  	// from the buffer so there is no need to copy it.
+  	//
+  	const std::string& payload = pMsg->get_payload();
+  	_rConnection.handleRead(ec, payload.size(), const_cast<std::string*>(&payload));
 }
 
 void SIPWebSocketConnection::ServerReadWriteHandler::on_error(websocketpp::server::connection_ptr pConnection)
@@ -126,7 +130,7 @@ void SIPWebSocketConnection::handleRead(const boost::system::error_code& e, std:
 	}
 
 	OSS_LOG_DEBUG("SIPWebSocketConnection::handleRead STARTING new connection");
-	std::string* buffer = reinterpret_cast<std::string*>(userData);
+	const std::string* buffer = reinterpret_cast<const std::string*>(userData);
 
 	//
 	// set the last read address
@@ -78,11 +78,10 @@ SIPWebSocketListener::SIPWebSocketListener(
   const std::string& port,
   SIPWebSocketConnectionManager& connectionManager) :
     SIPListener(pTransportService, address, port),
-    _pServerEndPoint(0),
+    _shardCount(1),
     _connectionManager(connectionManager),
     _resolver(pTransportService->ioService())
 {
-	_pServerThread = 0;
 	_pClientThread = 0;
 }
 
@@ -95,40 +94,40 @@ void SIPWebSocketListener::run()
 {
   if (!_hasStarted)
   {
-    assert(!_pServerThread);
-    _pServerThread = new boost::thread(boost::bind(&SIPWebSocketListener::run_server, this));
-    _hasStarted = true;
-  }
-}
-
-void SIPWebSocketListener::run_server()
-{
-  assert(!_pServerEndPoint);
-  try
-  {
+    assert(_serverEndPoints.empty());
     _pServerAcceptHandler = websocketpp::server::handler::ptr(new ServerAcceptHandler(*this));
-    _pServerEndPoint = new websocketpp::server(_pServerAcceptHandler);
 
-    if (PRIO_DEBUG == log_get_level())
+    //
+    // Every shard binds here, on the caller's thread, so that a resolve or
+    // bind failure reaches the caller like it does for the TCP listener.
+    // start_listen() spawns the thread that runs the shard once its
+    // acceptor is listening.
+    //
+    try
     {
-      _pServerEndPoint->alog().set_level(websocketpp::log::alevel::ALL);
-      _pServerEndPoint->elog().set_level(websocketpp::log::elevel::ALL);
+      boost::asio::ip::tcp::resolver::query query(getAddress(), getPort());
+      boost::asio::ip::tcp::endpoint endpoint = *_resolver.resolve(query);
+
+      for (std::size_t i = 0; i < _shardCount; i++)
+      {
+        websocketpp::server* pServerEndPoint = new websocketpp::server(_pServerAcceptHandler);
+        _serverEndPoints.push_back(pServerEndPoint);
+        pServerEndPoint->set_reuse_port(_shardCount > 1);
+        if (PRIO_DEBUG == log_get_level())
+        {
+          pServerEndPoint->alog().set_level(websocketpp::log::alevel::ALL);
+          pServerEndPoint->elog().set_level(websocketpp::log::elevel::ALL);
+        }
+        pServerEndPoint->start_listen(endpoint, 1);
+      }
+    }
+    catch(const std::exception& e)
+    {
+      OSS_LOG_ERROR("SIPWebSocketListener::run " << _address << ":" << _port << " Exception: " << e.what());
+      handleStop();
+      throw;
     }
-  
-    boost::asio::ip::tcp::resolver::query query(getAddress(), getPort());
-    boost::asio::ip::tcp::endpoint endpoint = *_resolver.resolve(query);
     _hasStarted = true;
-    _pServerEndPoint->listen(endpoint);
-  }
-  catch(const std::exception& e)
-  {
-    OSS_LOG_ERROR("SIPWebSocketListener::run_server " << _address << ":" << _port << " Exception: " << e.what());
-    handleStop();
-  }
-  catch(...)
-  {
-    OSS_LOG_ERROR("SIPWebSocketListener::run_server " << _address << ":" << _port << " UNKNOWN EXCEPTION");
-    handleStop();
   }
 }
 
@@ -168,31 +167,42 @@ void SIPWebSocketListener::handleStop()
 {
   _connectionManager.stopAll();
   
-  if (_pServerEndPoint)
-  {
-    _pServerEndPoint->stop_listen(true);
-  }
-
-  if (_pServerThread)
+  //
+  // stop_listen() joins the shard thread before it closes the acceptor, and
+  // the pending accept would keep that thread in io_service::run().  Stop
+  // the io_service first so the join returns.
+  //
+  for (ServerEndPoints::iterator iter = _serverEndPoints.begin(); iter != _serverEndPoints.end(); iter++)
   {
-	  _pServerThread->join();
-	  delete _pServerThread;
-	  _pServerThread = 0;
+    (*iter)->get_io_service().stop();
+    (*iter)->stop_listen(true);
   }
 
-  if (_pServerEndPoint)
+  for (ServerEndPoints::iterator iter = _serverEndPoints.begin(); iter != _serverEndPoints.end(); iter++)
   {
-     delete _pServerEndPoint;
-    _pServerEndPoint = 0;
+    delete *iter;
   }
+  _serverEndPoints.clear();
+  _hasStarted = false;
 }
 
 void SIPWebSocketListener::restart(boost::system::error_code& e)
 {
   if (canBeRestarted())
   {
-    run();
-    OSS_LOG_NOTICE("SIPWebSocketListener::restart() address: " << _address << ":" << _port << " Ok");
+    try
+    {
+      run();
+      OSS_LOG_NOTICE("SIPWebSocketListener::restart() address: " << _address << ":" << _port << " Ok");
+    }
+    catch(const boost::system::system_error& err)
+    {
+      e = err.code();
+    }
+    catch(const std::exception&)
+    {
+      e = boost::asio::error::invalid_argument;
+    }
   }
 }
   
@@ -204,7 +214,7 @@ void SIPWebSocketListener::closeTemporarily(boost::system::error_code& e)
   
 bool SIPWebSocketListener::canBeRestarted() const
 {
-  return !_pServerThread && !_pServerEndPoint;
+  return _serverEndPoints.empty();
 }
 
 
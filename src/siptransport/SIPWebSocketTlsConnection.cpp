@@ -48,8 +48,12 @@ void SIPWebSocketTlsConnection::ServerReadWriteHandler::on_close(websocketpp::se
 void SIPWebSocketTlsConnection::ServerReadWriteHandler::on_message(websocketpp::server_tls::connection_ptr pConnection, websocketpp::server_tls::handler::message_ptr pMsg)
 {
   	boost::system::error_code ec;
-  	std::string payload = pMsg->get_payload();
-  	_rConnection.handleRead(ec, payload.size(), &payload);
+  	//
+  	// Hand the parser a view of the frame payload.  handleRead() only reads
+  	// from the buffer so there is no need to copy it.
+  	//
+  	const std::string& payload = pMsg->get_payload();
+  	_rConnection.handleRead(ec, payload.size(), const_cast<std::string*>(&payload));
 }
 
 void SIPWebSocketTlsConnection::ServerReadWriteHandler::on_error(websocketpp::server_tls::connection_ptr pConnection)
@@ -133,7 +137,7 @@ void SIPWebSocketTlsConnection::handleRead(const boost::system::error_code& e, s
 	}
 
 	OSS_LOG_DEBUG("SIPWebSocketTlsConnection::handleRead STARTING new connection");
-	std::string* buffer = reinterpret_cast<std::string*>(userData);
+	const std::string* buffer = reinterpret_cast<const std::string*>(userData);
 
 	//
 	// set the last read address
@@ -0,0 +1,461 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+//
+
+
+#include "OSS/STUN/STUNBindingResponder.h"
+#if ENABLE_FEATURE_STUN
+
+#include <cstring>
+#include <boost/thread/tss.hpp>
+#include <openssl/evp.h>
+#include <openssl/sha.h>
+
+#include "OSS/STUN/STUNProto.h"
+
+
+namespace OSS {
+namespace STUN {
+
+
+using namespace OSS::STUN::Proto;
+
+struct STUNBindingResponder::Credential : boost::noncopyable
+  /// HMAC-SHA1 state with the key pads already absorbed
+{
+  Credential() : inner(EVP_MD_CTX_new()), outer(EVP_MD_CTX_new()) {}
+  ~Credential() { EVP_MD_CTX_free(inner); EVP_MD_CTX_free(outer); }
+  EVP_MD_CTX* inner;
+  EVP_MD_CTX* outer;
+};
+
+struct STUNHmacScratch : boost::noncopyable
+  /// Per thread digest context the credential pads are copied into
+{
+  STUNHmacScratch() : ctx(EVP_MD_CTX_new()) {}
+  ~STUNHmacScratch() { EVP_MD_CTX_free(ctx); }
+  EVP_MD_CTX* ctx;
+};
+
+static boost::thread_specific_ptr<STUNHmacScratch> _hmacScratch;
+
+static const std::size_t STUN_HEADER_SIZE = 20;
+static const std::size_t STUN_INTEGRITY_SIZE = 24; // attribute header + 20 byte HMAC
+static const std::size_t STUN_FINGERPRINT_SIZE = 8; // attribute header + 4 byte CRC
+static const std::size_t STUN_MIN_RESPONSE_SIZE = 128;
+
+static inline UInt16 stun_read16(const char* p)
+{
+  const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+  return (UInt16)((u[0] << 8) | u[1]);
+}
+
+static inline UInt32 stun_read32(const char* p)
+{
+  const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+  return ((UInt32)u[0] << 24) | ((UInt32)u[1] << 16) | ((UInt32)u[2] << 8) | (UInt32)u[3];
+}
+
+static inline char* stun_write16(char* p, UInt16 value)
+{
+  *p++ = (char)(value >> 8);
+  *p++ = (char)(value & 0xFF);
+  return p;
+}
+
+static inline char* stun_write32(char* p, UInt32 value)
+{
+  p = stun_write16(p, (UInt16)(value >> 16));
+  return stun_write16(p, (UInt16)(value & 0xFFFF));
+}
+
+static void stun_hmac_init(STUNBindingResponder::Credential& credential, const std::string& key)
+{
+  unsigned char block[64];
+  std::memset(block, 0, sizeof(block));
+  if (key.size() > sizeof(block))
+    EVP_Digest(key.data(), key.size(), block, 0, EVP_sha1(), 0);
+  else
+    std::memcpy(block, key.data(), key.size());
+
+  unsigned char pad[64];
+  for (std::size_t i = 0; i < sizeof(pad); i++)
+    pad[i] = block[i] ^ 0x36;
+  EVP_DigestInit_ex(credential.inner, EVP_sha1(), 0);
+  EVP_DigestUpdate(credential.inner, pad, sizeof(pad));
+
+  for (std::size_t i = 0; i < sizeof(pad); i++)
+    pad[i] = block[i] ^ 0x5C;
+  EVP_DigestInit_ex(credential.outer, EVP_sha1(), 0);
+  EVP_DigestUpdate(credential.outer, pad, sizeof(pad));
+}
+
+static void stun_hmac_compute(
+  const STUNBindingResponder::Credential& credential,
+  const char* message,
+  std::size_t length,
+  unsigned char* hmac)
+  /// Compute MESSAGE-INTEGRITY over the first length bytes of message.
+  /// RFC 5389 requires the header length to cover the MESSAGE-INTEGRITY
+  /// attribute itself so the length field is substituted on the fly.
+{
+  char header[4];
+  header[0] = message[0];
+  header[1] = message[1];
+  stun_write16(header + 2, (UInt16)(length - STUN_HEADER_SIZE + STUN_INTEGRITY_SIZE));
+
+  //
+  // Credentials are shared by every thread.  Copy their pads into a
+  // context owned by this thread and leave the originals untouched.
+  //
+  if (!_hmacScratch.get())
+    _hmacScratch.reset(new STUNHmacScratch());
+  EVP_MD_CTX* ctx = _hmacScratch->ctx;
+
+  unsigned char digest[SHA_DIGEST_LENGTH];
+  EVP_MD_CTX_copy_ex(ctx, credential.inner);
+  EVP_DigestUpdate(ctx, header, sizeof(header));
+  EVP_DigestUpdate(ctx, message + sizeof(header), length - sizeof(header));
+  EVP_DigestFinal_ex(ctx, digest, 0);
+
+  EVP_MD_CTX_copy_ex(ctx, credential.outer);
+  EVP_DigestUpdate(ctx, digest, sizeof(digest));
+  EVP_DigestFinal_ex(ctx, hmac, 0);
+}
+
+static char* stun_encode_error(char* ptr, int code, const char* reason)
+{
+  std::size_t reasonLength = std::strlen(reason);
+  std::size_t padded = (reasonLength + 3) & ~(std::size_t)3;
+  ptr = stun_write16(ptr, ErrorCode);
+  ptr = stun_write16(ptr, (UInt16)(4 + reasonLength));
+  *ptr++ = 0;
+  *ptr++ = 0;
+  *ptr++ = (char)(code / 100);
+  *ptr++ = (char)(code % 100);
+  std::memcpy(ptr, reason, reasonLength);
+  std::memset(ptr + reasonLength, 0, padded - reasonLength);
+  return ptr + padded;
+}
+
+static char* stun_encode_mapped_address(char* ptr, const char* request, bool xorAddress, const boost::asio::ip::udp::endpoint& source)
+{
+  const boost::asio::ip::address& address = source.address();
+  UInt16 port = source.port();
+  ptr = stun_write16(ptr, xorAddress ? XorMappedAddressRfc5389 : MappedAddress);
+
+  if (address.is_v4())
+  {
+    UInt32 ip = address.to_v4().to_ulong();
+    ptr = stun_write16(ptr, 8);
+    *ptr++ = 0;
+    *ptr++ = IPv4Family;
+    if (xorAddress)
+    {
+      port ^= (UInt16)(MagicCookie >> 16);
+      ip ^= MagicCookie;
+    }
+    ptr = stun_write16(ptr, port);
+    ptr = stun_write32(ptr, ip);
+  }
+  else
+  {
+    boost::asio::ip::address_v6::bytes_type ip = address.to_v6().to_bytes();
+    ptr = stun_write16(ptr, 20);
+    *ptr++ = 0;
+    *ptr++ = IPv6Family;
+    if (xorAddress)
+    {
+      //
+      // IPv6 addresses are XOR'ed with the magic cookie followed by
+      // the transaction id.  Both are bytes 4 to 20 of the request header.
+      //
+      port ^= (UInt16)(MagicCookie >> 16);
+      for (std::size_t i = 0; i < ip.size(); i++)
+        ip[i] ^= (unsigned char)request[4 + i];
+    }
+    ptr = stun_write16(ptr, port);
+    std::memcpy(ptr, ip.data(), ip.size());
+    ptr += ip.size();
+  }
+  return ptr;
+}
+
+static std::size_t stun_finalize(char* response, char* ptr, bool addFingerprint)
+{
+  std::size_t length = ptr - response;
+  if (addFingerprint)
+  {
+    stun_write16(response + 2, (UInt16)(length - STUN_HEADER_SIZE + STUN_FINGERPRINT_SIZE));
+    UInt32 crc = stunCrc32(response, (unsigned int)length) ^ FingerprintXor;
+    ptr = stun_write16(ptr, Fingerprint);
+    ptr = stun_write16(ptr, 4);
+    ptr = stun_write32(ptr, crc);
+    length = ptr - response;
+  }
+  stun_write16(response + 2, (UInt16)(length - STUN_HEADER_SIZE));
+  return length;
+}
+
+STUNBindingResponder::STUNBindingResponder() :
+  _requireAuthentication(false),
+  _requests(0),
+  _responses(0),
+  _errorResponses(0),
+  _authFailures(0),
+  _discarded(0)
+{
+}
+
+STUNBindingResponder::~STUNBindingResponder()
+{
+}
+
+void STUNBindingResponder::setCredential(const std::string& localUserFragment, const std::string& password)
+{
+  CredentialPtr pCredential(new Credential());
+  stun_hmac_init(*pCredential, password);
+  OSS::mutex_write_lock lock(_credentialsMutex);
+  _credentials[localUserFragment] = pCredential;
+}
+
+void STUNBindingResponder::removeCredential(const std::string& localUserFragment)
+{
+  OSS::mutex_write_lock lock(_credentialsMutex);
+  _credentials.erase(localUserFragment);
+}
+
+STUNBindingResponder::CredentialPtr STUNBindingResponder::findCredential(const char* username, std::size_t length) const
+{
+  //
+  // ICE usernames are "receiver-ufrag:sender-ufrag".  We are the receiver.
+  //
+  const char* colon = static_cast<const char*>(std::memchr(username, ':', length));
+  std::string key(username, colon ? colon - username : length);
+
+  OSS::mutex_read_lock lock(_credentialsMutex);
+  Credentials::const_iterator iter = _credentials.find(key);
+  if (iter == _credentials.end())
+    return CredentialPtr();
+  return iter->second;
+}
+
+STUNBindingResponder::Stats STUNBindingResponder::getStats() const
+{
+  Stats stats;
+  stats.requests = _requests;
+  stats.responses = _responses;
+  stats.errorResponses = _errorResponses;
+  stats.authFailures = _authFailures;
+  stats.discarded = _discarded;
+  return stats;
+}
+
+std::size_t STUNBindingResponder::processRequest(
+  const char* request,
+  std::size_t requestLength,
+  const boost::asio::ip::udp::endpoint& source,
+  char* response,
+  std::size_t responseSize)
+{
+  //
+  // The two most significant bits of a STUN message are zero.  Anything
+  // else (RTP, DTLS) that reaches this port is not for us.
+  //
+  if (requestLength < STUN_HEADER_SIZE || (request[0] & 0xC0) || responseSize < STUN_MIN_RESPONSE_SIZE)
+  {
+    _discarded.fetch_add(1, boost::memory_order_relaxed);
+    return 0;
+  }
+
+  UInt16 msgType = stun_read16(request);
+  UInt16 msgLength = stun_read16(request + 2);
+  if (STUN_HEADER_SIZE + msgLength != requestLength || (msgLength & 3) || msgType != BindRequestMsg)
+  {
+    //
+    // Binding indications used as keep-alives need no answer
+    //
+    _discarded.fetch_add(1, boost::memory_order_relaxed);
+    return 0;
+  }
+
+  _requests.fetch_add(1, boost::memory_order_relaxed);
+  bool isRfc5389 = stun_read32(request + 4) == MagicCookie;
+
+  const char* username = 0;
+  std::size_t usernameLength = 0;
+  std::size_t integrityOffset = 0;
+  std::size_t fingerprintOffset = 0;
+  UInt16 unknown[STUN_MAX_UNKNOWN_ATTRIBUTES];
+  std::size_t unknownCount = 0;
+
+  std::size_t offset = STUN_HEADER_SIZE;
+  while (offset + 4 <= requestLength)
+  {
+    UInt16 atrType = stun_read16(request + offset);
+    UInt16 atrLength = stun_read16(request + offset + 2);
+    std::size_t valueOffset = offset + 4;
+    std::size_t padded = (atrLength + 3) & ~(std::size_t)3;
+    if (valueOffset + padded > requestLength || fingerprintOffset)
+    {
+      _discarded.fetch_add(1, boost::memory_order_relaxed);
+      return 0;
+    }
+
+    if (atrType == Fingerprint)
+    {
+      if (atrLength != 4)
+      {
+        _discarded.fetch_add(1, boost::memory_order_relaxed);
+        return 0;
+      }
+      fingerprintOffset = offset;
+    }
+    else if (!integrityOffset)
+    {
+      //
+      // Attributes following MESSAGE-INTEGRITY, other than FINGERPRINT,
+      // must be ignored
+      //
+      switch (atrType)
+      {
+      case Username:
+        username = request + valueOffset;
+        usernameLength = atrLength;
+        break;
+      case MessageIntegrity:
+        if (atrLength != 20)
+        {
+          _discarded.fetch_add(1, boost::memory_order_relaxed);
+          return 0;
+        }
+        integrityOffset = offset;
+        break;
+      case ChangeRequest:
+        if (atrLength == 4 && stun_read32(request + valueOffset) == 0)
+          break;
+        // fall through, changing address or port is not supported
+      default:
+        if (atrType <= 0x7FFF && atrType != Priority && atrType != UseCandidate && unknownCount < STUN_MAX_UNKNOWN_ATTRIBUTES)
+          unknown[unknownCount++] = atrType;
+      }
+    }
+    offset = valueOffset + padded;
+  }
+
+  if (offset != requestLength)
+  {
+    _discarded.fetch_add(1, boost::memory_order_relaxed);
+    return 0;
+  }
+
+  if (fingerprintOffset)
+  {
+    UInt32 crc = stunCrc32(request, (unsigned int)fingerprintOffset) ^ FingerprintXor;
+    if (crc != stun_read32(request + fingerprintOffset + 4))
+    {
+      _discarded.fetch_add(1, boost::memory_order_relaxed);
+      return 0;
+    }
+  }
+
+  int errorCode = 0;
+  const char* errorReason = 0;
+  CredentialPtr pCredential;
+  if (unknownCount)
+  {
+    errorCode = 420;
+    errorReason = "Unknown Attribute";
+  }
+  else if (integrityOffset)
+  {
+    unsigned char hmac[SHA_DIGEST_LENGTH];
+    if (!username)
+    {
+      errorCode = 400;
+      errorReason = "Bad Request";
+    }
+    else if (!(pCredential = findCredential(username, usernameLength)))
+    {
+      errorCode = 401;
+      errorReason = "Unauthorized";
+    }
+    else
+    {
+      stun_hmac_compute(*pCredential, request, integrityOffset, hmac);
+      if (std::memcmp(hmac, request + integrityOffset + 4, sizeof(hmac)) != 0)
+      {
+        pCredential.reset();
+        errorCode = 401;
+        errorReason = "Unauthorized";
+      }
+    }
+    if (errorCode == 401)
+      _authFailures.fetch_add(1, boost::memory_order_relaxed);
+  }
+  else if (_requireAuthentication)
+  {
+    errorCode = 400;
+    errorReason = "Bad Request";
+  }
+
+  //
+  // The response echoes the magic cookie and transaction id
+  //
+  char* ptr = response;
+  ptr = stun_write16(ptr, errorCode ? BindErrorResponseMsg : BindResponseMsg);
+  ptr = stun_write16(ptr, 0);
+  std::memcpy(ptr, request + 4, 16);
+  ptr += 16;
+
+  if (errorCode)
+  {
+    ptr = stun_encode_error(ptr, errorCode, errorReason);
+    if (unknownCount)
+    {
+      ptr = stun_write16(ptr, UnknownAttribute);
+      ptr = stun_write16(ptr, (UInt16)(unknownCount * 2));
+      for (std::size_t i = 0; i < unknownCount; i++)
+        ptr = stun_write16(ptr, unknown[i]);
+      if (unknownCount % 2)
+        ptr = stun_write16(ptr, 0);
+    }
+    _errorResponses.fetch_add(1, boost::memory_order_relaxed);
+    return stun_finalize(response, ptr, fingerprintOffset != 0);
+  }
+
+  ptr = stun_encode_mapped_address(ptr, request, isRfc5389, source);
+
+  if (pCredential)
+  {
+    std::size_t length = ptr - response;
+    ptr = stun_write16(ptr, MessageIntegrity);
+    ptr = stun_write16(ptr, SHA_DIGEST_LENGTH);
+    stun_hmac_compute(*pCredential, response, length, reinterpret_cast<unsigned char*>(ptr));
+    ptr += SHA_DIGEST_LENGTH;
+  }
+
+  _responses.fetch_add(1, boost::memory_order_relaxed);
+  return stun_finalize(response, ptr, fingerprintOffset != 0);
+}
+
+} } // OSS::STUN
+
+
+#endif // ENABLE_FEATURE_STUN
\ No newline at end of file
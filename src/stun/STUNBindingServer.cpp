@@ -0,0 +1,239 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+//
+
+
+#include "OSS/STUN/STUNBindingServer.h"
+#if ENABLE_FEATURE_STUN
+
+#include <cstring>
+#include <errno.h>
+#include <boost/bind.hpp>
+
+#ifndef OSS_OS_FAMILY_WINDOWS
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#endif
+
+#include "OSS/STUN/STUNProto.h"
+#include "OSS/UTL/Logger.h"
+
+
+namespace OSS {
+namespace STUN {
+
+
+STUNBindingServer::STUNBindingServer() :
+  _isRunning(false)
+{
+}
+
+STUNBindingServer::~STUNBindingServer()
+{
+  stop();
+}
+
+bool STUNBindingServer::initialize(const OSS::Net::IPAddress& address, std::size_t threadCount)
+{
+  _address = address;
+  if (!_address.getPort())
+    _address.setPort(STUN_PORT);
+
+  if (!threadCount)
+    threadCount = boost::thread::hardware_concurrency();
+  if (!threadCount)
+    threadCount = 1;
+#ifndef SO_REUSEPORT
+  threadCount = 1;
+#endif
+
+  boost::asio::ip::udp::endpoint endpoint(_address.address(), _address.getPort());
+  try
+  {
+    for (std::size_t i = 0; i < threadCount; i++)
+    {
+      SocketPtr pSocket(new boost::asio::ip::udp::socket(_ioService));
+      pSocket->open(endpoint.protocol());
+      pSocket->set_option(boost::asio::ip::udp::socket::reuse_address(true));
+#ifdef SO_REUSEPORT
+      int reusePort = 1;
+      ::setsockopt(pSocket->native_handle(), SOL_SOCKET, SO_REUSEPORT, (const char*)&reusePort, sizeof(reusePort));
+#endif
+#ifndef OSS_OS_FAMILY_WINDOWS
+      //
+      // Blocking reads time out periodically so workers notice stop()
+      //
+      struct timeval timeout;
+      timeout.tv_sec = 0;
+      timeout.tv_usec = 250000;
+      ::setsockopt(pSocket->native_handle(), SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+#endif
+      pSocket->bind(endpoint);
+      _sockets.push_back(pSocket);
+    }
+  }
+  catch(const std::exception& e)
+  {
+    OSS_LOG_ERROR("STUNBindingServer::initialize - Unable to bind " << _address.toIpPortString() << " - " << e.what());
+    _sockets.clear();
+    return false;
+  }
+
+  OSS_LOG_INFO("STUNBindingServer::initialize - Listening on " << _address.toIpPortString() << " with " << _sockets.size() << " sockets");
+  return true;
+}
+
+void STUNBindingServer::run()
+{
+  if (_isRunning.exchange(true))
+    return;
+  for (std::size_t i = 0; i < _sockets.size(); i++)
+    _threads.push_back(new boost::thread(boost::bind(&STUNBindingServer::runWorker, this, i)));
+}
+
+void STUNBindingServer::stop()
+{
+  if (_isRunning.exchange(false))
+  {
+    for (std::size_t i = 0; i < _threads.size(); i++)
+    {
+      _threads[i]->join();
+      delete _threads[i];
+    }
+    _threads.clear();
+  }
+
+  for (std::size_t i = 0; i < _sockets.size(); i++)
+  {
+    boost::system::error_code ignored;
+    _sockets[i]->close(ignored);
+  }
+  _sockets.clear();
+}
+
+void STUNBindingServer::runWorker(std::size_t index)
+{
+#if OSS_OS == OSS_OS_LINUX
+  runWorkerBatched(_sockets[index]->native_handle());
+#else
+  runWorkerSimple(*_sockets[index]);
+#endif
+}
+
+void STUNBindingServer::runWorkerBatched(int fd)
+{
+#if OSS_OS == OSS_OS_LINUX
+  std::vector<char> inBuffer(BATCH_SIZE * MAX_DATAGRAM_SIZE);
+  std::vector<char> outBuffer(BATCH_SIZE * MAX_DATAGRAM_SIZE);
+  struct mmsghdr inMessages[BATCH_SIZE];
+  struct mmsghdr outMessages[BATCH_SIZE];
+  struct iovec inVectors[BATCH_SIZE];
+  struct iovec outVectors[BATCH_SIZE];
+  struct sockaddr_storage addresses[BATCH_SIZE];
+
+  while (_isRunning)
+  {
+    for (int i = 0; i < BATCH_SIZE; i++)
+    {
+      inVectors[i].iov_base = &inBuffer[i * MAX_DATAGRAM_SIZE];
+      inVectors[i].iov_len = MAX_DATAGRAM_SIZE;
+      std::memset(&inMessages[i], 0, sizeof(inMessages[i]));
+      inMessages[i].msg_hdr.msg_name = &addresses[i];
+      inMessages[i].msg_hdr.msg_namelen = sizeof(addresses[i]);
+      inMessages[i].msg_hdr.msg_iov = &inVectors[i];
+      inMessages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    //
+    // MSG_WAITFORONE blocks for the first datagram only and then returns
+    // whatever else is already queued
+    //
+    int received = ::recvmmsg(fd, inMessages, BATCH_SIZE, MSG_WAITFORONE, 0);
+    if (received <= 0)
+    {
+      if (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR && _isRunning)
+        OSS_LOG_ERROR("STUNBindingServer::runWorkerBatched - recvmmsg failed with errno " << errno);
+      continue;
+    }
+
+    int replies = 0;
+    for (int i = 0; i < received; i++)
+    {
+      boost::asio::ip::udp::endpoint source;
+      if (inMessages[i].msg_hdr.msg_namelen > source.capacity())
+        continue;
+      std::memcpy(source.data(), &addresses[i], inMessages[i].msg_hdr.msg_namelen);
+      source.resize(inMessages[i].msg_hdr.msg_namelen);
+
+      char* reply = &outBuffer[replies * MAX_DATAGRAM_SIZE];
+      std::size_t length = processRequest(&inBuffer[i * MAX_DATAGRAM_SIZE], inMessages[i].msg_len, source, reply, MAX_DATAGRAM_SIZE);
+      if (!length)
+        continue;
+
+      outVectors[replies].iov_base = reply;
+      outVectors[replies].iov_len = length;
+      std::memset(&outMessages[replies], 0, sizeof(outMessages[replies]));
+      outMessages[replies].msg_hdr.msg_name = &addresses[i];
+      outMessages[replies].msg_hdr.msg_namelen = inMessages[i].msg_hdr.msg_namelen;
+      outMessages[replies].msg_hdr.msg_iov = &outVectors[replies];
+      outMessages[replies].msg_hdr.msg_iovlen = 1;
+      replies++;
+    }
+
+    int sent = 0;
+    while (sent < replies)
+    {
+      int result = ::sendmmsg(fd, outMessages + sent, replies - sent, 0);
+      if (result <= 0)
+      {
+        if (result < 0 && errno == EINTR)
+          continue;
+        break;
+      }
+      sent += result;
+    }
+  }
+#endif
+}
+
+void STUNBindingServer::runWorkerSimple(boost::asio::ip::udp::socket& socket)
+{
+  char request[MAX_DATAGRAM_SIZE];
+  char response[MAX_DATAGRAM_SIZE];
+  while (_isRunning)
+  {
+    boost::asio::ip::udp::endpoint source;
+    socklen_t sourceLength = source.capacity();
+    int received = ::recvfrom(socket.native_handle(), request, sizeof(request), 0, source.data(), &sourceLength);
+    if (received <= 0)
+      continue;
+    source.resize(sourceLength);
+
+    std::size_t length = processRequest(request, received, source, response, sizeof(response));
+    if (length)
+      ::sendto(socket.native_handle(), response, length, 0, source.data(), source.size());
+  }
+}
+
+
+} } // OSS::STUN
+
+
+#endif // ENABLE_FEATURE_STUN
\ No newline at end of file
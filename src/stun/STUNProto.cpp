@@ -1293,6 +1293,33 @@ stunServerProcessMsg( char* buf,
    return false;
 }
 
+struct StunCrc32Table
+{
+   StunCrc32Table()
+   {
+      for (UInt32 i = 0; i < 256; i++)
+      {
+         UInt32 c = i;
+         for (int k = 0; k < 8; k++)
+            c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+         value[i] = c;
+      }
+   }
+   UInt32 value[256];
+};
+
+static const StunCrc32Table stunCrc32Table;
+
+UInt32
+stunCrc32(const char* buf, unsigned int bufLen)
+{
+   UInt32 crc = 0xFFFFFFFF;
+   const unsigned char* p = reinterpret_cast<const unsigned char*>(buf);
+   for (unsigned int i = 0; i < bufLen; i++)
+      crc = stunCrc32Table.value[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+   return crc ^ 0xFFFFFFFF;
+}
+
 void
 stunBuildReqSimple( StunMessage* msg,
                     const StunAtrString& username,
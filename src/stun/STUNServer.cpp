@@ -20,6 +20,7 @@
 
 
 #include "OSS/STUN/STUNServer.h"
+#include "OSS/UTL/Logger.h"
 
 
 struct NullStream:
@@ -47,14 +48,16 @@ namespace STUN {
 
 STUNServer::STUNServer() : 
   _config(0),
-  _exitSync(0, 0xFFFF)
+  _pServerThread(0),
+  _useBindingServer(false)
 {
 
 }
 
 STUNServer::~STUNServer()
 {
-
+  if (_pServerThread)
+    stop();
 }
 
 bool STUNServer::initialize(
@@ -63,12 +66,33 @@ bool STUNServer::initialize(
 {
   _primaryIp = primary;
   _secondaryIp = secondary;
+
+  //
+  // Without a secondary address there is no NAT discovery to do.
+  // Serve binding requests from all cores instead.
+  //
+  _useBindingServer = !_secondaryIp.isValid();
+  if (_useBindingServer)
+    return _bindingServer.initialize(_primaryIp);
   return true;
 }
 
 void STUNServer::run()
 {
-  OSS::thread_pool::static_schedule(boost::bind(&STUNServer::internal_run, this));
+  if (_useBindingServer)
+  {
+    _bindingServer.run();
+    return;
+  }
+  if (_pServerThread)
+    return;
+  //
+  // internal_run() blocks for the lifetime of the server.  Scheduling it on
+  // the shared thread pool would pin a pool worker and keep the pool from
+  // stopping, so it gets a dedicated thread.
+  //
+  _config = new VovidaStunServerInfo();
+  _pServerThread = new boost::thread(boost::bind(&STUNServer::internal_run, this));
 }
 
 void STUNServer::internal_run()
@@ -88,25 +112,45 @@ void STUNServer::internal_run()
   if (secondaryAddr.port == 0)
     secondaryAddr.port = STUN_PORT + 1;
 
-  VovidaStunServerInfo* pInfo = new VovidaStunServerInfo();
-  _config = pInfo;
+  VovidaStunServerInfo* pInfo = static_cast<VovidaStunServerInfo*>(_config);
 
   if (vovida_stun_InitServer(*pInfo, primaryAddr, secondaryAddr, 0, 0))
   {
     while (vovida_stun_ServerProcess(*pInfo, 0));
   }
-  _exitSync.set();
 }
 
 void STUNServer::stop()
 {
+  if (_useBindingServer)
+  {
+    _bindingServer.stop();
+    return;
+  }
+
+  if (!_pServerThread)
+    return;
+
   VovidaStunServerInfo* pInfo = static_cast<VovidaStunServerInfo*>(_config);
   if (pInfo)
-  {
     vovida_stun_StopServer(*pInfo);
+
+  if (_pServerThread->timed_join(boost::posix_time::milliseconds(10000)))
+  {
     delete pInfo;
-    _exitSync.wait(10000);
   }
+  else
+  {
+    //
+    // The loop is still using the server info.  Leave it allocated rather
+    // than free it under a running thread.
+    //
+    OSS_LOG_WARNING("STUNServer::stop - Server thread did not exit");
+    _pServerThread->detach();
+  }
+  _config = 0;
+  delete _pServerThread;
+  _pServerThread = 0;
 }
 
 
@@ -0,0 +1,109 @@
+#include "gtest/gtest.h"
+#include "OSS/SIP/B2BUA/SIPB2BAdmissionControl.h"
+
+using OSS::SIP::B2BUA::SIPB2BAdmissionControl;
+
+
+TEST(B2BAdmissionControlTest, test_signal_thresholds)
+{
+  ASSERT_EQ(SIPB2BAdmissionControl::computeSignalLevel(0.4, 0.5, 0.9, SIPB2BAdmissionControl::LEVEL_NORMAL, 0.8),
+    SIPB2BAdmissionControl::LEVEL_NORMAL);
+  ASSERT_EQ(SIPB2BAdmissionControl::computeSignalLevel(0.5, 0.5, 0.9, SIPB2BAdmissionControl::LEVEL_NORMAL, 0.8),
+    SIPB2BAdmissionControl::LEVEL_OVERLOADED);
+  ASSERT_EQ(SIPB2BAdmissionControl::computeSignalLevel(0.95, 0.5, 0.9, SIPB2BAdmissionControl::LEVEL_NORMAL, 0.8),
+    SIPB2BAdmissionControl::LEVEL_CRITICAL);
+
+  //
+  // A zero threshold disables the signal
+  //
+  ASSERT_EQ(SIPB2BAdmissionControl::computeSignalLevel(1000, 0, 0, SIPB2BAdmissionControl::LEVEL_NORMAL, 0.8),
+    SIPB2BAdmissionControl::LEVEL_NORMAL);
+}
+
+TEST(B2BAdmissionControlTest, test_signal_hysteresis)
+{
+  //
+  // Entering needs the full threshold.  Leaving needs the threshold scaled
+  // by the hysteresis factor.
+  //
+  ASSERT_EQ(SIPB2BAdmissionControl::computeSignalLevel(0.45, 0.5, 0.9, SIPB2BAdmissionControl::LEVEL_NORMAL, 0.8),
+    SIPB2BAdmissionControl::LEVEL_NORMAL);
+  ASSERT_EQ(SIPB2BAdmissionControl::computeSignalLevel(0.45, 0.5, 0.9, SIPB2BAdmissionControl::LEVEL_OVERLOADED, 0.8),
+    SIPB2BAdmissionControl::LEVEL_OVERLOADED);
+  ASSERT_EQ(SIPB2BAdmissionControl::computeSignalLevel(0.39, 0.5, 0.9, SIPB2BAdmissionControl::LEVEL_OVERLOADED, 0.8),
+    SIPB2BAdmissionControl::LEVEL_NORMAL);
+
+  ASSERT_EQ(SIPB2BAdmissionControl::computeSignalLevel(0.8, 0.5, 0.9, SIPB2BAdmissionControl::LEVEL_OVERLOADED, 0.8),
+    SIPB2BAdmissionControl::LEVEL_OVERLOADED);
+  ASSERT_EQ(SIPB2BAdmissionControl::computeSignalLevel(0.8, 0.5, 0.9, SIPB2BAdmissionControl::LEVEL_CRITICAL, 0.8),
+    SIPB2BAdmissionControl::LEVEL_CRITICAL);
+  ASSERT_EQ(SIPB2BAdmissionControl::computeSignalLevel(0.7, 0.5, 0.9, SIPB2BAdmissionControl::LEVEL_CRITICAL, 0.8),
+    SIPB2BAdmissionControl::LEVEL_OVERLOADED);
+}
+
+TEST(B2BAdmissionControlTest, test_peek_request)
+{
+  std::string method;
+  bool inDialog = true;
+
+  ASSERT_TRUE(SIPB2BAdmissionControl::peekRequest(
+    "\r\nINVITE sip:bob@example.com SIP/2.0\r\n"
+    "Via: SIP/2.0/UDP 10.0.0.1;branch=z9hG4bK1\r\n"
+    "From: <sip:alice@example.com>;tag=1234\r\n"
+    "To: \"Bob;tag=x\" <sip:bob@example.com>\r\n"
+    "Call-ID: abc\r\n"
+    "CSeq: 1 INVITE\r\n\r\n", method, inDialog));
+  ASSERT_STREQ(method.c_str(), "INVITE");
+  ASSERT_FALSE(inDialog);
+
+  ASSERT_TRUE(SIPB2BAdmissionControl::peekRequest(
+    "UPDATE sip:bob@example.com SIP/2.0\r\n"
+    "f: <sip:alice@example.com>;tag=1234\r\n"
+    "t: <sip:bob@example.com> ; TAG = 5678\r\n"
+    "CSeq: 2 UPDATE\r\n\r\n", method, inDialog));
+  ASSERT_STREQ(method.c_str(), "UPDATE");
+  ASSERT_TRUE(inDialog);
+
+  //
+  // The header section ends at the first blank line
+  //
+  ASSERT_TRUE(SIPB2BAdmissionControl::peekRequest(
+    "MESSAGE sip:bob@example.com SIP/2.0\r\n"
+    "To: sip:bob@example.com\r\n\r\n"
+    "To: sip:bob@example.com;tag=1\r\n", method, inDialog));
+  ASSERT_FALSE(inDialog);
+
+  ASSERT_FALSE(SIPB2BAdmissionControl::peekRequest("SIP/2.0 200 OK\r\n\r\n", method, inDialog));
+  ASSERT_FALSE(SIPB2BAdmissionControl::peekRequest("\r\n\r\n", method, inDialog));
+}
+
+TEST(B2BAdmissionControlTest, test_priority_requests_exempt)
+{
+  const char* exempt[] = { "ACK", "BYE", "CANCEL", "PRACK", "bye" };
+  for (std::size_t i = 0; i < sizeof(exempt) / sizeof(exempt[0]); i++)
+  {
+    ASSERT_FALSE(SIPB2BAdmissionControl::shouldReject(SIPB2BAdmissionControl::LEVEL_CRITICAL, exempt[i], false));
+    ASSERT_FALSE(SIPB2BAdmissionControl::shouldReject(SIPB2BAdmissionControl::LEVEL_OVERLOADED, exempt[i], false));
+  }
+
+  //
+  // Anything with a To tag belongs to an existing dialog
+  //
+  ASSERT_FALSE(SIPB2BAdmissionControl::shouldReject(SIPB2BAdmissionControl::LEVEL_CRITICAL, "INVITE", true));
+  ASSERT_FALSE(SIPB2BAdmissionControl::shouldReject(SIPB2BAdmissionControl::LEVEL_CRITICAL, "INFO", true));
+}
+
+TEST(B2BAdmissionControlTest, test_shedding_by_level)
+{
+  ASSERT_FALSE(SIPB2BAdmissionControl::shouldReject(SIPB2BAdmissionControl::LEVEL_NORMAL, "INVITE", false));
+  ASSERT_FALSE(SIPB2BAdmissionControl::shouldReject(SIPB2BAdmissionControl::LEVEL_NORMAL, "OPTIONS", false));
+
+  ASSERT_TRUE(SIPB2BAdmissionControl::shouldReject(SIPB2BAdmissionControl::LEVEL_OVERLOADED, "INVITE", false));
+  ASSERT_TRUE(SIPB2BAdmissionControl::shouldReject(SIPB2BAdmissionControl::LEVEL_OVERLOADED, "SUBSCRIBE", false));
+  ASSERT_TRUE(SIPB2BAdmissionControl::shouldReject(SIPB2BAdmissionControl::LEVEL_OVERLOADED, "REFER", false));
+  ASSERT_FALSE(SIPB2BAdmissionControl::shouldReject(SIPB2BAdmissionControl::LEVEL_OVERLOADED, "OPTIONS", false));
+  ASSERT_FALSE(SIPB2BAdmissionControl::shouldReject(SIPB2BAdmissionControl::LEVEL_OVERLOADED, "REGISTER", false));
+
+  ASSERT_TRUE(SIPB2BAdmissionControl::shouldReject(SIPB2BAdmissionControl::LEVEL_CRITICAL, "OPTIONS", false));
+  ASSERT_TRUE(SIPB2BAdmissionControl::shouldReject(SIPB2BAdmissionControl::LEVEL_CRITICAL, "REGISTER", false));
+}
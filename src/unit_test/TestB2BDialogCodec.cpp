@@ -0,0 +1,116 @@
+#include "gtest/gtest.h"
+#include "OSS/SIP/B2BUA/SIPB2BDialogCodec.h"
+
+#if ENABLE_FEATURE_B2BUA
+
+using namespace OSS::SIP::B2BUA;
+
+
+static const char* TEST_SDP =
+  "v=0\r\n"
+  "o=FreeSWITCH 1410664034 1410664035 IN IP4 172.31.1.9\r\n"
+  "s=FreeSWITCH\r\n"
+  "c=IN IP4 107.23.34.40\r\n"
+  "t=0 0\r\n"
+  "m=audio 30466 RTP/AVP 0 101\r\n"
+  "c=IN IP4 107.23.34.40\r\n"
+  "a=rtpmap:0 PCMU/8000\r\n"
+  "a=rtpmap:101 telephone-event/8000\r\n"
+  "a=fmtp:101 0-16\r\n"
+  "a=silenceSupp:off - - - -\r\n"
+  "a=ptime:20\r\n"
+  "a=x-sipx-ntap:X172.31.1.9-107.23.34.40;2296\r\n";
+
+static void fill_dialog(SIPB2BDialogData& dialog)
+{
+  dialog.sessionId = "4147414987334546318926127303";
+  dialog.timeStamp = 1410675320642ULL;
+  dialog.connectTime = 1410675320643ULL;
+  dialog.disconnectTime = 1410675320644ULL;
+  dialog.sessionAge = 1410675320645ULL;
+  dialog.expires = 3600;
+  dialog.leg1.callId = "OTU2YWMzOGZiMDJkM2Q2NmRiZmNhNTk0OTQ1MDk3ZTA.";
+  dialog.leg1.from = "<sip:32017@ezuce.com;transport=UDP>;tag=Xg67jHjDemXjF";
+  dialog.leg1.to = "<sip:2017@ezuce.com;transport=UDP>;tag=2ed94c23";
+  dialog.leg1.remoteContact = "<sip:2017@192.168.1.10:58959;transport=UDP>";
+  dialog.leg1.remoteIp = "192.168.1.10:58959";
+  dialog.leg1.transportId = "0";
+  dialog.leg1.targetTransport = "udp";
+  dialog.leg1.localSdp = TEST_SDP;
+  dialog.leg1.localCSeq = 7;
+  dialog.leg2 = dialog.leg1;
+  dialog.leg2.remoteSdp = TEST_SDP;
+  dialog.leg2.noRtpProxy = true;
+  dialog.leg2.routeSet.push_back("<sip:107.23.34.40:5060;lr>");
+  dialog.leg2.routeSet.push_back("<sip:10.0.0.1;lr>");
+}
+
+static void expect_same_leg(const SIPB2BDialogData::LegInfo& a, const SIPB2BDialogData::LegInfo& b)
+{
+  ASSERT_EQ(a.callId, b.callId);
+  ASSERT_EQ(a.from, b.from);
+  ASSERT_EQ(a.to, b.to);
+  ASSERT_EQ(a.remoteContact, b.remoteContact);
+  ASSERT_EQ(a.remoteIp, b.remoteIp);
+  ASSERT_EQ(a.transportId, b.transportId);
+  ASSERT_EQ(a.targetTransport, b.targetTransport);
+  ASSERT_EQ(a.localSdp, b.localSdp);
+  ASSERT_EQ(a.remoteSdp, b.remoteSdp);
+  ASSERT_EQ(a.noRtpProxy, b.noRtpProxy);
+  ASSERT_EQ(a.localCSeq, b.localCSeq);
+  ASSERT_TRUE(a.routeSet == b.routeSet);
+}
+
+TEST(B2BDialogCodecTest, test_dialog_codec_round_trip)
+{
+  SIPB2BDialogData dialog;
+  fill_dialog(dialog);
+
+  for (int compress = 0; compress < 2; compress++)
+  {
+    std::string record;
+    SIPB2BDialogCodec::encode(dialog, record, compress != 0);
+    ASSERT_TRUE(SIPB2BDialogCodec::isBinary(record));
+
+    SIPB2BDialogData decoded;
+    ASSERT_TRUE(SIPB2BDialogCodec::decode(record, decoded));
+    ASSERT_EQ(decoded.sessionId, dialog.sessionId);
+    ASSERT_EQ(decoded.timeStamp, dialog.timeStamp);
+    ASSERT_EQ(decoded.connectTime, dialog.connectTime);
+    ASSERT_EQ(decoded.disconnectTime, dialog.disconnectTime);
+    ASSERT_EQ(decoded.sessionAge, dialog.sessionAge);
+    ASSERT_EQ(decoded.expires, dialog.expires);
+    expect_same_leg(decoded.leg1, dialog.leg1);
+    expect_same_leg(decoded.leg2, dialog.leg2);
+
+    SIPB2BDialogDataView view;
+    ASSERT_TRUE(SIPB2BDialogCodec::decode(record.data(), record.size(), view));
+    ASSERT_TRUE(view.leg1.callId == dialog.leg1.callId);
+    ASSERT_EQ(view.leg2.routeSet.size(), (std::size_t)2);
+    ASSERT_EQ(view.leg1.localSdp.compressed, compress != 0);
+    ASSERT_TRUE(view.leg1.callId.data >= record.data() &&
+      view.leg1.callId.data < record.data() + record.size());
+  }
+
+  std::string json;
+  dialog.toJsonString(json);
+  ASSERT_FALSE(SIPB2BDialogCodec::isBinary(json));
+}
+
+TEST(B2BDialogCodecTest, test_dialog_codec_rejects_truncated)
+{
+  SIPB2BDialogData dialog;
+  fill_dialog(dialog);
+  std::string record;
+  SIPB2BDialogCodec::encode(dialog, record, true);
+
+  SIPB2BDialogDataView view;
+  for (std::size_t size = 0; size < record.size(); size++)
+    ASSERT_FALSE(SIPB2BDialogCodec::decode(record.data(), size, view));
+
+  std::string badVersion = record;
+  badVersion[3] = (char)(SIPB2BDialogCodec::VERSION + 1);
+  ASSERT_FALSE(SIPB2BDialogCodec::decode(badVersion.data(), badVersion.size(), view));
+}
+
+#endif // ENABLE_FEATURE_B2BUA
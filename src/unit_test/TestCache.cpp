@@ -59,6 +59,7 @@ See also: For more string comparison tricks (substring, prefix, suffix, and regu
 
 #include "gtest/gtest.h"
 #include "OSS/UTL/Cache.h"
+#include "OSS/UTL/ExpireHashMap.h"
 
 
 struct MyCacheObj
@@ -84,4 +85,40 @@ TEST(APITest, ExpireCache )
   ASSERT_STREQ(boost::any_cast<MyCacheObj&>(data->data()).value.c_str(), "This is a new value");
   cache.remove("123");
   ASSERT_FALSE(cache.has("123"));
-}
\ No newline at end of file
+}
+
+TEST(APITest, ExpireHashMap )
+{
+  OSS::ExpireHashMap<std::string> map(60000, 4);
+  for (int i = 0; i < 10000; i++)
+    map.add(OSS::string_from_number(i), OSS::string_from_number(i * 2));
+  ASSERT_EQ(map.size(), 10000);
+
+  std::string value;
+  for (int i = 0; i < 10000; i += 2)
+    map.remove(OSS::string_from_number(i));
+  ASSERT_EQ(map.size(), 5000);
+
+  for (int i = 0; i < 10000; i++)
+  {
+    bool found = map.get(OSS::string_from_number(i), value);
+    ASSERT_EQ(found, i % 2 == 1);
+    if (found)
+    {
+      ASSERT_EQ(value, OSS::string_from_number(i * 2));
+    }
+  }
+
+  ASSERT_TRUE(map.pop("1", value));
+  ASSERT_EQ(value, "2");
+  ASSERT_FALSE(map.has("1"));
+
+  OSS::ExpireHashMap<std::string> shortLived(1);
+  shortLived.add("abc", "def");
+  OSS::thread_sleep(10);
+  ASSERT_FALSE(shortLived.get("abc", value));
+  shortLived.add("abc", "def");
+  OSS::thread_sleep(10);
+  shortLived.sweep();
+  ASSERT_EQ(shortLived.size(), 0);
+}
@@ -167,3 +167,54 @@ TEST(TestDigestAuth, SIPProxyAuthenticate)
   std::cout << auth << std::endl;
 }
 
+
+TEST(TestDigestAuth, RFC2617Response)
+{
+  //
+  // Example from RFC 2617 section 3.5
+  //
+  std::string a1 = SIPDigestAuth::digestCreateA1Hash("\"Mufasa\"", "Circle Of Life", "\"testrealm@host.com\"");
+  std::string a2 = SIPDigestAuth::digestCreateA2Hash("/dir/index.html", "GET");
+  std::string response = SIPDigestAuth::digestCreateAuthorizationQop(
+    a1, "\"dcd98b7102dd2f0e8b11d0f600bfb0c093\"", "00000001", "\"0a4f113b\"", "auth", a2);
+  ASSERT_EQ(response, "6629fae49393a05397450978507c4ef1");
+}
+
+TEST(TestDigestAuth, SignedNonce)
+{
+  std::string callId = "signed-nonce-call-id";
+  std::string signedNonce = SIPDigestAuth::digestCreateSignedNonce(callId);
+  ASSERT_EQ(signedNonce.size(), 48u);
+
+  ASSERT_EQ(SIPDigestAuth::digestValidateNonce(signedNonce, callId), SIPDigestAuth::NONCE_VALID);
+  ASSERT_EQ(SIPDigestAuth::digestValidateNonce("\"" + signedNonce + "\"", callId), SIPDigestAuth::NONCE_VALID);
+  ASSERT_EQ(SIPDigestAuth::digestValidateNonce(signedNonce, "other-call-id"), SIPDigestAuth::NONCE_INVALID);
+  ASSERT_EQ(SIPDigestAuth::digestValidateNonce(nonce, callId), SIPDigestAuth::NONCE_INVALID);
+
+  std::string tampered = signedNonce;
+  tampered[7] = tampered[7] == '0' ? '1' : '0';
+  ASSERT_EQ(SIPDigestAuth::digestValidateNonce(tampered, callId), SIPDigestAuth::NONCE_INVALID);
+
+  //
+  // Nonce counts must increase
+  //
+  ASSERT_EQ(SIPDigestAuth::digestValidateNonce(signedNonce, callId, "00000001"), SIPDigestAuth::NONCE_VALID);
+  ASSERT_EQ(SIPDigestAuth::digestValidateNonce(signedNonce, callId, "00000002"), SIPDigestAuth::NONCE_VALID);
+  ASSERT_EQ(SIPDigestAuth::digestValidateNonce(signedNonce, callId, "00000002"), SIPDigestAuth::NONCE_REPLAYED);
+  ASSERT_EQ(SIPDigestAuth::digestValidateNonce(signedNonce, callId, "00000001"), SIPDigestAuth::NONCE_REPLAYED);
+  ASSERT_EQ(SIPDigestAuth::digestValidateNonce(signedNonce, callId, "00000000"), SIPDigestAuth::NONCE_INVALID);
+
+  //
+  // Moving the issue time back invalidates the signature
+  //
+  std::string oldNonce = "00000001" + signedNonce.substr(8);
+  ASSERT_EQ(SIPDigestAuth::digestValidateNonce(oldNonce, callId), SIPDigestAuth::NONCE_INVALID);
+
+  //
+  // A nonce used without qop is accepted once
+  //
+  std::string singleUse = SIPDigestAuth::digestCreateSignedNonce("single-use-call-id");
+  ASSERT_EQ(SIPDigestAuth::digestConsumeNonce(singleUse, "other-call-id"), SIPDigestAuth::NONCE_INVALID);
+  ASSERT_EQ(SIPDigestAuth::digestConsumeNonce(singleUse, "single-use-call-id"), SIPDigestAuth::NONCE_VALID);
+  ASSERT_EQ(SIPDigestAuth::digestConsumeNonce(singleUse, "single-use-call-id"), SIPDigestAuth::NONCE_REPLAYED);
+}
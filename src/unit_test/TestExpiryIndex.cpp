@@ -0,0 +1,156 @@
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <unistd.h>
+#include <boost/filesystem.hpp>
+#include "OSS/UTL/ExpiryIndex.h"
+#include "OSS/UTL/CoreUtils.h"
+
+using namespace OSS;
+
+
+static boost::filesystem::path expiry_journal_path()
+{
+  std::ostringstream strm;
+  strm << "/tmp/oss_expiry_index_" << ::getpid() << ".journal";
+  return boost::filesystem::path(strm.str());
+}
+
+TEST(ExpiryIndexTest, test_expiry_order_and_batches)
+{
+  ExpiryIndex index(10);
+  index.add("c", 300, "call-c");
+  index.add("a", 100, "call-a");
+  index.add("b", 200, "call-b");
+  ASSERT_EQ(index.size(), 3u);
+
+  ExpiryIndex::Entries expired;
+  ASSERT_EQ(index.popExpired(99, 10, expired), 0u);
+
+  //
+  // Keys are never returned early
+  //
+  ASSERT_EQ(index.popExpired(150, 10, expired), 1u);
+  ASSERT_EQ(expired[0].key, "a");
+  ASSERT_EQ(expired[0].data, "call-a");
+  ASSERT_EQ(expired[0].expires, 100u);
+  ASSERT_FALSE(index.has("a"));
+
+  //
+  // Batches are bounded
+  //
+  expired.clear();
+  ASSERT_EQ(index.popExpired(1000, 1, expired), 1u);
+  ASSERT_EQ(expired[0].key, "b");
+  ASSERT_EQ(index.popExpired(1000, 1, expired), 1u);
+  ASSERT_EQ(expired[1].key, "c");
+  ASSERT_EQ(index.size(), 0u);
+}
+
+TEST(ExpiryIndexTest, test_expiry_touch_and_remove)
+{
+  ExpiryIndex index(10);
+  index.add("a", 100, "call-a");
+  index.add("b", 100);
+  ASSERT_TRUE(index.touch("a", 500));
+  ASSERT_FALSE(index.touch("missing", 500));
+  ASSERT_TRUE(index.remove("b"));
+  ASSERT_FALSE(index.remove("b"));
+
+  ExpiryIndex::Entries expired;
+  ASSERT_EQ(index.popExpired(200, 10, expired), 0u);
+  ASSERT_EQ(index.popExpired(500, 10, expired), 1u);
+  ASSERT_EQ(expired[0].data, "call-a");
+
+  //
+  // Re-adding replaces both the deadline and the data
+  //
+  index.add("c", 100, "first");
+  index.add("c", 900, "second");
+  expired.clear();
+  ASSERT_EQ(index.popExpired(500, 10, expired), 0u);
+  ASSERT_EQ(index.popExpired(900, 10, expired), 1u);
+  ASSERT_EQ(expired[0].data, "second");
+}
+
+TEST(ExpiryIndexTest, test_expiry_journal_replay)
+{
+  boost::filesystem::path journal = expiry_journal_path();
+  boost::filesystem::remove(journal);
+
+  {
+    ExpiryIndex index(10);
+    ASSERT_TRUE(index.open(journal));
+    index.add("a", 100, "call-a");
+    index.add("b", 200, "call-b");
+    index.add("c", 300);
+    ASSERT_TRUE(index.touch("c", 700));
+    ASSERT_TRUE(index.remove("b"));
+    ExpiryIndex::Entries expired;
+    ASSERT_EQ(index.popExpired(100, 10, expired), 1u);
+    index.add("d", 400, "call-d");
+  }
+
+  {
+    ExpiryIndex index(10);
+    ASSERT_TRUE(index.open(journal));
+    ASSERT_EQ(index.size(), 2u);
+    ASSERT_FALSE(index.has("a"));
+    ASSERT_FALSE(index.has("b"));
+    ExpiryIndex::Entries expired;
+    ASSERT_EQ(index.popExpired(1000, 10, expired), 2u);
+    ASSERT_EQ(expired[0].key, "d");
+    ASSERT_EQ(expired[0].data, "call-d");
+    ASSERT_EQ(expired[1].key, "c");
+    ASSERT_EQ(expired[1].expires, 700u);
+  }
+
+  //
+  // A record cut short by a crash is ignored, everything before it is kept
+  //
+  {
+    ExpiryIndex index(10);
+    ASSERT_TRUE(index.open(journal));
+    index.add("e", 100, "call-e");
+    index.add("f", 200, "call-f");
+  }
+  ASSERT_EQ(::truncate(journal.string().c_str(), boost::filesystem::file_size(journal) - 3), 0);
+  {
+    ExpiryIndex index(10);
+    ASSERT_TRUE(index.open(journal));
+    ASSERT_EQ(index.size(), 1u);
+    ASSERT_TRUE(index.has("e"));
+  }
+
+  boost::filesystem::remove(journal);
+}
+
+TEST(ExpiryIndexTest, test_expiry_journal_compaction)
+{
+  boost::filesystem::path journal = expiry_journal_path();
+  boost::filesystem::remove(journal);
+
+  ExpiryIndex index(60);
+  ASSERT_TRUE(index.open(journal));
+  for (int i = 0; i < 5000; i++)
+  {
+    index.add("session", 1000 + i, "call");
+  }
+  ASSERT_EQ(index.size(), 1u);
+
+  //
+  // Writers only append.  Compaction waits for the housekeeping call.
+  //
+  ASSERT_GT(boost::filesystem::file_size(journal), 1024 * 64);
+  ASSERT_TRUE(index.compactIfStale());
+  ASSERT_FALSE(index.compactIfStale());
+  ASSERT_LT(boost::filesystem::file_size(journal), 1024 * 64);
+
+  index.close();
+  ExpiryIndex reopened(60);
+  ASSERT_TRUE(reopened.open(journal));
+  ExpiryIndex::Entries expired;
+  ASSERT_EQ(reopened.popExpired(10000, 10, expired), 1u);
+  ASSERT_EQ(expired[0].expires, 5999u);
+
+  boost::filesystem::remove(journal);
+}
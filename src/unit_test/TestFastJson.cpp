@@ -0,0 +1,111 @@
+#include "gtest/gtest.h"
+#include <sstream>
+#include "OSS/JSON/Json.h"
+#include "OSS/JSON/FastJson.h"
+#include "OSS/UTL/CoreUtils.h"
+
+using OSS::JSON::FastReader;
+using OSS::JSON::FastWriter;
+
+
+static const char* TEST_DOCUMENT =
+  "{\n"
+  "  \"jsonrpc\" : \"2.0\",\n"
+  "  \"id\" : 42,\n"
+  "  \"params\" : {\n"
+  "    \"sdp\" : \"v=0\\r\\no=Z 0 0 IN IP4 192.168.1.10\\r\\ns=Z\\r\\nc=IN IP4 192.168.1.10\\r\\nt=0 0\\r\\nm=audio 8000 RTP/AVP 0 101\\r\\n\",\n"
+  "    \"quote\" : \"say \\\"hi\\\" \\\\ \\/ \\u00e9\\ud83d\\ude00\",\n"
+  "    \"ratio\" : -1.25e2,\n"
+  "    \"enabled\" : true,\n"
+  "    \"disabled\" : false,\n"
+  "    \"nothing\" : null,\n"
+  "    \"ports\" : [ 10000, 10002, 10004 ],\n"
+  "    \"empty\" : {},\n"
+  "    \"none\" : []\n"
+  "  }\n"
+  "}\n";
+
+TEST(FastJsonTest, test_fast_reader_matches_reader)
+{
+  json::Object expected;
+  std::istringstream strm(
+    "{\"a\" : \"x\\ny\", \"b\" : [1, 2.5, -3e2, true, null], \"c\" : {\"d\" : false}}");
+  json::Reader::Read(expected, strm);
+
+  json::Object object;
+  FastReader::Read(object,
+    std::string("{\"a\" : \"x\\ny\", \"b\" : [1, 2.5, -3e2, true, null], \"c\" : {\"d\" : false}}"));
+  ASSERT_TRUE(object == expected);
+}
+
+TEST(FastJsonTest, test_fast_reader_values)
+{
+  json::Object object;
+  FastReader::Read(object, std::string(TEST_DOCUMENT));
+
+  ASSERT_EQ(json::String(object["jsonrpc"]).Value(), "2.0");
+  ASSERT_EQ(json::Number(object["id"]).Value(), 42);
+
+  const json::Object& params = object["params"];
+  ASSERT_EQ(json::String(params["quote"]).Value(), "say \"hi\" \\ / \xc3\xa9\xf0\x9f\x98\x80");
+  ASSERT_EQ(json::Number(params["ratio"]).Value(), -125);
+  ASSERT_TRUE(json::Boolean(params["enabled"]).Value());
+  ASSERT_FALSE(json::Boolean(params["disabled"]).Value());
+  ASSERT_EQ(json::Array(params["ports"]).Size(), (std::size_t)3);
+  ASSERT_EQ(json::Number(params["ports"][2]).Value(), 10004);
+  ASSERT_TRUE(json::Object(params["empty"]).Empty());
+  ASSERT_TRUE(json::Array(params["none"]).Empty());
+}
+
+TEST(FastJsonTest, test_fast_writer_round_trip)
+{
+  json::Object object;
+  FastReader::Read(object, std::string(TEST_DOCUMENT));
+  object["fraction"] = json::Number(0.1);
+  object["large"] = json::Number(1e300);
+  object["control"] = json::String(std::string("a\x01" "b"));
+
+  std::string compact = FastWriter::toString(object);
+  ASSERT_EQ(compact.find('\n'), std::string::npos);
+  ASSERT_NE(compact.find("\"id\":42"), std::string::npos);
+  ASSERT_NE(compact.find("\"fraction\":0.1"), std::string::npos);
+  ASSERT_NE(compact.find("a\\u0001b"), std::string::npos);
+
+  json::Object reread;
+  FastReader::Read(reread, compact);
+  ASSERT_TRUE(reread == object);
+
+  std::string json;
+  ASSERT_TRUE(OSS::JSON::json_object_to_string(object, json));
+  ASSERT_EQ(json, compact);
+}
+
+TEST(FastJsonTest, test_fast_reader_errors)
+{
+  const char* invalid[] = {
+    "",
+    "{",
+    "{\"a\" 1}",
+    "{\"a\" : 1,}",
+    "{\"a\" : 1} x",
+    "{\"a\" : 1, \"a\" : 2}",
+    "{\"a\" : tru}",
+    "{\"a\" : \"\\q\"}",
+    "{\"a\" : 1.2.3}",
+    "[1, 2",
+    "\"unterminated"
+  };
+
+  for (std::size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+  {
+    json::UnknownElement element;
+    ASSERT_THROW(FastReader::Read(element, std::string(invalid[i])), json::Exception) << invalid[i];
+  }
+
+  std::string deep(FastReader::MAX_DEPTH + 1, '[');
+  json::UnknownElement element;
+  ASSERT_THROW(FastReader::Read(element, deep), json::Exception);
+
+  json::Object object;
+  ASSERT_FALSE(OSS::JSON::json_parse_string("[1]", object));
+}
@@ -0,0 +1,199 @@
+
+#include "gtest/gtest.h"
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "OSS/UTL/IPCRing.h"
+#include "OSS/UTL/CoreUtils.h"
+#include "OSS/UTL/Thread.h"
+
+using namespace OSS;
+
+
+TEST(IPCTest, test_ipc_ring_basic)
+{
+  IPCRing reader;
+  IPCRing writer;
+  ASSERT_TRUE(reader.create("/oss_core_test_ipc_ring_basic", 100));
+  ASSERT_EQ(reader.capacity(), 4096);
+  ASSERT_TRUE(writer.open("/oss_core_test_ipc_ring_basic"));
+  ASSERT_FALSE(writer.isOwner());
+  ASSERT_FALSE(writer.write(std::string(writer.maxRecordSize() + 1, 'x'), false));
+
+  IPCRing::Record record;
+  ASSERT_FALSE(reader.read(record, false));
+
+  //
+  // Variable sized records that wrap around the ring several times
+  //
+  for (int i = 0; i < 1000; i++)
+  {
+    std::string data(i % 700 + 1, (char)('a' + i % 26));
+    ASSERT_TRUE(writer.write(data, false));
+    ASSERT_TRUE(reader.read(record, false));
+    ASSERT_EQ(std::string(record.data, record.size), data);
+    reader.release(record);
+  }
+
+  //
+  // Fill it up and make sure a non-blocking write fails instead of overwriting
+  //
+  std::string record16 = "0123456789abcdef";
+  int written = 0;
+  while (writer.write(record16, false))
+    written++;
+  ASSERT_EQ(written, 4096 / 24);
+
+  std::string data;
+  for (int i = 0; i < written; i++)
+  {
+    ASSERT_TRUE(reader.read(data, false));
+    ASSERT_EQ(data, record16);
+  }
+  ASSERT_FALSE(reader.read(data, false));
+}
+
+static void ipc_ring_producer(const std::string* pName, int base, int count)
+{
+  IPCRing writer;
+  if (!writer.open(*pName))
+    return;
+  for (int i = base; i < base + count; i++)
+  {
+    std::string data = OSS::string_from_number<int>(i);
+    writer.write(data);
+  }
+}
+
+TEST(IPCTest, test_ipc_ring_multi_producer)
+{
+  const int producers = 4;
+  const int count = 50000;
+  std::string name = "/oss_core_test_ipc_ring_mpsc";
+  IPCRing reader;
+  ASSERT_TRUE(reader.create(name, 8192));
+  std::vector<int> seen(producers * count, 0);
+
+  boost::thread_group threads;
+  for (int i = 0; i < producers; i++)
+    threads.create_thread(boost::bind(ipc_ring_producer, &name, i * count, count));
+
+  IPCRing::Record record;
+  for (int received = 0; received < producers * count; received++)
+  {
+    ASSERT_TRUE(reader.read(record));
+    int value = OSS::string_to_number<int>(std::string(record.data, record.size).c_str());
+    reader.release(record);
+    ASSERT_TRUE(value >= 0 && value < producers * count);
+    seen[value]++;
+  }
+  threads.join_all();
+
+  for (std::size_t i = 0; i < seen.size(); i++)
+    ASSERT_EQ(seen[i], 1);
+}
+
+TEST(IPCTest, test_ipc_ring_cross_process)
+{
+  std::string name = "/oss_core_test_ipc_ring_fork";
+  IPCRing reader;
+  ASSERT_TRUE(reader.create(name, 4096));
+
+  pid_t pid = fork();
+  ASSERT_NE(pid, -1);
+  if (pid == 0)
+  {
+    IPCRing writer;
+    if (!writer.open(name))
+      _exit(1);
+    for (int i = 0; i < 10000; i++)
+      writer.write(OSS::string_from_number<int>(i));
+    _exit(0);
+  }
+
+  std::string data;
+  for (int i = 0; i < 10000; i++)
+  {
+    ASSERT_TRUE(reader.read(data));
+    ASSERT_EQ(data, OSS::string_from_number<int>(i));
+  }
+
+  int status = 0;
+  waitpid(pid, &status, 0);
+  ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+static OSS::UInt64* ipc_ring_map_first_record(const std::string& name, void*& pMap, std::size_t& mapSize)
+{
+  //
+  // Records start one page into the segment.  The ring is empty so the
+  // first write lands at the start of the data area.
+  //
+  int fd = shm_open(name.c_str(), O_RDWR, 0600);
+  if (fd == -1)
+    return 0;
+  mapSize = 4096 + 4096;
+  pMap = mmap(0, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (pMap == MAP_FAILED)
+    return 0;
+  return reinterpret_cast<OSS::UInt64*>(reinterpret_cast<char*>(pMap) + 4096);
+}
+
+TEST(IPCTest, test_ipc_ring_corrupt_header)
+{
+  std::string name = "/oss_core_test_ipc_ring_corrupt";
+  IPCRing reader;
+  IPCRing writer;
+  ASSERT_TRUE(reader.create(name, 4096));
+  ASSERT_TRUE(writer.open(name));
+  ASSERT_TRUE(writer.write(std::string("abc"), false));
+
+  void* pMap = 0;
+  std::size_t mapSize = 0;
+  OSS::UInt64* pWord = ipc_ring_map_first_record(name, pMap, mapSize);
+  ASSERT_TRUE(pWord != 0);
+
+  //
+  // A committed record claiming more than the ring holds
+  //
+  *pWord = ((OSS::UInt64)0x100000 << 32) | 0x1;
+  IPCRing::Record record;
+  ASSERT_FALSE(reader.read(record, false));
+  ASSERT_FALSE(writer.write(std::string("def"), false));
+  munmap(pMap, mapSize);
+}
+
+TEST(IPCTest, test_ipc_ring_reclaim_abandoned_record)
+{
+  std::string name = "/oss_core_test_ipc_ring_reclaim";
+  IPCRing reader;
+  IPCRing writer;
+  ASSERT_TRUE(reader.create(name, 4096));
+  ASSERT_TRUE(writer.open(name));
+  reader.setReclaimTimeout(50);
+  ASSERT_TRUE(writer.write(std::string("abc"), false));
+
+  void* pMap = 0;
+  std::size_t mapSize = 0;
+  OSS::UInt64* pWord = ipc_ring_map_first_record(name, pMap, mapSize);
+  ASSERT_TRUE(pWord != 0);
+
+  //
+  // Roll the record back to reserved as if its producer died mid copy
+  //
+  *pWord = ((OSS::UInt64)3 << 32) | 0x4;
+  IPCRing::Record record;
+  ASSERT_FALSE(reader.read(record, false));
+  OSS::thread_sleep(100);
+  ASSERT_FALSE(reader.read(record, false));
+
+  ASSERT_TRUE(writer.write(std::string("def"), false));
+  std::string data;
+  ASSERT_TRUE(reader.read(data, false));
+  ASSERT_EQ(data, "def");
+  munmap(pMap, mapSize);
+}
@@ -0,0 +1,102 @@
+#include "gtest/gtest.h"
+#include <boost/unordered_set.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include "OSS/Net/IPAddress.h"
+#include "OSS/Net/IPEndPoint.h"
+
+using OSS::Net::IPAddress;
+using OSS::Net::IPEndPoint;
+
+
+static const std::size_t TEST_INTERN_COUNT = 200;
+
+static std::string test_intern_name(std::size_t index)
+{
+  std::ostringstream name;
+  name << "intern-" << index << ".example.com";
+  return name.str();
+}
+
+static void test_intern_names(std::vector<OSS::UInt16>* pIds)
+{
+  for (std::size_t i = 0; i < TEST_INTERN_COUNT; i++)
+    pIds->push_back(IPEndPoint::intern(test_intern_name(i)));
+}
+
+TEST(IPEndPointTest, test_endpoint_round_trip)
+{
+  IPAddress v4("192.168.1.10", 5060, IPAddress::TCP);
+  v4.externalAddress() = "203.0.113.5";
+  v4.alias() = "public";
+  v4.setVirtual(true);
+
+  IPEndPoint endpoint = v4.toEndPoint();
+  ASSERT_TRUE(endpoint.isV4());
+  ASSERT_EQ(endpoint.port, 5060);
+  ASSERT_TRUE(endpoint.isVirtual());
+  ASSERT_EQ(endpoint.externalAddress(), "203.0.113.5");
+  ASSERT_EQ(endpoint.alias(), "public");
+
+  IPAddress copy(endpoint);
+  ASSERT_TRUE(copy == v4);
+  ASSERT_EQ(copy.getProtocol(), IPAddress::TCP);
+  ASSERT_EQ(copy.externalAddress(), v4.externalAddress());
+  ASSERT_EQ(copy.alias(), v4.alias());
+  ASSERT_TRUE(copy.isVirtual());
+
+  IPAddress v6("fe80::1", 5061, IPAddress::UDP);
+  IPEndPoint endpoint6 = v6.toEndPoint();
+  ASSERT_TRUE(endpoint6.isV6());
+  ASSERT_EQ(endpoint6.externalId, 0);
+  ASSERT_TRUE(IPAddress(endpoint6) == v6);
+  ASSERT_EQ(IPAddress(endpoint6).toIpPortString(), "[fe80::1]:5061");
+}
+
+TEST(IPEndPointTest, test_endpoint_hash_and_compare)
+{
+  IPEndPoint a = IPAddress("10.0.0.1", 5060, IPAddress::UDP).toEndPoint();
+  IPEndPoint b = IPAddress("10.0.0.1", 5060, IPAddress::UDP).toEndPoint();
+  IPEndPoint c = IPAddress("10.0.0.1", 5061, IPAddress::UDP).toEndPoint();
+  IPEndPoint d = IPAddress("10.0.0.1", 5060, IPAddress::TCP).toEndPoint();
+
+  ASSERT_TRUE(a == b);
+  ASSERT_EQ(a.hash(), b.hash());
+  ASSERT_TRUE(a != c);
+  ASSERT_TRUE(a != d);
+  ASSERT_TRUE(a < c || c < a);
+
+  boost::unordered_set<IPEndPoint> endpoints;
+  endpoints.insert(a);
+  endpoints.insert(b);
+  endpoints.insert(c);
+  endpoints.insert(d);
+  ASSERT_EQ(endpoints.size(), (std::size_t)3);
+
+  ASSERT_EQ(IPEndPoint::intern(""), 0);
+  ASSERT_EQ(IPEndPoint::intern("sip.example.com"), IPEndPoint::intern("sip.example.com"));
+}
+
+TEST(IPEndPointTest, test_concurrent_intern_agrees_on_ids)
+{
+  //
+  // Every thread races to add the same names.  All of them must end up
+  // with the same id for a name and the id must map back to it.
+  //
+  std::vector<OSS::UInt16> ids[8];
+  boost::thread_group threads;
+  for (std::size_t i = 0; i < 8; i++)
+    threads.create_thread(boost::bind(test_intern_names, &ids[i]));
+  threads.join_all();
+
+  std::set<OSS::UInt16> unique;
+  for (std::size_t i = 0; i < TEST_INTERN_COUNT; i++)
+  {
+    ASSERT_TRUE(ids[0][i] != 0);
+    ASSERT_EQ(IPEndPoint::internedString(ids[0][i]), test_intern_name(i));
+    for (std::size_t t = 1; t < 8; t++)
+      ASSERT_EQ(ids[t][i], ids[0][i]);
+    unique.insert(ids[0][i]);
+  }
+  ASSERT_EQ(unique.size(), TEST_INTERN_COUNT);
+}
@@ -0,0 +1,60 @@
+#include "gtest/gtest.h"
+#include <set>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include "OSS/UTL/IdGenerator.h"
+#include "OSS/UTL/CoreUtils.h"
+#include "OSS/UTL/Thread.h"
+
+using namespace OSS;
+
+
+static bool is_id_char(char ch)
+{
+  return (ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'v');
+}
+
+TEST(IdGeneratorTest, test_id_generator_format)
+{
+  char branch[IdGenerator::BRANCH_LENGTH + 1];
+  IdGenerator::createBranch(branch);
+  ASSERT_EQ(strlen(branch), (std::size_t)IdGenerator::BRANCH_LENGTH);
+  ASSERT_EQ(std::string(branch, 7), "z9hG4bK");
+  for (std::size_t i = 7; i < IdGenerator::BRANCH_LENGTH; i++)
+    ASSERT_TRUE(is_id_char(branch[i]));
+
+  std::string tag = IdGenerator::createTag();
+  ASSERT_EQ(tag.size(), (std::size_t)IdGenerator::TAG_LENGTH);
+  for (std::size_t i = 0; i < tag.size(); i++)
+    ASSERT_TRUE(is_id_char(tag[i]));
+
+  std::string callId = IdGenerator::createCallId();
+  ASSERT_EQ(callId.size(), (std::size_t)IdGenerator::CALL_ID_LENGTH);
+
+  char odd[6];
+  IdGenerator::generate(odd, 5);
+  ASSERT_EQ(strlen(odd), 5u);
+}
+
+#define ID_TEST_THREADS 8
+#define ID_TEST_COUNT 20000
+
+static void id_generator_collect(std::vector<std::string>* pIds)
+{
+  for (int i = 0; i < ID_TEST_COUNT; i++)
+    pIds->push_back(IdGenerator::createTag());
+}
+
+TEST(IdGeneratorTest, test_id_generator_unique_across_threads)
+{
+  std::vector<std::string> ids[ID_TEST_THREADS];
+  boost::thread_group threads;
+  for (int i = 0; i < ID_TEST_THREADS; i++)
+    threads.create_thread(boost::bind(id_generator_collect, &ids[i]));
+  threads.join_all();
+
+  std::set<std::string> unique;
+  for (int i = 0; i < ID_TEST_THREADS; i++)
+    unique.insert(ids[i].begin(), ids[i].end());
+  ASSERT_EQ(unique.size(), (std::size_t)(ID_TEST_THREADS * ID_TEST_COUNT));
+}
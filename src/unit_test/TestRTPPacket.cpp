@@ -22,6 +22,7 @@
 #include "OSS/RTP/RTPPacket.h"
 #include "OSS/RTP/RTPPCAPReader.h"
 #include "OSS/RTP/RTPResizingQueue.h"
+#include "OSS/RTP/RTPProxy.h"
 
 using namespace OSS;
 using namespace OSS::RTP;
@@ -413,4 +414,22 @@ TEST(RTPPacketTest, test_rtp_resizer_upsize)
   }
 }
 
-
+TEST(RTPPacketTest, test_rfc7983_demux)
+{
+  char stun[] = { 0x00, 0x01, 0x00, 0x00 };
+  char dtls[] = { 0x16, (char)0xfe, (char)0xfd };
+  char rtp[] = { (char)0x80, 0x00 };
+  char rtcp[] = { (char)0x81, (char)0xc8 };
+  char turn[] = { 0x40, 0x00 };
+  char zrtp[] = { 0x10, 0x00 };
+  char unknown[] = { (char)0xff };
+
+  ASSERT_EQ(RTPProxy::classifyPacket(stun, sizeof(stun)), RTPProxy::PACKET_STUN);
+  ASSERT_EQ(RTPProxy::classifyPacket(dtls, sizeof(dtls)), RTPProxy::PACKET_DTLS);
+  ASSERT_EQ(RTPProxy::classifyPacket(rtp, sizeof(rtp)), RTPProxy::PACKET_RTP);
+  ASSERT_EQ(RTPProxy::classifyPacket(rtcp, sizeof(rtcp)), RTPProxy::PACKET_RTP);
+  ASSERT_EQ(RTPProxy::classifyPacket(turn, sizeof(turn)), RTPProxy::PACKET_TURN_CHANNEL);
+  ASSERT_EQ(RTPProxy::classifyPacket(zrtp, sizeof(zrtp)), RTPProxy::PACKET_ZRTP);
+  ASSERT_EQ(RTPProxy::classifyPacket(unknown, sizeof(unknown)), RTPProxy::PACKET_UNKNOWN);
+  ASSERT_EQ(RTPProxy::classifyPacket(unknown, 0), RTPProxy::PACKET_UNKNOWN);
+}
@@ -0,0 +1,144 @@
+#include "gtest/gtest.h"
+#include <set>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include "OSS/RTP/RTPPortAllocator.h"
+
+#if ENABLE_FEATURE_RTP
+
+using namespace OSS::RTP;
+
+
+TEST(RTPPortAllocatorTest, test_allocate_unique_pairs)
+{
+  RTPPortAllocator allocator;
+  ASSERT_TRUE(allocator.open(30000, 30199));
+  ASSERT_EQ(allocator.available(), 100u);
+
+  std::set<unsigned short> ports;
+  for (int i = 0; i < 100; i++)
+  {
+    unsigned short port = allocator.allocate();
+    ASSERT_GE(port, 30000);
+    ASSERT_LE(port + 1, 30199);
+    ASSERT_EQ((port - 30000) % 2, 0);
+    ASSERT_TRUE(ports.insert(port).second);
+  }
+
+  //
+  // The range is exhausted and nothing was released
+  //
+  ASSERT_EQ(allocator.allocate(), 0);
+}
+
+TEST(RTPPortAllocatorTest, test_release_is_deferred)
+{
+  RTPPortAllocator allocator;
+  ASSERT_TRUE(allocator.open(30000, 30003));
+  unsigned short first = allocator.allocate();
+  unsigned short second = allocator.allocate();
+  ASSERT_NE(first, 0);
+  ASSERT_NE(second, 0);
+  ASSERT_EQ(allocator.allocate(), 0);
+
+  allocator.release(first);
+  ASSERT_EQ(allocator.allocate(), 0);
+
+  //
+  // A released port waits for a full rotation before it is reused
+  //
+  allocator.recycle();
+  ASSERT_EQ(allocator.allocate(), 0);
+  allocator.recycle();
+  ASSERT_EQ(allocator.allocate(), first);
+}
+
+TEST(RTPPortAllocatorTest, test_reserve)
+{
+  RTPPortAllocator allocator;
+  ASSERT_TRUE(allocator.open(30000, 30003));
+  ASSERT_TRUE(allocator.reserve(30002));
+  ASSERT_FALSE(allocator.reserve(30002));
+  ASSERT_FALSE(allocator.reserve(30001));
+  ASSERT_FALSE(allocator.reserve(40000));
+  ASSERT_EQ(allocator.allocate(), 30000);
+  ASSERT_EQ(allocator.allocate(), 0);
+}
+
+static void allocate_ports(RTPPortAllocator* pAllocator, std::vector<unsigned short>* pPorts, int count)
+{
+  for (int i = 0; i < count; i++)
+  {
+    unsigned short port = pAllocator->allocate();
+    if (port)
+      pPorts->push_back(port);
+  }
+}
+
+TEST(RTPPortAllocatorTest, test_concurrent_allocation)
+{
+  RTPPortAllocator allocator;
+  ASSERT_TRUE(allocator.open(20000, 59999));
+
+  const int threadCount = 4;
+  std::vector<unsigned short> ports[threadCount];
+  boost::thread_group threads;
+  for (int i = 0; i < threadCount; i++)
+  {
+    threads.create_thread(boost::bind(&allocate_ports, &allocator, &ports[i], 4000));
+  }
+  threads.join_all();
+
+  std::set<unsigned short> unique;
+  for (int i = 0; i < threadCount; i++)
+  {
+    ASSERT_EQ(ports[i].size(), 4000u);
+    for (std::size_t j = 0; j < ports[i].size(); j++)
+    {
+      ASSERT_TRUE(unique.insert(ports[i][j]).second);
+    }
+  }
+}
+
+TEST(RTPPortAllocatorTest, test_steal_from_idle_pool)
+{
+  RTPPortAllocator allocator;
+  ASSERT_TRUE(allocator.open(30000, 30255));
+
+  //
+  // This thread claims a small batch and keeps the rest in its pool.  The
+  // other thread still gets every remaining port.
+  //
+  ASSERT_NE(allocator.allocate(), 0);
+  std::vector<unsigned short> ports;
+  boost::thread thread(boost::bind(&allocate_ports, &allocator, &ports, 127));
+  thread.join();
+  ASSERT_EQ(ports.size(), 127u);
+  ASSERT_EQ(allocator.allocate(), 0);
+}
+
+static void allocate_and_wait(RTPPortAllocator* pAllocator, unsigned short* pPort,
+  boost::barrier* pAllocated, boost::barrier* pDestroyed)
+{
+  *pPort = pAllocator->allocate();
+  pAllocated->wait();
+  pDestroyed->wait();
+}
+
+TEST(RTPPortAllocatorTest, test_thread_exits_after_allocator)
+{
+  RTPPortAllocator* pAllocator = new RTPPortAllocator();
+  ASSERT_TRUE(pAllocator->open(30000, 30255));
+
+  unsigned short port = 0;
+  boost::barrier allocated(2);
+  boost::barrier destroyed(2);
+  boost::thread thread(boost::bind(&allocate_and_wait, pAllocator, &port, &allocated, &destroyed));
+  allocated.wait();
+  delete pAllocator;
+  destroyed.wait();
+  thread.join();
+  ASSERT_NE(port, 0);
+}
+
+#endif // ENABLE_FEATURE_RTP
@@ -0,0 +1,159 @@
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <boost/filesystem.hpp>
+#include "OSS/RTP/RTPSessionTable.h"
+#include "OSS/UTL/CoreUtils.h"
+
+#if ENABLE_FEATURE_RTP
+
+using namespace OSS::RTP;
+
+
+static boost::filesystem::path session_table_path()
+{
+  std::ostringstream strm;
+  strm << "/tmp/oss_rtp_session_table_" << ::getpid() << ".map";
+  return boost::filesystem::path(strm.str());
+}
+
+static RTPProxyRecord session_table_record(const std::string& identifier)
+{
+  RTPProxyRecord record;
+  record.identifier = identifier;
+  record.logId = "log-" + identifier;
+  record.leg1Identifier = "leg1";
+  record.leg2Identifier = "leg2";
+  record.leg1OriginAddress = "10.0.0.1";
+  record.leg2OriginAddress = "10.0.0.2";
+  record.lastSDPInAck = "v=0\r\no=- 1 1 IN IP4 10.0.0.1\r\n";
+  record.isExpectingInitialAnswer = false;
+  record.hasOfferedAudioProxy = true;
+  record.hasOfferedVideoProxy = false;
+  record.hasOfferedFaxProxy = false;
+  record.isAudioProxyNegotiated = true;
+  record.isVideoProxyNegotiated = false;
+  record.isFaxProxyNegotiated = false;
+  record.verbose = false;
+  record.state = 2;
+  record.lastOfferIndex = 1;
+  record.audio.data.localEndPointLeg1 = "192.168.1.10:30000";
+  record.audio.data.localEndPointLeg2 = "192.168.1.10:30002";
+  record.audio.data.senderEndPointLeg1 = "10.0.0.1:4000";
+  record.audio.data.senderEndPointLeg2 = "0.0.0.0:0";
+  record.audio.data.lastSenderEndPointLeg1 = "10.0.0.1:4000";
+  record.audio.data.lastSenderEndPointLeg2 = "0.0.0.0:0";
+  record.audio.data.adjustSenderFromPacketSource = true;
+  record.audio.data.leg1Reset = false;
+  record.audio.data.leg2Reset = true;
+  record.audio.data.isStarted = true;
+  record.audio.data.isInactive = false;
+  record.audio.data.isLeg1XOREncrypted = true;
+  record.audio.data.isLeg2XOREncrypted = false;
+  return record;
+}
+
+TEST(RTPSessionTableTest, test_store_and_reload)
+{
+  boost::filesystem::path file = session_table_path();
+  std::remove(OSS::boost_path(file).c_str());
+
+  {
+    RTPSessionTable table;
+    ASSERT_TRUE(table.open(file, 8));
+    ASSERT_EQ(table.capacity(), 8);
+    ASSERT_TRUE(table.store(session_table_record("call-1")));
+    ASSERT_TRUE(table.store(session_table_record("call-2")));
+    ASSERT_TRUE(table.store(session_table_record("call-3")));
+    ASSERT_TRUE(table.remove("call-2"));
+    ASSERT_FALSE(table.remove("call-2"));
+    ASSERT_EQ(table.size(), 2);
+  }
+
+  //
+  // A new instance sees what the previous one left behind
+  //
+  RTPSessionTable table;
+  ASSERT_TRUE(table.open(file, 4));
+  ASSERT_EQ(table.capacity(), 8);
+  ASSERT_EQ(table.size(), 2);
+
+  std::vector<RTPProxyRecord> records;
+  ASSERT_EQ(table.load(records), 2);
+  const RTPProxyRecord& record = records[0].identifier == "call-1" ? records[0] : records[1];
+  ASSERT_EQ(record.identifier, "call-1");
+  ASSERT_EQ(record.logId, "log-call-1");
+  ASSERT_EQ(record.lastSDPInAck, "v=0\r\no=- 1 1 IN IP4 10.0.0.1\r\n");
+  ASSERT_EQ(record.state, 2);
+  ASSERT_TRUE(record.hasOfferedAudioProxy);
+  ASSERT_FALSE(record.hasOfferedVideoProxy);
+  ASSERT_EQ(record.audio.data.identifier, "call-1-audio-data");
+  ASSERT_EQ(record.audio.data.localEndPointLeg1, "192.168.1.10:30000");
+  ASSERT_EQ(record.audio.data.localEndPointLeg2, "192.168.1.10:30002");
+  ASSERT_EQ(record.audio.data.senderEndPointLeg1, "10.0.0.1:4000");
+  ASSERT_EQ(record.audio.data.senderEndPointLeg2, "0.0.0.0:0");
+  ASSERT_TRUE(record.audio.data.adjustSenderFromPacketSource);
+  ASSERT_TRUE(record.audio.data.leg2Reset);
+  ASSERT_TRUE(record.audio.data.isLeg1XOREncrypted);
+  ASSERT_FALSE(record.audio.data.isLeg2XOREncrypted);
+
+  table.close();
+  std::remove(OSS::boost_path(file).c_str());
+}
+
+TEST(RTPSessionTableTest, test_full_table)
+{
+  boost::filesystem::path file = session_table_path();
+  std::remove(OSS::boost_path(file).c_str());
+
+  RTPSessionTable table;
+  ASSERT_TRUE(table.open(file, 2));
+  ASSERT_TRUE(table.store(session_table_record("call-1")));
+  ASSERT_TRUE(table.store(session_table_record("call-2")));
+  ASSERT_FALSE(table.store(session_table_record("call-3")));
+
+  //
+  // Updating a stored session does not need a free slot
+  //
+  ASSERT_TRUE(table.store(session_table_record("call-1")));
+  ASSERT_EQ(table.size(), 2);
+
+  table.close();
+  std::remove(OSS::boost_path(file).c_str());
+}
+
+TEST(RTPSessionTableTest, test_torn_slot_is_discarded)
+{
+  boost::filesystem::path file = session_table_path();
+  std::remove(OSS::boost_path(file).c_str());
+
+  {
+    RTPSessionTable table;
+    ASSERT_TRUE(table.open(file, 4));
+    ASSERT_TRUE(table.store(session_table_record("call-1")));
+  }
+
+  //
+  // Leave the sequence of the first slot odd as if the process died while
+  // writing it
+  //
+  int fd = ::open(OSS::boost_path(file).c_str(), O_RDWR);
+  ASSERT_NE(fd, -1);
+  OSS::UInt32 sequence = 0;
+  ASSERT_EQ(::pread(fd, &sequence, sizeof(sequence), RTPSessionTable::SLOT_SIZE), (ssize_t)sizeof(sequence));
+  sequence |= 1;
+  ASSERT_EQ(::pwrite(fd, &sequence, sizeof(sequence), RTPSessionTable::SLOT_SIZE), (ssize_t)sizeof(sequence));
+  ::close(fd);
+
+  RTPSessionTable table;
+  ASSERT_TRUE(table.open(file, 4));
+  ASSERT_EQ(table.size(), 0);
+  ASSERT_TRUE(table.store(session_table_record("call-2")));
+
+  table.close();
+  std::remove(OSS::boost_path(file).c_str());
+}
+
+#endif // ENABLE_FEATURE_RTP
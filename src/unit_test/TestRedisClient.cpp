@@ -0,0 +1,107 @@
+#include "gtest/gtest.h"
+#include "OSS/build.h"
+
+#if ENABLE_FEATURE_REDIS
+#if OSS_HAVE_HIREDIS
+
+#include "OSS/UTL/CoreUtils.h"
+#include "OSS/Persistent/RedisClient.h"
+
+
+using OSS::Persistent::RedisClient;
+
+
+static const std::size_t TEST_KEY_COUNT = 250;
+
+
+TEST(TestRedisClient, test_scan_iterates_every_key)
+{
+  RedisClient client("127.0.0.1", 6379);
+  if (!client.connect())
+  {
+    return;
+  }
+
+  RedisClient::Commands commands;
+  for (std::size_t i = 0; i < TEST_KEY_COUNT; i++)
+  {
+    commands.push_back(RedisClient::Command());
+    commands.back().push_back("SET");
+    commands.back().push_back("oss-test-scan:" + OSS::string_from_number<std::size_t>(i));
+    commands.back().push_back("value");
+  }
+  ASSERT_TRUE(client.pipeline(commands));
+
+  //
+  // A small count forces many round trips through the cursor loop
+  //
+  std::vector<std::string> keys;
+  ASSERT_TRUE(client.scan("oss-test-scan:*", keys, 10));
+  ASSERT_EQ(keys.size(), TEST_KEY_COUNT);
+  for (std::size_t i = 1; i < keys.size(); i++)
+  {
+    ASSERT_TRUE(keys[i - 1] < keys[i]);
+  }
+
+  std::vector<std::string> values;
+  ASSERT_TRUE(client.getAll(values, "oss-test-scan:*"));
+  ASSERT_EQ(values.size(), TEST_KEY_COUNT);
+
+  for (std::vector<std::string>::const_iterator iter = keys.begin(); iter != keys.end(); iter++)
+  {
+    client.del(*iter);
+  }
+  keys.clear();
+  ASSERT_FALSE(client.scan("oss-test-scan:*", keys, 10));
+  ASSERT_TRUE(keys.empty());
+}
+
+TEST(TestRedisClient, test_pipeline_drains_replies_after_error)
+{
+  RedisClient client("127.0.0.1", 6379);
+  if (!client.connect())
+  {
+    return;
+  }
+
+  RedisClient::Commands commands(4);
+  commands[0].push_back("SET");
+  commands[0].push_back("oss-test-pipeline");
+  commands[0].push_back("not-a-number");
+  commands[1].push_back("INCR");
+  commands[1].push_back("oss-test-pipeline");
+  commands[2].push_back("GET");
+  commands[2].push_back("oss-test-pipeline");
+  commands[3].push_back("DEL");
+  commands[3].push_back("oss-test-pipeline-missing");
+
+  //
+  // The INCR error must not stop the remaining replies from being read
+  //
+  std::vector<std::string> replies;
+  ASSERT_FALSE(client.pipeline(commands, replies));
+  ASSERT_EQ(replies.size(), 4u);
+  ASSERT_EQ(replies[0], "OK");
+  ASSERT_TRUE(replies[1].empty());
+  ASSERT_EQ(replies[2], "not-a-number");
+  ASSERT_EQ(replies[3], "0");
+
+  //
+  // Nothing is left on the connection for the next caller
+  //
+  std::string value;
+  ASSERT_TRUE(client.get("oss-test-pipeline", value));
+  ASSERT_EQ(value, "not-a-number");
+
+  replies.clear();
+  ASSERT_FALSE(client.pipeline(commands, replies, true));
+  ASSERT_EQ(replies.size(), 4u);
+  ASSERT_EQ(replies[2], "not-a-number");
+  ASSERT_TRUE(client.get("oss-test-pipeline", value));
+  ASSERT_EQ(value, "not-a-number");
+
+  client.del("oss-test-pipeline");
+}
+
+#endif // OSS_HAVE_HIREDIS
+#endif // ENABLE_FEATURE_REDIS
@@ -0,0 +1,66 @@
+
+#include "gtest/gtest.h"
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include "OSS/UTL/RingBuffer.h"
+
+using namespace OSS;
+
+
+TEST(ThreadTest, test_ring_buffer_basic)
+{
+  RingBuffer<int> ring(5);
+  ASSERT_EQ(ring.capacity(), 8);
+  ASSERT_TRUE(ring.empty());
+
+  for (int i = 0; i < 8; i++)
+    ASSERT_TRUE(ring.tryEnqueue(i));
+  ASSERT_FALSE(ring.tryEnqueue(8));
+  ASSERT_EQ(ring.size(), 8);
+
+  int value = -1;
+  for (int i = 0; i < 8; i++)
+  {
+    ASSERT_TRUE(ring.tryDequeue(value));
+    ASSERT_EQ(value, i);
+  }
+  ASSERT_FALSE(ring.tryDequeue(value));
+  ASSERT_TRUE(ring.empty());
+}
+
+static void ring_buffer_producer(RingBuffer<int>* pRing, int base, int count)
+{
+  for (int i = 0; i < count; i++)
+  {
+    while (!pRing->tryEnqueue(base + i))
+      boost::this_thread::yield();
+  }
+}
+
+TEST(ThreadTest, test_ring_buffer_multi_producer)
+{
+  const int producers = 4;
+  const int count = 100000;
+  RingBuffer<int> ring(1024);
+  std::vector<int> seen(producers * count, 0);
+
+  boost::thread_group threads;
+  for (int i = 0; i < producers; i++)
+    threads.create_thread(boost::bind(ring_buffer_producer, &ring, i * count, count));
+
+  int received = 0;
+  int value = 0;
+  while (received < producers * count)
+  {
+    if (ring.tryDequeue(value))
+    {
+      seen[value]++;
+      received++;
+    }
+  }
+  threads.join_all();
+
+  for (std::size_t i = 0; i < seen.size(); i++)
+    ASSERT_EQ(seen[i], 1);
+  ASSERT_TRUE(ring.empty());
+}
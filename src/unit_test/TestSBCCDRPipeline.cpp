@@ -0,0 +1,266 @@
+#include "gtest/gtest.h"
+#include <boost/bind.hpp>
+#include "OSS/SIP/SBC/SBCCDRPipeline.h"
+#include "OSS/UTL/CoreUtils.h"
+
+using namespace OSS::SIP::SBC;
+
+
+class TestCDRSink : public SBCCDRSink
+  /// Records every batch.  write() can be made to fail, to throw or to
+  /// block until released.
+{
+public:
+  enum Mode
+  {
+    ACCEPT,
+    FAIL,
+    THROW
+  };
+
+  TestCDRSink(Mode mode = ACCEPT) :
+    _mode(mode),
+    _isGated(false),
+    _isWriting(false)
+  {
+  }
+
+  const char* name() const
+  {
+    return "test";
+  }
+
+  bool write(const Batch& batch)
+  {
+    boost::unique_lock<boost::mutex> lock(_mutex);
+    _isWriting = true;
+    _changed.notify_all();
+    while (_isGated)
+      _changed.wait(lock);
+    _isWriting = false;
+
+    _batches.push_back(batch);
+    if (_mode == THROW)
+      throw std::runtime_error("test sink exception");
+    return _mode == ACCEPT;
+  }
+
+  void gate()
+  {
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    _isGated = true;
+  }
+
+  void release()
+  {
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    _isGated = false;
+    _changed.notify_all();
+  }
+
+  bool waitWriting(unsigned int timeoutMs)
+  {
+    boost::unique_lock<boost::mutex> lock(_mutex);
+    boost::system_time deadline = boost::get_system_time() + boost::posix_time::milliseconds(timeoutMs);
+    while (!_isWriting)
+    {
+      if (!_changed.timed_wait(lock, deadline))
+        return _isWriting;
+    }
+    return true;
+  }
+
+  std::vector<Batch> batches()
+  {
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    return _batches;
+  }
+
+  std::vector<std::string> records()
+  {
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    std::vector<std::string> records;
+    for (std::vector<Batch>::iterator iter = _batches.begin(); iter != _batches.end(); iter++)
+      records.insert(records.end(), iter->begin(), iter->end());
+    return records;
+  }
+
+private:
+  Mode _mode;
+  bool _isGated;
+  bool _isWriting;
+  boost::mutex _mutex;
+  boost::condition_variable _changed;
+  std::vector<Batch> _batches;
+};
+
+static std::string test_cdr_record(std::size_t index)
+{
+  return std::string("cdr-") + OSS::string_from_number<std::size_t>(index);
+}
+
+static void test_cdr_enqueue(SBCCDRPipeline* pPipeline, const std::string& record, bool* pQueued)
+{
+  *pQueued = pPipeline->enqueue(record);
+}
+
+TEST(SBCCDRPipelineTest, test_records_are_written_in_batches)
+{
+  SBCCDRPipeline pipeline(1024, 16, 50);
+  boost::shared_ptr<TestCDRSink> pSink(new TestCDRSink());
+  pipeline.addSink(pSink);
+  ASSERT_TRUE(pipeline.start());
+  ASSERT_FALSE(pipeline.start());
+
+  for (std::size_t i = 0; i < 100; i++)
+    ASSERT_TRUE(pipeline.enqueue(test_cdr_record(i)));
+
+  //
+  // stop() flushes what is still queued
+  //
+  pipeline.stop();
+
+  std::vector<TestCDRSink::Batch> batches = pSink->batches();
+  ASSERT_TRUE(batches.size() >= 7u);
+  for (std::vector<TestCDRSink::Batch>::iterator iter = batches.begin(); iter != batches.end(); iter++)
+  {
+    ASSERT_FALSE(iter->empty());
+    ASSERT_TRUE(iter->size() <= 16u);
+  }
+
+  std::vector<std::string> records = pSink->records();
+  ASSERT_EQ(records.size(), 100u);
+  for (std::size_t i = 0; i < records.size(); i++)
+    ASSERT_EQ(records[i], test_cdr_record(i));
+
+  SBCCDRPipeline::Metrics metrics = pipeline.getMetrics();
+  ASSERT_EQ(metrics.enqueued, 100u);
+  ASSERT_EQ(metrics.written, 100u);
+  ASSERT_EQ(metrics.batches, batches.size());
+  ASSERT_EQ(metrics.dropped, 0u);
+  ASSERT_EQ(metrics.sinkErrors, 0u);
+  ASSERT_EQ(metrics.depth, 0u);
+  ASSERT_EQ(metrics.capacity, 1024u);
+  ASSERT_TRUE(metrics.highWatermark > 0u);
+}
+
+TEST(SBCCDRPipelineTest, test_full_ring_drops_newest)
+{
+  SBCCDRPipeline pipeline(8, 4, 10);
+  boost::shared_ptr<TestCDRSink> pSink(new TestCDRSink());
+  pipeline.addSink(pSink);
+  pSink->gate();
+  ASSERT_TRUE(pipeline.start());
+
+  //
+  // Hold the writer inside the sink, then fill the ring behind it
+  //
+  ASSERT_TRUE(pipeline.enqueue(test_cdr_record(0)));
+  ASSERT_TRUE(pSink->waitWriting(2000));
+  for (std::size_t i = 1; i <= 8; i++)
+    ASSERT_TRUE(pipeline.enqueue(test_cdr_record(i)));
+  ASSERT_FALSE(pipeline.enqueue(test_cdr_record(9)));
+
+  pSink->release();
+  pipeline.stop();
+
+  SBCCDRPipeline::Metrics metrics = pipeline.getMetrics();
+  ASSERT_EQ(metrics.enqueued, 9u);
+  ASSERT_EQ(metrics.written, 9u);
+  ASSERT_EQ(metrics.dropped, 1u);
+  ASSERT_EQ(metrics.highWatermark, 8u);
+  ASSERT_EQ(pSink->records().size(), 9u);
+}
+
+TEST(SBCCDRPipelineTest, test_blocked_producer_resumes_when_writer_frees_room)
+{
+  SBCCDRPipeline pipeline(8, 4, 10);
+  boost::shared_ptr<TestCDRSink> pSink(new TestCDRSink());
+  pipeline.addSink(pSink);
+  pipeline.setDropPolicy(SBCCDRPipeline::BLOCK, 5000);
+  pSink->gate();
+  ASSERT_TRUE(pipeline.start());
+
+  ASSERT_TRUE(pipeline.enqueue(test_cdr_record(0)));
+  ASSERT_TRUE(pSink->waitWriting(2000));
+  for (std::size_t i = 1; i <= 8; i++)
+    ASSERT_TRUE(pipeline.enqueue(test_cdr_record(i)));
+
+  //
+  // The producer waits for room instead of dropping the record
+  //
+  bool queued = false;
+  boost::thread producer(boost::bind(test_cdr_enqueue, &pipeline, test_cdr_record(9), &queued));
+  OSS::thread_sleep(200);
+  ASSERT_FALSE(producer.timed_join(boost::posix_time::milliseconds(0)));
+
+  pSink->release();
+  ASSERT_TRUE(producer.timed_join(boost::posix_time::milliseconds(2000)));
+  ASSERT_TRUE(queued);
+  pipeline.stop();
+
+  SBCCDRPipeline::Metrics metrics = pipeline.getMetrics();
+  ASSERT_EQ(metrics.enqueued, 10u);
+  ASSERT_EQ(metrics.written, 10u);
+  ASSERT_EQ(metrics.dropped, 0u);
+
+  std::vector<std::string> records = pSink->records();
+  ASSERT_EQ(records.size(), 10u);
+  for (std::size_t i = 0; i < records.size(); i++)
+    ASSERT_EQ(records[i], test_cdr_record(i));
+}
+
+TEST(SBCCDRPipelineTest, test_blocked_producer_gives_up_after_timeout)
+{
+  SBCCDRPipeline pipeline(8, 4, 10);
+  boost::shared_ptr<TestCDRSink> pSink(new TestCDRSink());
+  pipeline.addSink(pSink);
+  pipeline.setDropPolicy(SBCCDRPipeline::BLOCK, 100);
+  pSink->gate();
+  ASSERT_TRUE(pipeline.start());
+
+  ASSERT_TRUE(pipeline.enqueue(test_cdr_record(0)));
+  ASSERT_TRUE(pSink->waitWriting(2000));
+  for (std::size_t i = 1; i <= 8; i++)
+    ASSERT_TRUE(pipeline.enqueue(test_cdr_record(i)));
+
+  OSS::UInt64 start = OSS::getTime();
+  ASSERT_FALSE(pipeline.enqueue(test_cdr_record(9)));
+  ASSERT_TRUE(OSS::getTime() - start >= 90);
+
+  pSink->release();
+  pipeline.stop();
+  ASSERT_EQ(pipeline.getMetrics().dropped, 1u);
+  ASSERT_EQ(pipeline.getMetrics().written, 9u);
+}
+
+TEST(SBCCDRPipelineTest, test_sink_errors_do_not_starve_other_sinks)
+{
+  SBCCDRPipeline pipeline(1024, 8, 10);
+  boost::shared_ptr<TestCDRSink> pGood(new TestCDRSink());
+  boost::shared_ptr<TestCDRSink> pFailing(new TestCDRSink(TestCDRSink::FAIL));
+  boost::shared_ptr<TestCDRSink> pThrowing(new TestCDRSink(TestCDRSink::THROW));
+  pipeline.addSink(pFailing);
+  pipeline.addSink(pThrowing);
+  pipeline.addSink(pGood);
+  ASSERT_TRUE(pipeline.start());
+
+  for (std::size_t i = 0; i < 50; i++)
+    ASSERT_TRUE(pipeline.enqueue(test_cdr_record(i)));
+  pipeline.stop();
+
+  //
+  // Every sink sees every batch.  A batch only counts as written once all
+  // sinks accepted it.
+  //
+  std::size_t batchCount = pGood->batches().size();
+  ASSERT_EQ(pGood->records().size(), 50u);
+  ASSERT_EQ(pFailing->records().size(), 50u);
+  ASSERT_EQ(pThrowing->records().size(), 50u);
+
+  SBCCDRPipeline::Metrics metrics = pipeline.getMetrics();
+  ASSERT_EQ(metrics.enqueued, 50u);
+  ASSERT_EQ(metrics.written, 0u);
+  ASSERT_EQ(metrics.batches, 0u);
+  ASSERT_EQ(metrics.sinkErrors, 2 * batchCount);
+}
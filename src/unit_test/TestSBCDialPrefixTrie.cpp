@@ -0,0 +1,90 @@
+#include "gtest/gtest.h"
+#include "OSS/SIP/SBC/SBCDialPrefixTrie.h"
+
+using namespace OSS::SIP::SBC;
+
+
+TEST(SBCDialPrefixTrieTest, test_empty_trie)
+{
+  SBCDialPrefixTrie trie;
+  ASSERT_EQ(trie.size(), 0u);
+  ASSERT_TRUE(trie.match("16505551234") == 0);
+  ASSERT_TRUE(trie.match("") == 0);
+  ASSERT_TRUE(trie.find("1") == 0);
+  ASSERT_FALSE(trie.remove("1"));
+}
+
+TEST(SBCDialPrefixTrieTest, test_longest_prefix_match)
+{
+  SBCDialPrefixTrie trie;
+  SBCDialPrefixTrie::Prefix* pCountry = trie.insert("1", 100);
+  SBCDialPrefixTrie::Prefix* pArea = trie.insert("1650", 10);
+  SBCDialPrefixTrie::Prefix* pIntl = trie.insert("+44", 5);
+  ASSERT_TRUE(pCountry != 0);
+  ASSERT_TRUE(pArea != 0);
+  ASSERT_TRUE(pIntl != 0);
+  ASSERT_EQ(trie.size(), 3u);
+
+  ASSERT_EQ(trie.match("16505551234"), pArea);
+  ASSERT_EQ(trie.match("12125551234"), pCountry);
+  ASSERT_EQ(trie.match("1650"), pArea);
+  ASSERT_EQ(trie.match("165"), pCountry);
+  ASSERT_EQ(trie.match("+442071234567"), pIntl);
+  ASSERT_TRUE(trie.match("44") == 0);
+  ASSERT_TRUE(trie.match("2125551234") == 0);
+
+  //
+  // Matching stops at the first non dialable character
+  //
+  ASSERT_EQ(trie.match("1650;user=phone"), pArea);
+  ASSERT_TRUE(trie.insert("1a", 1) == 0);
+}
+
+TEST(SBCDialPrefixTrieTest, test_overlapping_prefixes_and_aliases)
+{
+  SBCDialPrefixTrie trie;
+  SBCDialPrefixTrie::Prefix* pShort = trie.insert("99", 2);
+  SBCDialPrefixTrie::Prefix* pLong = trie.insert("9911", 4);
+
+  //
+  // Re-registering keeps the prefix and updates its limit
+  //
+  ASSERT_EQ(trie.insert("99", 3), pShort);
+  ASSERT_EQ(pShort->channelLimit.load(), 3u);
+  ASSERT_EQ(trie.size(), 2u);
+
+  ASSERT_TRUE(trie.alias("8", pLong));
+  ASSERT_EQ(trie.match("8123"), pLong);
+  ASSERT_EQ(trie.match("99123"), pShort);
+  ASSERT_EQ(trie.match("991123"), pLong);
+  ASSERT_EQ(trie.find("9911"), pLong);
+  ASSERT_TRUE(trie.find("8") == 0);
+  ASSERT_TRUE(trie.find("991") == 0);
+}
+
+TEST(SBCDialPrefixTrieTest, test_remove)
+{
+  SBCDialPrefixTrie trie;
+  SBCDialPrefixTrie::Prefix* pShort = trie.insert("1", 100);
+  SBCDialPrefixTrie::Prefix* pLong = trie.insert("1650", 10);
+  ASSERT_TRUE(trie.alias("2", pLong));
+
+  ASSERT_FALSE(trie.remove("165"));
+  ASSERT_FALSE(trie.remove("2"));
+  ASSERT_TRUE(trie.remove("1650"));
+  ASSERT_FALSE(trie.remove("1650"));
+  ASSERT_EQ(trie.size(), 1u);
+
+  //
+  // The shorter prefix takes over and aliases of the removed prefix stop
+  // matching
+  //
+  ASSERT_EQ(trie.match("16505551234"), pShort);
+  ASSERT_TRUE(trie.match("2125551234") == 0);
+  ASSERT_TRUE(trie.find("1650") == 0);
+
+  SBCDialPrefixTrie::Prefix* pAgain = trie.insert("1650", 20);
+  ASSERT_TRUE(pAgain != 0);
+  ASSERT_EQ(trie.match("16505551234"), pAgain);
+  ASSERT_EQ(trie.size(), 2u);
+}
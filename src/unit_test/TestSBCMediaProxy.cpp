@@ -0,0 +1,367 @@
+#include "gtest/gtest.h"
+#include <boost/bind.hpp>
+#include "OSS/SIP/SBC/SBCMediaProxy.h"
+#include "OSS/UTL/CoreUtils.h"
+
+using namespace OSS::SIP::SBC;
+
+
+static const std::size_t TEST_SESSION_COUNT = 2000;
+static const char* TEST_RESPONDER_ADDRESS = "tcp://127.0.0.1:41590";
+
+class TestMediaProxy : public SBCMediaProxy
+{
+public:
+  TestMediaProxy() : SBCMediaProxy(0) {}
+  using SBCMediaProxy::getNode;
+  using SBCMediaProxy::findNode;
+  using SBCMediaProxy::releaseNode;
+  SBCMediaProxyClient* node(std::size_t index) { return _nodes[index]; }
+};
+
+static std::string test_node_address(int index)
+{
+  //
+  // Nothing listens on these.  The ring never talks to the nodes.
+  //
+  return std::string("tcp://127.0.0.1:") + OSS::string_from_number<int>(41600 + index);
+}
+
+static std::string test_session_id(std::size_t index)
+{
+  return std::string("session-") + OSS::string_from_number<std::size_t>(index);
+}
+
+TEST(SBCMediaProxyTest, test_ring_ownership_is_stable)
+{
+  TestMediaProxy proxy1;
+  TestMediaProxy proxy2;
+  TestMediaProxy proxy3;
+  for (int i = 0; i < 4; i++)
+  {
+    ASSERT_TRUE(proxy1.addNode(test_node_address(i)));
+    ASSERT_TRUE(proxy2.addNode(test_node_address(i)));
+    ASSERT_TRUE(proxy3.addNode(test_node_address(i)));
+  }
+  ASSERT_FALSE(proxy1.addNode(test_node_address(0)));
+  ASSERT_TRUE(proxy3.addNode(test_node_address(4)));
+  ASSERT_TRUE(proxy1.initialize(true));
+  ASSERT_TRUE(proxy2.initialize(true));
+  ASSERT_TRUE(proxy3.initialize(true));
+  ASSERT_FALSE(proxy1.addNode(test_node_address(5)));
+
+  std::map<std::string, std::size_t> share;
+  std::size_t moved = 0;
+  for (std::size_t i = 0; i < TEST_SESSION_COUNT; i++)
+  {
+    std::string sessionId = test_session_id(i);
+    SBCMediaProxyClient* pOwner = proxy1.findNode(sessionId);
+    ASSERT_TRUE(pOwner != 0);
+    ASSERT_EQ(pOwner->getAddress(), proxy2.findNode(sessionId)->getAddress());
+    share[pOwner->getAddress()]++;
+
+    //
+    // Adding a node only takes sessions over.  Nothing moves between
+    // the nodes that were already there.
+    //
+    const std::string& address = proxy3.findNode(sessionId)->getAddress();
+    if (address != pOwner->getAddress())
+    {
+      ASSERT_EQ(address, test_node_address(4));
+      moved++;
+    }
+  }
+
+  ASSERT_EQ(share.size(), 4u);
+  for (std::map<std::string, std::size_t>::iterator iter = share.begin(); iter != share.end(); iter++)
+    ASSERT_TRUE(iter->second > TEST_SESSION_COUNT / 8);
+  ASSERT_TRUE(moved > 0);
+  ASSERT_TRUE(moved < TEST_SESSION_COUNT / 2);
+}
+
+TEST(SBCMediaProxyTest, test_ring_spill_over_and_affinity)
+{
+  TestMediaProxy proxy;
+  for (int i = 0; i < 3; i++)
+    ASSERT_TRUE(proxy.addNode(test_node_address(i)));
+
+  //
+  // The first node is full.  Not connected yet so no RPC is sent.
+  //
+  proxy.node(0)->setMaxSession(0);
+  ASSERT_TRUE(proxy.initialize(true));
+
+  std::size_t spilled = 0;
+  for (std::size_t i = 0; i < TEST_SESSION_COUNT; i++)
+  {
+    std::string sessionId = test_session_id(i);
+    SBCMediaProxyClient* pOwner = proxy.findNode(sessionId);
+    bool spillOver = true;
+    SBCMediaProxyClient* pNode = proxy.getNode(sessionId, spillOver);
+    ASSERT_TRUE(pNode != 0);
+    if (pOwner == proxy.node(0))
+    {
+      ASSERT_TRUE(spillOver);
+      ASSERT_TRUE(pNode != proxy.node(0));
+      spilled++;
+
+      //
+      // The session is pinned to the node that took it
+      //
+      ASSERT_EQ(proxy.findNode(sessionId), pNode);
+      ASSERT_EQ(proxy.getNode(sessionId, spillOver), pNode);
+      ASSERT_TRUE(spillOver);
+
+      proxy.releaseNode(sessionId);
+      ASSERT_EQ(proxy.findNode(sessionId), proxy.node(0));
+    }
+    else
+    {
+      ASSERT_FALSE(spillOver);
+      ASSERT_EQ(pNode, pOwner);
+      ASSERT_EQ(proxy.findNode(sessionId), pOwner);
+    }
+  }
+  ASSERT_TRUE(spilled > 0);
+}
+
+class TestMediaProxyResponder
+  /// ROUTER socket standing in for a media proxy node.  Requests of the
+  /// test.batch command are answered in reverse order once BATCH_SIZE of
+  /// them arrived.  test.late is answered after the client gave up.
+  /// Anything else is answered right away.  The reply is the request body.
+{
+public:
+  enum { BATCH_SIZE = 8, LATE_REPLY_MS = 2500 };
+  typedef std::vector<std::string> Frames;
+
+  TestMediaProxyResponder() :
+    _context(1),
+    _socket(_context, ZMQ_ROUTER),
+    _isTerminating(false),
+    _pThread(0)
+  {
+    int linger = 0;
+    _socket.setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
+    _socket.bind(TEST_RESPONDER_ADDRESS);
+    _pThread = new boost::thread(boost::bind(&TestMediaProxyResponder::run, this));
+  }
+
+  ~TestMediaProxyResponder()
+  {
+    _isTerminating = true;
+    _pThread->join();
+    delete _pThread;
+  }
+
+  void run()
+  {
+    std::vector<Frames> batch;
+    std::vector<std::pair<OSS::UInt64, Frames> > late;
+    while (!_isTerminating)
+    {
+      Frames frames;
+      if (receive(frames) && frames.size() == 5)
+      {
+        if (frames[3] == "test.batch")
+        {
+          batch.push_back(frames);
+          if (batch.size() == BATCH_SIZE)
+          {
+            for (std::vector<Frames>::reverse_iterator iter = batch.rbegin(); iter != batch.rend(); iter++)
+              reply(*iter);
+            batch.clear();
+          }
+        }
+        else if (frames[3] == "test.late")
+        {
+          late.push_back(std::make_pair(OSS::getTime() + LATE_REPLY_MS, frames));
+        }
+        else
+        {
+          reply(frames);
+        }
+        continue;
+      }
+
+      OSS::UInt64 now = OSS::getTime();
+      for (std::size_t i = 0; i < late.size();)
+      {
+        if (late[i].first <= now)
+        {
+          reply(late[i].second);
+          late.erase(late.begin() + i);
+        }
+        else
+        {
+          i++;
+        }
+      }
+      OSS::thread_sleep(10);
+    }
+  }
+
+  bool receive(Frames& frames)
+  {
+    //
+    // [identity][correlation-id][empty][command][body]
+    //
+    zmq::message_t message;
+    if (!_socket.recv(&message, ZMQ_NOBLOCK))
+      return false;
+    frames.push_back(std::string(static_cast<char*>(message.data()), message.size()));
+#if ZMQ_VERSION_MAJOR < 3
+    int64_t more = 0;
+#else
+    int more = 0;
+#endif
+    size_t moreSize = sizeof(more);
+    _socket.getsockopt(ZMQ_RCVMORE, &more, &moreSize);
+    while (more)
+    {
+      zmq::message_t part;
+      _socket.recv(&part);
+      frames.push_back(std::string(static_cast<char*>(part.data()), part.size()));
+      _socket.getsockopt(ZMQ_RCVMORE, &more, &moreSize);
+    }
+    return true;
+  }
+
+  void send(const std::string& data, int flags)
+  {
+    zmq::message_t message(data.size());
+    memcpy(message.data(), data.data(), data.size());
+    _socket.send(message, flags);
+  }
+
+  void reply(const Frames& frames)
+  {
+    send(frames[0], ZMQ_SNDMORE);
+    send(frames[1], ZMQ_SNDMORE);
+    send(std::string(), ZMQ_SNDMORE);
+    send(frames[4], 0);
+  }
+
+private:
+  zmq::context_t _context;
+  zmq::socket_t _socket;
+  volatile bool _isTerminating;
+  boost::thread* _pThread;
+};
+
+struct TestMediaProxyResult
+{
+  TestMediaProxyResult() : seq(0), received(-1), ok(false), done(false) {}
+  int seq;
+  int received;
+  bool ok;
+  volatile bool done;
+};
+
+static void test_media_proxy_handler(TestMediaProxyResult* pResult, bool ok, json::Object& result)
+{
+  pResult->ok = ok;
+  if (ok && result.Find("seq") != result.End())
+  {
+    json::Number& seq = result["seq"];
+    pResult->received = (int)seq.Value();
+  }
+  pResult->done = true;
+}
+
+static bool test_media_proxy_wait(TestMediaProxyResult* results, std::size_t count, OSS::UInt64 timeout)
+{
+  OSS::UInt64 expires = OSS::getTime() + timeout;
+  while (OSS::getTime() < expires)
+  {
+    std::size_t done = 0;
+    for (std::size_t i = 0; i < count; i++)
+    {
+      if (results[i].done)
+        done++;
+    }
+    if (done == count)
+      return true;
+    OSS::thread_sleep(10);
+  }
+  return false;
+}
+
+TEST(SBCMediaProxyTest, test_client_matches_out_of_order_responses)
+{
+  TestMediaProxyResponder responder;
+  SBCMediaProxyClient client(TEST_RESPONDER_ADDRESS);
+
+  json::Object params;
+  json::Object result;
+  params["seq"] = json::Number(-1);
+  ASSERT_TRUE(client.sendRequest("", "test.echo", params, result));
+
+  //
+  // The responder answers the batch back to front.  Every handler must
+  // still get the body of its own request.
+  //
+  TestMediaProxyResult results[TestMediaProxyResponder::BATCH_SIZE];
+  for (int i = 0; i < TestMediaProxyResponder::BATCH_SIZE; i++)
+  {
+    results[i].seq = i;
+    params["seq"] = json::Number(i);
+    ASSERT_TRUE(client.sendRequest("", "test.batch", params,
+      boost::bind(test_media_proxy_handler, &results[i], _1, _2)));
+  }
+  ASSERT_TRUE(test_media_proxy_wait(results, TestMediaProxyResponder::BATCH_SIZE, 1500));
+  for (int i = 0; i < TestMediaProxyResponder::BATCH_SIZE; i++)
+  {
+    ASSERT_TRUE(results[i].ok);
+    ASSERT_EQ(results[i].received, results[i].seq);
+  }
+  ASSERT_EQ(client.getPendingCount(), 0u);
+  ASSERT_TRUE(client.isAvailable());
+}
+
+TEST(SBCMediaProxyTest, test_client_expires_requests_and_probes)
+{
+  TestMediaProxyResponder responder;
+  SBCMediaProxyClient client(TEST_RESPONDER_ADDRESS);
+
+  json::Object params;
+  TestMediaProxyResult results[3];
+  for (int i = 0; i < 3; i++)
+  {
+    params["seq"] = json::Number(i);
+    ASSERT_TRUE(client.sendRequest("", "test.late", params,
+      boost::bind(test_media_proxy_handler, &results[i], _1, _2)));
+  }
+  ASSERT_TRUE(test_media_proxy_wait(results, 3, 4000));
+  for (int i = 0; i < 3; i++)
+    ASSERT_FALSE(results[i].ok);
+  ASSERT_EQ(client.getPendingCount(), 0u);
+  ASSERT_FALSE(client.isAvailable());
+
+  //
+  // The late responses find nobody waiting and do not revive the node
+  //
+  OSS::thread_sleep(1000);
+  ASSERT_FALSE(client.isAvailable());
+
+  //
+  // Once the probe interval elapsed a single caller is let through
+  //
+  bool probe = false;
+  OSS::UInt64 expires = OSS::getTime() + 6000;
+  while (!probe && OSS::getTime() < expires)
+  {
+    probe = client.isAvailable();
+    if (!probe)
+      OSS::thread_sleep(50);
+  }
+  ASSERT_TRUE(probe);
+  ASSERT_FALSE(client.isAvailable());
+
+  json::Object result;
+  params["seq"] = json::Number(3);
+  ASSERT_TRUE(client.sendRequest("", "test.echo", params, result));
+  json::Number& seq = result["seq"];
+  ASSERT_EQ(seq.Value(), 3);
+  ASSERT_TRUE(client.isAvailable());
+}
@@ -0,0 +1,197 @@
+#include "gtest/gtest.h"
+#include <boost/bind.hpp>
+#include "OSS/SIP/SIPStreamedConnectionManager.h"
+#include "OSS/UTL/CoreUtils.h"
+
+using namespace OSS::SIP;
+
+
+typedef boost::shared_ptr<SIPStreamedConnection> TestStreamedConnection;
+
+static void test_connection_dispatch(SIPMessage::Ptr pMsg, SIPTransportSession::Ptr pTransport)
+{
+}
+
+class TestConnectionPeer
+  /// Accepts a single loopback connection for the connection under test
+  /// and reads what it writes.  The connection's io_service is only run
+  /// by the test so every write completion is stepped explicitly.
+{
+public:
+  TestConnectionPeer(boost::asio::io_service& ioService, const TestStreamedConnection& conn) :
+    _ioService(ioService),
+    _acceptor(_peerService, boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0)),
+    _socket(_peerService)
+  {
+    conn->socket().connect(_acceptor.local_endpoint());
+    _acceptor.accept(_socket);
+  }
+
+  std::size_t available()
+  {
+    return _socket.available();
+  }
+
+  std::string read(std::size_t size)
+  {
+    std::string data(size, '\0');
+    boost::asio::read(_socket, boost::asio::buffer(&data[0], size));
+    return data;
+  }
+
+  std::string drain(std::size_t size, unsigned int timeoutMs)
+  {
+    //
+    // Runs the connection's handlers while reading so that writes larger
+    // than the socket buffers can make progress
+    //
+    std::string data;
+    OSS::UInt64 expires = OSS::getTime() + timeoutMs;
+    while (data.size() < size && OSS::getTime() < expires)
+    {
+      _ioService.poll();
+      _ioService.reset();
+      std::size_t count = _socket.available();
+      if (count)
+        data.append(read(count));
+      else
+        OSS::thread_sleep(1);
+    }
+    return data;
+  }
+
+private:
+  boost::asio::io_service& _ioService;
+  boost::asio::io_service _peerService;
+  boost::asio::ip::tcp::acceptor _acceptor;
+  boost::asio::ip::tcp::socket _socket;
+};
+
+static std::string test_message(std::size_t index, std::size_t size)
+{
+  return std::string(size, (char)('A' + index % 26));
+}
+
+TEST(SIPStreamedConnectionTest, test_writes_are_batched_per_tls_record)
+{
+  boost::asio::io_service ioService;
+  SIPStreamedConnectionManager manager(boost::bind(test_connection_dispatch, _1, _2));
+  TestStreamedConnection conn(new SIPStreamedConnection(ioService, manager, 0));
+  TestConnectionPeer peer(ioService, conn);
+
+  std::vector<std::string> messages;
+  messages.push_back(test_message(0, 1000));
+  for (std::size_t i = 1; i <= 20; i++)
+    messages.push_back(test_message(i, 1000));
+  messages.push_back(test_message(21, 20000));
+  for (std::size_t i = 22; i < 27; i++)
+    messages.push_back(test_message(i, 1000));
+
+  //
+  // The first message goes out right away and its completion stays pending
+  // until the io_service runs.  Everything after it is queued.
+  //
+  std::string received;
+  std::string expected;
+  conn->writeMessage(messages[0]);
+  received.append(peer.read(1000));
+  for (std::size_t i = 1; i < messages.size(); i++)
+    conn->writeMessage(messages[i]);
+  ASSERT_EQ(peer.available(), 0u);
+
+  //
+  // Whole messages are taken until the next one would not fit in 16 KB.
+  // The large message is sent on its own.
+  //
+  std::size_t batches[] = { 16000, 4000, 20000, 5000 };
+  for (std::size_t i = 0; i < sizeof(batches) / sizeof(batches[0]); i++)
+  {
+    ASSERT_EQ(ioService.run_one(), 1u);
+    received.append(peer.read(batches[i]));
+    ASSERT_EQ(peer.available(), 0u);
+  }
+  ASSERT_EQ(ioService.run_one(), 1u);
+
+  for (std::size_t i = 0; i < messages.size(); i++)
+    expected.append(messages[i]);
+  ASSERT_TRUE(received == expected);
+}
+
+TEST(SIPStreamedConnectionTest, test_backlog_overflow_returns_no_buffer_space)
+{
+  boost::asio::io_service ioService;
+  SIPStreamedConnectionManager manager(boost::bind(test_connection_dispatch, _1, _2));
+  TestStreamedConnection conn(new SIPStreamedConnection(ioService, manager, 0));
+  TestConnectionPeer peer(ioService, conn);
+
+  std::string expected = test_message(0, 1000);
+  conn->writeMessage(expected);
+
+  //
+  // The in-flight message counts toward the 1 MB backlog
+  //
+  for (std::size_t i = 1; i <= 15; i++)
+  {
+    boost::system::error_code ec;
+    std::string message = test_message(i, 65536);
+    conn->writeMessage(message, ec);
+    ASSERT_FALSE(ec);
+    expected.append(message);
+  }
+
+  boost::system::error_code ec;
+  conn->writeMessage(test_message(16, 65536), ec);
+  ASSERT_TRUE(ec == boost::asio::error::no_buffer_space);
+
+  //
+  // The dropped message never reaches the peer
+  //
+  std::string received = peer.drain(expected.size(), 5000);
+  ASSERT_EQ(received.size(), expected.size());
+  ASSERT_TRUE(received == expected);
+  ioService.poll();
+  ASSERT_EQ(peer.available(), 0u);
+
+  //
+  // The backlog is released as the batches complete
+  //
+  ec.clear();
+  conn->writeMessage(test_message(17, 1000), ec);
+  ASSERT_FALSE(ec);
+  ASSERT_EQ(peer.read(1000), test_message(17, 1000));
+}
+
+TEST(SIPStreamedConnectionTest, test_sync_write_is_ordered_behind_async_write)
+{
+  boost::asio::io_service ioService;
+  SIPStreamedConnectionManager manager(boost::bind(test_connection_dispatch, _1, _2));
+  TestStreamedConnection conn(new SIPStreamedConnection(ioService, manager, 0));
+  TestConnectionPeer peer(ioService, conn);
+
+  std::string first = test_message(0, 3000);
+  std::string second = test_message(1, 2000);
+  std::string third = test_message(2, 1000);
+
+  //
+  // A synchronous write while the async write is in flight is queued
+  // behind it instead of being written into the middle of it
+  //
+  conn->writeMessage(first);
+  boost::system::error_code ec;
+  conn->writeMessage(second, ec);
+  ASSERT_FALSE(ec);
+  ASSERT_EQ(peer.read(first.size()), first);
+  ASSERT_EQ(peer.available(), 0u);
+
+  ASSERT_EQ(peer.drain(second.size(), 2000), second);
+  ioService.poll();
+  ioService.reset();
+
+  //
+  // Nothing is in flight any more so the write goes out immediately
+  //
+  conn->writeMessage(third, ec);
+  ASSERT_FALSE(ec);
+  ASSERT_EQ(peer.read(third.size()), third);
+  ASSERT_EQ(peer.available(), 0u);
+}
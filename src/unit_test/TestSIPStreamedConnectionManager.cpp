@@ -0,0 +1,142 @@
+#include "gtest/gtest.h"
+#include <boost/bind.hpp>
+#include "OSS/SIP/SIPStreamedConnectionManager.h"
+
+using namespace OSS::SIP;
+
+
+typedef boost::shared_ptr<SIPStreamedConnection> TestStreamedConnection;
+
+static void test_manager_dispatch(SIPMessage::Ptr pMsg, SIPTransportSession::Ptr pTransport)
+{
+}
+
+class TestManagerAcceptor
+  /// Loopback listener the connections under test connect to.  Every
+  /// connection to the same acceptor has the same remote address.
+{
+public:
+  TestManagerAcceptor() :
+    _acceptor(_ioService, boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0))
+  {
+  }
+
+  unsigned short getPort() const
+  {
+    return _acceptor.local_endpoint().port();
+  }
+
+  OSS::Net::IPAddress getAddress() const
+  {
+    return OSS::Net::IPAddress("127.0.0.1", getPort());
+  }
+
+  TestStreamedConnection connect(boost::asio::io_service& ioService, SIPStreamedConnectionManager& manager)
+  {
+    TestStreamedConnection conn(new SIPStreamedConnection(ioService, manager, 0));
+    conn->socket().connect(_acceptor.local_endpoint());
+    boost::shared_ptr<boost::asio::ip::tcp::socket> peer(new boost::asio::ip::tcp::socket(_ioService));
+    _acceptor.accept(*peer);
+    _peers.push_back(peer);
+    return conn;
+  }
+
+private:
+  boost::asio::io_service _ioService;
+  boost::asio::ip::tcp::acceptor _acceptor;
+  std::vector<boost::shared_ptr<boost::asio::ip::tcp::socket> > _peers;
+};
+
+TEST(SIPStreamedConnectionManagerTest, test_find_connection_by_address)
+{
+  boost::asio::io_service ioService;
+  SIPStreamedConnectionManager manager(boost::bind(test_manager_dispatch, _1, _2));
+  TestManagerAcceptor acceptor1;
+  TestManagerAcceptor acceptor2;
+
+  TestStreamedConnection conn1 = acceptor1.connect(ioService, manager);
+  TestStreamedConnection conn2 = acceptor2.connect(ioService, manager);
+  ASSERT_FALSE(manager.findConnectionByAddress(acceptor1.getAddress()));
+
+  manager.add(conn1);
+  manager.start(conn2);
+  ASSERT_TRUE(conn1->getIdentifier() != 0);
+  ASSERT_TRUE(conn2->getIdentifier() != 0);
+  ASSERT_TRUE(conn1->getIdentifier() != conn2->getIdentifier());
+
+  ASSERT_EQ(manager.findConnectionByAddress(acceptor1.getAddress()), conn1);
+  ASSERT_EQ(manager.findConnectionByAddress(acceptor2.getAddress()), conn2);
+  ASSERT_EQ(manager.findConnectionById(conn1->getIdentifier()), conn1);
+  ASSERT_EQ(manager.findConnectionById(conn2->getIdentifier()), conn2);
+
+  manager.stop(conn1);
+  ASSERT_FALSE(manager.findConnectionByAddress(acceptor1.getAddress()));
+  ASSERT_FALSE(manager.findConnectionById(conn1->getIdentifier()));
+  ASSERT_EQ(manager.findConnectionByAddress(acceptor2.getAddress()), conn2);
+  manager.stop(conn2);
+}
+
+TEST(SIPStreamedConnectionManagerTest, test_reconnect_replaces_index_entry)
+{
+  boost::asio::io_service ioService;
+  SIPStreamedConnectionManager manager(boost::bind(test_manager_dispatch, _1, _2));
+  TestManagerAcceptor acceptor;
+
+  TestStreamedConnection oldConn = acceptor.connect(ioService, manager);
+  manager.add(oldConn);
+  ASSERT_EQ(manager.findConnectionByAddress(acceptor.getAddress()), oldConn);
+
+  //
+  // The peer reconnected before the old connection was torn down
+  //
+  TestStreamedConnection newConn = acceptor.connect(ioService, manager);
+  manager.start(newConn);
+  ASSERT_EQ(manager.findConnectionByAddress(acceptor.getAddress()), newConn);
+  ASSERT_EQ(manager.findConnectionById(oldConn->getIdentifier()), oldConn);
+
+  //
+  // Stopping the old connection must leave the new entry alone
+  //
+  manager.stop(oldConn);
+  ASSERT_EQ(manager.findConnectionByAddress(acceptor.getAddress()), newConn);
+  ASSERT_FALSE(manager.findConnectionById(oldConn->getIdentifier()));
+
+  manager.stop(newConn);
+  ASSERT_FALSE(manager.findConnectionByAddress(acceptor.getAddress()));
+  ASSERT_FALSE(manager.findConnectionById(newConn->getIdentifier()));
+}
+
+TEST(SIPStreamedConnectionManagerTest, test_stop_all_clears_index)
+{
+  boost::asio::io_service ioService;
+  SIPStreamedConnectionManager manager(boost::bind(test_manager_dispatch, _1, _2));
+  TestManagerAcceptor acceptors[4];
+  TestStreamedConnection conns[4];
+
+  for (std::size_t i = 0; i < 4; i++)
+  {
+    conns[i] = acceptors[i].connect(ioService, manager);
+    if (i % 2)
+      manager.start(conns[i]);
+    else
+      manager.add(conns[i]);
+    ASSERT_EQ(manager.findConnectionByAddress(acceptors[i].getAddress()), conns[i]);
+  }
+
+  manager.stopAll();
+  for (std::size_t i = 0; i < 4; i++)
+  {
+    ASSERT_FALSE(manager.findConnectionByAddress(acceptors[i].getAddress()));
+    ASSERT_FALSE(manager.findConnectionById(conns[i]->getIdentifier()));
+    ASSERT_FALSE(conns[i]->socket().is_open());
+  }
+
+  //
+  // The manager is usable again after stopAll()
+  //
+  TestStreamedConnection conn = acceptors[0].connect(ioService, manager);
+  manager.add(conn);
+  ASSERT_EQ(manager.findConnectionByAddress(acceptors[0].getAddress()), conn);
+  manager.stop(conn);
+  ASSERT_FALSE(manager.findConnectionByAddress(acceptors[0].getAddress()));
+}
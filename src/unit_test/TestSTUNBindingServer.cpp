@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2012  OSS Software Solutions
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with main.c; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+
+#include <cstring>
+#include <openssl/hmac.h>
+#include "gtest/gtest.h"
+#include "OSS/STUN/STUNBindingServer.h"
+#include "OSS/STUN/STUNProto.h"
+
+using namespace OSS;
+using namespace OSS::STUN;
+
+//
+// RFC 5769 section 2.1 sample request
+//
+static const unsigned char rfc5769_request[] =
+{
+  0x00, 0x01, 0x00, 0x58, 0x21, 0x12, 0xa4, 0x42,
+  0xb7, 0xe7, 0xa7, 0x01, 0xbc, 0x34, 0xd6, 0x86,
+  0xfa, 0x87, 0xdf, 0xae, 0x80, 0x22, 0x00, 0x10,
+  0x53, 0x54, 0x55, 0x4e, 0x20, 0x74, 0x65, 0x73,
+  0x74, 0x20, 0x63, 0x6c, 0x69, 0x65, 0x6e, 0x74,
+  0x00, 0x24, 0x00, 0x04, 0x6e, 0x00, 0x01, 0xff,
+  0x80, 0x29, 0x00, 0x08, 0x93, 0x2f, 0xf9, 0xb1,
+  0x51, 0x26, 0x3b, 0x36, 0x00, 0x06, 0x00, 0x09,
+  0x65, 0x76, 0x74, 0x6a, 0x3a, 0x68, 0x36, 0x76,
+  0x59, 0x20, 0x20, 0x20, 0x00, 0x08, 0x00, 0x14,
+  0x9a, 0xea, 0xa7, 0x0c, 0xbf, 0xd8, 0xcb, 0x56,
+  0x78, 0x1e, 0xf2, 0xb5, 0xb2, 0xd3, 0xf2, 0x49,
+  0xc1, 0xb5, 0x71, 0xa2, 0x80, 0x28, 0x00, 0x04,
+  0xe5, 0x7a, 0x3b, 0xcf
+};
+
+static const char* rfc5769_password = "VOkJxbRl1RmTxUk/WvJxBt";
+
+static UInt16 read16(const char* p)
+{
+  return (UInt16)(((unsigned char)p[0] << 8) | (unsigned char)p[1]);
+}
+
+static UInt32 read32(const char* p)
+{
+  return ((UInt32)read16(p) << 16) | read16(p + 2);
+}
+
+static const char* findAttribute(const char* msg, std::size_t len, UInt16 type)
+{
+  std::size_t offset = 20;
+  while (offset + 4 <= len)
+  {
+    if (read16(msg + offset) == type)
+      return msg + offset;
+    offset += 4 + ((read16(msg + offset + 2) + 3) & ~3);
+  }
+  return 0;
+}
+
+static boost::asio::ip::udp::endpoint rfc5769_source()
+{
+  return boost::asio::ip::udp::endpoint(boost::asio::ip::address::from_string("192.0.2.1"), 32853);
+}
+
+TEST(STUNBindingServerTest, test_authenticated_request)
+{
+  STUNBindingServer server;
+  server.setCredential("evtj", rfc5769_password);
+
+  char response[STUNBindingServer::MAX_DATAGRAM_SIZE];
+  std::size_t len = server.processRequest((const char*)rfc5769_request, sizeof(rfc5769_request), rfc5769_source(), response, sizeof(response));
+  ASSERT_TRUE(len > 20);
+  ASSERT_EQ(read16(response), Proto::BindResponseMsg);
+  ASSERT_EQ(read16(response + 2), len - 20);
+  ASSERT_TRUE(std::memcmp(response + 4, rfc5769_request + 4, 16) == 0);
+
+  //
+  // XOR-MAPPED-ADDRESS values from RFC 5769 section 2.2
+  //
+  const char* mapped = findAttribute(response, len, Proto::XorMappedAddressRfc5389);
+  ASSERT_TRUE(mapped != 0);
+  ASSERT_EQ(read16(mapped + 6), 0xa147);
+  ASSERT_EQ(read32(mapped + 8), 0xe112a643);
+
+  const char* integrity = findAttribute(response, len, Proto::MessageIntegrity);
+  const char* fingerprint = findAttribute(response, len, Proto::Fingerprint);
+  ASSERT_TRUE(integrity != 0);
+  ASSERT_TRUE(fingerprint != 0);
+  ASSERT_EQ(fingerprint + 8, response + len);
+  ASSERT_EQ(integrity + 24, fingerprint);
+
+  char copy[STUNBindingServer::MAX_DATAGRAM_SIZE];
+  std::memcpy(copy, response, len);
+  std::size_t integrityOffset = integrity - response;
+  copy[2] = (char)((integrityOffset + 24 - 20) >> 8);
+  copy[3] = (char)((integrityOffset + 24 - 20) & 0xFF);
+  unsigned char hmac[20];
+  unsigned int hmacLength = sizeof(hmac);
+  HMAC(EVP_sha1(), rfc5769_password, std::strlen(rfc5769_password), (const unsigned char*)copy, integrityOffset, hmac, &hmacLength);
+  ASSERT_TRUE(std::memcmp(hmac, integrity + 4, sizeof(hmac)) == 0);
+
+  UInt32 crc = Proto::stunCrc32(response, fingerprint - response) ^ Proto::FingerprintXor;
+  ASSERT_EQ(read32(fingerprint + 4), crc);
+
+  STUNBindingServer::Stats stats = server.getStats();
+  ASSERT_EQ(stats.requests, 1);
+  ASSERT_EQ(stats.responses, 1);
+  ASSERT_EQ(stats.authFailures, 0);
+}
+
+TEST(STUNBindingServerTest, test_rejected_requests)
+{
+  STUNBindingServer server;
+  char response[STUNBindingServer::MAX_DATAGRAM_SIZE];
+
+  //
+  // Unknown username fragment
+  //
+  std::size_t len = server.processRequest((const char*)rfc5769_request, sizeof(rfc5769_request), rfc5769_source(), response, sizeof(response));
+  ASSERT_TRUE(len > 20);
+  ASSERT_EQ(read16(response), Proto::BindErrorResponseMsg);
+  const char* error = findAttribute(response, len, Proto::ErrorCode);
+  ASSERT_TRUE(error != 0);
+  ASSERT_EQ(error[6], 4);
+  ASSERT_EQ(error[7], 1);
+
+  //
+  // Wrong password
+  //
+  server.setCredential("evtj", "wrong");
+  len = server.processRequest((const char*)rfc5769_request, sizeof(rfc5769_request), rfc5769_source(), response, sizeof(response));
+  ASSERT_EQ(read16(response), Proto::BindErrorResponseMsg);
+  ASSERT_EQ(server.getStats().authFailures, 2);
+
+  //
+  // Corrupted fingerprint is silently dropped
+  //
+  unsigned char corrupted[sizeof(rfc5769_request)];
+  std::memcpy(corrupted, rfc5769_request, sizeof(corrupted));
+  corrupted[sizeof(corrupted) - 1] ^= 0x01;
+  ASSERT_EQ(server.processRequest((const char*)corrupted, sizeof(corrupted), rfc5769_source(), response, sizeof(response)), 0);
+
+  //
+  // RTP and DTLS are dropped
+  //
+  unsigned char rtp[] = { 0x80, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+  ASSERT_EQ(server.processRequest((const char*)rtp, sizeof(rtp), rfc5769_source(), response, sizeof(response)), 0);
+  ASSERT_EQ(server.getStats().discarded, 2);
+}
+
+TEST(STUNBindingServerTest, test_unauthenticated_request)
+{
+  STUNBindingServer server;
+  char response[STUNBindingServer::MAX_DATAGRAM_SIZE];
+
+  //
+  // Classic RFC 3489 request with a CHANGE-REQUEST asking for a different port
+  //
+  unsigned char request[] =
+  {
+    0x00, 0x01, 0x00, 0x08, 0x01, 0x02, 0x03, 0x04,
+    0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c,
+    0x0d, 0x0e, 0x0f, 0x10, 0x00, 0x03, 0x00, 0x04,
+    0x00, 0x00, 0x00, 0x02
+  };
+  std::size_t len = server.processRequest((const char*)request, sizeof(request), rfc5769_source(), response, sizeof(response));
+  ASSERT_EQ(read16(response), Proto::BindErrorResponseMsg);
+  ASSERT_TRUE(findAttribute(response, len, Proto::UnknownAttribute) != 0);
+
+  //
+  // Without the CHANGE-REQUEST the source is returned in MAPPED-ADDRESS
+  //
+  request[3] = 0x00;
+  len = server.processRequest((const char*)request, 20, rfc5769_source(), response, sizeof(response));
+  ASSERT_EQ(read16(response), Proto::BindResponseMsg);
+  const char* mapped = findAttribute(response, len, Proto::MappedAddress);
+  ASSERT_TRUE(mapped != 0);
+  ASSERT_EQ(read16(mapped + 6), 32853);
+  ASSERT_EQ(read32(mapped + 8), 0xc0000201);
+
+  server.setRequireAuthentication(true);
+  server.processRequest((const char*)request, 20, rfc5769_source(), response, sizeof(response));
+  ASSERT_EQ(read16(response), Proto::BindErrorResponseMsg);
+}
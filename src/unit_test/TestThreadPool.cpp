@@ -0,0 +1,89 @@
+#include "gtest/gtest.h"
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include "OSS/UTL/TaskExecutor.h"
+#include "OSS/UTL/CoreUtils.h"
+
+using namespace OSS;
+
+
+static void task_executor_count(boost::atomic<int>* pCount)
+{
+  pCount->fetch_add(1);
+}
+
+static void task_executor_block(OSS::semaphore* pGate)
+{
+  pGate->wait();
+}
+
+TEST(ThreadTest, test_task_executor_burst)
+{
+  boost::atomic<int> count(0);
+  TaskExecutor executor(4, 1024);
+
+  for (int i = 0; i < 4000; i++)
+  {
+    if (i % 2)
+      ASSERT_NE(executor.schedule(boost::bind(task_executor_count, &count), OSS::string_from_number(i)), -1);
+    else
+      ASSERT_NE(executor.schedule(boost::bind(task_executor_count, &count)), -1);
+  }
+  executor.join();
+  ASSERT_EQ(count, 4000);
+  ASSERT_EQ(executor.getPendingCount(), 0);
+}
+
+TEST(ThreadTest, test_task_executor_bounded_admission)
+{
+  OSS::semaphore gate(0, 2);
+  boost::atomic<int> count(0);
+  TaskExecutor executor(2, 4);
+
+  //
+  // Park both workers so nothing is dequeued while the queue fills
+  //
+  ASSERT_NE(executor.schedule(boost::bind(task_executor_block, &gate)), -1);
+  ASSERT_NE(executor.schedule(boost::bind(task_executor_block, &gate)), -1);
+  while (executor.getActiveCount() < 2)
+    boost::this_thread::yield();
+
+  for (std::size_t i = 0; i < executor.getCapacity(); i++)
+    ASSERT_NE(executor.schedule(boost::bind(task_executor_count, &count)), -1);
+  ASSERT_EQ(executor.schedule(boost::bind(task_executor_count, &count)), -1);
+
+  gate.set();
+  gate.set();
+  executor.join();
+  ASSERT_EQ(count, (int)executor.getCapacity());
+}
+
+TEST(ThreadTest, test_task_executor_grows_when_busy)
+{
+  OSS::semaphore gate(0, 4);
+  boost::atomic<int> count(0);
+  TaskExecutor executor(1, 4, 3);
+  ASSERT_EQ(executor.getWorkerCount(), 1u);
+  ASSERT_EQ(executor.getMaxWorkerCount(), 3u);
+
+  //
+  // Each blocking task lands while every worker is busy so a worker is
+  // added until the maximum is reached
+  //
+  for (std::size_t i = 1; i <= 3; i++)
+  {
+    ASSERT_NE(executor.schedule(boost::bind(task_executor_block, &gate)), -1);
+    while (executor.getActiveCount() < i)
+      boost::this_thread::yield();
+  }
+  ASSERT_EQ(executor.getWorkerCount(), 3u);
+
+  ASSERT_NE(executor.schedule(boost::bind(task_executor_count, &count)), -1);
+  ASSERT_EQ(executor.getWorkerCount(), 3u);
+
+  gate.set();
+  gate.set();
+  gate.set();
+  executor.join();
+  ASSERT_EQ(count, 1);
+}
@@ -1940,6 +1940,7 @@ void OSSApp::initialize(OSSApplication& self)
   std::string libLoggerPurgeCount = config().getString("library.logger.purgeCount", "7");
   std::string libLoggerPriorityCache = config().getString("library.logger.priority.cache", "");
   std::string libLoggerTimes = config().getString("library.logger.times.cache", "");
+  bool libLoggerAsync = config().getBool("library.logger.async", false);
 
   if (!libLoggerPriorityCache.empty())
   {
@@ -1984,7 +1985,7 @@ void OSSApp::initialize(OSSApplication& self)
   else if ("trace" == libLoggerPriority)
     logPriority = OSS::PRIO_TRACE;
 
-  OSS::logger_init(libLogger, logPriority, libLoggerPattern, libLoggerCompress, libLoggerPurgeCount, libLoggerTimes);
+  OSS::logger_init(libLogger, logPriority, libLoggerPattern, libLoggerCompress, libLoggerPurgeCount, libLoggerTimes, libLoggerAsync);
 
   if (_initHandler)
     _initHandler();
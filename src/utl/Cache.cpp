@@ -19,14 +19,13 @@
 
 
 #include "OSS/UTL/Cache.h"
-#include "Poco/ExpireCache.h"
+#include "OSS/UTL/ExpireHashMap.h"
 
 
 
 namespace OSS {
 
-typedef Poco::ExpireCache<std::string, OSS::Cacheable::Ptr> ExpireCache;
-typedef Poco::SharedPtr<Cacheable::Ptr> ExpireCacheable;
+typedef ExpireHashMap<OSS::Cacheable::Ptr> ExpireCache;
 
 Cacheable::Cacheable(const std::string& id,  const boost::any& data) :
   _data(data),
@@ -56,23 +55,16 @@ void CacheManager::add(Cacheable::Ptr pCacheable)
 
 Cacheable::Ptr CacheManager::get(const std::string& id) const
 {
-  ExpireCacheable pCacheObj = static_cast<ExpireCache*>(_manager)->get(id);
-  if (pCacheObj)
-    return *pCacheObj;
-  
-  return Cacheable::Ptr();
+  Cacheable::Ptr pCacheObj;
+  static_cast<ExpireCache*>(_manager)->get(id, pCacheObj);
+  return pCacheObj;
 }
 
 Cacheable::Ptr CacheManager::pop(const std::string& id)
 {
-  ExpireCacheable pCacheObj = static_cast<ExpireCache*>(_manager)->get(id);
-  if (pCacheObj)
-  {
-    static_cast<ExpireCache*>(_manager)->remove(id);
-    return *pCacheObj;
-  }
-
-  return Cacheable::Ptr();
+  Cacheable::Ptr pCacheObj;
+  static_cast<ExpireCache*>(_manager)->pop(id, pCacheObj);
+  return pCacheObj;
 }
 
 void CacheManager::remove(const std::string& id)
@@ -93,8 +85,7 @@ void CacheManager::clear()
 
 /////////////////////////////////
 
-typedef Poco::ExpireCache<std::string, std::string> StringPairExpireCache;
-typedef Poco::SharedPtr<std::string> StringPairExpireCacheable;
+typedef ExpireHashMap<std::string> StringPairExpireCache;
 
 
 StringPairCache::StringPairCache(int expireInSeconds)
@@ -114,23 +105,16 @@ void StringPairCache::add(const std::string& id, const std::string& value)
 
 std::string StringPairCache::get(const std::string& id) const
 {
-  StringPairExpireCacheable pCacheObj = static_cast<StringPairExpireCache*>(_manager)->get(id);
-  if (pCacheObj)
-    return *pCacheObj;
-
-  return std::string();
+  std::string value;
+  static_cast<StringPairExpireCache*>(_manager)->get(id, value);
+  return value;
 }
 
 std::string StringPairCache::pop(const std::string& id)
 {
-  StringPairExpireCacheable pCacheObj = static_cast<StringPairExpireCache*>(_manager)->get(id);
-  if (pCacheObj)
-  {
-    static_cast<StringPairExpireCache*>(_manager)->remove(id);
-    return *pCacheObj;
-  }
-
-  return std::string();
+  std::string value;
+  static_cast<StringPairExpireCache*>(_manager)->pop(id, value);
+  return value;
 }
 
 void StringPairCache::remove(const std::string& id)
@@ -157,4 +141,3 @@ void StringPairCache::clear()
 
 
 } // OSS
-
@@ -0,0 +1,104 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include <set>
+#include <boost/bind.hpp>
+#include "OSS/UTL/ExpireHashMap.h"
+
+
+namespace OSS {
+
+#define EXPIRE_HASH_MAP_SWEEP_INTERVAL_MS 1000
+
+class ExpireHashMapSweeper : boost::noncopyable
+{
+public:
+  typedef std::set<ExpireHashMapBase*> Maps;
+
+  ExpireHashMapSweeper() :
+    _pThread(0)
+  {
+  }
+
+  void add(ExpireHashMapBase* pMap)
+  {
+    OSS::mutex_critic_sec_lock lock(_mutex);
+    _maps.insert(pMap);
+    if (!_pThread)
+      _pThread = new boost::thread(boost::bind(&ExpireHashMapSweeper::run, this));
+  }
+
+  void remove(ExpireHashMapBase* pMap)
+  {
+    //
+    // The sweep loop holds the same mutex while sweeping so once we
+    // get through here the map is guaranteed to no longer be in use
+    //
+    OSS::mutex_critic_sec_lock lock(_mutex);
+    _maps.erase(pMap);
+  }
+
+  void run()
+  {
+    while (true)
+    {
+      OSS::thread_sleep(EXPIRE_HASH_MAP_SWEEP_INTERVAL_MS);
+      OSS::mutex_critic_sec_lock lock(_mutex);
+      for (Maps::iterator iter = _maps.begin(); iter != _maps.end(); iter++)
+        (*iter)->sweep();
+    }
+  }
+
+private:
+  OSS::mutex_critic_sec _mutex;
+  Maps _maps;
+  boost::thread* _pThread;
+};
+
+static ExpireHashMapSweeper& sweeper()
+{
+  //
+  // Intentionally never destroyed.  Maps with static storage duration
+  // may still unregister while the process is exiting.
+  //
+  static ExpireHashMapSweeper* pSweeper = new ExpireHashMapSweeper();
+  return *pSweeper;
+}
+
+ExpireHashMapBase::ExpireHashMapBase()
+{
+}
+
+ExpireHashMapBase::~ExpireHashMapBase()
+{
+}
+
+void ExpireHashMapBase::enableSweep()
+{
+  sweeper().add(this);
+}
+
+void ExpireHashMapBase::disableSweep()
+{
+  sweeper().remove(this);
+}
+
+} // OSS
+
@@ -0,0 +1,470 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include "OSS/UTL/ExpiryIndex.h"
+#include "OSS/UTL/CoreUtils.h"
+#include "OSS/UTL/Logger.h"
+#include <cstring>
+#include <unistd.h>
+
+
+namespace OSS {
+
+
+//
+// Journal layout.  A four byte header followed by records.  Integers are
+// little endian.
+//
+//   'A' u64 expires u16 keyLength u16 dataLength key data
+//   'T' u64 expires u16 keyLength key
+//   'R' u16 keyLength key
+//
+static const char JOURNAL_MAGIC[4] = { 'O', 'X', 'I', 1 };
+static const std::size_t MAX_FIELD_SIZE = 0xFFFF;
+static const std::size_t MIN_COMPACT_RECORDS = 1024;
+
+
+static void put_u16(std::string& buff, std::size_t value)
+{
+  buff.push_back((char)(value & 0xFF));
+  buff.push_back((char)((value >> 8) & 0xFF));
+}
+
+static void put_u64(std::string& buff, OSS::UInt64 value)
+{
+  for (int i = 0; i < 8; i++)
+  {
+    buff.push_back((char)((value >> (i * 8)) & 0xFF));
+  }
+}
+
+static std::size_t get_u16(const unsigned char* data)
+{
+  return (std::size_t)data[0] | ((std::size_t)data[1] << 8);
+}
+
+static OSS::UInt64 get_u64(const unsigned char* data)
+{
+  OSS::UInt64 value = 0;
+  for (int i = 7; i >= 0; i--)
+  {
+    value = (value << 8) | data[i];
+  }
+  return value;
+}
+
+
+ExpiryIndex::ExpiryIndex(unsigned int bucketSeconds) :
+  _bucketSeconds(bucketSeconds ? bucketSeconds : 1),
+  _journal(0),
+  _journalRecords(0)
+{
+}
+
+ExpiryIndex::~ExpiryIndex()
+{
+  close();
+}
+
+bool ExpiryIndex::open(const boost::filesystem::path& journal)
+{
+  boost::lock_guard<boost::mutex> lock(_mutex);
+  if (_journal)
+  {
+    return false;
+  }
+
+  _journalPath = journal;
+  load(journal);
+
+  //
+  // Start from a compacted copy so stale records from the previous run do
+  // not accumulate across restarts.
+  //
+  return rewrite();
+}
+
+void ExpiryIndex::close()
+{
+  boost::lock_guard<boost::mutex> lock(_mutex);
+  if (_journal)
+  {
+    std::fclose(_journal);
+    _journal = 0;
+  }
+}
+
+void ExpiryIndex::add(const std::string& key, OSS::UInt64 expires, const std::string& data)
+{
+  boost::lock_guard<boost::mutex> lock(_mutex);
+  insert(key, expires, data);
+  journalAdd('A', key, expires, data);
+  journalFlush();
+}
+
+bool ExpiryIndex::touch(const std::string& key, OSS::UInt64 expires)
+{
+  boost::lock_guard<boost::mutex> lock(_mutex);
+  Records::iterator iter = _records.find(key);
+  if (iter == _records.end())
+  {
+    return false;
+  }
+
+  std::string data;
+  data.swap(iter->second.data);
+  insert(key, expires, data);
+  journalAdd('T', key, expires, std::string());
+  journalFlush();
+  return true;
+}
+
+bool ExpiryIndex::remove(const std::string& key)
+{
+  boost::lock_guard<boost::mutex> lock(_mutex);
+  if (!erase(key))
+  {
+    return false;
+  }
+  journalRemove(key);
+  journalFlush();
+  return true;
+}
+
+std::size_t ExpiryIndex::popExpired(OSS::UInt64 now, std::size_t maxCount, Entries& expired)
+{
+  boost::lock_guard<boost::mutex> lock(_mutex);
+  std::size_t count = 0;
+
+  //
+  // Every key in a bucket expires at or before the bucket's upper bound, so
+  // only whole buckets at or below now need to be looked at.
+  //
+  Buckets::iterator bucket = _buckets.begin();
+  while (count < maxCount && bucket != _buckets.end() && bucket->first * _bucketSeconds <= now)
+  {
+    Keys& keys = bucket->second;
+    while (count < maxCount && !keys.empty())
+    {
+      Keys::iterator key = keys.begin();
+      Records::iterator record = _records.find(*key);
+      if (record != _records.end())
+      {
+        expired.push_back(Entry());
+        Entry& entry = expired.back();
+        entry.key = *key;
+        entry.data.swap(record->second.data);
+        entry.expires = record->second.expires;
+        _records.erase(record);
+        journalRemove(entry.key);
+        count++;
+      }
+      keys.erase(key);
+    }
+
+    if (keys.empty())
+    {
+      _buckets.erase(bucket++);
+    }
+  }
+
+  if (count)
+  {
+    journalFlush();
+  }
+  return count;
+}
+
+bool ExpiryIndex::has(const std::string& key) const
+{
+  boost::lock_guard<boost::mutex> lock(_mutex);
+  return _records.find(key) != _records.end();
+}
+
+std::size_t ExpiryIndex::size() const
+{
+  boost::lock_guard<boost::mutex> lock(_mutex);
+  return _records.size();
+}
+
+bool ExpiryIndex::isOpen() const
+{
+  boost::lock_guard<boost::mutex> lock(_mutex);
+  return _journal != 0;
+}
+
+void ExpiryIndex::compact()
+{
+  boost::lock_guard<boost::mutex> lock(_mutex);
+  if (_journal)
+  {
+    rewrite();
+  }
+}
+
+bool ExpiryIndex::compactIfStale()
+{
+  boost::lock_guard<boost::mutex> lock(_mutex);
+  if (!_journal || _journalRecords <= MIN_COMPACT_RECORDS || _journalRecords <= 2 * _records.size())
+  {
+    return false;
+  }
+  return rewrite();
+}
+
+void ExpiryIndex::insert(const std::string& key, OSS::UInt64 expires, const std::string& data)
+{
+  OSS::UInt64 bucket = bucketOf(expires);
+  std::pair<Records::iterator, bool> result = _records.insert(Records::value_type(key, Record()));
+  Record& record = result.first->second;
+  if (!result.second && record.bucket != bucket)
+  {
+    Buckets::iterator previous = _buckets.find(record.bucket);
+    if (previous != _buckets.end())
+    {
+      previous->second.erase(key);
+      if (previous->second.empty())
+      {
+        _buckets.erase(previous);
+      }
+    }
+  }
+  record.expires = expires;
+  record.bucket = bucket;
+  record.data = data;
+  _buckets[bucket].insert(key);
+}
+
+bool ExpiryIndex::erase(const std::string& key)
+{
+  Records::iterator record = _records.find(key);
+  if (record == _records.end())
+  {
+    return false;
+  }
+
+  Buckets::iterator bucket = _buckets.find(record->second.bucket);
+  if (bucket != _buckets.end())
+  {
+    bucket->second.erase(key);
+    if (bucket->second.empty())
+    {
+      _buckets.erase(bucket);
+    }
+  }
+  _records.erase(record);
+  return true;
+}
+
+void ExpiryIndex::load(const boost::filesystem::path& journal)
+{
+  std::FILE* file = std::fopen(OSS::boost_path(journal).c_str(), "rb");
+  if (!file)
+  {
+    return;
+  }
+
+  std::string buff;
+  char chunk[65536];
+  std::size_t read = 0;
+  while ((read = std::fread(chunk, 1, sizeof(chunk), file)) > 0)
+  {
+    buff.append(chunk, read);
+  }
+  std::fclose(file);
+
+  if (buff.size() < sizeof(JOURNAL_MAGIC) || std::memcmp(buff.data(), JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0)
+  {
+    OSS_LOG_WARNING("ExpiryIndex::load - Ignoring unrecognized journal " << OSS::boost_path(journal));
+    return;
+  }
+
+  //
+  // Replay records in order.  A truncated record at the tail is what a crash
+  // in the middle of an append leaves behind, so replay simply stops there.
+  //
+  const unsigned char* data = (const unsigned char*)buff.data();
+  std::size_t size = buff.size();
+  std::size_t offset = sizeof(JOURNAL_MAGIC);
+  while (offset < size)
+  {
+    char type = (char)data[offset];
+    if (type == 'A' && offset + 13 <= size)
+    {
+      OSS::UInt64 expires = get_u64(data + offset + 1);
+      std::size_t keyLength = get_u16(data + offset + 9);
+      std::size_t dataLength = get_u16(data + offset + 11);
+      if (offset + 13 + keyLength + dataLength > size)
+      {
+        break;
+      }
+      const char* key = (const char*)data + offset + 13;
+      insert(std::string(key, keyLength), expires, std::string(key + keyLength, dataLength));
+      offset += 13 + keyLength + dataLength;
+    }
+    else if (type == 'T' && offset + 11 <= size)
+    {
+      OSS::UInt64 expires = get_u64(data + offset + 1);
+      std::size_t keyLength = get_u16(data + offset + 9);
+      if (offset + 11 + keyLength > size)
+      {
+        break;
+      }
+      std::string key((const char*)data + offset + 11, keyLength);
+      Records::iterator record = _records.find(key);
+      if (record != _records.end())
+      {
+        std::string value;
+        value.swap(record->second.data);
+        insert(key, expires, value);
+      }
+      offset += 11 + keyLength;
+    }
+    else if (type == 'R' && offset + 3 <= size)
+    {
+      std::size_t keyLength = get_u16(data + offset + 1);
+      if (offset + 3 + keyLength > size)
+      {
+        break;
+      }
+      erase(std::string((const char*)data + offset + 3, keyLength));
+      offset += 3 + keyLength;
+    }
+    else
+    {
+      if (type != 'A' && type != 'T' && type != 'R')
+      {
+        OSS_LOG_WARNING("ExpiryIndex::load - Corrupt record at offset " << offset << " in " << OSS::boost_path(journal));
+      }
+      break;
+    }
+  }
+}
+
+bool ExpiryIndex::rewrite()
+{
+  if (_journal)
+  {
+    std::fclose(_journal);
+    _journal = 0;
+  }
+
+  std::string path = OSS::boost_path(_journalPath);
+  std::string temp = path + ".tmp";
+  std::FILE* file = std::fopen(temp.c_str(), "wb");
+  if (!file)
+  {
+    OSS_LOG_ERROR("ExpiryIndex::rewrite - Unable to create " << temp);
+    return false;
+  }
+
+  _journal = file;
+  _journalRecords = 0;
+  std::fwrite(JOURNAL_MAGIC, 1, sizeof(JOURNAL_MAGIC), _journal);
+  for (Records::const_iterator iter = _records.begin(); iter != _records.end(); iter++)
+  {
+    journalAdd('A', iter->first, iter->second.expires, iter->second.data);
+  }
+
+  bool ok = std::fflush(_journal) == 0 && ::fsync(fileno(_journal)) == 0;
+  std::fclose(_journal);
+  _journal = 0;
+
+  if (!ok || std::rename(temp.c_str(), path.c_str()) != 0)
+  {
+    OSS_LOG_ERROR("ExpiryIndex::rewrite - Unable to replace " << path);
+    std::remove(temp.c_str());
+    return false;
+  }
+
+  _journal = std::fopen(path.c_str(), "ab");
+  if (!_journal)
+  {
+    OSS_LOG_ERROR("ExpiryIndex::rewrite - Unable to open " << path);
+    return false;
+  }
+  return true;
+}
+
+void ExpiryIndex::journalAdd(char type, const std::string& key, OSS::UInt64 expires, const std::string& data)
+{
+  if (!_journal)
+  {
+    return;
+  }
+
+  if (key.size() > MAX_FIELD_SIZE || data.size() > MAX_FIELD_SIZE)
+  {
+    OSS_LOG_WARNING("ExpiryIndex::journalAdd - Key or data too large to journal (" << key.size() << "/" << data.size() << " bytes)");
+    return;
+  }
+
+  std::string buff;
+  buff.reserve(13 + key.size() + data.size());
+  buff.push_back(type);
+  put_u64(buff, expires);
+  put_u16(buff, key.size());
+  if (type == 'A')
+  {
+    put_u16(buff, data.size());
+  }
+  buff.append(key);
+  if (type == 'A')
+  {
+    buff.append(data);
+  }
+  std::fwrite(buff.data(), 1, buff.size(), _journal);
+  _journalRecords++;
+}
+
+void ExpiryIndex::journalRemove(const std::string& key)
+{
+  if (!_journal || key.size() > MAX_FIELD_SIZE)
+  {
+    return;
+  }
+
+  std::string buff;
+  buff.reserve(3 + key.size());
+  buff.push_back('R');
+  put_u16(buff, key.size());
+  buff.append(key);
+  std::fwrite(buff.data(), 1, buff.size(), _journal);
+  _journalRecords++;
+}
+
+void ExpiryIndex::journalFlush()
+{
+  if (!_journal)
+  {
+    return;
+  }
+
+  //
+  // Hand the appended records to the kernel without an fsync.  Losing the
+  // last few records in a power failure only delays or repeats a cleanup.
+  // Compaction is left to compactIfStale() so callers on the SIP threads
+  // never wait on a rewrite.
+  //
+  std::fflush(_journal);
+}
+
+
+} // OSS
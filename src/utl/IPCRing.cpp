@@ -0,0 +1,524 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <climits>
+#include <cstring>
+
+#include "OSS/UTL/IPCRing.h"
+#include "OSS/UTL/RingBuffer.h"
+#include "OSS/UTL/Logger.h"
+#include "OSS/UTL/CoreUtils.h"
+
+
+namespace OSS {
+
+
+//
+// The header and the record words are shared with other processes so they
+// are accessed with the compiler atomics directly rather than boost::atomic.
+// The futex calls need the address of a plain 32 bit word.
+//
+struct IPCRing::Header
+{
+  OSS::UInt32 magic;
+  OSS::UInt32 version;
+  OSS::UInt64 capacity;
+  char _pad0[OSS_CACHE_LINE_SIZE - 16];
+  OSS::UInt64 reserve;
+    /// Producer reservation cursor
+  char _pad1[OSS_CACHE_LINE_SIZE - 8];
+  OSS::UInt64 tail;
+    /// Consumer cursor
+  char _pad2[OSS_CACHE_LINE_SIZE - 8];
+  OSS::UInt32 dataSeq;
+  OSS::UInt32 readerWaiting;
+  char _pad3[OSS_CACHE_LINE_SIZE - 8];
+  OSS::UInt32 spaceSeq;
+  OSS::UInt32 writersWaiting;
+  OSS::UInt32 closed;
+  char _pad4[OSS_CACHE_LINE_SIZE - 12];
+};
+
+static const OSS::UInt32 IPC_RING_MAGIC = 0x4f535352; // "OSSR"
+static const OSS::UInt32 IPC_RING_VERSION = 2;
+static const std::size_t IPC_RING_DATA_OFFSET = 4096;
+static const std::size_t IPC_RING_MIN_CAPACITY = 4096;
+static const unsigned long IPC_RING_RECLAIM_TIMEOUT_MS = 5000;
+static const long IPC_RING_STALL_POLL_MS = 100;
+
+//
+// Every record starts with an 8 byte word holding the payload size in the
+// upper half and the flags below in the lower half.  Records are 8 byte
+// aligned and never wrap.  A padding record fills the tail end of the ring
+// when the next record does not fit there.  A reserved record has its size
+// set but is not committed yet.
+//
+static const OSS::UInt64 RECORD_COMMITTED = 0x1;
+static const OSS::UInt64 RECORD_PADDING = 0x2;
+static const OSS::UInt64 RECORD_RESERVED = 0x4;
+static const OSS::UInt64 RECORD_FLAGS = 0xFFFFFFFF;
+static const std::size_t RECORD_HEADER_SIZE = sizeof(OSS::UInt64);
+
+static inline OSS::UInt64 record_span(std::size_t size)
+{
+  return (RECORD_HEADER_SIZE + size + 7) & ~((OSS::UInt64)7);
+}
+
+static inline OSS::UInt64* record_word(char* pRecord)
+{
+  return reinterpret_cast<OSS::UInt64*>(pRecord);
+}
+
+static void futex_wait(OSS::UInt32* pWord, OSS::UInt32 value, long timeoutMs = 0)
+{
+  //
+  // Not FUTEX_PRIVATE_FLAG.  The waiters live in other processes.
+  //
+  struct timespec timeout;
+  timeout.tv_sec = timeoutMs / 1000;
+  timeout.tv_nsec = (timeoutMs % 1000) * 1000000;
+  syscall(SYS_futex, pWord, FUTEX_WAIT, value, timeoutMs > 0 ? &timeout : 0, 0, 0);
+}
+
+static void futex_wake(OSS::UInt32* pWord, int count)
+{
+  syscall(SYS_futex, pWord, FUTEX_WAKE, count, 0, 0, 0);
+}
+
+
+IPCRing::IPCRing() :
+  _pHeader(0),
+  _pData(0),
+  _mapSize(0),
+  _mask(0),
+  _isOwner(false),
+  _reclaimTimeout(IPC_RING_RECLAIM_TIMEOUT_MS),
+  _stallPosition(0),
+  _stallSince(0)
+{
+}
+
+IPCRing::~IPCRing()
+{
+  close();
+}
+
+bool IPCRing::map(int fd, std::size_t size)
+{
+  void* pMap = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (pMap == MAP_FAILED)
+  {
+    OSS_LOG_ERROR("IPCRing::map " << _name << " mmap failed: " << strerror(errno));
+    return false;
+  }
+  _pHeader = reinterpret_cast<Header*>(pMap);
+  _pData = reinterpret_cast<char*>(pMap) + IPC_RING_DATA_OFFSET;
+  _mapSize = size;
+  return true;
+}
+
+bool IPCRing::create(const std::string& name, std::size_t capacity)
+{
+  close();
+
+  OSS::UInt64 size = IPC_RING_MIN_CAPACITY;
+  while (size < capacity)
+    size <<= 1;
+
+  shm_unlink(name.c_str());
+  int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd == -1)
+  {
+    OSS_LOG_ERROR("IPCRing::create " << name << " shm_open failed: " << strerror(errno));
+    return false;
+  }
+
+  std::size_t mapSize = IPC_RING_DATA_OFFSET + (std::size_t)size;
+  if (ftruncate(fd, mapSize) == -1)
+  {
+    OSS_LOG_ERROR("IPCRing::create " << name << " ftruncate failed: " << strerror(errno));
+    ::close(fd);
+    shm_unlink(name.c_str());
+    return false;
+  }
+
+  _name = name;
+  if (!map(fd, mapSize))
+  {
+    shm_unlink(name.c_str());
+    return false;
+  }
+
+  //
+  // ftruncate hands us zeroed pages so every record word starts uncommitted.
+  // The magic is published last so open() never sees a half built header.
+  //
+  _pHeader->version = IPC_RING_VERSION;
+  _pHeader->capacity = size;
+  _mask = size - 1;
+  _isOwner = true;
+  _stallSince = 0;
+  __atomic_store_n(&_pHeader->magic, IPC_RING_MAGIC, __ATOMIC_RELEASE);
+  return true;
+}
+
+bool IPCRing::open(const std::string& name)
+{
+  close();
+
+  int fd = shm_open(name.c_str(), O_RDWR, 0600);
+  if (fd == -1)
+  {
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) == -1 || st.st_size < (off_t)(IPC_RING_DATA_OFFSET + IPC_RING_MIN_CAPACITY))
+  {
+    ::close(fd);
+    return false;
+  }
+
+  _name = name;
+  if (!map(fd, st.st_size))
+  {
+    return false;
+  }
+
+  if (__atomic_load_n(&_pHeader->magic, __ATOMIC_ACQUIRE) != IPC_RING_MAGIC ||
+    _pHeader->version != IPC_RING_VERSION ||
+    IPC_RING_DATA_OFFSET + _pHeader->capacity != _mapSize)
+  {
+    OSS_LOG_ERROR("IPCRing::open " << name << " is not a valid ring");
+    close();
+    return false;
+  }
+
+  _mask = _pHeader->capacity - 1;
+  return true;
+}
+
+void IPCRing::shutdown()
+{
+  if (!_pHeader)
+  {
+    return;
+  }
+
+  __atomic_store_n(&_pHeader->closed, 1, __ATOMIC_SEQ_CST);
+  __atomic_add_fetch(&_pHeader->dataSeq, 1, __ATOMIC_SEQ_CST);
+  __atomic_add_fetch(&_pHeader->spaceSeq, 1, __ATOMIC_SEQ_CST);
+  futex_wake(&_pHeader->dataSeq, INT_MAX);
+  futex_wake(&_pHeader->spaceSeq, INT_MAX);
+}
+
+void IPCRing::close()
+{
+  if (!_pHeader)
+  {
+    return;
+  }
+
+  if (_isOwner)
+  {
+    shutdown();
+    shm_unlink(_name.c_str());
+  }
+
+  munmap(_pHeader, _mapSize);
+  _pHeader = 0;
+  _pData = 0;
+  _mapSize = 0;
+  _mask = 0;
+  _isOwner = false;
+}
+
+std::size_t IPCRing::maxRecordSize() const
+{
+  //
+  // A record and the padding in front of it must fit in the ring together
+  //
+  return _pHeader ? (std::size_t)((_mask + 1) / 2 - RECORD_HEADER_SIZE) : 0;
+}
+
+bool IPCRing::write(const char* data, std::size_t size, bool blocking)
+{
+  if (!_pHeader || size > maxRecordSize())
+  {
+    return false;
+  }
+
+  OSS::UInt64 capacity = _mask + 1;
+  OSS::UInt64 span = record_span(size);
+  OSS::UInt64 position;
+  OSS::UInt64 padding;
+
+  while (true)
+  {
+    if (__atomic_load_n(&_pHeader->closed, __ATOMIC_ACQUIRE))
+    {
+      return false;
+    }
+
+    OSS::UInt32 spaceSeq = __atomic_load_n(&_pHeader->spaceSeq, __ATOMIC_SEQ_CST);
+    //
+    // Load the tail first.  Both cursors only move forward so reading them in
+    // this order guarantees tail <= position.
+    //
+    OSS::UInt64 tail = __atomic_load_n(&_pHeader->tail, __ATOMIC_ACQUIRE);
+    position = __atomic_load_n(&_pHeader->reserve, __ATOMIC_ACQUIRE);
+    OSS::UInt64 contiguous = capacity - (position & _mask);
+    padding = span <= contiguous ? 0 : contiguous;
+
+    if (position + padding + span - tail <= capacity)
+    {
+      if (__atomic_compare_exchange_n(&_pHeader->reserve, &position, position + padding + span,
+        true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+      {
+        break;
+      }
+      continue;
+    }
+
+    if (!blocking)
+    {
+      return false;
+    }
+
+    //
+    // Full.  Sleep until the reader releases something.
+    //
+    __atomic_add_fetch(&_pHeader->writersWaiting, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&_pHeader->tail, __ATOMIC_SEQ_CST) == tail)
+    {
+      futex_wait(&_pHeader->spaceSeq, spaceSeq);
+    }
+    __atomic_sub_fetch(&_pHeader->writersWaiting, 1, __ATOMIC_SEQ_CST);
+  }
+
+  if (padding)
+  {
+    __atomic_store_n(record_word(at(position)),
+      ((padding - RECORD_HEADER_SIZE) << 32) | RECORD_PADDING | RECORD_COMMITTED, __ATOMIC_RELEASE);
+    position += padding;
+  }
+
+  //
+  // Mark the reservation with its size before copying so the reader can
+  // reclaim it if this process dies before the commit
+  //
+  char* pRecord = at(position);
+  OSS::UInt64 reserved = ((OSS::UInt64)size << 32) | RECORD_RESERVED;
+  __atomic_store_n(record_word(pRecord), reserved, __ATOMIC_RELEASE);
+  std::memcpy(pRecord + RECORD_HEADER_SIZE, data, size);
+  if (!__atomic_compare_exchange_n(record_word(pRecord), &reserved, ((OSS::UInt64)size << 32) | RECORD_COMMITTED,
+    false, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+  {
+    OSS_LOG_WARNING("IPCRing::write " << _name << " record was reclaimed before it was committed");
+    return false;
+  }
+
+  __atomic_add_fetch(&_pHeader->dataSeq, 1, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&_pHeader->readerWaiting, __ATOMIC_SEQ_CST))
+  {
+    futex_wake(&_pHeader->dataSeq, 1);
+  }
+  return true;
+}
+
+bool IPCRing::read(Record& record, bool blocking)
+{
+  if (!_pHeader)
+  {
+    return false;
+  }
+
+  while (true)
+  {
+    OSS::UInt64 tail = __atomic_load_n(&_pHeader->tail, __ATOMIC_RELAXED);
+    char* pRecord = at(tail);
+    OSS::UInt32 dataSeq = __atomic_load_n(&_pHeader->dataSeq, __ATOMIC_SEQ_CST);
+    OSS::UInt64 word = __atomic_load_n(record_word(pRecord), __ATOMIC_ACQUIRE);
+
+    if (word && !isValidRecord(tail, word))
+    {
+      markCorrupt(tail, word);
+      return false;
+    }
+
+    if (word & RECORD_COMMITTED)
+    {
+      _stallSince = 0;
+      std::size_t size = (std::size_t)(word >> 32);
+      if (word & RECORD_PADDING)
+      {
+        Record padding;
+        padding.next = tail + record_span(size);
+        release(padding);
+        continue;
+      }
+      record.data = pRecord + RECORD_HEADER_SIZE;
+      record.size = size;
+      record.next = tail + record_span(size);
+      return true;
+    }
+
+    //
+    // Space past the tail was reserved but the record is not committed.
+    // Either its producer is still copying or it died.
+    //
+    bool isStalled = __atomic_load_n(&_pHeader->reserve, __ATOMIC_ACQUIRE) != tail;
+    if (isStalled && reclaim(tail, word))
+    {
+      continue;
+    }
+
+    if (!blocking || __atomic_load_n(&_pHeader->closed, __ATOMIC_ACQUIRE))
+    {
+      return false;
+    }
+
+    __atomic_store_n(&_pHeader->readerWaiting, 1, __ATOMIC_SEQ_CST);
+    if (!(__atomic_load_n(record_word(pRecord), __ATOMIC_SEQ_CST) & RECORD_COMMITTED))
+    {
+      futex_wait(&_pHeader->dataSeq, dataSeq, isStalled ? IPC_RING_STALL_POLL_MS : 0);
+    }
+    __atomic_store_n(&_pHeader->readerWaiting, 0, __ATOMIC_SEQ_CST);
+  }
+}
+
+bool IPCRing::isValidRecord(OSS::UInt64 position, OSS::UInt64 word) const
+{
+  //
+  // The header is written by other processes.  Never trust a size that
+  // would take the reader past the reserved space or the end of the ring.
+  //
+  OSS::UInt64 flags = word & RECORD_FLAGS;
+  if ((position & 7) || (flags & ~(RECORD_COMMITTED | RECORD_PADDING | RECORD_RESERVED)))
+  {
+    return false;
+  }
+
+  std::size_t size = (std::size_t)(word >> 32);
+  OSS::UInt64 span = record_span(size);
+  if (!(flags & RECORD_PADDING) && size > maxRecordSize())
+  {
+    return false;
+  }
+
+  OSS::UInt64 reserve = __atomic_load_n(&_pHeader->reserve, __ATOMIC_ACQUIRE);
+  return (position & _mask) + span <= _mask + 1 && position + span <= reserve;
+}
+
+bool IPCRing::reclaim(OSS::UInt64 position, OSS::UInt64 word)
+{
+  OSS::UInt64 now = OSS::getTime();
+  if (!_stallSince || _stallPosition != position)
+  {
+    _stallPosition = position;
+    _stallSince = now;
+    return false;
+  }
+
+  if (now - _stallSince < _reclaimTimeout)
+  {
+    return false;
+  }
+  _stallSince = 0;
+
+  if (!(word & RECORD_RESERVED))
+  {
+    //
+    // The producer died between the reservation and marking it.  The size
+    // of the record is unknown so there is no way past it.
+    //
+    markCorrupt(position, word);
+    return false;
+  }
+
+  //
+  // Turn the record into padding.  The compare-and-swap fails if the
+  // producer committed in the meantime, which is just as good.
+  //
+  OSS::UInt64 padding = (word & ~RECORD_FLAGS) | RECORD_PADDING | RECORD_COMMITTED;
+  if (__atomic_compare_exchange_n(record_word(at(position)), &word, padding,
+    false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+  {
+    OSS_LOG_WARNING("IPCRing::read " << _name << " reclaimed a record at " << position
+      << " that was not committed within " << _reclaimTimeout << " ms");
+  }
+  return true;
+}
+
+void IPCRing::markCorrupt(OSS::UInt64 position, OSS::UInt64 word)
+{
+  OSS_LOG_ERROR("IPCRing::read " << _name << " invalid record header " << std::hex << word << std::dec
+    << " at " << position << ".  Shutting down the ring.");
+  shutdown();
+}
+
+void IPCRing::release(const Record& record)
+{
+  if (!_pHeader)
+  {
+    return;
+  }
+
+  //
+  // Zero the span so stale payload bytes can never be mistaken for a
+  // committed record word once producers wrap around to it.
+  //
+  OSS::UInt64 tail = __atomic_load_n(&_pHeader->tail, __ATOMIC_RELAXED);
+  if (record.next <= tail || (tail & _mask) + (record.next - tail) > _mask + 1)
+  {
+    OSS_LOG_ERROR("IPCRing::release " << _name << " invalid record position " << record.next);
+    return;
+  }
+  std::memset(at(tail), 0, (std::size_t)(record.next - tail));
+  __atomic_store_n(&_pHeader->tail, record.next, __ATOMIC_RELEASE);
+
+  __atomic_add_fetch(&_pHeader->spaceSeq, 1, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&_pHeader->writersWaiting, __ATOMIC_SEQ_CST))
+  {
+    futex_wake(&_pHeader->spaceSeq, INT_MAX);
+  }
+}
+
+bool IPCRing::read(std::string& data, bool blocking)
+{
+  Record record;
+  if (!read(record, blocking))
+  {
+    return false;
+  }
+  data.assign(record.data, record.size);
+  release(record);
+  return true;
+}
+
+
+} // OSS
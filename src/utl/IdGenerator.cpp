@@ -0,0 +1,239 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <boost/thread.hpp>
+
+#include "OSS/UTL/IdGenerator.h"
+#include "OSS/UTL/CoreUtils.h"
+#include "OSS/UTL/Logger.h"
+
+
+namespace OSS {
+
+
+static const char ID_ALPHABET[] = "0123456789abcdefghijklmnopqrstuv";
+static const char MAGIC_COOKIE[] = "z9hG4bK";
+static const std::size_t MAGIC_COOKIE_LENGTH = sizeof(MAGIC_COOKIE) - 1;
+
+struct IdGeneratorState
+{
+  OSS::UInt32 input[16];
+  OSS::UInt32 block[16];
+  std::size_t index;
+};
+
+static boost::thread_specific_ptr<IdGeneratorState> _idGeneratorState;
+
+#define ID_GENERATOR_ROTL(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+#define ID_GENERATOR_QUARTER_ROUND(a, b, c, d) \
+  a += b; d ^= a; d = ID_GENERATOR_ROTL(d, 16); \
+  c += d; b ^= c; b = ID_GENERATOR_ROTL(b, 12); \
+  a += b; d ^= a; d = ID_GENERATOR_ROTL(d, 8); \
+  c += d; b ^= c; b = ID_GENERATOR_ROTL(b, 7);
+
+static void id_generator_chacha20_block(IdGeneratorState* pState)
+{
+  OSS::UInt32* x = pState->block;
+  std::memcpy(x, pState->input, sizeof(pState->input));
+  for (int i = 0; i < 10; i++)
+  {
+    ID_GENERATOR_QUARTER_ROUND(x[0], x[4], x[8], x[12]);
+    ID_GENERATOR_QUARTER_ROUND(x[1], x[5], x[9], x[13]);
+    ID_GENERATOR_QUARTER_ROUND(x[2], x[6], x[10], x[14]);
+    ID_GENERATOR_QUARTER_ROUND(x[3], x[7], x[11], x[15]);
+    ID_GENERATOR_QUARTER_ROUND(x[0], x[5], x[10], x[15]);
+    ID_GENERATOR_QUARTER_ROUND(x[1], x[6], x[11], x[12]);
+    ID_GENERATOR_QUARTER_ROUND(x[2], x[7], x[8], x[13]);
+    ID_GENERATOR_QUARTER_ROUND(x[3], x[4], x[9], x[14]);
+  }
+  for (int i = 0; i < 16; i++)
+  {
+    x[i] += pState->input[i];
+  }
+
+  //
+  // 64-bit block counter in words 12 and 13
+  //
+  if (++pState->input[12] == 0)
+  {
+    ++pState->input[13];
+  }
+  pState->index = 0;
+}
+
+static bool id_generator_read_entropy(void* buffer, std::size_t length)
+{
+  char* pos = static_cast<char*>(buffer);
+#ifdef SYS_getrandom
+  while (length)
+  {
+    long ret = ::syscall(SYS_getrandom, pos, length, 0);
+    if (ret < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      break;
+    }
+    pos += ret;
+    length -= ret;
+  }
+  if (!length)
+  {
+    return true;
+  }
+#endif
+  int fd = ::open("/dev/urandom", O_RDONLY);
+  if (fd == -1)
+  {
+    return false;
+  }
+  while (length)
+  {
+    ssize_t ret = ::read(fd, pos, length);
+    if (ret < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (ret <= 0)
+    {
+      break;
+    }
+    pos += ret;
+    length -= ret;
+  }
+  ::close(fd);
+  return length == 0;
+}
+
+static IdGeneratorState* id_generator_create_state()
+{
+  IdGeneratorState* pState = new IdGeneratorState();
+
+  //
+  // "expand 32-byte k" followed by a 256-bit key from the kernel.  The
+  // counter starts at zero and the nonce words stay zero since every
+  // thread draws its own key.
+  //
+  pState->input[0] = 0x61707865;
+  pState->input[1] = 0x3320646e;
+  pState->input[2] = 0x79622d32;
+  pState->input[3] = 0x6b206574;
+  if (!id_generator_read_entropy(pState->input + 4, 8 * sizeof(OSS::UInt32)))
+  {
+    OSS_LOG_ERROR("IdGenerator - unable to read kernel entropy.  Identifiers will be predictable.");
+    OSS::UInt64 mix[2] = { OSS::getTime(), (OSS::UInt64)pthread_self() };
+    std::memcpy(pState->input + 4, mix, sizeof(mix));
+  }
+  pState->input[12] = 0;
+  pState->input[13] = 0;
+  pState->input[14] = 0;
+  pState->input[15] = 0;
+  id_generator_chacha20_block(pState);
+  return pState;
+}
+
+OSS::UInt64 IdGenerator::next()
+{
+  IdGeneratorState* pState = _idGeneratorState.get();
+  if (!pState)
+  {
+    pState = id_generator_create_state();
+    _idGeneratorState.reset(pState);
+  }
+
+  if (pState->index >= 16)
+  {
+    id_generator_chacha20_block(pState);
+  }
+  OSS::UInt64 value = ((OSS::UInt64)pState->block[pState->index] << 32) | pState->block[pState->index + 1];
+
+  //
+  // Never leave keystream that has been handed out lying around
+  //
+  pState->block[pState->index] = 0;
+  pState->block[pState->index + 1] = 0;
+  pState->index += 2;
+  return value;
+}
+
+char* IdGenerator::generate(char* buffer, std::size_t length)
+{
+  std::size_t i = 0;
+  while (i < length)
+  {
+    //
+    // Twelve 5-bit characters per 64-bit draw
+    //
+    OSS::UInt64 bits = next();
+    for (int j = 0; j < 12 && i < length; j++, i++)
+    {
+      buffer[i] = ID_ALPHABET[bits & 0x1F];
+      bits >>= 5;
+    }
+  }
+  buffer[length] = '\0';
+  return buffer;
+}
+
+char* IdGenerator::createBranch(char* buffer)
+{
+  std::memcpy(buffer, MAGIC_COOKIE, MAGIC_COOKIE_LENGTH);
+  generate(buffer + MAGIC_COOKIE_LENGTH, BRANCH_LENGTH - MAGIC_COOKIE_LENGTH);
+  return buffer;
+}
+
+char* IdGenerator::createTag(char* buffer)
+{
+  return generate(buffer, TAG_LENGTH);
+}
+
+char* IdGenerator::createCallId(char* buffer)
+{
+  return generate(buffer, CALL_ID_LENGTH);
+}
+
+std::string IdGenerator::createBranch()
+{
+  char buffer[BRANCH_LENGTH + 1];
+  return std::string(createBranch(buffer), BRANCH_LENGTH);
+}
+
+std::string IdGenerator::createTag()
+{
+  char buffer[TAG_LENGTH + 1];
+  return std::string(createTag(buffer), TAG_LENGTH);
+}
+
+std::string IdGenerator::createCallId()
+{
+  char buffer[CALL_ID_LENGTH + 1];
+  return std::string(createCallId(buffer), CALL_ID_LENGTH);
+}
+
+
+} // OSS
@@ -28,10 +28,15 @@
 #include "Poco/Logger.h"
 #include <iostream>
 #include <sstream>
+#include <list>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/tss.hpp>
 
 #include "OSS/UTL/Logger.h"
 #include "OSS/UTL/CoreUtils.h"
 #include "OSS/UTL/Thread.h"
+#include "OSS/UTL/RingBuffer.h"
 
 
 using Poco::AutoPtr;
@@ -57,6 +62,250 @@ static bool _enableConsoleLogging = true;
 static bool _enableLogging = true;
 static LogPriority _consoleLogLevel = PRIO_INFORMATION;
 static ExternalLogger _externalLogger;
+
+boost::atomic<int> log_gate_level(PRIO_INFORMATION);
+
+static void log_update_gate()
+{
+  int level = PRIO_NONE;
+  if (!_enableLogging)
+    level = PRIO_NONE;
+  else if (_externalLogger)
+    level = PRIO_TRACE; // the external logger does its own filtering
+  else if (_pLogger)
+    level = _pLogger->getLevel();
+  else if (_enableConsoleLogging)
+    level = _consoleLogLevel;
+  log_gate_level.store(level, boost::memory_order_relaxed);
+}
+
+
+class AsyncLogChannel : public Channel
+  /// A channel that queues messages in per-thread lock-free buffers and
+  /// forwards them to the wrapped channel from a single writer thread.
+  ///
+  /// Producers never contend with each other or with the file channel.
+  /// Formatting, file writes and rotation all happen on the writer thread.
+  /// Archive compression is already performed in the background by the
+  /// Poco ArchiveCompressor so rotation never stalls the writer for long.
+  ///
+  /// If a thread's buffer is full, or the writer is not running, the
+  /// message is written through synchronously rather than dropped.
+{
+public:
+  enum
+  {
+    BUFFER_SIZE = 4096,
+    IDLE_WAIT_MS = 10
+  };
+
+  AsyncLogChannel();
+
+  void setChannel(Channel* pChannel);
+    /// Set the channel messages are forwarded to
+
+  void start();
+    /// Start the writer thread
+
+  void stop();
+    /// Stop the writer thread after draining all pending messages
+
+  void log(const Message& msg);
+    /// Queue the message in the buffer of the calling thread
+
+  void open();
+
+  void close();
+
+protected:
+  ~AsyncLogChannel();
+
+private:
+  struct Buffer
+  {
+    Buffer() : messages(BUFFER_SIZE), orphaned(false) {}
+    RingBuffer<Message*> messages;
+    boost::atomic<bool> orphaned;
+  };
+  typedef std::list<Buffer*> Buffers;
+
+  static void releaseBuffer(Buffer* pBuffer);
+  Buffer* getBuffer();
+  void writeThrough(const Message& msg);
+  std::size_t drain();
+  void run();
+
+  OSS::mutex_critic_sec _channelMutex;
+  AutoPtr<Channel> _pChannel;
+  OSS::mutex_critic_sec _buffersMutex;
+  Buffers _buffers;
+  boost::thread_specific_ptr<Buffer> _threadBuffer;
+  boost::atomic<bool> _isRunning;
+  boost::thread* _pWriterThread;
+  boost::mutex _wakeupMutex;
+  boost::condition_variable _wakeup;
+};
+
+AsyncLogChannel::AsyncLogChannel() :
+  _threadBuffer(&AsyncLogChannel::releaseBuffer),
+  _isRunning(false),
+  _pWriterThread(0)
+{
+}
+
+AsyncLogChannel::~AsyncLogChannel()
+{
+  stop();
+  //
+  // Buffers that are still attached to a live thread are intentionally
+  // leaked. The thread will mark them orphaned when it exits.
+  //
+  for (Buffers::iterator iter = _buffers.begin(); iter != _buffers.end(); iter++)
+  {
+    if ((*iter)->orphaned)
+      delete *iter;
+  }
+}
+
+void AsyncLogChannel::releaseBuffer(Buffer* pBuffer)
+{
+  //
+  // Called by boost::thread_specific_ptr when the owning thread exits.
+  // The writer thread deletes the buffer once it is drained.
+  //
+  pBuffer->orphaned = true;
+}
+
+void AsyncLogChannel::setChannel(Channel* pChannel)
+{
+  OSS::mutex_critic_sec_lock lock(_channelMutex);
+  _pChannel = pChannel;
+  if (pChannel)
+    pChannel->duplicate();
+}
+
+void AsyncLogChannel::start()
+{
+  if (_isRunning.exchange(true))
+    return;
+  _pWriterThread = new boost::thread(boost::bind(&AsyncLogChannel::run, this));
+}
+
+void AsyncLogChannel::stop()
+{
+  if (!_isRunning.exchange(false))
+    return;
+
+  {
+    boost::mutex::scoped_lock lock(_wakeupMutex);
+    _wakeup.notify_one();
+  }
+
+  _pWriterThread->join();
+  delete _pWriterThread;
+  _pWriterThread = 0;
+  drain();
+}
+
+void AsyncLogChannel::open()
+{
+  OSS::mutex_critic_sec_lock lock(_channelMutex);
+  if (_pChannel)
+    _pChannel->open();
+}
+
+void AsyncLogChannel::close()
+{
+  OSS::mutex_critic_sec_lock lock(_channelMutex);
+  if (_pChannel)
+    _pChannel->close();
+}
+
+AsyncLogChannel::Buffer* AsyncLogChannel::getBuffer()
+{
+  Buffer* pBuffer = _threadBuffer.get();
+  if (!pBuffer)
+  {
+    pBuffer = new Buffer();
+    _threadBuffer.reset(pBuffer);
+    OSS::mutex_critic_sec_lock lock(_buffersMutex);
+    _buffers.push_back(pBuffer);
+  }
+  return pBuffer;
+}
+
+void AsyncLogChannel::writeThrough(const Message& msg)
+{
+  OSS::mutex_critic_sec_lock lock(_channelMutex);
+  if (_pChannel)
+    _pChannel->log(msg);
+}
+
+void AsyncLogChannel::log(const Message& msg)
+{
+  if (!_isRunning || msg.getPriority() <= Message::PRIO_CRITICAL)
+  {
+    writeThrough(msg);
+    return;
+  }
+
+  Message* pMessage = new Message(msg);
+  if (!getBuffer()->messages.tryEnqueue(pMessage))
+  {
+    delete pMessage;
+    writeThrough(msg);
+  }
+}
+
+std::size_t AsyncLogChannel::drain()
+{
+  std::size_t count = 0;
+  Buffers buffers;
+  {
+    OSS::mutex_critic_sec_lock lock(_buffersMutex);
+    buffers = _buffers;
+  }
+
+  for (Buffers::iterator iter = buffers.begin(); iter != buffers.end(); iter++)
+  {
+    Buffer* pBuffer = *iter;
+    //
+    // Read the orphaned flag before draining so that a message enqueued
+    // right before the thread exited is not lost.
+    //
+    bool orphaned = pBuffer->orphaned;
+    Message* pMessage = 0;
+    while (pBuffer->messages.tryDequeue(pMessage))
+    {
+      writeThrough(*pMessage);
+      delete pMessage;
+      count++;
+    }
+
+    if (orphaned)
+    {
+      OSS::mutex_critic_sec_lock lock(_buffersMutex);
+      _buffers.remove(pBuffer);
+      delete pBuffer;
+    }
+  }
+  return count;
+}
+
+void AsyncLogChannel::run()
+{
+  while (_isRunning)
+  {
+    if (drain() == 0)
+    {
+      boost::mutex::scoped_lock lock(_wakeupMutex);
+      if (_isRunning)
+        _wakeup.timed_wait(lock, boost::posix_time::milliseconds((long)IDLE_WAIT_MS));
+    }
+  }
+}
+
+static AsyncLogChannel* _pAsyncChannel = 0;
   /*
 enum LogPriority
 {
@@ -121,11 +370,13 @@ enum LogPriority
 void log_enable_console(bool yes)
 {
   _enableConsoleLogging = yes;
+  log_update_gate();
 }
 
 void log_enable_logging(bool yes)
 {
   _enableLogging = yes;
+  log_update_gate();
 }
 
 void logger_init_external(const ExternalLogger& externalLogger)
@@ -133,6 +384,7 @@ void logger_init_external(const ExternalLogger& externalLogger)
   _consoleMutex.lock();
   _externalLogger = externalLogger;
   _consoleMutex.unlock();
+  log_update_gate();
 }
 
 void logger_init(
@@ -141,7 +393,8 @@ void logger_init(
   const std::string& format,
   const std::string& compress,
   const std::string& purgeCount,
-  const std::string& times)
+  const std::string& times,
+  bool async)
 {
   if (_enableLogging)
   {
@@ -165,14 +418,38 @@ void logger_init(
     AutoPtr<Formatter> formatter(new PatternFormatter(format.c_str()));
     AutoPtr<Channel> formattingChannel(new FormattingChannel(formatter, rotatedFileChannel));
     formatter->setProperty("times", times);
-    _pLogger = &(Logger::create("OSS.logger", formattingChannel, level));
+
+    if (async)
+    {
+      //
+      // The async channel is never destroyed. Thread local buffers may
+      // outlive the logger and are released by their owning threads.
+      //
+      if (!_pAsyncChannel)
+        _pAsyncChannel = new AsyncLogChannel();
+      _pAsyncChannel->setChannel(formattingChannel);
+      _pAsyncChannel->start();
+      _pLogger = &(Logger::create("OSS.logger", AutoPtr<Channel>(_pAsyncChannel, true), level));
+    }
+    else
+    {
+      _pLogger = &(Logger::create("OSS.logger", formattingChannel, level));
+    }
+    log_update_gate();
   }
 }
 
 void logger_deinit()
 {
+  if (_pAsyncChannel)
+    _pAsyncChannel->stop();
+
   if (_pLogger)
+  {
     _pLogger->destroy("OSS.logger");
+    _pLogger = 0;
+  }
+  log_update_gate();
 }
 
 void log_reset_level(LogPriority level)
@@ -184,6 +461,7 @@ void log_reset_level(LogPriority level)
     _pLogger->setLevel(level);
 
   _consoleLogLevel = level;
+  log_update_gate();
 }
 
 LogPriority log_get_level()
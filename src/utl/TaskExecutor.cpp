@@ -0,0 +1,291 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare 
+// derivative works of the Software, all subject to the 
+// "GNU Lesser General Public License (LGPL)".
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include <boost/bind.hpp>
+#include <boost/functional/hash.hpp>
+
+#include "OSS/UTL/TaskExecutor.h"
+#include "OSS/UTL/Logger.h"
+
+
+namespace OSS {
+
+
+TaskExecutor::Worker::Worker(std::size_t index_, std::size_t size_) :
+  slots(new Task[size_]),
+  index(index_),
+  size(size_),
+  head(0),
+  count(0),
+  thread(0)
+{
+}
+
+TaskExecutor::Worker::~Worker()
+{
+  delete [] slots;
+}
+
+bool TaskExecutor::Worker::pushBack(const Task& task)
+{
+  OSS::mutex_critic_sec_lock lock(mutex);
+  if (count == size)
+    return false;
+  slots[(head + count) % size] = task;
+  ++count;
+  return true;
+}
+
+bool TaskExecutor::Worker::popFront(Task& task)
+{
+  OSS::mutex_critic_sec_lock lock(mutex);
+  if (!count)
+    return false;
+  //
+  // swap() hands over the functor without copying it and leaves the slot
+  // empty so bound arguments are released as soon as the task runs
+  //
+  task.swap(slots[head]);
+  head = (head + 1) % size;
+  --count;
+  return true;
+}
+
+bool TaskExecutor::Worker::popBack(Task& task)
+{
+  OSS::mutex_critic_sec_lock lock(mutex);
+  if (!count)
+    return false;
+  --count;
+  task.swap(slots[(head + count) % size]);
+  return true;
+}
+
+void TaskExecutor::releaseWorker(Worker*)
+{
+  //
+  // Workers are owned by the executor, not by the thread local pointer
+  //
+}
+
+TaskExecutor::TaskExecutor(std::size_t workerCount, std::size_t queueSize, std::size_t maxWorkers) :
+  _currentWorker(&TaskExecutor::releaseWorker),
+  _queueSize(queueSize ? queueSize : 1),
+  _workerCount(0),
+  _capacity(0),
+  _isRunning(true),
+  _pending(0),
+  _active(0),
+  _stolen(0),
+  _nextWorker(0),
+  _idleCount(0)
+{
+  if (!workerCount)
+    workerCount = 1;
+  if (maxWorkers < workerCount)
+    maxWorkers = workerCount;
+
+  //
+  // The slot vector is sized once so readers never see it reallocate.
+  // Only the first _workerCount entries are valid.
+  //
+  _workers.resize(maxWorkers, 0);
+  for (std::size_t i = 0; i < workerCount; i++)
+    grow();
+}
+
+TaskExecutor::~TaskExecutor()
+{
+  stop();
+  for (std::size_t i = 0; i < _workerCount; i++)
+    delete _workers[i];
+}
+
+bool TaskExecutor::grow()
+{
+  OSS::mutex_critic_sec_lock lock(_growMutex);
+  std::size_t index = _workerCount;
+  if (!_isRunning || index >= _workers.size())
+    return false;
+
+  Worker* pWorker = new Worker(index, _queueSize);
+  _workers[index] = pWorker;
+  _capacity.fetch_add(_queueSize);
+  _workerCount.store(index + 1, boost::memory_order_release);
+  pWorker->thread = new boost::thread(boost::bind(&TaskExecutor::run, this, index));
+  return true;
+}
+
+void TaskExecutor::stop()
+{
+  if (!_isRunning.exchange(false))
+    return;
+
+  {
+    //
+    // Wait out a grow() in progress.  Any later call sees _isRunning
+    // cleared so the worker count is final from here on.
+    //
+    OSS::mutex_critic_sec_lock lock(_growMutex);
+  }
+
+  {
+    boost::mutex::scoped_lock lock(_idleMutex);
+    _idleCondition.notify_all();
+  }
+
+  std::size_t workerCount = _workerCount;
+  for (std::size_t i = 0; i < workerCount; i++)
+  {
+    if (_workers[i]->thread)
+    {
+      _workers[i]->thread->join();
+      delete _workers[i]->thread;
+      _workers[i]->thread = 0;
+    }
+  }
+}
+
+int TaskExecutor::schedule(const Task& task)
+{
+  Worker* pCurrent = _currentWorker.get();
+  std::size_t home;
+  if (pCurrent)
+    home = pCurrent->index;
+  else
+    home = _nextWorker.fetch_add(1, boost::memory_order_relaxed) % getWorkerCount();
+  return enqueue(task, home);
+}
+
+int TaskExecutor::schedule(const Task& task, const std::string& affinityKey)
+{
+  boost::hash<std::string> hasher;
+  return enqueue(task, hasher(affinityKey) % getWorkerCount());
+}
+
+int TaskExecutor::enqueue(const Task& task, std::size_t home)
+{
+  if (!_isRunning || !task)
+    return -1;
+
+  //
+  // Reserve a slot first so admission is bounded even when several
+  // producers race for the last free slots
+  //
+  std::size_t pending = _pending.fetch_add(1) + 1;
+  if (pending > _capacity && !grow())
+  {
+    _pending.fetch_sub(1);
+    return -1;
+  }
+
+  bool queued = false;
+  std::size_t workerCount = getWorkerCount();
+  for (std::size_t i = 0; i < workerCount && !queued; i++)
+    queued = _workers[(home + i) % workerCount]->pushBack(task);
+
+  if (!queued)
+  {
+    _pending.fetch_sub(1);
+    return -1;
+  }
+
+  //
+  // Nobody is waiting for work and every worker is running a task.  The
+  // new task would sit behind a potentially blocking one so add a worker.
+  //
+  if (_idleCount == 0 && _active >= workerCount && workerCount < _workers.size())
+    grow();
+
+  //
+  // _pending is incremented before _idleCount is read.  A worker going idle
+  // increments _idleCount before reading _pending so one of the two sides
+  // always observes the other.
+  //
+  if (_idleCount > 0)
+  {
+    boost::mutex::scoped_lock lock(_idleMutex);
+    _idleCondition.notify_one();
+  }
+
+  return (int)pending;
+}
+
+bool TaskExecutor::dequeue(std::size_t index, Task& task)
+{
+  if (_workers[index]->popFront(task))
+    return true;
+
+  std::size_t workerCount = getWorkerCount();
+  for (std::size_t i = 1; i < workerCount; i++)
+  {
+    if (_workers[(index + i) % workerCount]->popBack(task))
+    {
+      _stolen.fetch_add(1, boost::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+
+void TaskExecutor::run(std::size_t index)
+{
+  _currentWorker.reset(_workers[index]);
+
+  Task task;
+  while (_isRunning)
+  {
+    if (dequeue(index, task))
+    {
+      _active.fetch_add(1);
+      _pending.fetch_sub(1);
+      try
+      {
+        task();
+      }
+      catch(const std::exception& e)
+      {
+        OSS_LOG_ERROR("TaskExecutor::run - Unhandled exception " << e.what());
+      }
+      catch(...)
+      {
+        OSS_LOG_ERROR("TaskExecutor::run - Unhandled unknown exception");
+      }
+      task.clear();
+      _active.fetch_sub(1);
+      continue;
+    }
+
+    boost::mutex::scoped_lock lock(_idleMutex);
+    _idleCount.fetch_add(1);
+    if (_isRunning && _pending == 0)
+      _idleCondition.timed_wait(lock, boost::posix_time::milliseconds(100));
+    _idleCount.fetch_sub(1);
+  }
+}
+
+void TaskExecutor::join()
+{
+  while (_isRunning && (_pending > 0 || _active > 0))
+    OSS::thread_sleep(1);
+}
+
+
+} // OSS
@@ -20,7 +20,7 @@
 
 #include "OSS/OSS.h"
 #include "OSS/UTL/Thread.h"
-#include "Poco/ThreadPool.h"
+#include "OSS/UTL/TaskExecutor.h"
 #include "Poco/Semaphore.h"
 #include "OSS/Net/Net.h"
 
@@ -113,33 +113,30 @@ private:
   thread_schedule_func _schedule;
 };
 
-class thread_pool_runnable : public Poco::Runnable
+//
+// thread_pool is a thin wrapper over the work-stealing TaskExecutor.  Like
+// the Poco pool it replaces, it grows on demand up to maxCapacity threads.
+// One worker per core is started up front and more are added while every
+// worker is busy, since B2BUA tasks may block on DNS or script execution.
+// Bursts beyond that are queued instead of rejected.
+//
+static const std::size_t THREAD_POOL_QUEUE_SIZE = 1024;
+
+static std::size_t thread_pool_worker_count(int minCapacity, int maxCapacity)
 {
-public:
-  thread_pool_runnable()
-  {
-  }
-  void run()
-  {
-    if (_voidArgTask)
-    {
-      _voidArgTask(_voidArg);
-    } 
-    else
-    {
-      if (_task)
-        _task();
-      else if (_argTask)
-        _argTask(_arg);
-    }
-    delete this;
-  }
-  boost::function<void()> _task;
-  thread_pool::argument_place_holder _arg;
-  boost::function<void(thread_pool::argument_place_holder)> _argTask;
-  void* _voidArg;
-  boost::function<void(void*)> _voidArgTask;
-};
+  int workers = (int)boost::thread::hardware_concurrency();
+  if (workers > maxCapacity)
+    workers = maxCapacity;
+  if (workers < minCapacity)
+    workers = minCapacity;
+  return workers > 0 ? workers : 1;
+}
+
+static TaskExecutor& thread_pool_default_executor()
+{
+  static TaskExecutor executor(thread_pool_worker_count(2, 16), THREAD_POOL_QUEUE_SIZE, 16);
+  return executor;
+}
 
 thread_pool::thread_pool(
   int minCapacity,
@@ -147,34 +144,28 @@ thread_pool::thread_pool(
 	int idleTime,
   int stackSize) : _threadPool(0)
 {
-  _threadPool = new Poco::ThreadPool(minCapacity, maxCapacity, idleTime, stackSize);
+  _threadPool = new TaskExecutor(thread_pool_worker_count(minCapacity, maxCapacity), THREAD_POOL_QUEUE_SIZE,
+    maxCapacity > 0 ? maxCapacity : 0);
 }
 
 thread_pool::~thread_pool()
 {
-  delete static_cast<Poco::ThreadPool*>(_threadPool);
+  delete static_cast<TaskExecutor*>(_threadPool);
 }
 
 void thread_pool::join()
 {
-  static_cast<Poco::ThreadPool*>(_threadPool)->joinAll();
+  static_cast<TaskExecutor*>(_threadPool)->join();
 }
 
 int thread_pool::schedule(boost::function<void()> task)
 {
-  thread_pool_runnable* runnable = new thread_pool_runnable();
-  runnable->_task = task;
-  try
-  {
-    static_cast<Poco::ThreadPool*>(_threadPool)->start(*runnable);
-    return static_cast<Poco::ThreadPool*>(_threadPool)->used();
-  }
-  catch(...)
-  {
-    delete runnable;
-    return -1;
-  }
-  return 0;
+  return static_cast<TaskExecutor*>(_threadPool)->schedule(task);
+}
+
+int thread_pool::schedule(boost::function<void()> task, const std::string& affinityKey)
+{
+  return static_cast<TaskExecutor*>(_threadPool)->schedule(task, affinityKey);
 }
 
 void thread_pool::schedule(boost::function<void()> task, int millis)
@@ -184,40 +175,28 @@ void thread_pool::schedule(boost::function<void()> task, int millis)
 
 int thread_pool::schedule_with_arg(boost::function<void(argument_place_holder)> task, argument_place_holder arg)
 {
-  thread_pool_runnable* runnable = new thread_pool_runnable();
-  runnable->_argTask = task;
-  runnable->_arg = arg;
-  try
-  {
-    static_cast<Poco::ThreadPool*>(_threadPool)->start(*runnable);
-    return static_cast<Poco::ThreadPool*>(_threadPool)->used();
-  }
-  catch(...)
-  {
-    delete runnable;
-    return -1;
-  }
-  return 0;
+  return static_cast<TaskExecutor*>(_threadPool)->schedule(boost::bind(task, arg));
 }
 
 int thread_pool::schedule_with_arg(boost::function<void(void*)> task, void* arg)
 {
-  thread_pool_runnable* runnable = new thread_pool_runnable();
-  runnable->_voidArgTask = task;
-  runnable->_voidArg = arg;
-  try
-  {
-    static_cast<Poco::ThreadPool*>(_threadPool)->start(*runnable);
-    return static_cast<Poco::ThreadPool*>(_threadPool)->used();
-  }
-  catch(...)
-  {
-    delete runnable;
-    return -1;
-  }
-  return 0;
+  return static_cast<TaskExecutor*>(_threadPool)->schedule(boost::bind(task, arg));
 }
 
+std::size_t thread_pool::get_pending_count() const
+{
+  return static_cast<TaskExecutor*>(_threadPool)->getPendingCount();
+}
+
+std::size_t thread_pool::get_active_count() const
+{
+  return static_cast<TaskExecutor*>(_threadPool)->getActiveCount();
+}
+
+std::size_t thread_pool::get_capacity() const
+{
+  return static_cast<TaskExecutor*>(_threadPool)->getCapacity();
+}
 
 void thread_pool::static_schedule(boost::function<void()> task, int millis)
 {
@@ -226,43 +205,17 @@ void thread_pool::static_schedule(boost::function<void()> task, int millis)
 
 int thread_pool::static_schedule(boost::function<void()> task)
 {
-  thread_pool_runnable* runnable = new thread_pool_runnable();
-  runnable->_task = task;
-  try
-  {
-    Poco::ThreadPool::defaultPool().start(*runnable);
-    return Poco::ThreadPool::defaultPool().used();
-  }
-  catch(...)
-  {
-    delete runnable;
-    return -1;
-  }
-  return 0;
-
+  return thread_pool_default_executor().schedule(task);
 }
 
 int thread_pool::static_schedule_with_arg(boost::function<void(argument_place_holder)> task, argument_place_holder arg)
 {
-  thread_pool_runnable* runnable = new thread_pool_runnable();
-  runnable->_argTask = task;
-  runnable->_arg = arg;
-  try
-  {
-    Poco::ThreadPool::defaultPool().start(*runnable);
-    return Poco::ThreadPool::defaultPool().used();
-  }
-  catch(...)
-  {
-    delete runnable;
-    return -1;
-  }
-  return 0;
+  return thread_pool_default_executor().schedule(boost::bind(task, arg));
 }
 
 void thread_pool::static_join()
 {
-  Poco::ThreadPool::defaultPool().joinAll();
+  thread_pool_default_executor().join();
 }
 
 